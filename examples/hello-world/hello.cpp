@@ -1,11 +1,12 @@
 #include <io2d.h>
 
 #include <fstream>
+#include <vector>
 #include "tga_header.h"
 
 namespace io2d = std::experimental::io2d;
 
-void save_surface_to_tga_file(io2d::image_surface& surface,
+void save_surface_to_tga_file(const io2d::image_surface& surface,
                               std::string const& fileName)
 {
     tga::header tga_header;
@@ -19,9 +20,17 @@ void save_surface_to_tga_file(io2d::image_surface& surface,
     ofs.write(reinterpret_cast<const char*>(&tga_header),
               sizeof(tga_header));
 
-    auto bytes = surface.data();
-    ofs.write(reinterpret_cast<const char*>(&bytes[0]),
-            bytes.size());
+    // TGA stores straight alpha in B, G, R, A order, with no padding
+    // between rows.
+    auto pixels = surface.const_pixels();
+    const int rowSize = pixels.width() * 4;
+    std::vector<unsigned char> image(static_cast<size_t>(rowSize) *
+                                     pixels.height());
+    io2d::convert_pixels(pixels.data(), pixels.stride(), pixels.format(),
+                         image.data(), rowSize,
+                         io2d::interchange_format::bgra8,
+                         pixels.width(), pixels.height());
+    ofs.write(reinterpret_cast<const char*>(image.data()), image.size());
 }
 
 int main ()
@@ -11,10 +11,13 @@
 #include <functional>
 #include <exception>
 #include <vector>
+#include <deque>
+#include <initializer_list>
 #include <string>
 #include <algorithm>
 #include <system_error>
 #include <cstdint>
+#include <cstddef>
 #include <atomic>
 
 #ifdef _WIN32_WINNT
@@ -147,6 +150,18 @@ namespace std {
 					rgb30
 				};
 
+				// 8 bits per channel, straight (not premultiplied) alpha, channels in the named byte order; what other libraries usually exchange pixels in. See convert_pixels.
+				enum class interchange_format {
+					rgba8,
+					bgra8
+				};
+
+				// Whether for_each_row, transform_pixels and convert_pixels may split an image into bands of rows and work on several of them at once, using worker threads that io2d starts the first time they are asked to and keeps until the process exits. The IO2D_THREADS environment variable sets how many threads, the caller's included, that may be; it defaults to the number of hardware threads.
+				enum class parallelism {
+					sequential,
+					parallel
+				};
+
 				enum class extend {
 					none,
 					repeat,
@@ -234,6 +249,62 @@ namespace std {
 					virtual bool equivalent(const ::std::error_code& ec, int condition) const noexcept override;
 				};
 
+				// Plays the role of C++17's std::pmr::memory_resource, which the C++14 this library targets does not have.
+				class memory_resource {
+					virtual void* do_allocate(::std::size_t bytes, ::std::size_t alignment) = 0;
+					virtual void do_deallocate(void* p, ::std::size_t bytes, ::std::size_t alignment) = 0;
+					virtual bool do_is_equal(const memory_resource& other) const noexcept = 0;
+				public:
+					virtual ~memory_resource();
+
+					void* allocate(::std::size_t bytes, ::std::size_t alignment = alignof(::std::max_align_t));
+					void deallocate(void* p, ::std::size_t bytes, ::std::size_t alignment = alignof(::std::max_align_t));
+					bool is_equal(const memory_resource& other) const noexcept;
+				};
+
+				bool operator==(const memory_resource& lhs, const memory_resource& rhs) noexcept;
+				bool operator!=(const memory_resource& lhs, const memory_resource& rhs) noexcept;
+				memory_resource* new_delete_resource() noexcept;
+				memory_resource* get_default_resource() noexcept;
+				memory_resource* set_default_resource(memory_resource* r) noexcept;
+
+				// Hands out memory from a buffer that only grows, so deallocate does nothing and an arena of transient objects is thrown away all at once. Like std::pmr::monotonic_buffer_resource.
+				class monotonic_buffer_resource : public memory_resource {
+					struct _Chunk {
+						_Chunk* next;
+						::std::size_t size;
+					};
+					memory_resource* _Upstream;
+					void* _Initial_buffer;
+					::std::size_t _Initial_size;
+					// Obtained from _Upstream, most recent first.
+					_Chunk* _Chunks = nullptr;
+					unsigned char* _Current;
+					::std::size_t _Space;
+					::std::size_t _Next_size;
+
+					void _Release_chunks(_Chunk* keep) noexcept;
+					virtual void* do_allocate(::std::size_t bytes, ::std::size_t alignment) override;
+					virtual void do_deallocate(void* p, ::std::size_t bytes, ::std::size_t alignment) override;
+					virtual bool do_is_equal(const memory_resource& other) const noexcept override;
+				public:
+					explicit monotonic_buffer_resource(memory_resource* upstream = get_default_resource()) noexcept;
+					monotonic_buffer_resource(::std::size_t initialSize, memory_resource* upstream = get_default_resource()) noexcept;
+					monotonic_buffer_resource(void* buffer, ::std::size_t bufferSize, memory_resource* upstream = get_default_resource()) noexcept;
+					monotonic_buffer_resource(const monotonic_buffer_resource&) = delete;
+					monotonic_buffer_resource& operator=(const monotonic_buffer_resource&) = delete;
+					virtual ~monotonic_buffer_resource();
+
+					// Modifiers
+					// Returns all memory obtained from upstream.
+					void release() noexcept;
+					// Makes all memory handed out so far available again but keeps the most recent, and largest, chunk obtained from upstream, so that a per frame arena stops touching upstream once it has grown to the size of a frame.
+					void reset() noexcept;
+
+					// Observers
+					memory_resource* upstream_resource() const noexcept;
+				};
+
 				// I don't know why Clang/C2 is complaining about weak vtables here since the at least one virtual function is always anchored but for now silence the warnings. I've never seen this using Clang on OpenSUSE.
 #ifdef _WIN32
 #ifdef __clang__
@@ -243,6 +314,50 @@ namespace std {
 
 				const ::std::error_category& io2d_category() noexcept;
 
+				template <class T>
+				class polymorphic_allocator {
+					memory_resource* _Resource;
+				public:
+					typedef T value_type;
+
+					polymorphic_allocator() noexcept
+						: _Resource(get_default_resource()) {
+					}
+					polymorphic_allocator(memory_resource* r) noexcept
+						: _Resource(r) {
+					}
+					polymorphic_allocator(const polymorphic_allocator& other) noexcept = default;
+					template <class U>
+					polymorphic_allocator(const polymorphic_allocator<U>& other) noexcept
+						: _Resource(other.resource()) {
+					}
+					polymorphic_allocator& operator=(const polymorphic_allocator&) = delete;
+
+					T* allocate(::std::size_t n) {
+						return static_cast<T*>(_Resource->allocate(n * sizeof(T), alignof(T)));
+					}
+					void deallocate(T* p, ::std::size_t n) noexcept {
+						_Resource->deallocate(p, n * sizeof(T), alignof(T));
+					}
+					// Copies of a container go to the default resource, not the one the original uses.
+					polymorphic_allocator select_on_container_copy_construction() const noexcept {
+						return polymorphic_allocator();
+					}
+					memory_resource* resource() const noexcept {
+						return _Resource;
+					}
+				};
+
+				template <class T1, class T2>
+				inline bool operator==(const polymorphic_allocator<T1>& lhs, const polymorphic_allocator<T2>& rhs) noexcept {
+					return *lhs.resource() == *rhs.resource();
+				}
+
+				template <class T1, class T2>
+				inline bool operator!=(const polymorphic_allocator<T1>& lhs, const polymorphic_allocator<T2>& rhs) noexcept {
+					return !(lhs == rhs);
+				}
+
 				class vector_2d {
 					double _X = 0.0;
 					double _Y = 0.0;
@@ -250,36 +365,130 @@ namespace std {
 					vector_2d() noexcept = default;
 					vector_2d(const vector_2d& other) noexcept = default;
 					vector_2d& operator=(const vector_2d& other) noexcept = default;
-					vector_2d(vector_2d&& other) noexcept;
-					vector_2d& operator=(vector_2d&& other) noexcept;
-					vector_2d(double x, double y) noexcept;
+					vector_2d(vector_2d&& other) noexcept = default;
+					vector_2d& operator=(vector_2d&& other) noexcept = default;
+					constexpr vector_2d(double x, double y) noexcept;
 
-					void x(double value) noexcept;
-					void y(double value) noexcept;
+					constexpr void x(double value) noexcept;
+					constexpr void y(double value) noexcept;
 
-					double x() const noexcept;
-					double y() const noexcept;
+					constexpr double x() const noexcept;
+					constexpr double y() const noexcept;
 
 					double magnitude() const noexcept;
-					double magnitude_squared() const noexcept;
-					double dot(const vector_2d& other) const noexcept;
+					constexpr double magnitude_squared() const noexcept;
+					constexpr double dot(const vector_2d& other) const noexcept;
 					double angular_direction(const vector_2d& to) const noexcept;
 
 					vector_2d to_unit() const noexcept;
 
-					vector_2d& operator+=(const vector_2d& rhs) noexcept;
-					vector_2d& operator-=(const vector_2d& rhs) noexcept;
-					vector_2d& operator*=(double rhs) noexcept;
+					constexpr vector_2d& operator+=(const vector_2d& rhs) noexcept;
+					constexpr vector_2d& operator-=(const vector_2d& rhs) noexcept;
+					constexpr vector_2d& operator*=(double rhs) noexcept;
 				};
 
-				bool operator==(const vector_2d& lhs, const vector_2d& rhs) noexcept;
-				bool operator!=(const vector_2d& lhs, const vector_2d& rhs) noexcept;
-				vector_2d operator+(const vector_2d& lhs) noexcept;
-				vector_2d operator+(const vector_2d& lhs, const vector_2d& rhs) noexcept;
-				vector_2d operator-(const vector_2d& lhs) noexcept;
-				vector_2d operator-(const vector_2d& lhs, const vector_2d& rhs) noexcept;
-				vector_2d operator*(const vector_2d& lhs, double rhs) noexcept;
-				vector_2d operator*(double lhs, const vector_2d& rhs) noexcept;
+				constexpr bool operator==(const vector_2d& lhs, const vector_2d& rhs) noexcept;
+				constexpr bool operator!=(const vector_2d& lhs, const vector_2d& rhs) noexcept;
+				constexpr vector_2d operator+(const vector_2d& lhs) noexcept;
+				constexpr vector_2d operator+(const vector_2d& lhs, const vector_2d& rhs) noexcept;
+				constexpr vector_2d operator-(const vector_2d& lhs) noexcept;
+				constexpr vector_2d operator-(const vector_2d& lhs, const vector_2d& rhs) noexcept;
+				constexpr vector_2d operator*(const vector_2d& lhs, double rhs) noexcept;
+				constexpr vector_2d operator*(double lhs, const vector_2d& rhs) noexcept;
+
+				inline constexpr vector_2d::vector_2d(double x, double y) noexcept
+					: _X(x)
+					, _Y(y) {
+				}
+
+				inline constexpr void vector_2d::x(double value) noexcept {
+					_X = value;
+				}
+
+				inline constexpr void vector_2d::y(double value) noexcept {
+					_Y = value;
+				}
+
+				inline constexpr double vector_2d::x() const noexcept {
+					return _X;
+				}
+
+				inline constexpr double vector_2d::y() const noexcept {
+					return _Y;
+				}
+
+				inline double vector_2d::magnitude() const noexcept {
+					return ::std::sqrt(_X * _X + _Y * _Y);
+				}
+
+				inline constexpr double vector_2d::magnitude_squared() const noexcept {
+					return _X * _X + _Y * _Y;
+				}
+
+				inline constexpr double vector_2d::dot(const vector_2d& other) const noexcept {
+					return _X * other._X + _Y * other._Y;
+				}
+
+				inline double vector_2d::angular_direction(const vector_2d& to) const noexcept {
+					auto v = to - *this;
+					return ::std::atan2(v._Y, v._X);
+				}
+
+				inline vector_2d vector_2d::to_unit() const noexcept {
+					auto leng = magnitude();
+
+					return vector_2d{ _X / leng, _Y / leng };
+				}
+
+				inline constexpr vector_2d& vector_2d::operator+=(const vector_2d& rhs) noexcept {
+					_X = _X + rhs.x();
+					_Y = _Y + rhs.y();
+					return *this;
+				}
+
+				inline constexpr vector_2d& vector_2d::operator-=(const vector_2d& rhs) noexcept {
+					_X = _X - rhs.x();
+					_Y = _Y - rhs.y();
+					return *this;
+				}
+
+				inline constexpr vector_2d& vector_2d::operator*=(double rhs) noexcept {
+					_X *= rhs;
+					_Y *= rhs;
+					return *this;
+				}
+
+				inline constexpr bool operator==(const vector_2d& lhs, const vector_2d& rhs) noexcept {
+					return lhs.x() == rhs.x() && lhs.y() == rhs.y();
+				}
+
+				inline constexpr bool operator!=(const vector_2d& lhs, const vector_2d& rhs) noexcept {
+					return !(lhs == rhs);
+				}
+
+				inline constexpr vector_2d operator+(const vector_2d& lhs) noexcept {
+					return lhs;
+				}
+
+				inline constexpr vector_2d operator+(const vector_2d& lhs, const vector_2d& rhs) noexcept {
+					return vector_2d{ lhs.x() + rhs.x(), lhs.y() + rhs.y() };
+				}
+
+				inline constexpr vector_2d operator-(const vector_2d& lhs) noexcept {
+					return vector_2d{ -lhs.x(), -lhs.y() };
+				}
+
+				inline constexpr vector_2d operator-(const vector_2d& lhs, const vector_2d& rhs) noexcept {
+					return vector_2d{ lhs.x() - rhs.x(), lhs.y() - rhs.y() };
+				}
+
+				inline constexpr vector_2d operator*(const vector_2d& lhs, double rhs) noexcept {
+					return vector_2d{ lhs.x() * rhs, lhs.y() * rhs };
+				}
+
+				inline constexpr vector_2d operator*(double lhs, const vector_2d& rhs) noexcept {
+					return vector_2d{ lhs * rhs.x(), lhs * rhs.y() };
+				}
 
 				class rectangle {
 					double _X = 0.0;
@@ -290,32 +499,123 @@ namespace std {
 					rectangle() noexcept = default;
 					rectangle(const rectangle& other) noexcept = default;
 					rectangle& operator=(const rectangle& other) noexcept = default;
-					rectangle(rectangle&& other) noexcept ;
-					rectangle& operator=(rectangle&& other) noexcept ;
-					rectangle(double x, double y, double width, double height) noexcept;
-					rectangle(const vector_2d& tl, const vector_2d& br) noexcept;
-
-					void x(double value) noexcept;
-					void y(double value) noexcept;
-					void width(double value) noexcept;
-					void height(double value) noexcept;
-					void top_left(const vector_2d& value) noexcept;
-					void bottom_right(const vector_2d& value) noexcept;
-					void top_left_bottom_right(const vector_2d& tl, const vector_2d& br) noexcept;
-
-					double x() const noexcept;
-					double y() const noexcept;
-					double width() const noexcept;
-					double height() const noexcept;
-					double left() const noexcept;
-					double right() const noexcept;
-					double top() const noexcept;
-					double bottom() const noexcept;
-					vector_2d top_left() const noexcept;
-					vector_2d bottom_right() const noexcept;
+					rectangle(rectangle&& other) noexcept = default;
+					rectangle& operator=(rectangle&& other) noexcept = default;
+					constexpr rectangle(double x, double y, double width, double height) noexcept;
+					constexpr rectangle(const vector_2d& tl, const vector_2d& br) noexcept;
+
+					constexpr void x(double value) noexcept;
+					constexpr void y(double value) noexcept;
+					constexpr void width(double value) noexcept;
+					constexpr void height(double value) noexcept;
+					constexpr void top_left(const vector_2d& value) noexcept;
+					constexpr void bottom_right(const vector_2d& value) noexcept;
+					constexpr void top_left_bottom_right(const vector_2d& tl, const vector_2d& br) noexcept;
+
+					constexpr double x() const noexcept;
+					constexpr double y() const noexcept;
+					constexpr double width() const noexcept;
+					constexpr double height() const noexcept;
+					constexpr double left() const noexcept;
+					constexpr double right() const noexcept;
+					constexpr double top() const noexcept;
+					constexpr double bottom() const noexcept;
+					constexpr vector_2d top_left() const noexcept;
+					constexpr vector_2d bottom_right() const noexcept;
 					tuple<vector_2d, vector_2d> top_left_bottom_right() const noexcept;
 				};
 
+				inline constexpr rectangle::rectangle(double x, double y, double width, double height) noexcept
+					: _X(x)
+					, _Y(y)
+					, _Width(width)
+					, _Height(height) {
+				}
+
+				inline constexpr rectangle::rectangle(const vector_2d& tl, const vector_2d& br) noexcept
+					: _X(tl.x())
+					, _Y(tl.y())
+					, _Width(::std::max(0.0, br.x() - tl.x()))
+					, _Height(::std::max(0.0, br.y() - tl.y())) {
+				}
+
+				inline constexpr void rectangle::x(double value) noexcept {
+					_X = value;
+				}
+
+				inline constexpr void rectangle::y(double value) noexcept {
+					_Y = value;
+				}
+
+				inline constexpr void rectangle::width(double value) noexcept {
+					_Width = value;
+				}
+
+				inline constexpr void rectangle::height(double value) noexcept {
+					_Height = value;
+				}
+
+				inline constexpr void rectangle::top_left(const vector_2d& value) noexcept {
+					_X = value.x();
+					_Y = value.y();
+				}
+
+				inline constexpr void rectangle::bottom_right(const vector_2d& value) noexcept {
+					_Width = ::std::max(0.0, value.x() - _X);
+					_Height = ::std::max(0.0, value.y() - _Y);
+				}
+
+				inline constexpr void rectangle::top_left_bottom_right(const vector_2d& tl, const vector_2d& br) noexcept {
+					_X = tl.x();
+					_Y = tl.y();
+					_Width = ::std::max(0.0, br.x() - tl.x());
+					_Height = ::std::max(0.0, br.y() - tl.y());
+				}
+
+				inline constexpr double rectangle::x() const noexcept {
+					return _X;
+				}
+
+				inline constexpr double rectangle::y() const noexcept {
+					return _Y;
+				}
+
+				inline constexpr double rectangle::width() const noexcept {
+					return _Width;
+				}
+
+				inline constexpr double rectangle::height() const noexcept {
+					return _Height;
+				}
+
+				inline constexpr double rectangle::left() const noexcept {
+					return _X;
+				}
+
+				inline constexpr double rectangle::right() const noexcept {
+					return _X + _Width;
+				}
+
+				inline constexpr double rectangle::top() const noexcept {
+					return _Y;
+				}
+
+				inline constexpr double rectangle::bottom() const noexcept {
+					return _Y + _Height;
+				}
+
+				inline constexpr vector_2d rectangle::top_left() const noexcept {
+					return{ _X, _Y };
+				}
+
+				inline constexpr vector_2d rectangle::bottom_right() const noexcept {
+					return{ _X + _Width, _Y + _Height };
+				}
+
+				inline tuple<vector_2d, vector_2d> rectangle::top_left_bottom_right() const noexcept {
+					return make_tuple<vector_2d, vector_2d>({ _X, _Y }, { _X + _Width, _Y + _Height });
+				}
+
 				class rgba_color {
 					double _R = 0.0;
 					double _G = 0.0;
@@ -578,54 +878,206 @@ namespace std {
 					double _M21 = 0.0;
 				public:
 
-					matrix_2d() noexcept;
+					matrix_2d() noexcept = default;
 					matrix_2d(const matrix_2d& other) noexcept = default;
 					matrix_2d& operator=(const matrix_2d& other) noexcept = default;
-					matrix_2d(matrix_2d&& other) noexcept;
-					matrix_2d& operator=(matrix_2d&& other) noexcept;
-					matrix_2d(double m00, double m01, double m10, double m11, double m20, double m21) noexcept;
+					matrix_2d(matrix_2d&& other) noexcept = default;
+					matrix_2d& operator=(matrix_2d&& other) noexcept = default;
+					constexpr matrix_2d(double m00, double m01, double m10, double m11, double m20, double m21) noexcept;
 
-					static matrix_2d init_identity() noexcept;
-					static matrix_2d init_translate(const vector_2d& value) noexcept;
-					static matrix_2d init_scale(const vector_2d& value) noexcept;
+					constexpr static matrix_2d init_identity() noexcept;
+					constexpr static matrix_2d init_translate(const vector_2d& value) noexcept;
+					constexpr static matrix_2d init_scale(const vector_2d& value) noexcept;
 					static matrix_2d init_rotate(double radians) noexcept;
-					static matrix_2d init_shear_x(double factor) noexcept;
-					static matrix_2d init_shear_y(double factor) noexcept;
+					constexpr static matrix_2d init_shear_x(double factor) noexcept;
+					constexpr static matrix_2d init_shear_y(double factor) noexcept;
 
 					// Modifiers
-					void m00(double value) noexcept;
-					void m01(double value) noexcept;
-					void m10(double value) noexcept;
-					void m11(double value) noexcept;
-					void m20(double value) noexcept;
-					void m21(double value) noexcept;
-					matrix_2d& translate(const vector_2d& value) noexcept;
-					matrix_2d& scale(const vector_2d& value) noexcept;
+					constexpr void m00(double value) noexcept;
+					constexpr void m01(double value) noexcept;
+					constexpr void m10(double value) noexcept;
+					constexpr void m11(double value) noexcept;
+					constexpr void m20(double value) noexcept;
+					constexpr void m21(double value) noexcept;
+					constexpr matrix_2d& translate(const vector_2d& value) noexcept;
+					constexpr matrix_2d& scale(const vector_2d& value) noexcept;
 					matrix_2d& rotate(double radians) noexcept;
-					matrix_2d& shear_x(double factor) noexcept;
-					matrix_2d& shear_y(double factor) noexcept;
+					constexpr matrix_2d& shear_x(double factor) noexcept;
+					constexpr matrix_2d& shear_y(double factor) noexcept;
 					matrix_2d& invert();
 					matrix_2d& invert(::std::error_code& ec) noexcept;
 
 					// Observers
-					double m00() const noexcept;
-					double m01() const noexcept;
-					double m10() const noexcept;
-					double m11() const noexcept;
-					double m20() const noexcept;
-					double m21() const noexcept;
+					constexpr double m00() const noexcept;
+					constexpr double m01() const noexcept;
+					constexpr double m10() const noexcept;
+					constexpr double m11() const noexcept;
+					constexpr double m20() const noexcept;
+					constexpr double m21() const noexcept;
 					bool is_invertible() const noexcept;
 					double determinant() const;
 					double determinant(::std::error_code& ec) const noexcept;
-					vector_2d transform_distance(const vector_2d& dist) const noexcept;
-					vector_2d transform_point(const vector_2d& pt) const noexcept;
+					constexpr vector_2d transform_distance(const vector_2d& dist) const noexcept;
+					constexpr vector_2d transform_point(const vector_2d& pt) const noexcept;
+					// Transforms count points in place or into out, which may alias pts. Equivalent to calling transform_point on each point.
+					void transform_points(vector_2d* pts, ::std::size_t count) const noexcept;
+					void transform_points(const vector_2d* pts, ::std::size_t count, vector_2d* out) const noexcept;
 
-					matrix_2d& operator*=(const matrix_2d& rhs) noexcept;
+					constexpr matrix_2d& operator*=(const matrix_2d& rhs) noexcept;
 				};
 
-				matrix_2d operator*(const matrix_2d& lhs, const matrix_2d& rhs) noexcept;
-				bool operator==(const matrix_2d& lhs, const matrix_2d& rhs) noexcept;
-				bool operator!=(const matrix_2d& lhs, const matrix_2d& rhs) noexcept;
+				constexpr matrix_2d operator*(const matrix_2d& lhs, const matrix_2d& rhs) noexcept;
+				constexpr bool operator==(const matrix_2d& lhs, const matrix_2d& rhs) noexcept;
+				constexpr bool operator!=(const matrix_2d& lhs, const matrix_2d& rhs) noexcept;
+
+				inline constexpr matrix_2d::matrix_2d(double m00, double m01, double m10, double m11, double m20, double m21) noexcept
+					: _M00{ m00 }
+					, _M01{ m01 }
+					, _M10{ m10 }
+					, _M11{ m11 }
+					, _M20{ m20 }
+					, _M21{ m21 } {
+				}
+
+				inline constexpr matrix_2d matrix_2d::init_identity() noexcept {
+					return{ 1.0, 0.0, 0.0, 1.0, 0.0, 0.0 };
+				}
+
+				inline constexpr matrix_2d matrix_2d::init_translate(const vector_2d& value) noexcept {
+					return{ 1.0, 0.0, 0.0, 1.0, value.x(), value.y() };
+				}
+
+				inline constexpr matrix_2d matrix_2d::init_scale(const vector_2d& value) noexcept {
+					return{ value.x(), 0.0, 0.0, value.y(), 0.0, 0.0 };
+				}
+
+				inline matrix_2d matrix_2d::init_rotate(double radians) noexcept {
+					auto sine = ::std::sin(radians);
+					auto cosine = ::std::cos(radians);
+					return{ cosine, sine, -sine, cosine, 0.0, 0.0 };
+				}
+
+				inline constexpr matrix_2d matrix_2d::init_shear_x(double factor) noexcept {
+					return{ 1.0, 0.0, factor, 1.0, 0.0, 0.0 };
+				}
+
+				inline constexpr matrix_2d matrix_2d::init_shear_y(double factor) noexcept {
+					return{ 1.0, factor, 0.0, 1.0, 0.0, 0.0 };
+				}
+
+				inline constexpr void matrix_2d::m00(double value) noexcept {
+					_M00 = value;
+				}
+
+				inline constexpr void matrix_2d::m01(double value) noexcept {
+					_M01 = value;
+				}
+
+				inline constexpr void matrix_2d::m10(double value) noexcept {
+					_M10 = value;
+				}
+
+				inline constexpr void matrix_2d::m11(double value) noexcept {
+					_M11 = value;
+				}
+
+				inline constexpr void matrix_2d::m20(double value) noexcept {
+					_M20 = value;
+				}
+
+				inline constexpr void matrix_2d::m21(double value) noexcept {
+					_M21 = value;
+				}
+
+				inline constexpr matrix_2d& matrix_2d::translate(const vector_2d& value) noexcept {
+					*this = init_translate(value) * (*this);
+					return *this;
+				}
+
+				inline constexpr matrix_2d& matrix_2d::scale(const vector_2d& value) noexcept {
+					*this = init_scale(value) * (*this);
+					return *this;
+				}
+
+				inline matrix_2d& matrix_2d::rotate(double radians) noexcept {
+					*this = init_rotate(radians) * (*this);
+					return *this;
+				}
+
+				inline constexpr matrix_2d& matrix_2d::shear_x(double factor) noexcept {
+					*this = init_shear_x(factor) * (*this);
+					return *this;
+				}
+
+				inline constexpr matrix_2d& matrix_2d::shear_y(double factor) noexcept {
+					*this = init_shear_y(factor) * (*this);
+					return *this;
+				}
+
+				inline constexpr double matrix_2d::m00() const noexcept {
+					return _M00;
+				}
+
+				inline constexpr double matrix_2d::m01() const noexcept {
+					return _M01;
+				}
+
+				inline constexpr double matrix_2d::m10() const noexcept {
+					return _M10;
+				}
+
+				inline constexpr double matrix_2d::m11() const noexcept {
+					return _M11;
+				}
+
+				inline constexpr double matrix_2d::m20() const noexcept {
+					return _M20;
+				}
+
+				inline constexpr double matrix_2d::m21() const noexcept {
+					return _M21;
+				}
+
+				inline bool matrix_2d::is_invertible() const noexcept {
+					if (!::std::isfinite(_M00) || !::std::isfinite(_M01) || !::std::isfinite(_M10) || !::std::isfinite(_M11) || !::std::isfinite(_M20) || !::std::isfinite(_M21)) {
+						return false;
+					}
+					return (_M00 * _M11 - _M01 * _M10) != 0.0;
+				}
+
+				inline constexpr vector_2d matrix_2d::transform_distance(const vector_2d& dist) const noexcept {
+					return{ _M00 * dist.x() + _M10 * dist.y(), _M01 * dist.x() + _M11 * dist.y() };
+				}
+
+				inline constexpr vector_2d matrix_2d::transform_point(const vector_2d& pt) const noexcept {
+					return{ _M00 * pt.x() + _M10 * pt.y() + _M20, _M01 * pt.x() + _M11 * pt.y() + _M21 };
+				}
+
+				inline constexpr matrix_2d& matrix_2d::operator*=(const matrix_2d& rhs) noexcept {
+					*this = *this * rhs;
+					return *this;
+				}
+
+				inline constexpr matrix_2d operator*(const matrix_2d& lhs, const matrix_2d& rhs) noexcept {
+					return matrix_2d{
+						(lhs.m00() * rhs.m00()) + (lhs.m01() * rhs.m10()),
+						(lhs.m00() * rhs.m01()) + (lhs.m01() * rhs.m11()),
+						(lhs.m10() * rhs.m00()) + (lhs.m11() * rhs.m10()),
+						(lhs.m10() * rhs.m01()) + (lhs.m11() * rhs.m11()),
+						(lhs.m20() * rhs.m00()) + (lhs.m21() * rhs.m10()) + rhs.m20(),
+						(lhs.m20() * rhs.m01()) + (lhs.m21() * rhs.m11()) + rhs.m21()
+					};
+				}
+
+				inline constexpr bool operator==(const matrix_2d& lhs, const matrix_2d& rhs) noexcept {
+					return lhs.m00() == rhs.m00() && lhs.m01() == rhs.m01() &&
+						lhs.m10() == rhs.m10() && lhs.m11() == rhs.m11() &&
+						lhs.m20() == rhs.m20() && lhs.m21() == rhs.m21();
+				}
+
+				inline constexpr bool operator!=(const matrix_2d& lhs, const matrix_2d& rhs) noexcept {
+					return !(lhs == rhs);
+				}
 
 				class path_data_item {
 					bool _Has_data = false;
@@ -1305,11 +1757,17 @@ namespace std {
 				// Forward declaration.
 				class path_factory;
 				class surface;
+				class _Cairo_path_converter;
 
 				class path {
 					friend path_factory;
-					::std::shared_ptr<::std::vector<path_data_item>> _Data;
-					::std::shared_ptr<cairo_path_t> _Cairo_path;
+					friend surface;
+					// Shared by all copies of a path. Defined in path.cpp.
+					struct _Native_path;
+					::std::shared_ptr<_Native_path> _Native;
+
+					// Replaces the current path of context with this one, reusing the fixed-point form cairo keeps paths in when it was already made for context's transformation.
+					void _Set_on(cairo_t* context) const noexcept;
 				public:
 					typedef cairo_path_t* native_handle_type;
 					native_handle_type native_handle() const noexcept;
@@ -1331,18 +1789,55 @@ namespace std {
 
 				class path_factory {
 					friend path;
-					::std::vector<path_data_item> _Data;
-					bool _Has_current_point;
+					friend _Cairo_path_converter;
+					friend surface;
+					// One path_data_type per item in _Verbs and only the doubles that item needs, in order, in _Coords. See _Coord_count.
+					::std::vector<unsigned char, polymorphic_allocator<unsigned char>> _Verbs;
+					::std::vector<double, polymorphic_allocator<double>> _Coords;
+					bool _Has_current_point = false;
 					vector_2d _Current_point;
 					vector_2d _Last_move_to_point;
 					matrix_2d _Transform_matrix;
 					vector_2d _Origin;
+					// Changes whenever the items are replaced or removed rather than appended to. See _Cairo_path_converter.
+					::std::uint_least64_t _Revision = _Next_revision();
+
+					// Lets surface::save record the items in O(1). Appending leaves the recorded items where they are, and anything else that would change them (clear or assignment) first swaps them into the save point, so restoring only has to take them back and drop what was appended since.
+					struct _Save_point {
+						::std::size_t _Verb_count;
+						::std::size_t _Coord_count;
+						bool _Has_current_point;
+						vector_2d _Current_point;
+						vector_2d _Last_move_to_point;
+						matrix_2d _Transform_matrix;
+						vector_2d _Origin;
+						bool _Items_moved;
+						::std::vector<unsigned char, polymorphic_allocator<unsigned char>> _Verbs;
+						::std::vector<double, polymorphic_allocator<double>> _Coords;
+					};
+					// The save point that still refers to this object's items, if any. Only set on a surface's immediate path.
+					_Save_point* _Active_save_point = nullptr;
+
+					static ::std::uint_least64_t _Next_revision() noexcept;
+					_Save_point _Make_save_point() const noexcept;
+					void _Restore_save_point(_Save_point& sp) noexcept;
+					void _Move_items_to_save_point() noexcept;
+					// Lets a surface move its immediate path without copying the items when the saved state that refers to them moves along with it.
+					path_factory&& _Without_save_point() noexcept;
+					static ::std::size_t _Coord_count(path_data_type type) noexcept;
+					static path_data_item _Make_data_item(path_data_type type, const double* coords) noexcept;
+					void _Add(path_data_type type, ::std::initializer_list<double> coords);
+					void _Add(const path_data_item& item);
 				public:
 					path_factory() noexcept = default;
-					path_factory(const path_factory& other) = default;
-					path_factory& operator=(const path_factory& other) = default;
-					path_factory(path_factory&& other) noexcept;
-					path_factory& operator=(path_factory&& other) noexcept;
+					explicit path_factory(::std::experimental::io2d::memory_resource* mr) noexcept;
+					path_factory(const path_factory& other);
+					path_factory(const path_factory& other, ::std::experimental::io2d::memory_resource* mr);
+					path_factory& operator=(const path_factory& other);
+					// Copies the items instead, and can throw, only when other is a surface's immediate path whose items a saved state still refers to.
+					path_factory(path_factory&& other);
+					// Keeps this object's memory resource, as a std::pmr container does, so if other's is different the items are copied and this can throw.
+					path_factory& operator=(path_factory&& other);
 
 					// Modifiers
 					void append(const path_factory& p);
@@ -1389,11 +1884,51 @@ namespace std {
 					vector_2d current_point(::std::error_code& ec) const noexcept;
 					matrix_2d current_matrix() const noexcept;
 					vector_2d current_origin() const noexcept;
+					::std::experimental::io2d::memory_resource* memory_resource() const noexcept;
 					::std::vector<path_data_item> data() const;
 					::std::vector<path_data_item> data(::std::error_code& ec) const noexcept;
 					path_data_item data_item(unsigned int index) const;
 					path_data_item data_item(unsigned int index, ::std::error_code& ec) const noexcept;
-					const ::std::vector<path_data_item>& data_ref() const noexcept;
+				};
+
+				// Converts the items of a path_factory to cairo path data. The conversion state is kept between calls so that, as long as the path_factory has only been appended to, a later call converts just the new items.
+				class _Cairo_path_converter {
+					::std::uint_least64_t _Revision = 0;
+					::std::size_t _Verb_count = 0;
+					::std::size_t _Coord_count = 0;
+					matrix_2d _Item_matrix;
+					vector_2d _Item_origin;
+					bool _Has_current_point = false;
+					// Untransformed because it is added to raw relative points before they are transformed.
+					vector_2d _Current_point;
+
+					// Headers and untransformed points of the items not yet written to _Data. The points of a run that shares a matrix and origin are transformed with a single matrix_2d::transform_points call when the run ends.
+					::std::vector<cairo_path_data_t> _Headers;
+					::std::vector<vector_2d> _Points;
+					::std::size_t _Run_start = 0;
+					matrix_2d _Matrix;
+					// The first point of the current sub-path; untransformed if _Last_move_to_in_run, otherwise already transformed.
+					vector_2d _Last_move_to;
+					bool _Last_move_to_in_run = false;
+
+					::std::vector<cairo_path_data_t> _Data;
+
+					cairo_status_t _Convert(const path_factory& pf);
+					void _Add_header(cairo_path_data_type_t type, int length);
+					void _Transform_run() noexcept;
+					void _Transform(const matrix_2d& matrix, const vector_2d& origin) noexcept;
+					void _Move_to(const vector_2d& pt);
+					void _Line_to(const vector_2d& pt);
+					void _Curve_to(const vector_2d& pt1, const vector_2d& pt2, const vector_2d& pt3);
+					bool _Close_path();
+					void _Flush();
+				public:
+					void convert(const path_factory& pf);
+					void convert(const path_factory& pf, ::std::error_code& ec) noexcept;
+					void reset() noexcept;
+					::std::vector<cairo_path_data_t> release_data() noexcept;
+					// Refers to the converted data, so it is only valid until the next call to a non-const member function.
+					cairo_path_t native_path() const noexcept;
 				};
 
 				class device {
@@ -1506,6 +2041,8 @@ namespace std {
 					::std::experimental::io2d::font_weight _Font_weight;
 					::std::shared_ptr<cairo_font_options_t> _Font_options;
 
+					// Leaves every pointer null, for a surface that has not needed its font yet.
+					explicit font_resource(::std::nullptr_t) noexcept;
 				public:
 					font_resource() = delete;
 					font_resource(const font_resource&) noexcept = default;
@@ -1529,6 +2066,23 @@ namespace std {
 					glyph_run make_glyph_run(const ::std::string& utf8, const vector_2d& pos, ::std::error_code& ec) const noexcept;
 				};
 
+				// Constructing a font_resource from a factory goes through one process-wide cache, so that equal requests share a single cairo scaled font along with the glyphs it has already rendered. These report and tune it; it is safe to use from several threads.
+				struct font_resource_cache_stats {
+					::std::size_t hits;
+					::std::size_t misses;
+					::std::size_t evictions;
+					::std::size_t size;
+					::std::size_t capacity;
+				};
+
+				::std::size_t get_font_resource_cache_capacity() noexcept;
+				// Returns the previous capacity. Drops the least recently used entries beyond the new one; 0 turns the cache off.
+				::std::size_t set_font_resource_cache_capacity(::std::size_t n) noexcept;
+				font_resource_cache_stats get_font_resource_cache_stats() noexcept;
+				void reset_font_resource_cache_stats() noexcept;
+				// Fonts already handed out stay valid; only the cache lets go of them.
+				void clear_font_resource_cache() noexcept;
+
 				class glyph_run {
 					friend ::std::experimental::io2d::font_resource;
 					friend surface;
@@ -1649,6 +2203,16 @@ namespace std {
 					::std::experimental::io2d::extend _Extend;
 					::std::experimental::io2d::filter _Filter;
 					matrix_2d _Matrix;
+					// Changes whenever the brush is created or its extend, filter or matrix changes; copies share it.
+					::std::uint_least64_t _Version = _Next_version();
+					// Lives with the pattern, so it is shared by every brush that refers to it: the _Version whose extend, filter and matrix the pattern currently has.
+					::std::uint_least64_t* _Pattern_version = nullptr;
+
+					static ::std::uint_least64_t _Next_version() noexcept;
+					// Takes ownership of p (destroying it if this throws) and gives it a _Pattern_version.
+					void _Set_pattern(cairo_pattern_t* p);
+					// Gives the pattern this brush's extend, filter and matrix unless it already has them.
+					void _Configure_pattern() const noexcept;
 
 				public:
 					native_handle_type native_handle() const noexcept;
@@ -1823,6 +2387,42 @@ namespace std {
 				};
 
 				class mapped_surface;
+				class const_pixel_view;
+				class pixel_view;
+
+				// The parts of a surface, in device space, that drawing has changed since they were last taken. Kept to a few boxes: once it is full, adding one merges the two whose union covers the least extra area. Defined in surface.cpp.
+				class _Damage_region {
+				public:
+					struct _Box {
+						int x0;
+						int y0;
+						int x1;
+						int y1;
+					};
+					static const int _Max_boxes = 8;
+				private:
+					_Box _Boxes[_Max_boxes + 1];
+					int _Count = 0;
+					bool _Everything = false;
+				public:
+					// Boxes are half-open; empty ones are ignored.
+					void _Add(const _Box& b) noexcept;
+					void _Add_everything() noexcept;
+					void _Clear() noexcept;
+					bool _Is_empty() const noexcept {
+						return !_Everything && _Count == 0;
+					}
+					// When set, the boxes are meaningless and the whole surface (and anything presented around it) has to be treated as changed.
+					bool _Is_everything() const noexcept {
+						return _Everything;
+					}
+					int _Box_count() const noexcept {
+						return _Count;
+					}
+					const _Box& _Box_at(int i) const noexcept {
+						return _Boxes[i];
+					}
+				};
 
 				// tuple<dashes, offset>
 				typedef ::std::tuple<::std::vector<double>, double> dashes;
@@ -1839,25 +2439,32 @@ namespace std {
 				public:
 					typedef _Surface_native_handles native_handle_type;
 				private:
+					friend surface_brush_factory;
+
 					::std::mutex _Lock_for_device;
 					::std::weak_ptr<::std::experimental::io2d::device> _Device;
 				protected:
 					::std::unique_ptr<cairo_surface_t, decltype(&cairo_surface_destroy)> _Surface;
 					::std::unique_ptr<cairo_t, decltype(&cairo_destroy)> _Context;
-					::std::unique_ptr<cairo_font_options_t, decltype(&cairo_font_options_destroy)> _Native_font_options;
 
 					const double _Line_join_miter_miter_limit = 10000.0;
 
 					// State - unsaved
-					typedef rectangle _Dirty_type;
-					_Dirty_type _Dirty_rect;
+					typedef _Damage_region _Dirty_type;
+					// Only kept when _Track_damage is set, which display_surface does so that it can present just what was drawn.
+					_Dirty_type _Dirty_region;
+					bool _Track_damage = false;
 					::std::experimental::io2d::format _Format;
 					::std::experimental::io2d::content _Content;
 
 					// State - saved
 					::std::experimental::io2d::brush _Brush;
+					// Set by the rgba_color overloads so they need no brush object; _Brush is stale while it is.
+					bool _Brush_is_color = false;
+					rgba_color _Brush_color;
 					::std::experimental::io2d::antialias _Antialias;
-					::std::experimental::io2d::dashes _Dashes;
+					// Shared with saved states rather than copied; null means no dashes.
+					::std::shared_ptr<const ::std::experimental::io2d::dashes> _Dashes;
 					::std::experimental::io2d::fill_rule _Fill_rule;
 					::std::experimental::io2d::line_cap _Line_cap;
 					::std::experimental::io2d::line_join _Line_join = ::std::experimental::io2d::line_join::miter;
@@ -1868,42 +2475,94 @@ namespace std {
 					::std::experimental::io2d::compositing_operator _Compositing_operator;
 					::std::shared_ptr<::std::experimental::io2d::path> _Current_path;
 					::std::experimental::io2d::path_factory _Immediate_path;
+					mutable _Cairo_path_converter _Immediate_cairo_path;
 					typedef matrix_2d _Transform_matrix_type;
 					_Transform_matrix_type _Transform_matrix;
-					::std::experimental::io2d::font_resource _Font_resource;
-
+					// Null until something needs it; see _Resolve_font_resource.
+					mutable ::std::experimental::io2d::font_resource _Font_resource;
+
+					// Everything in here is either a value, a shared_ptr or a path_factory save point, so saving state neither allocates (once _Saved_state has grown to the nesting depth in use) nor copies items.
+					struct _Saved_state_item {
+						::std::experimental::io2d::brush _Brush;
+						bool _Brush_is_color;
+						rgba_color _Brush_color;
+						::std::experimental::io2d::antialias _Antialias;
+						::std::shared_ptr<const ::std::experimental::io2d::dashes> _Dashes;
+						::std::experimental::io2d::fill_rule _Fill_rule;
+						::std::experimental::io2d::line_cap _Line_cap;
+						::std::experimental::io2d::line_join _Line_join;
+						_Line_width_type _Line_width;
+						_Miter_limit_type _Miter_limit;
+						::std::experimental::io2d::compositing_operator _Compositing_operator;
+						::std::shared_ptr<::std::experimental::io2d::path> _Current_path;
+						path_factory::_Save_point _Immediate_path;
+						_Transform_matrix_type _Transform_matrix;
+						::std::experimental::io2d::font_resource _Font_resource;
+						cairo_pattern_t* _Bound_pattern;
+					};
+					typedef ::std::vector<_Saved_state_item, polymorphic_allocator<_Saved_state_item>> _Saved_state_container;
+					typedef ::std::stack<_Saved_state_item, _Saved_state_container> _Saved_state_type;
+					// Used for _Saved_state.
+					::std::experimental::io2d::memory_resource* _Memory_resource;
 					// Relies on C++17 noexcept guarantee for vector default ctor (N4258, adopted 2014-11).
-					::std::stack<::std::tuple<
-						::std::experimental::io2d::brush,
-						::std::experimental::io2d::antialias,
-						::std::experimental::io2d::dashes,
-						::std::experimental::io2d::fill_rule,
-						::std::experimental::io2d::line_cap,
-						::std::experimental::io2d::line_join,
-						_Line_width_type,
-						_Miter_limit_type,
-						::std::experimental::io2d::compositing_operator,
-						::std::shared_ptr<::std::experimental::io2d::path>,
-						::std::experimental::io2d::path_factory,
-						_Transform_matrix_type,
-						::std::experimental::io2d::font_resource
-					>, ::std::vector<::std::tuple<
-						::std::experimental::io2d::brush,
-						::std::experimental::io2d::antialias,
-						::std::experimental::io2d::dashes,
-						::std::experimental::io2d::fill_rule,
-						::std::experimental::io2d::line_cap,
-						::std::experimental::io2d::line_join,
-						_Line_width_type,
-						_Miter_limit_type,
-						::std::experimental::io2d::compositing_operator,
-						::std::shared_ptr<::std::experimental::io2d::path>,
-						::std::experimental::io2d::path_factory,
-						_Transform_matrix_type,
-						::std::experimental::io2d::font_resource>>> _Saved_state;
+					_Saved_state_type _Saved_state;
+
+					// Saved state that differs from what _Context currently holds. Setters only record the new value and set its flag; _Flush_state and _Flush_current_path push flagged values to _Context right before something uses them. The transform matrix is not deferred because the context's path is stored in device space.
+					enum _State_flags : unsigned int {
+						_State_antialias = 0x1,
+						_State_dashes = 0x2,
+						_State_fill_rule = 0x4,
+						_State_line_cap = 0x8,
+						// Also covers the miter limit, which depends on the line join.
+						_State_line_join = 0x10,
+						_State_line_width = 0x20,
+						_State_compositing_operator = 0x40,
+						_State_font_resource = 0x80,
+						_State_current_path = 0x100,
+						_State_all = 0x1FF
+					};
+					mutable unsigned int _Dirty_state = _State_all;
+					// The pattern _Bind_brush last made the context's source, or null if something else may have replaced it since. The context holds a reference to it, so it cannot be freed and reused while this is set.
+					mutable cairo_pattern_t* _Bound_pattern = nullptr;
 
 					void _Ensure_state();
 					void _Ensure_state(::std::error_code& ec) noexcept;
+					// Pushes every flagged property except the current path to _Context.
+					void _Flush_state() const noexcept;
+					// Puts _Current_path on _Context if something else replaced it there since it was last set.
+					void _Flush_current_path() const noexcept;
+					// Makes _Brush the context's source, with its extend, filter and matrix. Does no pattern work when it already is.
+					void _Bind_brush() const noexcept;
+					// Makes the brush a solid color without creating a pattern for it.
+					void _Brush_color_to(const rgba_color& c) noexcept;
+					// Masks the bound source with maskSurface through a pattern that lives only for this call, which cairo takes from its pool of freed patterns, rather than through a surface_brush_factory and brush.
+					void _Mask_with_surface(const surface& maskSurface, const matrix_2d& maskMatrix, extend maskExtend, filter maskFilter) noexcept;
+					// Gives a surface whose font was never set the default font, which most surfaces never need.
+					void _Resolve_font_resource() const;
+					// Replaces the context's path with _Immediate_path, converting only what was appended to it since the last call.
+					void _Set_immediate_path() const;
+					void _Set_immediate_path(::std::error_code& ec) const noexcept;
+					// Marks _Current_path as no longer being on the context, e.g. after _Set_immediate_path. It is put back by the next _Flush_current_path.
+					void _Restore_current_path() const noexcept;
+					// Replaces the empty _Saved_state with one that allocates from _Memory_resource. Also hands back the memory the old one held, which matters when it came from a monotonic_buffer_resource that is about to be reset.
+					void _Reset_saved_state() noexcept;
+					// Points _Immediate_path at the save point in the top saved state, unless that state's items have already been moved out of it.
+					void _Set_active_save_point() noexcept;
+					// Each adds to _Dirty_region what the drawing operation about to be performed on _Context can change, given the state already flushed to it. _Damage_clip is for operations that can reach everywhere inside the clip, such as paint and mask.
+					void _Damage_clip() noexcept;
+					void _Damage_fill() noexcept;
+					// p is the path being stroked, the context's current path.
+					void _Damage_stroke(const cairo_path_t* p) noexcept;
+					void _Damage_text(const ::std::string& utf8) noexcept;
+					void _Damage_glyphs(const cairo_glyph_t* glyphs, int count) noexcept;
+					// Adds a user-space box, less whatever lies outside the clip, by its device-space bounds.
+					void _Damage_user_box(double x0, double y0, double x1, double y1) noexcept;
+					// The same for operations clipped to the box itself, which cannot reach past it whatever the operator.
+					void _Damage_clipped_user_box(double x0, double y0, double x1, double y1) noexcept;
+					// Exactly one of dstPoints and matrices is non-null and has as many entries as srcRects.
+					void _Draw_sprites(const surface& atlas, const ::std::vector<rectangle>& srcRects, const vector_2d* dstPoints, const matrix_2d* matrices, const ::std::vector<double>& alphas, ::std::error_code& ec) noexcept;
+					// Fills rects[i] with colors[i * colorStep], so a colorStep of 0 fills them all with the one color.
+					void _Fill_rectangles(const ::std::vector<rectangle>& rects, const rgba_color* colors, ::std::size_t colorStep, ::std::error_code& ec) noexcept;
 
 					surface(::std::experimental::io2d::format fmt, int width, int height);
 					surface(::std::experimental::io2d::format fmt, int width, int height, ::std::error_code& ec) noexcept;
@@ -1919,6 +2578,7 @@ namespace std {
 					void path(const ::std::shared_ptr<::std::experimental::io2d::path>& p, ::std::error_code& ec) noexcept;
 				public:
 					bool _Has_surface_resource() const noexcept;
+					// For callers outside the library, which may use the context; io2d itself reads a source surface through _Surface, so that drawing it never gives it a font.
 					native_handle_type native_handle() const;
 
 					surface() = delete;
@@ -1947,6 +2607,9 @@ namespace std {
 					virtual void save(::std::error_code& ec) noexcept;
 					virtual void restore();
 					virtual void restore(::std::error_code& ec) noexcept;
+					// Sets where save() keeps state. Only allowed while no state is saved; the memory is handed back when the last saved state is restored, so a per frame arena can be reset whenever save and restore calls balance. With new_delete_resource() the memory is kept for the next save() instead.
+					void memory_resource(::std::experimental::io2d::memory_resource* mr);
+					void memory_resource(::std::experimental::io2d::memory_resource* mr, ::std::error_code& ec) noexcept;
 					void brush(experimental::nullopt_t) noexcept;
 					void brush(const ::std::experimental::io2d::brush& source);
 					void brush(const ::std::experimental::io2d::brush& source, ::std::error_code& ec) noexcept;
@@ -1990,6 +2653,10 @@ namespace std {
 					void fill_immediate(const ::std::experimental::io2d::brush& b, ::std::error_code& ec) noexcept;
 					void fill_immediate(const surface& s, const matrix_2d& m = matrix_2d::init_identity(), extend e = extend::none, filter f = filter::good);
 					void fill_immediate(const surface& s, ::std::error_code& ec, const matrix_2d& m = matrix_2d::init_identity(), extend e = extend::none, filter f = filter::good) noexcept;
+					void fill_rectangles(const ::std::vector<rectangle>& rects, const rgba_color& c);
+					void fill_rectangles(const ::std::vector<rectangle>& rects, const rgba_color& c, ::std::error_code& ec) noexcept;
+					void fill_rectangles(const ::std::vector<rectangle>& rects, const ::std::vector<rgba_color>& colors);
+					void fill_rectangles(const ::std::vector<rectangle>& rects, const ::std::vector<rgba_color>& colors, ::std::error_code& ec) noexcept;
 					void paint();
 					void paint(::std::error_code& ec) noexcept;
 					void paint(const rgba_color& c);
@@ -2006,6 +2673,12 @@ namespace std {
 					void paint(const ::std::experimental::io2d::brush& b, double alpha, ::std::error_code& ec) noexcept;
 					void paint(const surface& s, double alpha, const matrix_2d& m = matrix_2d::init_identity(), extend e = extend::none, filter f = filter::good);
 					void paint(const surface& s, double alpha, ::std::error_code& ec, const matrix_2d& m = matrix_2d::init_identity(), extend e = extend::none, filter f = filter::good) noexcept;
+					void blit(const surface& s, const rectangle& srcRect, const vector_2d& dstPoint, ::std::experimental::io2d::compositing_operator co = ::std::experimental::io2d::compositing_operator::over);
+					void blit(const surface& s, const rectangle& srcRect, const vector_2d& dstPoint, ::std::error_code& ec, ::std::experimental::io2d::compositing_operator co = ::std::experimental::io2d::compositing_operator::over) noexcept;
+					void draw_sprites(const surface& atlas, const ::std::vector<rectangle>& srcRects, const ::std::vector<vector_2d>& dstPoints, const ::std::vector<double>& alphas = ::std::vector<double>());
+					void draw_sprites(const surface& atlas, const ::std::vector<rectangle>& srcRects, const ::std::vector<vector_2d>& dstPoints, ::std::error_code& ec, const ::std::vector<double>& alphas = ::std::vector<double>()) noexcept;
+					void draw_sprites(const surface& atlas, const ::std::vector<rectangle>& srcRects, const ::std::vector<matrix_2d>& matrices, const ::std::vector<double>& alphas = ::std::vector<double>());
+					void draw_sprites(const surface& atlas, const ::std::vector<rectangle>& srcRects, const ::std::vector<matrix_2d>& matrices, ::std::error_code& ec, const ::std::vector<double>& alphas = ::std::vector<double>()) noexcept;
 					void stroke();
 					void stroke(::std::error_code& ec) noexcept;
 					void stroke(const rgba_color& c);
@@ -2104,6 +2777,7 @@ namespace std {
 					double line_width() const noexcept;
 					double miter_limit() const noexcept;
 					::std::experimental::io2d::compositing_operator compositing_operator() const noexcept;
+					::std::experimental::io2d::memory_resource* memory_resource() const noexcept;
 					rectangle clip_extents() const noexcept;
 					bool in_clip(const vector_2d& pt) const noexcept;
 					::std::vector<rectangle> clip_rectangles() const;
@@ -2166,6 +2840,11 @@ namespace std {
 					image_surface(::std::experimental::io2d::format fmt, int width, int height, ::std::error_code& ec) noexcept;
 					image_surface(::std::vector<unsigned char>& data, ::std::experimental::io2d::format fmt, int width, int height);
 					image_surface(::std::vector<unsigned char>& data, ::std::experimental::io2d::format fmt, int width, int height, ::std::error_code& ec) noexcept;
+					// Draws directly into data, which holds height rows of stride bytes each, instead of copying it. stride must be at least format_stride_for_width(fmt, width) and a multiple of 4.
+					// If release is not empty it is called exactly once, with data, once nothing uses data any longer (before returning if the constructor fails), and must not throw. Otherwise data must outlive the surface.
+					// Call flush() before reading or writing data yourself, and mark_dirty() after writing to it.
+					image_surface(unsigned char* data, ::std::experimental::io2d::format fmt, int width, int height, int stride, ::std::function<void(unsigned char*)> release = nullptr);
+					image_surface(unsigned char* data, ::std::experimental::io2d::format fmt, int width, int height, int stride, ::std::error_code& ec, ::std::function<void(unsigned char*)> release = nullptr) noexcept;
 					//// create_similar_image
 					//image_surface(const surface& other, ::std::experimental::io2d::format fmt, int width, int height);
 					//image_surface(const surface& other, ::std::experimental::io2d::format fmt, int width, int height, ::std::error_code& ec) noexcept;
@@ -2178,12 +2857,21 @@ namespace std {
 					void data(const ::std::vector<unsigned char>& data, ::std::error_code& ec) noexcept;
 					::std::vector<unsigned char> data();
 					::std::vector<unsigned char> data(::std::error_code& ec) noexcept;
+					// Unlike data(), the views below refer to the surface's own pixels rather than copying them.
+					// The surface is marked dirty when the returned view is destroyed, so write through it only while no drawing happens.
+					::std::experimental::io2d::pixel_view pixels();
+					::std::experimental::io2d::pixel_view pixels(::std::error_code& ec) noexcept;
 
 					// Observers
 					::std::experimental::io2d::format format() const noexcept;
 					int width() const noexcept;
 					int height() const noexcept;
 					int stride() const noexcept;
+					::std::experimental::io2d::const_pixel_view const_pixels() const;
+					::std::experimental::io2d::const_pixel_view const_pixels(::std::error_code& ec) const noexcept;
+					// Writes height() rows to buffer, starting one row every stride bytes. stride may differ from stride() but must leave room for width() pixels.
+					void copy_to(unsigned char* buffer, int stride) const;
+					void copy_to(unsigned char* buffer, int stride, ::std::error_code& ec) const noexcept;
 				};
 
 				// I don't know why Clang/C2 is complaining about weak vtables here since the at least one virtual function is always anchored but for now silence the warnings. I've never seen this using Clang on OpenSUSE.
@@ -2234,6 +2922,305 @@ namespace std {
 					int stride() const noexcept;
 				};
 
+				// Read-only access to an image_surface's pixels. Keeps the pixels alive even if the image_surface is destroyed first.
+				class const_pixel_view {
+					cairo_surface_t* _Surface;
+
+					friend image_surface;
+					explicit const_pixel_view(cairo_surface_t* sfce) noexcept;
+
+				public:
+					const_pixel_view() = delete;
+					const_pixel_view(const const_pixel_view&) = delete;
+					const_pixel_view& operator=(const const_pixel_view&) = delete;
+					const_pixel_view(const_pixel_view&& other) noexcept;
+					const_pixel_view& operator=(const_pixel_view&& other) noexcept;
+					~const_pixel_view();
+
+					// Observers
+					const unsigned char* data() const noexcept;
+					const unsigned char* row(int y) const noexcept;
+					::std::size_t size() const noexcept;
+					::std::experimental::io2d::format format() const noexcept;
+					int width() const noexcept;
+					int height() const noexcept;
+					int stride() const noexcept;
+				};
+
+				// Writable access to an image_surface's pixels. Marks the surface dirty when destroyed so that cairo rereads them.
+				class pixel_view {
+					cairo_surface_t* _Surface;
+
+					friend image_surface;
+					explicit pixel_view(cairo_surface_t* sfce) noexcept;
+
+				public:
+					pixel_view() = delete;
+					pixel_view(const pixel_view&) = delete;
+					pixel_view& operator=(const pixel_view&) = delete;
+					pixel_view(pixel_view&& other) noexcept;
+					pixel_view& operator=(pixel_view&& other) noexcept;
+					~pixel_view();
+
+					// Modifiers
+					unsigned char* data() noexcept;
+					unsigned char* row(int y) noexcept;
+
+					// Observers
+					const unsigned char* data() const noexcept;
+					const unsigned char* row(int y) const noexcept;
+					::std::size_t size() const noexcept;
+					::std::experimental::io2d::format format() const noexcept;
+					int width() const noexcept;
+					int height() const noexcept;
+					int stride() const noexcept;
+				};
+
+				// 8 bits per channel with straight (not premultiplied) alpha; what transform_pixels hands to and takes back from its kernel.
+				struct rgba_pixel {
+					::std::uint8_t r;
+					::std::uint8_t g;
+					::std::uint8_t b;
+					::std::uint8_t a;
+				};
+
+				inline ::std::uint8_t _Premultiply_channel(::std::uint8_t c, ::std::uint8_t a) noexcept {
+					// Exact round(c * a / 255) without a division, which lets the compiler vectorize callers.
+					auto t = static_cast<unsigned int>(c) * a + 128u;
+					return static_cast<::std::uint8_t>((t + (t >> 8)) >> 8);
+				}
+
+				// Indexed by alpha: 255 / alpha in 16.16 fixed point, rounded up, which makes _Unpremultiply_channel exactly round(c * 255 / alpha) for every c <= alpha. Entry 0 is 0.
+				extern const ::std::uint32_t _Unpremultiply_factors[256];
+
+				inline ::std::uint8_t _Unpremultiply_channel(::std::uint8_t c, ::std::uint32_t factor) noexcept {
+					return static_cast<::std::uint8_t>(::std::min((c * factor + 32768u) >> 16, 255u));
+				}
+
+				// Describes how one pixel of a format is stored. Only formats that pack a pixel into whole bytes are supported.
+				template <::std::experimental::io2d::format Fmt>
+				struct pixel_traits;
+
+				template <>
+				struct pixel_traits<::std::experimental::io2d::format::argb32> {
+					typedef ::std::uint32_t value_type;
+					static rgba_pixel to_rgba(value_type v) noexcept {
+						auto a = static_cast<::std::uint8_t>(v >> 24);
+						auto factor = _Unpremultiply_factors[a];
+						return{ _Unpremultiply_channel(static_cast<::std::uint8_t>(v >> 16), factor), _Unpremultiply_channel(static_cast<::std::uint8_t>(v >> 8), factor), _Unpremultiply_channel(static_cast<::std::uint8_t>(v), factor), a };
+					}
+					static value_type from_rgba(rgba_pixel p) noexcept {
+						return (static_cast<value_type>(p.a) << 24) | (static_cast<value_type>(_Premultiply_channel(p.r, p.a)) << 16) | (static_cast<value_type>(_Premultiply_channel(p.g, p.a)) << 8) | _Premultiply_channel(p.b, p.a);
+					}
+				};
+
+				template <>
+				struct pixel_traits<::std::experimental::io2d::format::xrgb32> {
+					typedef ::std::uint32_t value_type;
+					static rgba_pixel to_rgba(value_type v) noexcept {
+						return{ static_cast<::std::uint8_t>(v >> 16), static_cast<::std::uint8_t>(v >> 8), static_cast<::std::uint8_t>(v), 255 };
+					}
+					static value_type from_rgba(rgba_pixel p) noexcept {
+						return (static_cast<value_type>(p.r) << 16) | (static_cast<value_type>(p.g) << 8) | p.b;
+					}
+				};
+
+				template <>
+				struct pixel_traits<::std::experimental::io2d::format::rgb16_565> {
+					typedef ::std::uint16_t value_type;
+					static rgba_pixel to_rgba(value_type v) noexcept {
+						auto r = static_cast<unsigned int>(v >> 11) & 0x1fu;
+						auto g = static_cast<unsigned int>(v >> 5) & 0x3fu;
+						auto b = static_cast<unsigned int>(v) & 0x1fu;
+						return{ static_cast<::std::uint8_t>((r << 3) | (r >> 2)), static_cast<::std::uint8_t>((g << 2) | (g >> 4)), static_cast<::std::uint8_t>((b << 3) | (b >> 2)), 255 };
+					}
+					static value_type from_rgba(rgba_pixel p) noexcept {
+						return static_cast<value_type>(((p.r >> 3) << 11) | ((p.g >> 2) << 5) | (p.b >> 3));
+					}
+				};
+
+				template <>
+				struct pixel_traits<::std::experimental::io2d::format::a8> {
+					typedef ::std::uint8_t value_type;
+					static rgba_pixel to_rgba(value_type v) noexcept {
+						return{ 0, 0, 0, v };
+					}
+					static value_type from_rgba(rgba_pixel p) noexcept {
+						return p.a;
+					}
+				};
+
+				template <::std::experimental::io2d::format Fmt>
+				class typed_pixel_row {
+				public:
+					typedef typename pixel_traits<Fmt>::value_type value_type;
+				private:
+					value_type* _Data;
+					int _Width;
+				public:
+					typed_pixel_row(value_type* data, int width) noexcept
+						: _Data(data)
+						, _Width(width) {
+					}
+
+					value_type* data() const noexcept {
+						return _Data;
+					}
+					int width() const noexcept {
+						return _Width;
+					}
+					value_type& operator[](int x) const noexcept {
+						return _Data[x];
+					}
+					rgba_pixel get(int x) const noexcept {
+						return pixel_traits<Fmt>::to_rgba(_Data[x]);
+					}
+					void set(int x, rgba_pixel p) const noexcept {
+						_Data[x] = pixel_traits<Fmt>::from_rgba(p);
+					}
+				};
+
+				// Views the pixels of a mapped_surface or pixel_view as values of Fmt's pixel type. Does not own them, so it must not outlive what it was made from.
+				template <::std::experimental::io2d::format Fmt>
+				class typed_pixel_view {
+					unsigned char* _Data;
+					int _Width;
+					int _Height;
+					int _Stride;
+
+					static void _Check_format(::std::experimental::io2d::format fmt) {
+						if (fmt != Fmt) {
+							throw ::std::system_error(::std::make_error_code(::std::errc::invalid_argument));
+						}
+					}
+				public:
+					typed_pixel_view(unsigned char* data, int width, int height, int stride) noexcept
+						: _Data(data)
+						, _Width(width)
+						, _Height(height)
+						, _Stride(stride) {
+					}
+					explicit typed_pixel_view(mapped_surface& ms)
+						: _Data(nullptr)
+						, _Width(ms.width())
+						, _Height(ms.height())
+						, _Stride(ms.stride()) {
+						_Check_format(ms.format());
+						_Data = ms.data();
+					}
+					explicit typed_pixel_view(pixel_view& pv)
+						: _Data(pv.data())
+						, _Width(pv.width())
+						, _Height(pv.height())
+						, _Stride(pv.stride()) {
+						_Check_format(pv.format());
+					}
+
+					typed_pixel_row<Fmt> row(int y) const noexcept {
+						return typed_pixel_row<Fmt>(reinterpret_cast<typename pixel_traits<Fmt>::value_type*>(_Data + static_cast<::std::ptrdiff_t>(y) * _Stride), _Width);
+					}
+					int width() const noexcept {
+						return _Width;
+					}
+					int height() const noexcept {
+						return _Height;
+					}
+					int stride() const noexcept {
+						return _Stride;
+					}
+				};
+
+				// Calls band(context, first_row, end_row) for disjoint bands of [0, height) covering all of it. With parallelism::parallel and enough pixels to be worth it, the bands run at once on the calling thread and io2d's worker threads; otherwise, and while the workers are busy with another call, the calling thread does [0, height) itself. Rethrows the first exception band throws once every band has finished.
+				void _Run_row_bands(int width, int height, parallelism p, void(*band)(void*, int, int), void* context);
+
+				template <class Action>
+				void _For_each_row_band(int width, int height, parallelism p, Action& action) {
+					_Run_row_bands(width, height, p, [](void* a, int first, int last) { (*static_cast<Action*>(a))(first, last); }, &action);
+				}
+
+				// The argb32 row kernels of convert_pixels, vectorized where the CPU allows it: unpremultiply count pixels into rgba_pixel values, or premultiply them back.
+				void _Argb32_to_rgba_pixels(const ::std::uint32_t* src, rgba_pixel* dest, int count) noexcept;
+				void _Rgba_pixels_to_argb32(const rgba_pixel* src, ::std::uint32_t* dest, int count) noexcept;
+
+				// action(typed_pixel_row<Fmt> row, int y) is called once per row; with parallelism::parallel, possibly for different rows at the same time.
+				template <::std::experimental::io2d::format Fmt, class Action>
+				void for_each_row(const typed_pixel_view<Fmt>& view, Action action, parallelism p = parallelism::sequential) {
+					auto band = [&view, &action](int first, int last) {
+						for (int y = first; y < last; ++y) {
+							action(view.row(y), y);
+						}
+					};
+					_For_each_row_band(view.width(), view.height(), p, band);
+				}
+
+				template <::std::experimental::io2d::format Fmt>
+				struct _Pixel_transform {
+					template <class Kernel>
+					static void _Row(typed_pixel_row<Fmt> row, Kernel& kernel) {
+						auto data = row.data();
+						for (int x = 0, w = row.width(); x < w; ++x) {
+							data[x] = pixel_traits<Fmt>::from_rgba(kernel(pixel_traits<Fmt>::to_rgba(data[x])));
+						}
+					}
+				};
+
+				template <>
+				struct _Pixel_transform<::std::experimental::io2d::format::argb32> {
+					template <class Kernel>
+					static void _Row(typed_pixel_row<::std::experimental::io2d::format::argb32> row, Kernel& kernel) {
+						// A stretch at a time through convert_pixels' kernels, which give the same results as pixel_traits.
+						const int chunk = 256;
+						rgba_pixel pixels[chunk];
+						for (int x = 0, w = row.width(); x < w; x += chunk) {
+							auto count = ::std::min(chunk, w - x);
+							_Argb32_to_rgba_pixels(row.data() + x, pixels, count);
+							for (int i = 0; i < count; ++i) {
+								pixels[i] = kernel(pixels[i]);
+							}
+							_Rgba_pixels_to_argb32(pixels, row.data() + x, count);
+						}
+					}
+				};
+
+				// Replaces every pixel p with kernel(p), where kernel takes and returns an rgba_pixel. Premultiplication is undone before and redone after calling kernel. With parallelism::parallel, kernel may run on several threads at once.
+				template <::std::experimental::io2d::format Fmt, class Kernel>
+				void transform_pixels(const typed_pixel_view<Fmt>& view, Kernel kernel, parallelism p = parallelism::sequential) {
+					for_each_row(view, [&kernel](typed_pixel_row<Fmt> row, int) {
+						_Pixel_transform<Fmt>::_Row(row, kernel);
+					}, p);
+				}
+
+				template <class Kernel>
+				void _Transform_pixels(unsigned char* data, ::std::experimental::io2d::format fmt, int width, int height, int stride, Kernel& kernel, parallelism p) {
+					switch (fmt) {
+					case ::std::experimental::io2d::format::argb32:
+						transform_pixels(typed_pixel_view<::std::experimental::io2d::format::argb32>(data, width, height, stride), kernel, p);
+						break;
+					case ::std::experimental::io2d::format::xrgb32:
+						transform_pixels(typed_pixel_view<::std::experimental::io2d::format::xrgb32>(data, width, height, stride), kernel, p);
+						break;
+					case ::std::experimental::io2d::format::rgb16_565:
+						transform_pixels(typed_pixel_view<::std::experimental::io2d::format::rgb16_565>(data, width, height, stride), kernel, p);
+						break;
+					case ::std::experimental::io2d::format::a8:
+						transform_pixels(typed_pixel_view<::std::experimental::io2d::format::a8>(data, width, height, stride), kernel, p);
+						break;
+					default:
+						throw ::std::system_error(::std::make_error_code(::std::errc::invalid_argument));
+					}
+				}
+
+				// As above, choosing the typed view from the surface's format; a1 and rgb30 are not supported.
+				template <class Kernel>
+				void transform_pixels(mapped_surface& ms, Kernel kernel, parallelism p = parallelism::sequential) {
+					_Transform_pixels(ms.data(), ms.format(), ms.width(), ms.height(), ms.stride(), kernel, p);
+				}
+
+				template <class Kernel>
+				void transform_pixels(pixel_view& pv, Kernel kernel, parallelism p = parallelism::sequential) {
+					_Transform_pixels(pv.data(), pv.format(), pv.width(), pv.height(), pv.stride(), kernel, p);
+				}
+
 #ifdef _WIN32_WINNT
 				struct _Win32_display_surface_native_handle {
 					_Surface_native_handles sfc_nh;
@@ -2335,6 +3322,37 @@ namespace std {
 					const double _Maximum_frame_rate = 120.0;
 					::std::unique_ptr<cairo_surface_t, ::std::function<void(cairo_surface_t*)>> _Native_surface;
 					::std::unique_ptr<cairo_t, ::std::function<void(cairo_t*)>> _Native_context;
+#if defined(USE_XCB) || defined(USE_XLIB)
+					// show() sleeps in poll() on the X connection and on this, which redraw_required() writes to so that it need not wait for the next X event. Both are -1 if it could not be created, in which case show() wakes up periodically instead. The same eventfd on Linux; a pipe elsewhere.
+					int _Wake_read_fd = -1;
+					int _Wake_write_fd = -1;
+
+					void _Open_wake_fds() noexcept;
+					void _Close_wake_fds() noexcept;
+					void _Take_wake_fds(display_surface& other) noexcept;
+					int _Show_wait_timeout() const noexcept;
+					void _Wait_for_input(int connectionFd, int timeoutMs) noexcept;
+#endif
+#if defined(USE_XCB)
+					// When MIT-SHM can be used, _Native_surface is an image surface in a shared memory segment that _Put_shm_image copies to the window, so frames do not go over the X socket. Null otherwise. Defined in display_surface-xcb.cpp.
+					struct _Shm_buffer;
+					static void _Shm_buffer_delete(_Shm_buffer* buffer) noexcept;
+					::std::unique_ptr<_Shm_buffer, void(*)(_Shm_buffer*)> _Shm{ nullptr, &_Shm_buffer_delete };
+
+					// Returns null, leaving _Shm null, when the server or the visual rules shared memory out.
+					cairo_surface_t* _Create_shm_native_surface(xcb_visualtype_t* visual) noexcept;
+					// Copies the parts of the segment inside _Native_context's clip to the window.
+					void _Put_shm_image() noexcept;
+					// Waits until the server has read the segment for the last _Put_shm_image, so that drawing into it cannot tear the frame being shown. The server says so with a ShmCompletion event; whatever arrives before it is kept in _Held_events.
+					void _Wait_for_shm_put();
+					// Events that _Wait_for_shm_put took off the connection, oldest first, for show() to handle before any newer ones. They outlive _Shm, which is replaced on every resize. Made when there is first one to hold, since making or moving a deque can allocate and display_surface's moves cannot throw.
+					::std::unique_ptr<::std::deque<::std::unique_ptr<xcb_generic_event_t, decltype(&::free)>>> _Held_events;
+					bool _Has_held_events() const noexcept {
+						return _Held_events != nullptr && !_Held_events->empty();
+					}
+					// Moves the next event, held or new, into event if it is empty. Returns whether there is one.
+					bool _Poll_for_event(::std::unique_ptr<xcb_generic_event_t, decltype(&::free)>& event);
+#endif
 
 					void _Make_native_surface_and_context();
 					void _Make_native_surface_and_context(::std::error_code& ec) noexcept;
@@ -2344,8 +3362,39 @@ namespace std {
 					void _Render_to_native_surface(::std::error_code& ec) noexcept;
 					void _Resize_window();
 					void _Resize_window(::std::error_code& ec) noexcept;
-					void _Render_for_scaling_uniform_or_letterbox();
-					void _Render_for_scaling_uniform_or_letterbox(::std::error_code& ec) noexcept;
+					// How _Render_to_native_surface presents the back buffer. The first group is what it was worked out from; the rest is only worked out again when one of those changes, not every frame.
+					struct _Presentation_state {
+						cairo_surface_t* _Source = nullptr;
+						int _Width = 0;
+						int _Height = 0;
+						int _Display_width = 0;
+						int _Display_height = 0;
+						::std::experimental::io2d::scaling _Scaling = ::std::experimental::io2d::scaling::letterbox;
+						bool _User_scaling = false;
+						::std::experimental::io2d::rectangle _User_rect;
+						bool _Letterbox = false;
+
+						// Maps the back buffer to the native surface.
+						cairo_matrix_t _Matrix;
+						// The back buffer, already set up with the inverse of _Matrix and the filter to draw it with.
+						::std::unique_ptr<cairo_pattern_t, decltype(&cairo_pattern_destroy)> _Pattern{ nullptr, &cairo_pattern_destroy };
+						// How far past the edges of the back buffer pixels it reads _Pattern's filter can land a native pixel's centre, in back buffer pixels: half a pixel for bilinear filtering, which reads the pixels whose centres are within one pixel, and none for copying.
+						double _Filter_radius = 0.0;
+						// Whether _Pattern is painted over the whole native surface or only fills _Picture.
+						bool _Paint = true;
+						_Damage_region::_Box _Picture;
+						// The parts of the native surface around _Picture that the letterbox brush fills.
+						_Damage_region::_Box _Bars[4];
+						int _Bar_count = 0;
+					};
+					_Presentation_state _Presentation;
+
+					// Brings _Presentation up to date, returning true if anything about it changed. userRect and letterbox are what the user scaling callback returned, if there is one.
+					bool _Update_presentation(const ::std::experimental::io2d::rectangle& userRect, bool letterbox) noexcept;
+					// The mapping from the back buffer to the native surface for the current scaling. userRect is only used when there is a user scaling callback.
+					void _Back_buffer_to_native_matrix(cairo_matrix_t& m, const ::std::experimental::io2d::rectangle& userRect) const noexcept;
+					// Clips _Native_context to the parts of it that show _Dirty_region.
+					void _Clip_native_to_damage() noexcept;
 
 				public:
 #ifdef _WIN32_WINNT
@@ -2440,7 +3489,15 @@ namespace std {
 #endif
 
 				class surface_brush_factory {
-					::std::unique_ptr<image_surface> _Surface;
+					// A copy-on-write snapshot of the surface this was given, which the brushes made from it share. Its pixels are only copied if that surface changes while the snapshot is alive.
+					::std::unique_ptr<cairo_surface_t, decltype(&cairo_surface_destroy)> _Snapshot{ nullptr, &cairo_surface_destroy };
+					::std::experimental::io2d::format _Format = ::std::experimental::io2d::format::invalid;
+					int _Width = 0;
+					int _Height = 0;
+					// What surface() returns. Only surfaces that cannot be snapshotted directly are copied into it up front; otherwise it is copied out of _Snapshot the first time surface() is called.
+					mutable ::std::unique_ptr<image_surface> _Surface;
+					// Guards _Surface in surface() const. Not moved: each factory has its own.
+					mutable ::std::mutex _Surface_mutex;
 
 					friend ::std::experimental::io2d::brush;
 
@@ -2507,6 +3564,12 @@ namespace std {
 				}
 #endif
 				int format_stride_for_width(format format, int width) noexcept;
+				// Convert width x height pixels between a surface format and an interchange format, undoing or applying premultiplication. Channels a format lacks read as 0 (alpha as 255) and are dropped when written; a1 keeps alpha >= 128.
+				// Each stride must leave room for width pixels. src and dest must not overlap unless they are the same buffer with the same stride and both formats use 4 bytes per pixel.
+				void convert_pixels(const unsigned char* src, int srcStride, format srcFormat, unsigned char* dest, int destStride, interchange_format destFormat, int width, int height, parallelism p = parallelism::sequential);
+				void convert_pixels(const unsigned char* src, int srcStride, format srcFormat, unsigned char* dest, int destStride, interchange_format destFormat, int width, int height, ::std::error_code& ec, parallelism p = parallelism::sequential) noexcept;
+				void convert_pixels(const unsigned char* src, int srcStride, interchange_format srcFormat, unsigned char* dest, int destStride, format destFormat, int width, int height, parallelism p = parallelism::sequential);
+				void convert_pixels(const unsigned char* src, int srcStride, interchange_format srcFormat, unsigned char* dest, int destStride, format destFormat, int width, int height, ::std::error_code& ec, parallelism p = parallelism::sequential) noexcept;
 				display_surface make_display_surface(int preferredWidth, int preferredHeight, format preferredFormat, scaling scl = scaling::letterbox, refresh_rate rr = refresh_rate::as_fast_as_possible, double desiredFramerate = 30.0);
 				display_surface make_display_surface(int preferredWidth, int preferredHeight, format preferredFormat, ::std::error_code& ec, scaling scl = scaling::letterbox, refresh_rate rr = refresh_rate::as_fast_as_possible, double desiredFramerate = 30.0) noexcept;
 				display_surface make_display_surface(int preferredWidth, int preferredHeight, format preferredFormat, int preferredDisplayWidth, int preferredDisplayHeight, scaling scl = scaling::letterbox, refresh_rate rr = refresh_rate::as_fast_as_possible, double desiredFramerate = 30.0);
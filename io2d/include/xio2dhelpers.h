@@ -194,6 +194,13 @@ namespace std {
 					return static_cast<int>(::std::trunc(value));
 				}
 
+				// The smallest box of whole pixels that covers the given device-space bounds. Clamped well inside int so that boxes can be added and intersected without overflow.
+				inline _Damage_region::_Box _Device_box_covering(double x0, double y0, double x1, double y1) noexcept {
+					const double limit = 1 << 30;
+					auto clampToLimit = [limit](double v) { return static_cast<int>(::std::max(-limit, ::std::min(limit, v))); };
+					return{ clampToLimit(::std::floor(x0)), clampToLimit(::std::floor(y0)), clampToLimit(::std::ceil(x1)), clampToLimit(::std::ceil(y1)) };
+				}
+
 				template <typename T>
 				inline int _Container_size_to_int(const T& container) noexcept{
 					assert(container.size() <= static_cast<unsigned int>(::std::numeric_limits<int>::max()));
@@ -215,10 +222,69 @@ namespace std {
 
 				void _Curve_to_extents(const ::std::experimental::io2d::vector_2d& pt0, const ::std::experimental::io2d::vector_2d& pt1, const ::std::experimental::io2d::vector_2d& pt2, const ::std::experimental::io2d::vector_2d& pt3, ::std::experimental::io2d::vector_2d& extents0, ::std::experimental::io2d::vector_2d& extents1) noexcept;
 
+				// Folds a path's origin into its matrix, so that _Origin_adjusted_matrix(matrix, origin).transform_point(pt) is matrix.transform_point(pt - origin) + origin. With a non-zero origin the two are equal only up to rounding, since the composed matrix rounds differently than subtracting and adding the origin around the transform does.
+				inline ::std::experimental::io2d::matrix_2d _Origin_adjusted_matrix(const ::std::experimental::io2d::matrix_2d& matrix, const ::std::experimental::io2d::vector_2d& origin) noexcept {
+					if (origin == ::std::experimental::io2d::vector_2d{ }) {
+						return matrix;
+					}
+					return ::std::experimental::io2d::matrix_2d::init_translate(-origin) * matrix * ::std::experimental::io2d::matrix_2d::init_translate(origin);
+				}
+
+#if defined(USE_AVX2)
+				// True if the CPU and OS support AVX2 and the IO2D_DISABLE environment variable does not list "avx2".
+				bool _Has_avx2() noexcept;
+				// From simd_avx2.cpp; see matrix_2d::transform_points.
+				void _Transform_points_avx2(const double* m, const double* pts, ::std::size_t count, double* out) noexcept;
+				// From simd_avx2.cpp; see convert_pixels. Convert the first width / 8 * 8 pixels of a row between argb32 and rgba8 (bgra8 if bgra is set), with the same results as format_conversion.cpp's other code, and return how many that was.
+				int _Argb32_to_interchange_avx2(const unsigned char* src, unsigned char* dest, int width, bool bgra) noexcept;
+				int _Interchange_to_argb32_avx2(const unsigned char* src, unsigned char* dest, int width, bool bgra) noexcept;
+#endif
+
 				inline double _Clamp_to_normal(double value) {
 					return ::std::max(::std::min(value, 1.0), 0.0);
 				}
 
+				// The number of bytes a row of width pixels actually occupies, without the padding cairo adds to strides.
+				inline int _Row_size(::std::experimental::io2d::format fmt, int width) noexcept {
+					switch (fmt) {
+					case ::std::experimental::io2d::format::a1:
+						return (width + 7) / 8;
+					case ::std::experimental::io2d::format::a8:
+						return width;
+					case ::std::experimental::io2d::format::rgb16_565:
+						return width * 2;
+					default:
+						return width * 4;
+					}
+				}
+
+				// Copies height rows between buffers whose strides may differ, e.g. when the source wraps caller memory with padded rows.
+				inline void _Copy_rows(unsigned char* dest, int destStride, const unsigned char* src, int srcStride, int height) noexcept {
+					if (destStride == srcStride) {
+						::std::memcpy(dest, src, static_cast<size_t>(height) * static_cast<size_t>(destStride));
+						return;
+					}
+					auto rowSize = static_cast<size_t>(::std::min(destStride, srcStride));
+					for (int y = 0; y < height; ++y) {
+						::std::memcpy(dest + static_cast<ptrdiff_t>(y) * destStride, src + static_cast<ptrdiff_t>(y) * srcStride, rowSize);
+					}
+				}
+
+				// The number of pixel_views and mapped_surfaces that can write to sfce's pixels without cairo seeing it. It is kept in sfce's user data, so it follows the cairo surface through moves of the surface that owns it.
+				inline const cairo_user_data_key_t* _Pixel_writer_key() noexcept {
+					static const cairo_user_data_key_t key{};
+					return &key;
+				}
+
+				inline int _Pixel_writer_count(cairo_surface_t* sfce) noexcept {
+					return static_cast<int>(reinterpret_cast<intptr_t>(cairo_surface_get_user_data(sfce, _Pixel_writer_key())));
+				}
+
+				// surface_brush_factory copies rather than snapshots a surface with writers, since their writes would reach a snapshot that shares its pixels.
+				inline void _Add_pixel_writer(cairo_surface_t* sfce, int delta) noexcept {
+					cairo_surface_set_user_data(sfce, _Pixel_writer_key(), reinterpret_cast<void*>(static_cast<intptr_t>(_Pixel_writer_count(sfce) + delta)), nullptr);
+				}
+
 				// Note: The resulting image_surface does not maintain its own memory store.
 				inline ::std::experimental::io2d::image_surface _Surface_create_image_surface_copy(::std::experimental::io2d::surface& original) {
 					if (!original._Has_surface_resource()) {
@@ -237,8 +303,9 @@ namespace std {
 					original.map([&data, &width, &height, &fmt, &stride](::std::experimental::io2d::mapped_surface& ms) -> void {
 						width = ms.width();
 						height = ms.height();
-						stride = ms.stride();
 						fmt = ms.format();
+						auto srcStride = ms.stride();
+						stride = ::std::experimental::io2d::format_stride_for_width(fmt, width);
 						auto size = static_cast<vector<unsigned char>::size_type>(height * stride);
 						data.resize(size);
 						switch (fmt)
@@ -246,22 +313,22 @@ namespace std {
 						case std::experimental::io2d::format::invalid:
 							throw invalid_argument("Unexpected surface format 'format::invalid'.");
 						case std::experimental::io2d::format::argb32:
-							::std::memcpy(data.data(), ms.data(), size);
+							_Copy_rows(data.data(), stride, ms.data(), srcStride, height);
 							break;
 						case std::experimental::io2d::format::xrgb32:
-							::std::memcpy(data.data(), ms.data(), size);
+							_Copy_rows(data.data(), stride, ms.data(), srcStride, height);
 							break;
 						case std::experimental::io2d::format::a8:
-							::std::memcpy(data.data(), ms.data(), size);
+							_Copy_rows(data.data(), stride, ms.data(), srcStride, height);
 							break;
 						case std::experimental::io2d::format::a1:
-							::std::memcpy(data.data(), ms.data(), size);
+							_Copy_rows(data.data(), stride, ms.data(), srcStride, height);
 							break;
 						case std::experimental::io2d::format::rgb16_565:
-							::std::memcpy(data.data(), ms.data(), size);
+							_Copy_rows(data.data(), stride, ms.data(), srcStride, height);
 							break;
 						case std::experimental::io2d::format::rgb30:
-							::std::memcpy(data.data(), ms.data(), size);
+							_Copy_rows(data.data(), stride, ms.data(), srcStride, height);
 							break;
 						default:
 							assert(false && "Unknown format enumerator.");
@@ -303,8 +370,9 @@ namespace std {
 					original.map([&data, &width, &height, &fmt, &stride, &ec](::std::experimental::io2d::mapped_surface& ms, ::std::error_code&) -> void {
 						width = ms.width();
 						height = ms.height();
-						stride = ms.stride();
 						fmt = ms.format();
+						auto srcStride = ms.stride();
+						stride = ::std::experimental::io2d::format_stride_for_width(fmt, width);
 						auto size = static_cast<vector<unsigned char>::size_type>(height * stride);
 						try {
 							data.resize(size);
@@ -323,22 +391,22 @@ namespace std {
 							ec = ::std::make_error_code(::std::errc::invalid_argument);
 							break;
 						case std::experimental::io2d::format::argb32:
-							::std::memcpy(data.data(), ms.data(ec), size);
+							_Copy_rows(data.data(), stride, ms.data(ec), srcStride, height);
 							break;
 						case std::experimental::io2d::format::xrgb32:
-							::std::memcpy(data.data(), ms.data(ec), size);
+							_Copy_rows(data.data(), stride, ms.data(ec), srcStride, height);
 							break;
 						case std::experimental::io2d::format::a8:
-							::std::memcpy(data.data(), ms.data(ec), size);
+							_Copy_rows(data.data(), stride, ms.data(ec), srcStride, height);
 							break;
 						case std::experimental::io2d::format::a1:
-							::std::memcpy(data.data(), ms.data(ec), size);
+							_Copy_rows(data.data(), stride, ms.data(ec), srcStride, height);
 							break;
 						case std::experimental::io2d::format::rgb16_565:
-							::std::memcpy(data.data(), ms.data(ec), size);
+							_Copy_rows(data.data(), stride, ms.data(ec), srcStride, height);
 							break;
 						case std::experimental::io2d::format::rgb30:
-							::std::memcpy(data.data(), ms.data(ec), size);
+							_Copy_rows(data.data(), stride, ms.data(ec), srcStride, height);
 							break;
 						default:
 							assert(false && "Unknown format enumerator.");
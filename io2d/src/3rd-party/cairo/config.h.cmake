@@ -5,3 +5,7 @@
 #cmakedefine CAIRO_HAS_PTHREAD 1
 #cmakedefine CAIRO_HAS_XCB_SURFACE 1
 #cmakedefine HAVE_INTEL_ATOMIC_PRIMITIVES @HAVE_INTEL_ATOMIC_PRIMITIVES@
+#cmakedefine SIZEOF_VOID_P @SIZEOF_VOID_P@
+#cmakedefine SIZEOF_INT @SIZEOF_INT@
+#cmakedefine SIZEOF_LONG @SIZEOF_LONG@
+#cmakedefine SIZEOF_LONG_LONG @SIZEOF_LONG_LONG@
@@ -47,6 +47,7 @@
 #include "cairo-default-context-private.h"
 #include "cairo-error-private.h"
 #include "cairo-freed-pool-private.h"
+#include "cairo-image-surface-inline.h"
 #include "cairo-path-private.h"
 #include "cairo-pattern-private.h"
 
@@ -1476,3 +1477,738 @@ _cairo_default_context_create (void *target)
 
     return &cr->base;
 }
+
+struct _cairo_compiled_path {
+    cairo_matrix_t ctm;
+    cairo_matrix_t device_transform;
+    cairo_path_fixed_t path;
+};
+
+static cairo_status_t
+_cairo_compiled_path_append (cairo_compiled_path_t	*compiled,
+			     cairo_gstate_t		*gstate,
+			     const cairo_path_t		*path)
+{
+    const cairo_path_data_t *p, *end;
+    cairo_status_t status;
+    double x[3], y[3];
+    int i, n;
+
+    end = &path->data[path->num_data];
+    for (p = &path->data[0]; p < end; p += p->header.length) {
+	switch (p->header.type) {
+	case CAIRO_PATH_MOVE_TO:
+	case CAIRO_PATH_LINE_TO:
+	    n = 1;
+	    break;
+	case CAIRO_PATH_CURVE_TO:
+	    n = 3;
+	    break;
+	case CAIRO_PATH_CLOSE_PATH:
+	    n = 0;
+	    break;
+	default:
+	    return _cairo_error (CAIRO_STATUS_INVALID_PATH_DATA);
+	}
+	if (unlikely (p->header.length < n + 1))
+	    return _cairo_error (CAIRO_STATUS_INVALID_PATH_DATA);
+
+	for (i = 0; i < n; i++) {
+	    x[i] = p[i + 1].point.x;
+	    y[i] = p[i + 1].point.y;
+	    _cairo_gstate_user_to_backend (gstate, &x[i], &y[i]);
+	}
+
+	switch (p->header.type) {
+	case CAIRO_PATH_MOVE_TO:
+	    status = _cairo_path_fixed_move_to (&compiled->path,
+						_cairo_fixed_from_double (x[0]),
+						_cairo_fixed_from_double (y[0]));
+	    break;
+	case CAIRO_PATH_LINE_TO:
+	    status = _cairo_path_fixed_line_to (&compiled->path,
+						_cairo_fixed_from_double (x[0]),
+						_cairo_fixed_from_double (y[0]));
+	    break;
+	case CAIRO_PATH_CURVE_TO:
+	    status = _cairo_path_fixed_curve_to (&compiled->path,
+						 _cairo_fixed_from_double (x[0]),
+						 _cairo_fixed_from_double (y[0]),
+						 _cairo_fixed_from_double (x[1]),
+						 _cairo_fixed_from_double (y[1]),
+						 _cairo_fixed_from_double (x[2]),
+						 _cairo_fixed_from_double (y[2]));
+	    break;
+	default:
+	    status = _cairo_path_fixed_close_path (&compiled->path);
+	    break;
+	}
+	if (unlikely (status))
+	    return status;
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/**
+ * cairo_compiled_path_create:
+ * @cr: a cairo context
+ * @path: the path to convert
+ *
+ * Converts @path to the form cairo_append_path() would leave in @cr
+ * after cairo_new_path(), using the current transformation of @cr, so
+ * that cairo_set_compiled_path() can later install it without
+ * converting each point again.
+ *
+ * Return value: the compiled path, to be freed with
+ * cairo_compiled_path_destroy(), or %NULL if @cr is in an error state
+ * or does not support compiled paths, if @path is invalid or if memory
+ * could not be allocated.
+ **/
+cairo_compiled_path_t *
+cairo_compiled_path_create (cairo_t		*cr,
+			    const cairo_path_t	*path)
+{
+    cairo_default_context_t *dcr = (cairo_default_context_t *) cr;
+    cairo_compiled_path_t *compiled;
+
+    if (unlikely (cr->status || cr->backend->type != CAIRO_TYPE_DEFAULT))
+	return NULL;
+
+    compiled = malloc (sizeof (cairo_compiled_path_t));
+    if (unlikely (compiled == NULL))
+	return NULL;
+
+    compiled->ctm = dcr->gstate->ctm;
+    compiled->device_transform = dcr->gstate->target->device_transform;
+    _cairo_path_fixed_init (&compiled->path);
+    if (unlikely (_cairo_compiled_path_append (compiled, dcr->gstate, path))) {
+	cairo_compiled_path_destroy (compiled);
+	return NULL;
+    }
+
+    return compiled;
+}
+
+/**
+ * cairo_compiled_path_destroy:
+ * @compiled: a compiled path, or %NULL
+ *
+ * Frees a path created by cairo_compiled_path_create().
+ **/
+void
+cairo_compiled_path_destroy (cairo_compiled_path_t *compiled)
+{
+    if (compiled == NULL)
+	return;
+
+    _cairo_path_fixed_fini (&compiled->path);
+    free (compiled);
+}
+
+/**
+ * cairo_set_compiled_path:
+ * @cr: a cairo context
+ * @compiled: a compiled path
+ *
+ * Replaces the current path of @cr with @compiled, provided that @cr
+ * still has the transformation @compiled was created with.
+ *
+ * Return value: %TRUE if the path was replaced, %FALSE if the
+ * transformation differs or the copy failed, in which case the caller
+ * should fall back to cairo_new_path() and cairo_append_path().
+ **/
+cairo_bool_t
+cairo_set_compiled_path (cairo_t			*cr,
+			 const cairo_compiled_path_t	*compiled)
+{
+    cairo_default_context_t *dcr = (cairo_default_context_t *) cr;
+
+    if (unlikely (cr->status || cr->backend->type != CAIRO_TYPE_DEFAULT))
+	return FALSE;
+
+    if (memcmp (&compiled->ctm, &dcr->gstate->ctm, sizeof (cairo_matrix_t)) ||
+	memcmp (&compiled->device_transform,
+		&dcr->gstate->target->device_transform,
+		sizeof (cairo_matrix_t)))
+	return FALSE;
+
+    _cairo_path_fixed_fini (dcr->path);
+    if (unlikely (_cairo_path_fixed_init_copy (dcr->path, &compiled->path))) {
+	_cairo_path_fixed_init (dcr->path);
+	return FALSE;
+    }
+
+    return TRUE;
+}
+
+static cairo_bool_t
+_cairo_blit_pixman_operator (cairo_operator_t op, pixman_op_t *pixman_op)
+{
+    switch (op) {
+    case CAIRO_OPERATOR_CLEAR: *pixman_op = PIXMAN_OP_CLEAR; return TRUE;
+    case CAIRO_OPERATOR_SOURCE: *pixman_op = PIXMAN_OP_SRC; return TRUE;
+    case CAIRO_OPERATOR_OVER: *pixman_op = PIXMAN_OP_OVER; return TRUE;
+    case CAIRO_OPERATOR_ATOP: *pixman_op = PIXMAN_OP_ATOP; return TRUE;
+    case CAIRO_OPERATOR_DEST_OVER: *pixman_op = PIXMAN_OP_OVER_REVERSE; return TRUE;
+    case CAIRO_OPERATOR_DEST_OUT: *pixman_op = PIXMAN_OP_OUT_REVERSE; return TRUE;
+    case CAIRO_OPERATOR_XOR: *pixman_op = PIXMAN_OP_XOR; return TRUE;
+    case CAIRO_OPERATOR_ADD: *pixman_op = PIXMAN_OP_ADD; return TRUE;
+    case CAIRO_OPERATOR_SATURATE: *pixman_op = PIXMAN_OP_SATURATE; return TRUE;
+    /* The unbounded operators, DEST and the blend modes are left to
+     * cairo's compositors, which treat some of them specially; these are
+     * the ones whose pixels have been checked to match. */
+    default: return FALSE;
+    }
+}
+
+/* What cairo_blit_surface_array() and cairo_fill_rectangle_array()
+ * draw into: the target's image, the whole pixel translation from user
+ * space to it, and the clip as whole pixel boxes. */
+typedef struct _cairo_direct_target {
+    cairo_image_surface_t *image;
+    int tx, ty;
+    const cairo_box_t *boxes;
+    int num_boxes;
+    cairo_box_t all;
+} cairo_direct_target_t;
+
+static cairo_int_status_t
+_cairo_direct_target_init (cairo_default_context_t	*cr,
+			   cairo_direct_target_t	*target)
+{
+    cairo_gstate_t *gstate = cr->gstate;
+    cairo_surface_t *surface = gstate->target;
+    const cairo_clip_t *clip = gstate->clip;
+
+    if (surface->status || surface->finished ||
+	! _cairo_surface_is_image (surface) ||
+	! _cairo_matrix_is_identity (&surface->device_transform) ||
+	! _cairo_matrix_is_integer_translation (&gstate->ctm,
+						&target->tx, &target->ty))
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    target->image = (cairo_image_surface_t *) surface;
+    if (_cairo_clip_is_all_clipped (clip))
+	return CAIRO_INT_STATUS_NOTHING_TO_DO;
+
+    if (clip == NULL) {
+	target->all.p1.x = target->all.p1.y = 0;
+	target->all.p2.x = _cairo_fixed_from_int (target->image->width);
+	target->all.p2.y = _cairo_fixed_from_int (target->image->height);
+	target->boxes = &target->all;
+	target->num_boxes = 1;
+    } else if (clip->path == NULL && clip->is_region && clip->num_boxes) {
+	target->boxes = clip->boxes;
+	target->num_boxes = clip->num_boxes;
+    } else {
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+    }
+
+    return CAIRO_INT_STATUS_SUCCESS;
+}
+
+/* The part of the user space rectangle at (@x, @y) that lies inside
+ * clip box @i, in device space. Returns %FALSE if there is none. */
+static cairo_bool_t
+_cairo_direct_target_clip (const cairo_direct_target_t	*target,
+			   int				 i,
+			   int				 x,
+			   int				 y,
+			   int				 width,
+			   int				 height,
+			   cairo_rectangle_int_t	*clipped)
+{
+    const cairo_box_t *box = &target->boxes[i];
+    /* In 64 bits, so that no translation and size can overflow before
+     * clipping brings them within the image. */
+    int64_t left = (int64_t) x + target->tx;
+    int64_t top = (int64_t) y + target->ty;
+    int64_t x0 = MAX (MAX (left, _cairo_fixed_integer_part (box->p1.x)), 0);
+    int64_t y0 = MAX (MAX (top, _cairo_fixed_integer_part (box->p1.y)), 0);
+    int64_t x1 = MIN (MIN (left + width, _cairo_fixed_integer_part (box->p2.x)), target->image->width);
+    int64_t y1 = MIN (MIN (top + height, _cairo_fixed_integer_part (box->p2.y)), target->image->height);
+
+    if (x0 >= x1 || y0 >= y1)
+	return FALSE;
+
+    clipped->x = (int) x0;
+    clipped->y = (int) y0;
+    clipped->width = (int) (x1 - x0);
+    clipped->height = (int) (y1 - y0);
+    return TRUE;
+}
+
+/* Composites onto the user space rectangle at (@x, @y), less whatever
+ * lies outside the clip. (@src_x, @src_y) is where the rectangle starts
+ * in @src. */
+static void
+_cairo_direct_target_composite (const cairo_direct_target_t	*target,
+				pixman_op_t			 op,
+				pixman_image_t			*src,
+				pixman_image_t			*mask,
+				int				 src_x,
+				int				 src_y,
+				int				 x,
+				int				 y,
+				int				 width,
+				int				 height)
+{
+    cairo_rectangle_int_t r;
+    int i;
+
+    for (i = 0; i < target->num_boxes; i++) {
+	if (! _cairo_direct_target_clip (target, i, x, y, width, height, &r))
+	    continue;
+
+	pixman_image_composite32 (op, src, mask, target->image->pixman_image,
+				  (int) (r.x - ((int64_t) x + target->tx)) + src_x,
+				  (int) (r.y - ((int64_t) y + target->ty)) + src_y,
+				  0, 0,
+				  r.x, r.y,
+				  r.width, r.height);
+    }
+}
+
+/* Stores @pixel in every pixel of the user space rectangle at (@x, @y)
+ * that lies inside the clip, as cairo's image compositor fills boxes
+ * that reduce to %CAIRO_OPERATOR_SOURCE. */
+static void
+_cairo_direct_target_fill (const cairo_direct_target_t	*target,
+			   uint32_t			 pixel,
+			   int				 x,
+			   int				 y,
+			   int				 width,
+			   int				 height)
+{
+    cairo_image_surface_t *image = target->image;
+    cairo_rectangle_int_t r;
+    int i;
+
+    for (i = 0; i < target->num_boxes; i++) {
+	if (! _cairo_direct_target_clip (target, i, x, y, width, height, &r))
+	    continue;
+
+	pixman_fill ((uint32_t *) image->data,
+		     image->stride / sizeof (uint32_t),
+		     PIXMAN_FORMAT_BPP (image->pixman_format),
+		     r.x, r.y, r.width, r.height, pixel);
+    }
+}
+
+static void
+_cairo_direct_target_fini (cairo_direct_target_t *target)
+{
+    target->image->base.is_clear = FALSE;
+    target->image->base.serial++;
+}
+
+/**
+ * cairo_blit_surface_array:
+ * @cr: a cairo context
+ * @source: the surface to copy from
+ * @op: the compositing operator
+ * @blits: the rectangles to copy, in drawing order
+ * @num_blits: the number of entries in @blits
+ *
+ * Composites each rectangle of @source described by @blits onto the
+ * target of @cr, in order, exactly as clipping to the rectangle and
+ * painting @source with the entry's alpha would, but straight through
+ * pixman: no pattern is set up and no sample is filtered. Whatever the
+ * operator, nothing outside the rectangles is touched. This is only
+ * possible when both surfaces are distinct image surfaces, the
+ * transformation is a whole pixel translation, the clip is made of
+ * whole pixels and every rectangle lies inside @source.
+ * %CAIRO_OPERATOR_CLEAR and %CAIRO_OPERATOR_SOURCE are further limited
+ * to entries without alpha. Entries with no area are skipped.
+ *
+ * This is an io2d addition; it is not part of upstream cairo.
+ *
+ * Return value: %TRUE if every rectangle was composited, %FALSE if
+ * nothing was done and the caller should draw the rectangles instead.
+ **/
+cairo_bool_t
+cairo_blit_surface_array (cairo_t		*cr,
+			  cairo_surface_t	*source,
+			  cairo_operator_t	 op,
+			  const cairo_blit_t	*blits,
+			  int			 num_blits)
+{
+    cairo_default_context_t *dcr = (cairo_default_context_t *) cr;
+    cairo_direct_target_t target;
+    cairo_image_surface_t *src;
+    cairo_int_status_t status;
+    pixman_image_t *src_image, *mask_image;
+    pixman_image_t *stack_masks[CAIRO_STACK_ARRAY_LENGTH (pixman_image_t *)];
+    pixman_image_t **masks;
+    pixman_op_t pixman_op;
+    double mask_alpha;
+    cairo_bool_t need_masks, drawn;
+    int i, num_masks;
+
+    if (unlikely (cr->status || cr->backend->type != CAIRO_TYPE_DEFAULT))
+	return FALSE;
+
+    if (source == NULL || source->status || source->finished ||
+	source == dcr->gstate->target ||
+	! _cairo_surface_is_image (source) ||
+	! _cairo_matrix_is_identity (&source->device_transform) ||
+	! _cairo_blit_pixman_operator (op, &pixman_op))
+	return FALSE;
+
+    src = (cairo_image_surface_t *) source;
+    need_masks = FALSE;
+    for (i = 0; i < num_blits; i++) {
+	const cairo_blit_t *b = &blits[i];
+
+	if (b->width <= 0 || b->height <= 0)
+	    continue;
+	need_masks |= ! CAIRO_ALPHA_IS_OPAQUE (b->alpha);
+	if (b->src_x < 0 || b->src_y < 0 ||
+	    b->src_x > src->width - b->width ||
+	    b->src_y > src->height - b->height)
+	    return FALSE;
+	/* cairo keeps what a mask leaves out for these two, but pixman's
+	 * CLEAR and SRC would clear it. */
+	if ((op == CAIRO_OPERATOR_CLEAR || op == CAIRO_OPERATOR_SOURCE) &&
+	    ! CAIRO_ALPHA_IS_OPAQUE (b->alpha))
+	    return FALSE;
+    }
+
+    status = _cairo_direct_target_init (dcr, &target);
+    if (status == CAIRO_INT_STATUS_NOTHING_TO_DO)
+	return TRUE;
+    if (status)
+	return FALSE;
+
+    /* A private image over the same pixels, so that whatever transform
+     * or filter an earlier pattern left on the surface's own image does
+     * not apply. */
+    src_image = pixman_image_create_bits (src->pixman_format,
+					  src->width, src->height,
+					  (uint32_t *) src->data, src->stride);
+    if (unlikely (src_image == NULL))
+	return FALSE;
+
+    /* Every mask is made before anything is drawn, so that running out
+     * of memory leaves the target as it was for the caller to draw the
+     * rectangles instead. An entry shares the mask of the one before
+     * it when their alphas are the same; opaque entries need none. */
+    masks = NULL;
+    num_masks = 0;
+    drawn = FALSE;
+    if (need_masks) {
+	masks = stack_masks;
+	if (num_blits > ARRAY_LENGTH (stack_masks)) {
+	    masks = _cairo_malloc_ab (num_blits, sizeof (pixman_image_t *));
+	    if (unlikely (masks == NULL)) {
+		pixman_image_unref (src_image);
+		return FALSE;
+	    }
+	}
+	mask_image = NULL;
+	mask_alpha = 1.;
+	for (i = 0; i < num_blits; i++) {
+	    const cairo_blit_t *b = &blits[i];
+
+	    masks[i] = NULL;
+	    num_masks = i + 1;
+	    if (b->width <= 0 || b->height <= 0 ||
+		CAIRO_ALPHA_IS_OPAQUE (b->alpha))
+		continue;
+
+	    /* The same mask cairo_paint_with_alpha() would use. */
+	    if (mask_image == NULL || b->alpha != mask_alpha) {
+		cairo_color_t color;
+		pixman_color_t pixman_color;
+
+		_cairo_color_init_rgba (&color, 0., 0., 0., b->alpha);
+		pixman_color.red = color.red_short;
+		pixman_color.green = color.green_short;
+		pixman_color.blue = color.blue_short;
+		pixman_color.alpha = color.alpha_short;
+		mask_image = pixman_image_create_solid_fill (&pixman_color);
+		mask_alpha = b->alpha;
+		if (unlikely (mask_image == NULL))
+		    break;
+		masks[i] = mask_image;
+	    } else {
+		masks[i] = pixman_image_ref (mask_image);
+	    }
+	}
+	if (unlikely (i < num_blits))
+	    goto unref_masks;
+    }
+
+    if (unlikely (_cairo_surface_begin_modification (&target.image->base)))
+	goto unref_masks;
+
+    for (i = 0; i < num_blits; i++) {
+	const cairo_blit_t *b = &blits[i];
+
+	if (b->width <= 0 || b->height <= 0 ||
+	    (CAIRO_ALPHA_IS_ZERO (b->alpha) && _cairo_operator_bounded_by_mask (op)))
+	    continue;
+
+	_cairo_direct_target_composite (&target, pixman_op,
+					src_image, masks != NULL ? masks[i] : NULL,
+					b->src_x, b->src_y,
+					b->dst_x, b->dst_y,
+					b->width, b->height);
+    }
+    _cairo_direct_target_fini (&target);
+    drawn = TRUE;
+
+unref_masks:
+    if (masks != NULL) {
+	for (i = 0; i < num_masks; i++) {
+	    if (masks[i] != NULL)
+		pixman_image_unref (masks[i]);
+	}
+	if (masks != stack_masks)
+	    free (masks);
+    }
+    pixman_image_unref (src_image);
+    return drawn;
+}
+
+/**
+ * cairo_blit_surface:
+ * @cr: a cairo context
+ * @source: the surface to copy from
+ * @op: the compositing operator
+ * @src_x: X coordinate of the rectangle in @source
+ * @src_y: Y coordinate of the rectangle in @source
+ * @width: width of the rectangle
+ * @height: height of the rectangle
+ * @dst_x: user space X coordinate the rectangle is copied to
+ * @dst_y: user space Y coordinate the rectangle is copied to
+ *
+ * Composites a single rectangle of @source onto the target of @cr. See
+ * cairo_blit_surface_array() for when this is possible.
+ *
+ * This is an io2d addition; it is not part of upstream cairo.
+ *
+ * Return value: %TRUE if the rectangle was composited, %FALSE if
+ * nothing was done and the caller should draw the rectangle instead.
+ **/
+cairo_bool_t
+cairo_blit_surface (cairo_t		*cr,
+		    cairo_surface_t	*source,
+		    cairo_operator_t	 op,
+		    int			 src_x,
+		    int			 src_y,
+		    int			 width,
+		    int			 height,
+		    int			 dst_x,
+		    int			 dst_y)
+{
+    cairo_blit_t blit;
+
+    if (width <= 0 || height <= 0)
+	return FALSE;
+
+    blit.src_x = src_x;
+    blit.src_y = src_y;
+    blit.width = width;
+    blit.height = height;
+    blit.dst_x = dst_x;
+    blit.dst_y = dst_y;
+    blit.alpha = 1.;
+    return cairo_blit_surface_array (cr, source, op, &blit, 1);
+}
+
+/* The color of @r, as cairo_set_source_rgba() would make it. */
+static void
+_cairo_color_rectangle_color (const cairo_color_rectangle_t	*r,
+			      cairo_color_t			*color)
+{
+    _cairo_color_init_rgba (color,
+			    _cairo_restrict_value (r->red, 0., 1.),
+			    _cairo_restrict_value (r->green, 0., 1.),
+			    _cairo_restrict_value (r->blue, 0., 1.),
+			    _cairo_restrict_value (r->alpha, 0., 1.));
+}
+
+/* @color as a pixel of @format, as the image compositor's
+ * color_to_pixel() makes it; %FALSE for formats it does not store
+ * solid colors in directly. */
+static cairo_bool_t
+_cairo_color_to_pixel (const cairo_color_t	*color,
+		       pixman_format_code_t	 format,
+		       uint32_t			*pixel)
+{
+    uint32_t c;
+
+    if (!(format == PIXMAN_a8r8g8b8     ||
+          format == PIXMAN_x8r8g8b8     ||
+          format == PIXMAN_a8b8g8r8     ||
+          format == PIXMAN_x8b8g8r8     ||
+          format == PIXMAN_b8g8r8a8     ||
+          format == PIXMAN_b8g8r8x8     ||
+          format == PIXMAN_r5g6b5       ||
+          format == PIXMAN_b5g6r5       ||
+          format == PIXMAN_a8))
+    {
+	return FALSE;
+    }
+
+    c = (color->alpha_short >> 8 << 24) |
+	(color->red_short >> 8 << 16) |
+	(color->green_short & 0xff00) |
+	(color->blue_short >> 8);
+
+    if (PIXMAN_FORMAT_TYPE (format) == PIXMAN_TYPE_ABGR) {
+	c = ((c & 0xff000000) >>  0) |
+	    ((c & 0x00ff0000) >> 16) |
+	    ((c & 0x0000ff00) >>  0) |
+	    ((c & 0x000000ff) << 16);
+    }
+
+    if (PIXMAN_FORMAT_TYPE (format) == PIXMAN_TYPE_BGRA) {
+	c = ((c & 0xff000000) >> 24) |
+	    ((c & 0x00ff0000) >>  8) |
+	    ((c & 0x0000ff00) <<  8) |
+	    ((c & 0x000000ff) << 24);
+    }
+
+    if (format == PIXMAN_a8) {
+	c = c >> 24;
+    } else if (format == PIXMAN_r5g6b5 || format == PIXMAN_b5g6r5) {
+	c = ((((c) >> 3) & 0x001f) |
+	     (((c) >> 5) & 0x07e0) |
+	     (((c) >> 8) & 0xf800));
+    }
+
+    *pixel = c;
+    return TRUE;
+}
+
+/* Whether filling with @color under @op stores the color itself, as
+ * the image compositor decides for its own solid fills. */
+static cairo_bool_t
+_cairo_fill_is_store (cairo_operator_t		 op,
+		      const cairo_color_t	*color)
+{
+    return op == CAIRO_OPERATOR_SOURCE || op == CAIRO_OPERATOR_CLEAR ||
+	   (op == CAIRO_OPERATOR_OVER && CAIRO_COLOR_IS_OPAQUE (color));
+}
+
+/**
+ * cairo_fill_rectangle_array:
+ * @cr: a cairo context
+ * @rects: the rectangles to fill, in drawing order
+ * @num_rects: the number of entries in @rects
+ *
+ * Fills each rectangle described by @rects with its color, in order,
+ * exactly as setting that color as the source and filling the
+ * rectangle would, but straight through pixman: no path is built. As in
+ * cairo's image compositor, a rectangle that %CAIRO_OPERATOR_SOURCE,
+ * %CAIRO_OPERATOR_CLEAR or an opaque color under %CAIRO_OPERATOR_OVER
+ * fills has its pixels stored directly; the rest are composited from a
+ * single one pixel source made for the whole call, so that nothing is
+ * allocated per rectangle. This is only possible when the target is an
+ * image surface whose format cairo stores solid colors in directly, the
+ * transformation is a whole pixel translation, the clip is made of
+ * whole pixels and the operator leaves the destination alone outside
+ * what is filled. Entries with no area are skipped.
+ *
+ * This is an io2d addition; it is not part of upstream cairo.
+ *
+ * Return value: %TRUE if every rectangle was filled, %FALSE if nothing
+ * was done and the caller should fill the rectangles instead.
+ **/
+cairo_bool_t
+cairo_fill_rectangle_array (cairo_t			*cr,
+			    const cairo_color_rectangle_t	*rects,
+			    int				 num_rects)
+{
+    cairo_default_context_t *dcr = (cairo_default_context_t *) cr;
+    cairo_operator_t op = dcr->gstate->op;
+    cairo_direct_target_t target;
+    cairo_int_status_t status;
+    pixman_image_t *src_image;
+    pixman_op_t pixman_op;
+    cairo_color_t color;
+    uint32_t pixel, src_pixel;
+    int i;
+
+    if (unlikely (cr->status || cr->backend->type != CAIRO_TYPE_DEFAULT))
+	return FALSE;
+
+    if (! _cairo_operator_bounded_by_mask (op) ||
+	! _cairo_blit_pixman_operator (op, &pixman_op))
+	return FALSE;
+
+    status = _cairo_direct_target_init (dcr, &target);
+    if (status == CAIRO_INT_STATUS_NOTHING_TO_DO)
+	return TRUE;
+    if (status)
+	return FALSE;
+
+    /* Black stands in for every color when checking the format; a
+     * format takes all colors directly or none. */
+    _cairo_color_init_rgba (&color, 0., 0., 0., 1.);
+    if (! _cairo_color_to_pixel (&color, target.image->pixman_format, &pixel))
+	return FALSE;
+
+    /* The source for colors that are not stored is made before anything
+     * is drawn, so that running out of memory leaves the target as it
+     * was for the caller to fill the rectangles instead. It repeats its
+     * one pixel, which pixman treats as a solid color, and the pixel is
+     * rewritten whenever the color changes. */
+    src_image = NULL;
+    src_pixel = 0;
+    for (i = 0; i < num_rects; i++) {
+	const cairo_color_rectangle_t *r = &rects[i];
+
+	if (r->width <= 0 || r->height <= 0)
+	    continue;
+
+	_cairo_color_rectangle_color (r, &color);
+	if (_cairo_fill_is_store (op, &color))
+	    continue;
+
+	src_image = pixman_image_create_bits (PIXMAN_a8r8g8b8, 1, 1,
+					      &src_pixel, sizeof (src_pixel));
+	if (unlikely (src_image == NULL))
+	    return FALSE;
+	pixman_image_set_repeat (src_image, PIXMAN_REPEAT_NORMAL);
+	break;
+    }
+
+    if (unlikely (_cairo_surface_begin_modification (&target.image->base))) {
+	if (src_image != NULL)
+	    pixman_image_unref (src_image);
+	return FALSE;
+    }
+
+    for (i = 0; i < num_rects; i++) {
+	const cairo_color_rectangle_t *r = &rects[i];
+
+	if (r->width <= 0 || r->height <= 0)
+	    continue;
+
+	_cairo_color_rectangle_color (r, &color);
+	if (_cairo_fill_is_store (op, &color)) {
+	    if (op == CAIRO_OPERATOR_CLEAR)
+		pixel = 0;
+	    else
+		_cairo_color_to_pixel (&color, target.image->pixman_format, &pixel);
+	    _cairo_direct_target_fill (&target, pixel,
+				       r->x, r->y, r->width, r->height);
+	} else {
+	    _cairo_color_to_pixel (&color, PIXMAN_a8r8g8b8, &src_pixel);
+	    _cairo_direct_target_composite (&target, pixman_op,
+					    src_image, NULL,
+					    0, 0,
+					    r->x, r->y,
+					    r->width, r->height);
+	}
+    }
+    _cairo_direct_target_fini (&target);
+
+    if (src_image != NULL)
+	pixman_image_unref (src_image);
+    return TRUE;
+}
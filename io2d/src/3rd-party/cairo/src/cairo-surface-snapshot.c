@@ -287,3 +287,27 @@ _cairo_surface_snapshot (cairo_surface_t *surface)
 
     return &snapshot->base;
 }
+
+/**
+ * cairo_surface_create_snapshot:
+ * @surface: a #cairo_surface_t
+ *
+ * Makes the copy-on-write snapshot that _cairo_surface_snapshot()
+ * describes available outside cairo. The result may only be used as a
+ * source. It shares the pixels of @surface until @surface is drawn to,
+ * flushed or destroyed, and only then takes a copy of them.
+ *
+ * This is an io2d addition; it is not part of upstream cairo.
+ *
+ * Return value: the snapshot, to be freed with cairo_surface_destroy().
+ * This function will not return %NULL, but will return a nil surface
+ * instead.
+ **/
+cairo_surface_t *
+cairo_surface_create_snapshot (cairo_surface_t *surface)
+{
+    if (surface == NULL)
+	return _cairo_surface_create_in_error (_cairo_error (CAIRO_STATUS_NULL_POINTER));
+
+    return _cairo_surface_snapshot (surface);
+}
@@ -2087,6 +2087,94 @@ cairo_append_path (cairo_t		*cr,
 cairo_public void
 cairo_path_destroy (cairo_path_t *path);
 
+/**
+ * cairo_compiled_path_t:
+ *
+ * A path that has already been converted to the fixed-point device
+ * space form a #cairo_t keeps its current path in. See
+ * cairo_compiled_path_create().
+ *
+ * This is an io2d addition; it is not part of upstream cairo.
+ **/
+typedef struct _cairo_compiled_path cairo_compiled_path_t;
+
+cairo_public cairo_compiled_path_t *
+cairo_compiled_path_create (cairo_t		*cr,
+			    const cairo_path_t	*path);
+
+cairo_public void
+cairo_compiled_path_destroy (cairo_compiled_path_t *compiled);
+
+cairo_public cairo_bool_t
+cairo_set_compiled_path (cairo_t			*cr,
+			 const cairo_compiled_path_t	*compiled);
+
+/**
+ * cairo_blit_t:
+ * @src_x: X coordinate of the rectangle in the source surface
+ * @src_y: Y coordinate of the rectangle in the source surface
+ * @width: width of the rectangle
+ * @height: height of the rectangle
+ * @dst_x: user space X coordinate the rectangle is copied to
+ * @dst_y: user space Y coordinate the rectangle is copied to
+ * @alpha: the opacity the rectangle is composited with
+ *
+ * One rectangle for cairo_blit_surface_array() to copy.
+ *
+ * This is an io2d addition; it is not part of upstream cairo.
+ **/
+typedef struct _cairo_blit {
+    int src_x, src_y;
+    int width, height;
+    int dst_x, dst_y;
+    double alpha;
+} cairo_blit_t;
+
+cairo_public cairo_bool_t
+cairo_blit_surface_array (cairo_t		*cr,
+			  cairo_surface_t	*source,
+			  cairo_operator_t	 op,
+			  const cairo_blit_t	*blits,
+			  int			 num_blits);
+
+cairo_public cairo_bool_t
+cairo_blit_surface (cairo_t		*cr,
+		    cairo_surface_t	*source,
+		    cairo_operator_t	 op,
+		    int			 src_x,
+		    int			 src_y,
+		    int			 width,
+		    int			 height,
+		    int			 dst_x,
+		    int			 dst_y);
+
+/**
+ * cairo_color_rectangle_t:
+ * @x: user space X coordinate of the rectangle
+ * @y: user space Y coordinate of the rectangle
+ * @width: width of the rectangle
+ * @height: height of the rectangle
+ * @red: red component of the color
+ * @green: green component of the color
+ * @blue: blue component of the color
+ * @alpha: alpha component of the color
+ *
+ * One rectangle for cairo_fill_rectangle_array() to fill, with its
+ * color given as for cairo_set_source_rgba().
+ *
+ * This is an io2d addition; it is not part of upstream cairo.
+ **/
+typedef struct _cairo_color_rectangle {
+    int x, y;
+    int width, height;
+    double red, green, blue, alpha;
+} cairo_color_rectangle_t;
+
+cairo_public cairo_bool_t
+cairo_fill_rectangle_array (cairo_t				*cr,
+			    const cairo_color_rectangle_t	*rects,
+			    int					 num_rects);
+
 /* Error status queries */
 
 cairo_public cairo_status_t
@@ -2208,6 +2296,10 @@ cairo_surface_create_for_rectangle (cairo_surface_t	*target,
                                     double		 width,
                                     double		 height);
 
+/* This is an io2d addition; it is not part of upstream cairo. */
+cairo_public cairo_surface_t *
+cairo_surface_create_snapshot (cairo_surface_t *surface);
+
 typedef enum {
 	CAIRO_SURFACE_OBSERVER_NORMAL = 0,
 	CAIRO_SURFACE_OBSERVER_RECORD_OPERATIONS = 0x1
@@ -0,0 +1,625 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* AVX2 versions of the unified OVER, SRC and ADD combiners, of the
+ * 32 bpp solid fill and of the bilinear a8r8g8b8 scaling fetcher.
+ * Everything else is delegated to the fallback implementation (normally
+ * SSSE3 or SSE2), so this file only needs to cover the operations that
+ * dominate cairo's fill/paint/mask and scaled image traffic.
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <immintrin.h>
+#include "pixman-private.h"
+#include "pixman-combine32.h"
+#include "pixman-inlines.h"
+
+static force_inline __m256i
+load_256_unaligned (const uint32_t *p)
+{
+    return _mm256_loadu_si256 ((const __m256i *)p);
+}
+
+static force_inline void
+save_256_unaligned (uint32_t *p, __m256i v)
+{
+    _mm256_storeu_si256 ((__m256i *)p, v);
+}
+
+/* Broadcast the alpha word of each unpacked pixel to all four of its
+ * 16 bit channels.
+ */
+static force_inline __m256i
+expand_alpha_16 (__m256i x)
+{
+    x = _mm256_shufflelo_epi16 (x, _MM_SHUFFLE (3, 3, 3, 3));
+    return _mm256_shufflehi_epi16 (x, _MM_SHUFFLE (3, 3, 3, 3));
+}
+
+/* (x * a + 0x80) / 255, rounded the same way as MUL_UN8. */
+static force_inline __m256i
+pix_multiply_16 (__m256i x, __m256i a)
+{
+    __m256i t = _mm256_adds_epu16 (_mm256_mullo_epi16 (x, a),
+				   _mm256_set1_epi16 (0x0080));
+    return _mm256_mulhi_epu16 (t, _mm256_set1_epi16 (0x0101));
+}
+
+/* Multiplies eight pixels by the alpha of the matching mask pixels. */
+static force_inline __m256i
+in_mask_8 (__m256i s, __m256i m)
+{
+    __m256i zero = _mm256_setzero_si256 ();
+    __m256i s_lo = _mm256_unpacklo_epi8 (s, zero);
+    __m256i s_hi = _mm256_unpackhi_epi8 (s, zero);
+    __m256i m_lo = expand_alpha_16 (_mm256_unpacklo_epi8 (m, zero));
+    __m256i m_hi = expand_alpha_16 (_mm256_unpackhi_epi8 (m, zero));
+
+    return _mm256_packus_epi16 (pix_multiply_16 (s_lo, m_lo),
+				pix_multiply_16 (s_hi, m_hi));
+}
+
+/* s + d * (255 - alpha (s)) for eight pixels. */
+static force_inline __m256i
+over_8 (__m256i s, __m256i d)
+{
+    __m256i zero = _mm256_setzero_si256 ();
+    __m256i ff = _mm256_set1_epi16 (0x00ff);
+    __m256i d_lo = _mm256_unpacklo_epi8 (d, zero);
+    __m256i d_hi = _mm256_unpackhi_epi8 (d, zero);
+    __m256i ia_lo = _mm256_xor_si256 (
+	expand_alpha_16 (_mm256_unpacklo_epi8 (s, zero)), ff);
+    __m256i ia_hi = _mm256_xor_si256 (
+	expand_alpha_16 (_mm256_unpackhi_epi8 (s, zero)), ff);
+
+    d = _mm256_packus_epi16 (pix_multiply_16 (d_lo, ia_lo),
+			     pix_multiply_16 (d_hi, ia_hi));
+    return _mm256_adds_epu8 (s, d);
+}
+
+static force_inline int
+is_opaque_8 (__m256i s)
+{
+    __m256i ff = _mm256_cmpeq_epi8 (s, _mm256_set1_epi32 (0xff000000));
+    return (_mm256_movemask_epi8 (ff) & 0x88888888) == 0x88888888;
+}
+
+static force_inline int
+is_zero_8 (__m256i s)
+{
+    return _mm256_testz_si256 (s, s);
+}
+
+static force_inline uint32_t
+combine1 (const uint32_t *ps, const uint32_t *pm)
+{
+    uint32_t s = *ps;
+
+    if (pm)
+    {
+	uint32_t ma = ALPHA_8 (*pm);
+
+	UN8x4_MUL_UN8 (s, ma);
+    }
+
+    return s;
+}
+
+static force_inline __m256i
+combine8 (const uint32_t *ps, const uint32_t *pm)
+{
+    __m256i s = load_256_unaligned (ps);
+
+    if (pm)
+	s = in_mask_8 (s, load_256_unaligned (pm));
+
+    return s;
+}
+
+static void
+avx2_combine_over_u (pixman_implementation_t *imp,
+                     pixman_op_t              op,
+                     uint32_t *               pd,
+                     const uint32_t *         ps,
+                     const uint32_t *         pm,
+                     int                      w)
+{
+    while (w >= 8)
+    {
+	__m256i s = combine8 (ps, pm);
+
+	if (is_opaque_8 (s))
+	    save_256_unaligned (pd, s);
+	else if (!is_zero_8 (s))
+	    save_256_unaligned (pd, over_8 (s, load_256_unaligned (pd)));
+
+	pd += 8;
+	ps += 8;
+	if (pm)
+	    pm += 8;
+	w -= 8;
+    }
+
+    while (w--)
+    {
+	uint32_t s = combine1 (ps, pm);
+	uint32_t ia = ALPHA_8 (~s);
+	uint32_t d = *pd;
+
+	UN8x4_MUL_UN8_ADD_UN8x4 (d, ia, s);
+	*pd++ = d;
+	ps++;
+	if (pm)
+	    pm++;
+    }
+}
+
+static void
+avx2_combine_src_u (pixman_implementation_t *imp,
+                    pixman_op_t              op,
+                    uint32_t *               pd,
+                    const uint32_t *         ps,
+                    const uint32_t *         pm,
+                    int                      w)
+{
+    if (!pm)
+    {
+	memcpy (pd, ps, w * sizeof (uint32_t));
+	return;
+    }
+
+    while (w >= 8)
+    {
+	save_256_unaligned (pd, combine8 (ps, pm));
+
+	pd += 8;
+	ps += 8;
+	pm += 8;
+	w -= 8;
+    }
+
+    while (w--)
+	*pd++ = combine1 (ps++, pm++);
+}
+
+static void
+avx2_combine_add_u (pixman_implementation_t *imp,
+                    pixman_op_t              op,
+                    uint32_t *               pd,
+                    const uint32_t *         ps,
+                    const uint32_t *         pm,
+                    int                      w)
+{
+    while (w >= 8)
+    {
+	save_256_unaligned (
+	    pd, _mm256_adds_epu8 (combine8 (ps, pm), load_256_unaligned (pd)));
+
+	pd += 8;
+	ps += 8;
+	if (pm)
+	    pm += 8;
+	w -= 8;
+    }
+
+    while (w--)
+    {
+	uint32_t s = combine1 (ps, pm);
+	uint32_t d = *pd;
+
+	UN8x4_ADD_UN8x4 (d, s);
+	*pd++ = d;
+	ps++;
+	if (pm)
+	    pm++;
+    }
+}
+
+static pixman_bool_t
+avx2_fill (pixman_implementation_t *imp,
+           uint32_t *               bits,
+           int                      stride,
+           int                      bpp,
+           int                      x,
+           int                      y,
+           int                      width,
+           int                      height,
+           uint32_t                 filler)
+{
+    __m256i def;
+    uint32_t *line;
+
+    /* 8 and 16 bpp destinations are rare enough that the SSE2 version
+     * in the fallback chain handles them.
+     */
+    if (bpp != 32)
+	return FALSE;
+
+    def = _mm256_set1_epi32 (filler);
+    line = bits + stride * y + x;
+
+    while (height--)
+    {
+	uint32_t *d = line;
+	int w = width;
+
+	line += stride;
+
+	while (w && ((uintptr_t)d & 31))
+	{
+	    *d++ = filler;
+	    w--;
+	}
+
+	while (w >= 32)
+	{
+	    _mm256_store_si256 ((__m256i *)(d),      def);
+	    _mm256_store_si256 ((__m256i *)(d + 8),  def);
+	    _mm256_store_si256 ((__m256i *)(d + 16), def);
+	    _mm256_store_si256 ((__m256i *)(d + 24), def);
+
+	    d += 32;
+	    w -= 32;
+	}
+
+	while (w >= 8)
+	{
+	    _mm256_store_si256 ((__m256i *)d, def);
+
+	    d += 8;
+	    w -= 8;
+	}
+
+	while (w--)
+	    *d++ = filler;
+    }
+
+    return TRUE;
+}
+
+/* The bilinear fetcher below produces exactly what the SSSE3 one in
+ * pixman-ssse3.c does: each 128 bit lane of the AVX2 code is one
+ * iteration of the SSSE3 loop, and the line buffers have the same
+ * layout, so the odd pixels at the ends are finished with the SSSE3
+ * steps.
+ */
+typedef struct
+{
+    int		y;
+    uint64_t *	buffer;
+} line_t;
+
+typedef struct
+{
+    line_t		lines[2];
+    pixman_fixed_t	y;
+    pixman_fixed_t	x;
+    uint64_t		data[1];
+} bilinear_info_t;
+
+static force_inline __m256i
+combine_128 (__m128i lo, __m128i hi)
+{
+    return _mm256_inserti128_si256 (_mm256_castsi128_si256 (lo), hi, 1);
+}
+
+/* Interleaves the left and right neighbours of two pixels and weights
+ * them; see ssse3_fetch_horizontal for the byte layout.
+ */
+static force_inline __m128i
+bilinear_horizontal_2 (__m128i vrl0, __m128i vrl1, __m128i vw)
+{
+    __m128i vr = _mm_unpacklo_epi16 (vrl1, vrl0);
+    __m128i s = _mm_shuffle_epi32 (vr, _MM_SHUFFLE (1, 0, 3, 2));
+
+    vr = _mm_unpackhi_epi8 (vr, s);
+
+    /* A zero weight makes the inverse weight 128, which maddubsw reads
+     * as -128; the absolute value puts the sign right.
+     */
+    return _mm_abs_epi16 (_mm_maddubs_epi16 (vr, _mm_packus_epi16 (vw, vw)));
+}
+
+static void
+avx2_fetch_horizontal (bits_image_t *image, line_t *line,
+		       int y, pixman_fixed_t x, pixman_fixed_t ux, int n)
+{
+    uint32_t *bits = image->bits + y * image->rowstride;
+    __m256i vx = _mm256_set_epi16 (
+	- (x + 2 * ux + 1), x + 2 * ux, - (x + 2 * ux + 1), x + 2 * ux,
+	- (x + 3 * ux + 1), x + 3 * ux, - (x + 3 * ux + 1), x + 3 * ux,
+	- (x + 1), x, - (x + 1), x,
+	- (x + ux + 1), x + ux,  - (x + ux + 1), x + ux);
+    __m256i vux = _mm256_set_epi16 (
+	- 4 * ux, 4 * ux, - 4 * ux, 4 * ux, - 4 * ux, 4 * ux, - 4 * ux, 4 * ux,
+	- 4 * ux, 4 * ux, - 4 * ux, 4 * ux, - 4 * ux, 4 * ux, - 4 * ux, 4 * ux);
+    __m256i vaddc = _mm256_set_epi16 (
+	1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0);
+    __m128i *b = (__m128i *)line->buffer;
+    __m128i vx2, vux2, vaddc2, vrl0, vrl1;
+
+    while ((n -= 4) >= 0)
+    {
+	__m256i vw, vr, s;
+
+	vrl0 = _mm_loadl_epi64 ((__m128i *)(bits + pixman_fixed_to_int (x)));
+	vrl1 = _mm_loadl_epi64 (
+	    (__m128i *)(bits + pixman_fixed_to_int (x + ux)));
+	vr = combine_128 (
+	    _mm_unpacklo_epi16 (vrl1, vrl0),
+	    _mm_unpacklo_epi16 (
+		_mm_loadl_epi64 (
+		    (__m128i *)(bits + pixman_fixed_to_int (x + 3 * ux))),
+		_mm_loadl_epi64 (
+		    (__m128i *)(bits + pixman_fixed_to_int (x + 2 * ux)))));
+
+	vw = _mm256_add_epi16 (
+	    vaddc, _mm256_srli_epi16 (vx, 16 - BILINEAR_INTERPOLATION_BITS));
+	vw = _mm256_packus_epi16 (vw, vw);
+	vx = _mm256_add_epi16 (vx, vux);
+
+	x += 4 * ux;
+
+	s = _mm256_shuffle_epi32 (vr, _MM_SHUFFLE (1, 0, 3, 2));
+	vr = _mm256_unpackhi_epi8 (vr, s);
+	vr = _mm256_abs_epi16 (_mm256_maddubs_epi16 (vr, vw));
+
+	_mm256_storeu_si256 ((__m256i *)b, vr);
+	b += 2;
+    }
+    n += 4;
+
+    /* At most three pixels are left; x has moved on with the loop, so
+     * the SSSE3 weights are rebuilt from it.
+     */
+    vx2 = _mm_set_epi16 (
+	- (x + 1), x, - (x + 1), x,
+	- (x + ux + 1), x + ux,  - (x + ux + 1), x + ux);
+    vux2 = _mm_set_epi16 (
+	- 2 * ux, 2 * ux, - 2 * ux, 2 * ux,
+	- 2 * ux, 2 * ux, - 2 * ux, 2 * ux);
+    vaddc2 = _mm_set_epi16 (1, 0, 1, 0, 1, 0, 1, 0);
+
+    while (n > 0)
+    {
+	vrl0 = _mm_loadl_epi64 ((__m128i *)(bits + pixman_fixed_to_int (x)));
+	vrl1 = n > 1 ?
+	    _mm_loadl_epi64 ((__m128i *)(bits + pixman_fixed_to_int (x + ux))) :
+	    _mm_setzero_si128 ();
+
+	_mm_store_si128 (b++, bilinear_horizontal_2 (
+	    vrl0, vrl1,
+	    _mm_add_epi16 (
+		vaddc2, _mm_srli_epi16 (vx2, 16 - BILINEAR_INTERPOLATION_BITS))));
+
+	vx2 = _mm_add_epi16 (vx2, vux2);
+	x += 2 * ux;
+	n -= 2;
+    }
+
+    line->y = y;
+}
+
+/* top + (bottom - top) * dist_y for the 16 bit channels of some
+ * interleaved pixel pairs, then back to 8 bits in pixel order.
+ */
+static force_inline __m256i
+bilinear_vertical_4 (__m256i top, __m256i bot, __m256i vw)
+{
+    __m256i r = _mm256_mulhi_epu16 (_mm256_sub_epi16 (bot, top), vw);
+    __m256i tmp = _mm256_and_si256 (_mm256_cmpgt_epi16 (top, bot), vw);
+
+    r = _mm256_add_epi16 (_mm256_sub_epi16 (r, tmp), top);
+    r = _mm256_srli_epi16 (r, BILINEAR_INTERPOLATION_BITS);
+    return _mm256_shuffle_epi32 (r, _MM_SHUFFLE (2, 0, 3, 1));
+}
+
+static force_inline __m128i
+bilinear_vertical_2 (__m128i top, __m128i bot, __m128i vw)
+{
+    __m128i r = _mm_mulhi_epu16 (_mm_sub_epi16 (bot, top), vw);
+    __m128i tmp = _mm_and_si128 (_mm_cmplt_epi16 (bot, top), vw);
+
+    r = _mm_add_epi16 (_mm_sub_epi16 (r, tmp), top);
+    r = _mm_srli_epi16 (r, BILINEAR_INTERPOLATION_BITS);
+    return _mm_shuffle_epi32 (r, _MM_SHUFFLE (2, 0, 3, 1));
+}
+
+static uint32_t *
+avx2_fetch_bilinear_cover (pixman_iter_t *iter, const uint32_t *mask)
+{
+    pixman_fixed_t fx, ux;
+    bilinear_info_t *info = iter->data;
+    line_t *line0, *line1;
+    int y0, y1;
+    int32_t dist_y;
+    __m256i vw;
+    int i;
+
+    fx = info->x;
+    ux = iter->image->common.transform->matrix[0][0];
+
+    y0 = pixman_fixed_to_int (info->y);
+    y1 = y0 + 1;
+
+    line0 = &info->lines[y0 & 0x01];
+    line1 = &info->lines[y1 & 0x01];
+
+    if (line0->y != y0)
+    {
+	avx2_fetch_horizontal (
+	    &iter->image->bits, line0, y0, fx, ux, iter->width);
+    }
+
+    if (line1->y != y1)
+    {
+	avx2_fetch_horizontal (
+	    &iter->image->bits, line1, y1, fx, ux, iter->width);
+    }
+
+    dist_y = pixman_fixed_to_bilinear_weight (info->y);
+    dist_y <<= (16 - BILINEAR_INTERPOLATION_BITS);
+
+    vw = _mm256_set1_epi16 (dist_y);
+
+    for (i = 0; i + 7 < iter->width; i += 8)
+    {
+	__m256i r0 = bilinear_vertical_4 (
+	    _mm256_loadu_si256 ((__m256i *)(line0->buffer + i)),
+	    _mm256_loadu_si256 ((__m256i *)(line1->buffer + i)), vw);
+	__m256i r1 = bilinear_vertical_4 (
+	    _mm256_loadu_si256 ((__m256i *)(line0->buffer + i + 4)),
+	    _mm256_loadu_si256 ((__m256i *)(line1->buffer + i + 4)), vw);
+
+	/* The pack works per lane, which leaves the pixel pairs in the
+	 * order 0, 2, 1, 3.
+	 */
+	_mm256_storeu_si256 (
+	    (__m256i *)(iter->buffer + i),
+	    _mm256_permute4x64_epi64 (
+		_mm256_packus_epi16 (r0, r1), _MM_SHUFFLE (3, 1, 2, 0)));
+    }
+
+    while (i < iter->width)
+    {
+	__m128i p = bilinear_vertical_2 (
+	    _mm_load_si128 ((__m128i *)(line0->buffer + i)),
+	    _mm_load_si128 ((__m128i *)(line1->buffer + i)),
+	    _mm256_castsi256_si128 (vw));
+
+	p = _mm_packus_epi16 (p, p);
+
+	if (iter->width - i == 1)
+	{
+	    *(uint32_t *)(iter->buffer + i) = _mm_cvtsi128_si32 (p);
+	    i++;
+	}
+	else
+	{
+	    _mm_storel_epi64 ((__m128i *)(iter->buffer + i), p);
+	    i += 2;
+	}
+    }
+
+    info->y += iter->image->common.transform->matrix[1][1];
+
+    return iter->buffer;
+}
+
+static void
+avx2_bilinear_cover_iter_fini (pixman_iter_t *iter)
+{
+    free (iter->data);
+}
+
+static void
+avx2_bilinear_cover_iter_init (pixman_iter_t *iter, const pixman_iter_info_t *iter_info)
+{
+    int width = iter->width;
+    bilinear_info_t *info;
+    pixman_vector_t v;
+
+    /* Reference point is the center of the pixel */
+    v.vector[0] = pixman_int_to_fixed (iter->x) + pixman_fixed_1 / 2;
+    v.vector[1] = pixman_int_to_fixed (iter->y) + pixman_fixed_1 / 2;
+    v.vector[2] = pixman_fixed_1;
+
+    if (!pixman_transform_point_3d (iter->image->common.transform, &v))
+	goto fail;
+
+    /* Each line holds one 64 bit entry per pixel, rounded up to a whole
+     * pixel pair, and starts on a 16 byte boundary.
+     */
+    info = malloc (sizeof (*info) + (2 * width + 1) * sizeof (uint64_t) + 64);
+    if (!info)
+	goto fail;
+
+    info->x = v.vector[0] - pixman_fixed_1 / 2;
+    info->y = v.vector[1] - pixman_fixed_1 / 2;
+
+#define ALIGN(addr)							\
+    ((void *)((((uintptr_t)(addr)) + 15) & (~15)))
+
+    /* It is safe to set the y coordinates to -1 initially
+     * because COVER_CLIP_BILINEAR ensures that we will only
+     * be asked to fetch lines in the [0, height) interval
+     */
+    info->lines[0].y = -1;
+    info->lines[0].buffer = ALIGN (&(info->data[0]));
+    info->lines[1].y = -1;
+    info->lines[1].buffer = ALIGN (info->lines[0].buffer + width + 1);
+
+    iter->get_scanline = avx2_fetch_bilinear_cover;
+    iter->fini = avx2_bilinear_cover_iter_fini;
+
+    iter->data = info;
+    return;
+
+fail:
+    /* Something went wrong, either a bad matrix or OOM; in such cases,
+     * we don't guarantee any particular rendering.
+     */
+    _pixman_log_error (
+	FUNC, "Allocation failure or bad matrix, skipping rendering\n");
+
+    iter->get_scanline = _pixman_iter_get_scanline_noop;
+    iter->fini = NULL;
+}
+
+static const pixman_iter_info_t avx2_iters[] =
+{
+    { PIXMAN_a8r8g8b8,
+      (FAST_PATH_STANDARD_FLAGS			|
+       FAST_PATH_SCALE_TRANSFORM		|
+       FAST_PATH_BILINEAR_FILTER		|
+       FAST_PATH_SAMPLES_COVER_CLIP_BILINEAR),
+      ITER_NARROW | ITER_SRC,
+      avx2_bilinear_cover_iter_init,
+      NULL, NULL
+    },
+
+    { PIXMAN_null },
+};
+
+static const pixman_fast_path_t avx2_fast_paths[] =
+{
+    { PIXMAN_OP_NONE },
+};
+
+pixman_implementation_t *
+_pixman_implementation_create_avx2 (pixman_implementation_t *fallback)
+{
+    pixman_implementation_t *imp = _pixman_implementation_create (fallback, avx2_fast_paths);
+
+    imp->combine_32[PIXMAN_OP_OVER] = avx2_combine_over_u;
+    imp->combine_32[PIXMAN_OP_SRC] = avx2_combine_src_u;
+    imp->combine_32[PIXMAN_OP_ADD] = avx2_combine_add_u;
+
+    imp->fill = avx2_fill;
+
+    imp->iter_info = avx2_iters;
+
+    return imp;
+}
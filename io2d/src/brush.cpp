@@ -5,16 +5,65 @@
 using namespace std;
 using namespace std::experimental::io2d;
 
+namespace {
+	struct _Shared_pattern {
+		cairo_pattern_t* pattern;
+		uint_least64_t version;
+
+		explicit _Shared_pattern(cairo_pattern_t* p) noexcept
+			: pattern(p)
+			, version(0) {
+		}
+		_Shared_pattern(const _Shared_pattern&) = delete;
+		_Shared_pattern& operator=(const _Shared_pattern&) = delete;
+		~_Shared_pattern() {
+			cairo_pattern_destroy(pattern);
+		}
+	};
+}
+
+uint_least64_t brush::_Next_version() noexcept {
+	static atomic<uint_least64_t> version{ 0 };
+	return ++version;
+}
+
+void brush::_Set_pattern(cairo_pattern_t* p) {
+	shared_ptr<_Shared_pattern> owner;
+	try {
+		owner = make_shared<_Shared_pattern>(p);
+	}
+	catch (...) {
+		cairo_pattern_destroy(p);
+		throw;
+	}
+	_Pattern_version = &owner->version;
+	// Aliases owner so that _Brush keeps handing out the pattern itself.
+	_Brush = shared_ptr<cairo_pattern_t>(owner, p);
+}
+
+void brush::_Configure_pattern() const noexcept {
+	if (*_Pattern_version != _Version) {
+		auto pattern = _Brush.get();
+		cairo_pattern_set_extend(pattern, _Extend_to_cairo_extend_t(_Extend));
+		cairo_pattern_set_filter(pattern, _Filter_to_cairo_filter_t(_Filter));
+		cairo_matrix_t cPttnMatrix;
+		cairo_matrix_init(&cPttnMatrix, _Matrix.m00(), _Matrix.m01(), _Matrix.m10(), _Matrix.m11(), _Matrix.m20(), _Matrix.m21());
+		cairo_pattern_set_matrix(pattern, &cPttnMatrix);
+		*_Pattern_version = _Version;
+	}
+}
+
 brush::native_handle_type brush::native_handle() const noexcept {
 	return _Brush.get();
 }
 
 brush::brush(brush::native_handle_type nh) noexcept
-	: _Brush(nh, &cairo_pattern_destroy)
+	: _Brush()
 	, _Brush_type(_Cairo_pattern_type_t_to_brush_type(cairo_pattern_get_type(nh)))
 	, _Extend(::std::experimental::io2d::extend::none)
 	, _Filter(::std::experimental::io2d::filter::good)
 	, _Matrix(matrix_2d::init_identity()) {
+	_Set_pattern(nh);
 }
 
 brush::brush(brush&& other) noexcept
@@ -22,7 +71,9 @@ brush::brush(brush&& other) noexcept
 	, _Brush_type(move(other._Brush_type))
 	, _Extend(move(other._Extend))
 	, _Filter(move(other._Filter))
-	, _Matrix(move(other._Matrix)) {
+	, _Matrix(move(other._Matrix))
+	, _Version(other._Version)
+	, _Pattern_version(other._Pattern_version) {
 	other._Brush = nullptr;
 }
 
@@ -33,6 +84,8 @@ brush& brush::operator=(brush&& other) noexcept {
 		_Extend = move(other._Extend);
 		_Filter = move(other._Filter);
 		_Matrix = move(other._Matrix);
+		_Version = other._Version;
+		_Pattern_version = other._Pattern_version;
 		other._Brush = nullptr;
 	}
 
@@ -46,7 +99,7 @@ brush::brush(const solid_color_brush_factory& f)
 , _Filter(::std::experimental::io2d::filter::good)
 , _Matrix(matrix_2d::init_identity()) {
 	auto color = f.color();
-	_Brush = shared_ptr<cairo_pattern_t>(cairo_pattern_create_rgba(color.r(), color.g(), color.b(), color.a()), &cairo_pattern_destroy);
+	_Set_pattern(cairo_pattern_create_rgba(color.r(), color.g(), color.b(), color.a()));
 	_Throw_if_failed_cairo_status_t(cairo_pattern_status(_Brush.get()));
 }
 
@@ -58,7 +111,7 @@ brush::brush(const solid_color_brush_factory& f, error_code& ec) noexcept
 	, _Matrix(matrix_2d::init_identity()) {
 	auto color = f.color();
 	try {
-		_Brush = shared_ptr<cairo_pattern_t>(cairo_pattern_create_rgba(color.r(), color.g(), color.b(), color.a()), &cairo_pattern_destroy);
+		_Set_pattern(cairo_pattern_create_rgba(color.r(), color.g(), color.b(), color.a()));
 	}
 	catch (const bad_alloc&) {
 		ec = make_error_code(errc::not_enough_memory);
@@ -82,7 +135,7 @@ brush::brush(const linear_brush_factory& f)
 	, _Matrix(matrix_2d::init_identity()) {
 	vector_2d lpt0 = f.begin_point();
 	vector_2d lpt1 = f.end_point();
-	_Brush = shared_ptr<cairo_pattern_t>(cairo_pattern_create_linear(lpt0.x(), lpt0.y(), lpt1.x(), lpt1.y()), &cairo_pattern_destroy);
+	_Set_pattern(cairo_pattern_create_linear(lpt0.x(), lpt0.y(), lpt1.x(), lpt1.y()));
 	_Throw_if_failed_cairo_status_t(cairo_pattern_status(_Brush.get()));
 
 	auto count = f.color_stop_count();
@@ -104,7 +157,7 @@ brush::brush(const linear_brush_factory& f, error_code& ec) noexcept
 	vector_2d lpt0 = f.begin_point();
 	vector_2d lpt1 = f.end_point();
 	try {
-		_Brush = shared_ptr<cairo_pattern_t>(cairo_pattern_create_linear(lpt0.x(), lpt0.y(), lpt1.x(), lpt1.y()), &cairo_pattern_destroy);
+		_Set_pattern(cairo_pattern_create_linear(lpt0.x(), lpt0.y(), lpt1.x(), lpt1.y()));
 	}
 	catch (const bad_alloc&) {
 		ec = make_error_code(errc::not_enough_memory);
@@ -146,7 +199,7 @@ brush::brush(const radial_brush_factory& f)
 	double& radius0 = get<1>(points);
 	vector_2d& center1 = get<2>(points);
 	double& radius1 = get<3>(points);
-	_Brush = shared_ptr<cairo_pattern_t>(cairo_pattern_create_radial(center0.x(), center0.y(), radius0, center1.x(), center1.y(), radius1), &cairo_pattern_destroy);
+	_Set_pattern(cairo_pattern_create_radial(center0.x(), center0.y(), radius0, center1.x(), center1.y(), radius1));
 	_Throw_if_failed_cairo_status_t(cairo_pattern_status(_Brush.get()));
 
 	auto count = f.color_stop_count();
@@ -171,7 +224,7 @@ brush::brush(const radial_brush_factory& f, error_code& ec) noexcept
 	vector_2d& center1 = get<2>(points);
 	double& radius1 = get<3>(points);
 	try {
-		_Brush = shared_ptr<cairo_pattern_t>(cairo_pattern_create_radial(center0.x(), center0.y(), radius0, center1.x(), center1.y(), radius1), &cairo_pattern_destroy);
+		_Set_pattern(cairo_pattern_create_radial(center0.x(), center0.y(), radius0, center1.x(), center1.y(), radius1));
 	}
 	catch (const bad_alloc&) {
 		ec = make_error_code(errc::not_enough_memory);
@@ -442,8 +495,8 @@ brush::brush(surface_brush_factory& f)
 	if (!f.has_surface()) {
 		_Throw_if_failed_cairo_status_t(CAIRO_STATUS_NULL_POINTER);
 	}
-	auto brushSurface = _Surface_create_image_surface_copy(*f._Surface.get());
-	_Brush = shared_ptr<cairo_pattern_t>(cairo_pattern_create_for_surface(brushSurface.native_handle().csfce), &cairo_pattern_destroy);
+	// The factory's snapshot already stands for the pixels the brush needs; sharing it copies nothing.
+	_Set_pattern(cairo_pattern_create_for_surface(f._Snapshot.get()));
 	_Throw_if_failed_cairo_status_t(cairo_pattern_status(_Brush.get()));
 }
 
@@ -453,18 +506,13 @@ brush::brush(surface_brush_factory& f, error_code& ec) noexcept
 	, _Extend(::std::experimental::io2d::extend::none)
 	, _Filter(::std::experimental::io2d::filter::good)
 	, _Matrix(matrix_2d::init_identity()) {
-	image_surface imgSfc{ format::argb32, 0, 0, ec };
-	if (static_cast<bool>(ec)) {
-		_Brush.reset();
-		return;
-	}
-	_Surface_create_image_surface_copy(*f._Surface.get(), imgSfc, ec);
-	if (static_cast<bool>(ec)) {
+	if (!f.has_surface()) {
 		_Brush.reset();
+		ec = _Cairo_status_t_to_std_error_code(CAIRO_STATUS_NULL_POINTER);
 		return;
 	}
 	try {
-		_Brush = shared_ptr<cairo_pattern_t>(cairo_pattern_create_for_surface(f.surface().native_handle().csfce), &cairo_pattern_destroy);
+		_Set_pattern(cairo_pattern_create_for_surface(f._Snapshot.get()));
 	}
 	catch (const ::std::bad_alloc&) {
 		_Brush.reset();
@@ -481,14 +529,17 @@ brush::brush(surface_brush_factory& f, error_code& ec) noexcept
 
 void brush::extend(::std::experimental::io2d::extend e) noexcept {
 	_Extend = e;
+	_Version = _Next_version();
 }
 
 void brush::filter(::std::experimental::io2d::filter f) noexcept {
 	_Filter = f;
+	_Version = _Next_version();
 }
 
 void brush::matrix(const matrix_2d& m) noexcept {
 	_Matrix = m;
+	_Version = _Next_version();
 }
 
 ::std::experimental::io2d::extend brush::extend() const noexcept {
@@ -4,6 +4,16 @@
 #include <sstream>
 #include <string>
 #include <iostream>
+#include <cmath>
+#if defined(USE_XCB) || defined(USE_XLIB)
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+#endif
 
 using namespace std;
 using namespace std::experimental;
@@ -15,210 +25,208 @@ void display_surface::_All_dimensions(int w, int h, int dw, int dh) {
 	display_dimensions(dw, dh);
 }
 
-// Note: cairo_surface_flush(_Native_surface.get()); must be called after calling this function.
-void display_surface::_Render_for_scaling_uniform_or_letterbox() {
-	const cairo_filter_t cairoFilter = CAIRO_FILTER_GOOD;
-	
-// 	static auto previousTime = steady_clock::now();
-
-	if (_Width == _Display_width && _Height == _Display_height) {
-		cairo_set_source_surface(_Native_context.get(), _Surface.get(), 0.0, 0.0);
-		cairo_paint(_Native_context.get());
+void display_surface::_Back_buffer_to_native_matrix(cairo_matrix_t& m, const experimental::io2d::rectangle& userRect) const noexcept {
+	cairo_matrix_init_identity(&m);
+	if (_User_scaling_fn != nullptr) {
+		cairo_matrix_init(&m, static_cast<double>(_Display_width) / userRect.width(), 0.0, 0.0, static_cast<double>(_Display_height) / userRect.height(), userRect.x(), userRect.y());
+		return;
 	}
-	else {
+	if (_Scaling == experimental::io2d::scaling::none || (_Width == _Display_width && _Height == _Display_height)) {
+		return;
+	}
+	const auto widthRatio = static_cast<double>(_Display_width) / static_cast<double>(_Width);
+	const auto heightRatio = static_cast<double>(_Display_height) / static_cast<double>(_Height);
+	switch (_Scaling) {
+	case experimental::io2d::scaling::letterbox:
+	case experimental::io2d::scaling::uniform:
+	{
 		const auto whRatio = static_cast<double>(_Width) / static_cast<double>(_Height);
 		const auto displayWHRatio = static_cast<double>(_Display_width) / static_cast<double>(_Display_height);
-		cairo_matrix_t ctm;
-		auto nativeContext = _Native_context.get();
-		//cairo_save(nativeContext);
-		double rectX, rectY, rectWidth, rectHeight;
 		if (whRatio < displayWHRatio) {
-			cairo_new_path(nativeContext);
-			const auto displayHeightAsDouble = static_cast<double>(_Display_height);
-			rectWidth = trunc(displayHeightAsDouble * whRatio);
-			rectHeight = displayHeightAsDouble;
-			rectX = trunc(abs(rectWidth - static_cast<double>(_Display_width)) / 2.0);
-			rectY = 0.0;
-			cairo_rectangle(nativeContext, rectX, rectY, rectWidth, rectHeight);
-
-			const auto heightRatio = static_cast<double>(_Height) / static_cast<double>(_Display_height);
-			cairo_matrix_init_scale(&ctm, heightRatio, heightRatio);
-			cairo_matrix_translate(&ctm, -rectX, 0.0);
-			unique_ptr<cairo_pattern_t, decltype(&cairo_pattern_destroy)> pat(cairo_pattern_create_for_surface(_Surface.get()), &cairo_pattern_destroy);
-			cairo_pattern_set_matrix(pat.get(), &ctm);
-			cairo_pattern_set_extend(pat.get(), CAIRO_EXTEND_NONE);
-			cairo_pattern_set_filter(pat.get(), cairoFilter);
-			cairo_set_source(_Native_context.get(), pat.get());
-			cairo_fill(_Native_context.get());
-			//cairo_restore(nativeContext);
-			if (_Scaling == std::experimental::io2d::scaling::letterbox) {
-				const auto lboxWidth = trunc((static_cast<double>(_Display_width) - rectWidth) / 2.0);
-				cairo_rectangle(nativeContext, 0.0, 0.0, lboxWidth, rectHeight);
-				cairo_rectangle(nativeContext, rectWidth + lboxWidth, 0.0, lboxWidth, rectHeight);
-				cairo_pattern_set_extend(_Letterbox_brush.native_handle(), _Extend_to_cairo_extend_t(_Letterbox_brush.extend()));
-				cairo_pattern_set_filter(_Letterbox_brush.native_handle(), _Filter_to_cairo_filter_t(_Letterbox_brush.filter()));
-				cairo_matrix_t cPttnMatrix;
-				cairo_matrix_init(&cPttnMatrix, _Letterbox_brush.matrix().m00(), _Letterbox_brush.matrix().m01(), _Letterbox_brush.matrix().m10(), _Letterbox_brush.matrix().m11(), _Letterbox_brush.matrix().m20(), _Letterbox_brush.matrix().m21());
-				cairo_pattern_set_matrix(_Letterbox_brush.native_handle(), &cPttnMatrix);
-				cairo_set_source(_Native_context.get(), _Letterbox_brush.native_handle());
-				cairo_fill(_Native_context.get());
-			}
+			const auto rectX = trunc(abs(trunc(static_cast<double>(_Display_height) * whRatio) - static_cast<double>(_Display_width)) / 2.0);
+			cairo_matrix_init(&m, heightRatio, 0.0, 0.0, heightRatio, rectX, 0.0);
+		}
+		else {
+			const auto rectY = trunc(abs(trunc(static_cast<double>(_Display_width) / whRatio) - static_cast<double>(_Display_height)) / 2.0);
+			cairo_matrix_init(&m, widthRatio, 0.0, 0.0, widthRatio, 0.0, rectY);
+		}
+	} break;
+	case experimental::io2d::scaling::fill_uniform:
+	{
+		if (widthRatio < heightRatio) {
+			cairo_matrix_init(&m, heightRatio, 0.0, 0.0, heightRatio, -trunc(abs(static_cast<double>(_Display_width - (_Width * heightRatio)) / 2.0)), 0.0);
 		}
 		else {
-			cairo_new_path(nativeContext);
-			const auto displayWidthAsDouble = static_cast<double>(_Display_width);
-			rectWidth = displayWidthAsDouble;
-			rectHeight = trunc(displayWidthAsDouble / whRatio);
-			rectX = 0.0;
-			rectY = trunc(abs(rectHeight - static_cast<double>(_Display_height)) / 2.0);
-			cairo_rectangle(nativeContext, rectX, rectY, rectWidth, rectHeight);
-
-			const auto widthRatio = static_cast<double>(_Width) / static_cast<double>(_Display_width);
-			cairo_matrix_init_scale(&ctm, widthRatio, widthRatio);
-			cairo_matrix_translate(&ctm, 0.0, -rectY);
-			unique_ptr<cairo_pattern_t, decltype(&cairo_pattern_destroy)> pat(cairo_pattern_create_for_surface(_Surface.get()), &cairo_pattern_destroy);
-			cairo_pattern_set_matrix(pat.get(), &ctm);
-			cairo_pattern_set_extend(pat.get(), CAIRO_EXTEND_NONE);
-			cairo_pattern_set_filter(pat.get(), cairoFilter);
-			cairo_set_source(_Native_context.get(), pat.get());
-			cairo_fill(_Native_context.get());
-			//cairo_restore(nativeContext);
-			if (_Scaling == std::experimental::io2d::scaling::letterbox) {
-				const auto lboxHeight = trunc((static_cast<double>(_Display_height) - rectHeight) / 2.0);
-				cairo_rectangle(nativeContext, 0.0, 0.0, rectWidth, lboxHeight);
-				cairo_rectangle(nativeContext, 0.0, rectHeight + lboxHeight, rectWidth, lboxHeight);
-				cairo_pattern_set_extend(_Letterbox_brush.native_handle(), _Extend_to_cairo_extend_t(_Letterbox_brush.extend()));
-				cairo_pattern_set_filter(_Letterbox_brush.native_handle(), _Filter_to_cairo_filter_t(_Letterbox_brush.filter()));
-				cairo_matrix_t cPttnMatrix;
-				cairo_matrix_init(&cPttnMatrix, _Letterbox_brush.matrix().m00(), _Letterbox_brush.matrix().m01(), _Letterbox_brush.matrix().m10(), _Letterbox_brush.matrix().m11(), _Letterbox_brush.matrix().m20(), _Letterbox_brush.matrix().m21());
-				cairo_pattern_set_matrix(_Letterbox_brush.native_handle(), &cPttnMatrix);
-				cairo_set_source(_Native_context.get(), _Letterbox_brush.native_handle());
-				cairo_fill(_Native_context.get());
-			}
+			cairo_matrix_init(&m, widthRatio, 0.0, 0.0, widthRatio, 0.0, -trunc(abs(static_cast<double>(_Display_height - (_Height * widthRatio)) / 2.0)));
 		}
+	} break;
+	case experimental::io2d::scaling::fill_exact:
+	{
+		cairo_matrix_init_scale(&m, widthRatio, heightRatio);
+	} break;
+	default:
+		break;
 	}
+}
 
-// 	auto currentTime = steady_clock::now();
-// 	auto elapsedTimeIncrement = static_cast<double>(duration_cast<nanoseconds>(currentTime - previousTime).count());
-// 	previousTime = currentTime;
-// 	stringstream timingStr;
-// 	timingStr << "timing: " << elapsedTimeIncrement / 1'000'000.0 << endl;
-// 	cerr << timingStr.str().c_str();
+bool display_surface::_Update_presentation(const experimental::io2d::rectangle& userRect, bool letterbox) noexcept {
+	auto& p = _Presentation;
+	const bool userScaling = _User_scaling_fn != nullptr;
+	if (p._Pattern != nullptr && p._Source == _Surface.get() && p._Width == _Width && p._Height == _Height && p._Display_width == _Display_width && p._Display_height == _Display_height && p._User_scaling == userScaling) {
+		if (userScaling ? (userRect.x() == p._User_rect.x() && userRect.y() == p._User_rect.y() && userRect.width() == p._User_rect.width() && userRect.height() == p._User_rect.height() && letterbox == p._Letterbox) : _Scaling == p._Scaling) {
+			return false;
+		}
+	}
+	p._Source = _Surface.get();
+	p._Width = _Width;
+	p._Height = _Height;
+	p._Display_width = _Display_width;
+	p._Display_height = _Display_height;
+	p._Scaling = _Scaling;
+	p._User_scaling = userScaling;
+	p._User_rect = userRect;
+	p._Letterbox = letterbox;
+
+	_Back_buffer_to_native_matrix(p._Matrix, userRect);
+	const bool unscaled = p._Matrix.xx == 1.0 && p._Matrix.yx == 0.0 && p._Matrix.xy == 0.0 && p._Matrix.yy == 1.0 && p._Matrix.x0 == 0.0 && p._Matrix.y0 == 0.0;
+	p._Pattern.reset(cairo_pattern_create_for_surface(_Surface.get()));
+	cairo_matrix_t patternMatrix = p._Matrix;
+	if (cairo_matrix_invert(&patternMatrix) == CAIRO_STATUS_SUCCESS) {
+		// cairo gives pixman the matrix in 16.16 fixed point, adjusting its translation so that the two agree in the middle of
+		// the area being drawn. Unless the entries are exact in fixed point that adjustment depends on the area, so a present
+		// clipped to damage would filter differently from a whole one. With 15 fractional bits they stay exact even when
+		// multiplied by the half-pixel centres cairo and pixman use.
+		const double grid = 32768.0;
+		for (auto entry : { &patternMatrix.xx, &patternMatrix.yx, &patternMatrix.xy, &patternMatrix.yy, &patternMatrix.x0, &patternMatrix.y0 }) {
+			*entry = round(*entry * grid) / grid;
+		}
+		cairo_matrix_t snapped = patternMatrix;
+		if (cairo_matrix_invert(&snapped) == CAIRO_STATUS_SUCCESS) {
+			p._Matrix = snapped;
+			cairo_pattern_set_matrix(p._Pattern.get(), &patternMatrix);
+		}
+	}
+	cairo_pattern_set_extend(p._Pattern.get(), CAIRO_EXTEND_NONE);
+	// With nothing to scale, presenting is a straight copy. This cairo draws CAIRO_FILTER_GOOD with pixman's bilinear filter.
+	cairo_pattern_set_filter(p._Pattern.get(), unscaled ? CAIRO_FILTER_FAST : CAIRO_FILTER_GOOD);
+	p._Filter_radius = unscaled ? 0.0 : 0.5;
+
+	p._Paint = true;
+	p._Bar_count = 0;
+	const bool fitted = !userScaling && !unscaled && (_Scaling == experimental::io2d::scaling::letterbox || _Scaling == experimental::io2d::scaling::uniform);
+	if (!fitted && !(userScaling && letterbox)) {
+		return true;
+	}
+	double x0 = 0.0;
+	double y0 = 0.0;
+	double x1 = static_cast<double>(_Width);
+	double y1 = static_cast<double>(_Height);
+	cairo_matrix_transform_point(&p._Matrix, &x0, &y0);
+	cairo_matrix_transform_point(&p._Matrix, &x1, &y1);
+	if (fitted) {
+		// Whole pixels, as the letterbox and uniform scaling have always used.
+		p._Picture = { static_cast<int>(trunc(x0)), static_cast<int>(trunc(y0)), static_cast<int>(trunc(x1)), static_cast<int>(trunc(y1)) };
+	}
+	else {
+		p._Picture = _Device_box_covering(min(x0, x1), min(y0, y1), max(x0, x1), max(y0, y1));
+	}
+	p._Picture.x0 = max(p._Picture.x0, 0);
+	p._Picture.y0 = max(p._Picture.y0, 0);
+	p._Picture.x1 = max(min(p._Picture.x1, _Display_width), p._Picture.x0);
+	p._Picture.y1 = max(min(p._Picture.y1, _Display_height), p._Picture.y0);
+	p._Paint = false;
+	if (_Scaling == experimental::io2d::scaling::uniform && !userScaling) {
+		return true;
+	}
+	const auto& pic = p._Picture;
+	const _Damage_region::_Box bars[4] = {
+		{ 0, 0, _Display_width, pic.y0 },
+		{ 0, pic.y1, _Display_width, _Display_height },
+		{ 0, pic.y0, pic.x0, pic.y1 },
+		{ pic.x1, pic.y0, _Display_width, pic.y1 }
+	};
+	for (const auto& bar : bars) {
+		if (bar.x0 < bar.x1 && bar.y0 < bar.y1) {
+			p._Bars[p._Bar_count++] = bar;
+		}
+	}
+	return true;
+}
+
+void display_surface::_Clip_native_to_damage() noexcept {
+	auto context = _Native_context.get();
+	cairo_reset_clip(context);
+	if (_Dirty_region._Is_everything()) {
+		return;
+	}
+	const auto& m = _Presentation._Matrix;
+	const auto radius = _Presentation._Filter_radius;
+	cairo_new_path(context);
+	for (int i = 0; i < _Dirty_region._Box_count(); i++) {
+		const auto& b = _Dirty_region._Box_at(i);
+		// A native pixel changes if its centre lands within the filter's reach of a damaged pixel. The padded box is not
+		// clipped to the back buffer, since the native pixels just outside the picture read its edge.
+		double x0 = b.x0 - radius;
+		double y0 = b.y0 - radius;
+		double x1 = b.x1 + radius;
+		double y1 = b.y1 + radius;
+		cairo_matrix_transform_point(&m, &x0, &y0);
+		cairo_matrix_transform_point(&m, &x1, &y1);
+		auto nativeBox = _Device_box_covering(min(x0, x1), min(y0, y1), max(x0, x1), max(y0, y1));
+		cairo_rectangle(context, nativeBox.x0, nativeBox.y0, nativeBox.x1 - nativeBox.x0, nativeBox.y1 - nativeBox.y0);
+	}
+	cairo_clip(context);
 }
 
 void display_surface::_Render_to_native_surface() {
-	const cairo_filter_t cairoFilter = CAIRO_FILTER_GOOD;
 	cairo_surface_flush(_Surface.get());
-// 	cairo_save(_Native_context.get());
-	cairo_set_operator(_Native_context.get(), CAIRO_OPERATOR_SOURCE);
+	bool letterbox = false;
+	experimental::io2d::rectangle userRect;
 	if (_User_scaling_fn != nullptr) {
-		bool letterbox = false;
-		auto userRect = _User_scaling_fn(*this, letterbox);
-		if (letterbox) {
-			cairo_pattern_set_extend(_Letterbox_brush.native_handle(), _Extend_to_cairo_extend_t(_Letterbox_brush.extend()));
-			cairo_pattern_set_filter(_Letterbox_brush.native_handle(), _Filter_to_cairo_filter_t(_Letterbox_brush.filter()));
-			cairo_matrix_t cPttnMatrix;
-			cairo_matrix_init(&cPttnMatrix, _Letterbox_brush.matrix().m00(), _Letterbox_brush.matrix().m01(), _Letterbox_brush.matrix().m10(), _Letterbox_brush.matrix().m11(), _Letterbox_brush.matrix().m20(), _Letterbox_brush.matrix().m21());
-			cairo_pattern_set_matrix(_Letterbox_brush.native_handle(), &cPttnMatrix);
-			cairo_set_source(_Native_context.get(), _Letterbox_brush.native_handle());
-			cairo_paint(_Native_context.get());
+		userRect = _User_scaling_fn(*this, letterbox);
+	}
+	if (_Update_presentation(userRect, letterbox)) {
+		_Dirty_region._Add_everything();
+	}
+	if (_Dirty_region._Is_empty()) {
+		// Nothing has been drawn since the last time, so the native surface already shows the back buffer.
+		return;
+	}
+#if defined(USE_XCB)
+	_Wait_for_shm_put();
+#endif
+	auto context = _Native_context.get();
+	_Clip_native_to_damage();
+	cairo_set_operator(context, CAIRO_OPERATOR_SOURCE);
+	// Damage never reaches past _Picture into the bars, so they only need filling when everything is presented again, as after a resize or an expose.
+	if (_Presentation._Bar_count != 0 && _Dirty_region._Is_everything()) {
+		cairo_new_path(context);
+		for (int i = 0; i < _Presentation._Bar_count; i++) {
+			const auto& bar = _Presentation._Bars[i];
+			cairo_rectangle(context, bar.x0, bar.y0, bar.x1 - bar.x0, bar.y1 - bar.y0);
 		}
-		cairo_matrix_t ctm;
-		cairo_matrix_init_scale(&ctm, 1.0 / (static_cast<double>(_Display_width) / userRect.width()), 1.0 / (static_cast<double>(_Display_height) / userRect.height()));
-		cairo_matrix_translate(&ctm, -userRect.x(), -userRect.y());
-		unique_ptr<cairo_pattern_t, decltype(&cairo_pattern_destroy)> pat(cairo_pattern_create_for_surface(_Surface.get()), &cairo_pattern_destroy);
-		cairo_pattern_set_matrix(pat.get(), &ctm);
-		cairo_pattern_set_extend(pat.get(), CAIRO_EXTEND_NONE);
-		cairo_pattern_set_filter(pat.get(), cairoFilter);
-		cairo_set_source(_Native_context.get(), pat.get());
-		cairo_paint(_Native_context.get());
-		cairo_surface_flush(_Native_surface.get());
+		_Letterbox_brush._Configure_pattern();
+		cairo_set_source(context, _Letterbox_brush.native_handle());
+		cairo_fill(context);
+	}
+	cairo_set_source(context, _Presentation._Pattern.get());
+	if (_Presentation._Paint) {
+		cairo_paint(context);
 	}
 	else {
-
-		// Calculate the destRect values.
-		switch (_Scaling) {
-		case std::experimental::io2d::scaling::letterbox:
-		{
-			_Render_for_scaling_uniform_or_letterbox();
-		} break;
-
-		case std::experimental::io2d::scaling::uniform:
-		{
-			_Render_for_scaling_uniform_or_letterbox();
-		} break;
-
-		case std::experimental::io2d::scaling::fill_uniform:
-		{
-			// Maintain aspect ratio and center, but overflow if needed rather than letterboxing.
-			if (_Width == _Display_width && _Height == _Display_height) {
-				cairo_set_source_surface(_Native_context.get(), _Surface.get(), 0.0, 0.0);
-				cairo_paint(_Native_context.get());
-			}
-			else {
-				auto widthRatio = static_cast<double>(_Display_width) / static_cast<double>(_Width);
-				auto heightRatio = static_cast<double>(_Display_height) / static_cast<double>(_Height);
-				if (widthRatio < heightRatio) {
-					cairo_set_source_rgb(_Native_context.get(), 0.0, 0.0, 0.0);
-					cairo_paint(_Native_context.get());
-					cairo_matrix_t ctm;
-					cairo_matrix_init_scale(&ctm, 1.0 / heightRatio, 1.0 / heightRatio);
-					cairo_matrix_translate(&ctm, trunc(abs(static_cast<double>(_Display_width - (_Width * heightRatio)) / 2.0)), 0.0);
-					unique_ptr<cairo_pattern_t, decltype(&cairo_pattern_destroy)> pat(cairo_pattern_create_for_surface(_Surface.get()), &cairo_pattern_destroy);
-					cairo_pattern_set_matrix(pat.get(), &ctm);
-					cairo_pattern_set_extend(pat.get(), CAIRO_EXTEND_NONE);
-					cairo_pattern_set_filter(pat.get(), cairoFilter);
-					cairo_set_source(_Native_context.get(), pat.get());
-					cairo_paint(_Native_context.get());
-				}
-				else {
-					cairo_set_source_rgb(_Native_context.get(), 0.0, 0.0, 0.0);
-					cairo_paint(_Native_context.get());
-					cairo_matrix_t ctm;
-					cairo_matrix_init_scale(&ctm, 1.0 / widthRatio, 1.0 / widthRatio);
-					cairo_matrix_translate(&ctm, 0.0, trunc(abs(static_cast<double>(_Display_height - (_Height * widthRatio)) / 2.0)));
-					unique_ptr<cairo_pattern_t, decltype(&cairo_pattern_destroy)> pat(cairo_pattern_create_for_surface(_Surface.get()), &cairo_pattern_destroy);
-					cairo_pattern_set_matrix(pat.get(), &ctm);
-					cairo_pattern_set_extend(pat.get(), CAIRO_EXTEND_NONE);
-					cairo_pattern_set_filter(pat.get(), cairoFilter);
-					cairo_set_source(_Native_context.get(), pat.get());
-					cairo_paint(_Native_context.get());
-				}
-			}
-		} break;
-		case std::experimental::io2d::scaling::fill_exact:
-		{
-			// Maintain aspect ratio and center, but overflow if needed rather than letterboxing.
-			if (_Width == _Display_width && _Height == _Display_height) {
-				cairo_set_source_surface(_Native_context.get(), _Surface.get(), 0.0, 0.0);
-				cairo_paint(_Native_context.get());
-			}
-			else {
-				auto widthRatio = static_cast<double>(_Display_width) / static_cast<double>(_Width);
-				auto heightRatio = static_cast<double>(_Display_height) / static_cast<double>(_Height);
-				cairo_matrix_t ctm;
-				cairo_matrix_init_scale(&ctm, 1.0 / widthRatio, 1.0 / heightRatio);
-				unique_ptr<cairo_pattern_t, decltype(&cairo_pattern_destroy)> pat(cairo_pattern_create_for_surface(_Surface.get()), &cairo_pattern_destroy);
-				cairo_pattern_set_matrix(pat.get(), &ctm);
-				cairo_pattern_set_extend(pat.get(), CAIRO_EXTEND_NONE);
-				cairo_pattern_set_filter(pat.get(), cairoFilter);
-				cairo_set_source(_Native_context.get(), pat.get());
-				cairo_paint(_Native_context.get());
-			}
-		} break;
-		case std::experimental::io2d::scaling::none:
-		{
-			cairo_set_source_surface(_Native_context.get(), _Surface.get(), 0.0, 0.0);
-			cairo_paint(_Native_context.get());
-		} break;
-		default:
-		{
-			assert("Unexpected _Scaling value." && false);
-		} break;
-		}
+		const auto& pic = _Presentation._Picture;
+		cairo_new_path(context);
+		cairo_rectangle(context, pic.x0, pic.y0, pic.x1 - pic.x0, pic.y1 - pic.y0);
+		cairo_fill(context);
 	}
 
-// 	cairo_restore(_Native_context.get());
+#if defined(USE_XCB)
+	if (_Shm != nullptr) {
+		_Put_shm_image();
+	}
+#endif
+	cairo_reset_clip(context);
+	_Dirty_region._Clear();
 	// This call to cairo_surface_flush is needed for Win32 surfaces to update.
 	cairo_surface_flush(_Native_surface.get());
 }
@@ -305,6 +313,7 @@ void display_surface::dimensions(int w, int h) {
 		_Surface = unique_ptr<cairo_surface_t, decltype(&cairo_surface_destroy)>(cairo_image_surface_create(_Format_to_cairo_format_t(_Format), _Width, _Height), &cairo_surface_destroy);
 		_Context = unique_ptr<cairo_t, decltype(&cairo_destroy)>(cairo_create(_Surface.get()), &cairo_destroy);
 		_Ensure_state();
+		_Dirty_region._Add_everything();
 	}
 }
 
@@ -318,23 +327,30 @@ void display_surface::display_dimensions(int dw, int dh) {
 }
 
 void display_surface::scaling(experimental::io2d::scaling scl) noexcept {
+	if (_Scaling != scl) {
+		_Dirty_region._Add_everything();
+	}
 	_Scaling = scl;
 }
 
 void display_surface::user_scaling_callback(const function<experimental::io2d::rectangle(const display_surface&, bool&)>& fn) {
 	_User_scaling_fn = fn;
+	_Dirty_region._Add_everything();
 }
 
 void display_surface::letterbox_brush(nullopt_t) noexcept {
 	_Letterbox_brush = _Default_brush;
+	_Dirty_region._Add_everything();
 }
 
 void display_surface::letterbox_brush(const rgba_color& c) {
 	_Letterbox_brush = experimental::io2d::brush(solid_color_brush_factory(c));
+	_Dirty_region._Add_everything();
 }
 
 void display_surface::letterbox_brush(const experimental::io2d::brush& b) {
 	_Letterbox_brush = b;
+	_Dirty_region._Add_everything();
 }
 
 void display_surface::auto_clear(bool val) noexcept {
@@ -367,6 +383,19 @@ bool display_surface::desired_frame_rate(double fps) noexcept {
 
 void display_surface::redraw_required() noexcept {
 	_Redraw_requested.store(true, std::memory_order_release);
+#if defined(USE_XCB) || defined(USE_XLIB)
+	if (_Wake_write_fd != -1) {
+#ifdef __linux__
+		const uint64_t one = 1;
+		auto result = ::write(_Wake_write_fd, &one, sizeof(one));
+#else
+		const char one = 1;
+		auto result = ::write(_Wake_write_fd, &one, sizeof(one));
+#endif
+		// A full eventfd counter or pipe already means show() will wake up, so failure needs no handling.
+		(void)result;
+	}
+#endif
 }
 
 format display_surface::format() const noexcept {
@@ -435,3 +464,85 @@ double display_surface::desired_frame_rate() const noexcept {
 double display_surface::elapsed_draw_time() const noexcept {
 	return _Elapsed_draw_time / 1'000'000.0;
 }
+
+#if defined(USE_XCB) || defined(USE_XLIB)
+void display_surface::_Open_wake_fds() noexcept {
+#ifdef __linux__
+	_Wake_read_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	_Wake_write_fd = _Wake_read_fd;
+#else
+	int fds[2];
+	if (pipe(fds) == 0) {
+		for (auto fd : fds) {
+			fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+			fcntl(fd, F_SETFD, FD_CLOEXEC);
+		}
+		_Wake_read_fd = fds[0];
+		_Wake_write_fd = fds[1];
+	}
+#endif
+}
+
+void display_surface::_Close_wake_fds() noexcept {
+	if (_Wake_write_fd != -1 && _Wake_write_fd != _Wake_read_fd) {
+		::close(_Wake_write_fd);
+	}
+	if (_Wake_read_fd != -1) {
+		::close(_Wake_read_fd);
+	}
+	_Wake_read_fd = -1;
+	_Wake_write_fd = -1;
+}
+
+void display_surface::_Take_wake_fds(display_surface& other) noexcept {
+	_Close_wake_fds();
+	_Wake_read_fd = other._Wake_read_fd;
+	_Wake_write_fd = other._Wake_write_fd;
+	other._Wake_read_fd = -1;
+	other._Wake_write_fd = -1;
+}
+
+// How long show() may sleep waiting for input before it has drawing to do, in milliseconds, or -1 for as long as it takes.
+int display_surface::_Show_wait_timeout() const noexcept {
+	if (!_Can_draw) {
+		// Only an X event can make drawing possible again.
+		return -1;
+	}
+	switch (_Refresh_rate) {
+	case experimental::io2d::refresh_rate::as_needed:
+		return _Redraw_requested.load(memory_order_acquire) ? 0 : -1;
+	case experimental::io2d::refresh_rate::fixed:
+	{
+		auto remaining = 1'000'000'000.0 / _Desired_frame_rate - _Elapsed_draw_time;
+		return (remaining <= 0.0) ? 0 : static_cast<int>(ceil(remaining / 1'000'000.0));
+	}
+	case experimental::io2d::refresh_rate::as_fast_as_possible:
+	default:
+		return 0;
+	}
+}
+
+void display_surface::_Wait_for_input(int connectionFd, int timeoutMs) noexcept {
+	if (timeoutMs == 0) {
+		return;
+	}
+	// Without a wake fd, redraw_required() can only be noticed by checking again.
+	const int noWakeFdTimeoutMs = 10;
+	if (_Wake_read_fd == -1 && (timeoutMs < 0 || timeoutMs > noWakeFdTimeoutMs)) {
+		timeoutMs = noWakeFdTimeoutMs;
+	}
+	pollfd fds[2] = { { connectionFd, POLLIN, 0 }, { _Wake_read_fd, POLLIN, 0 } };
+	// An interrupted poll just means one more trip around show()'s loop.
+	if (::poll(fds, (_Wake_read_fd == -1) ? 1 : 2, timeoutMs) > 0 && (fds[1].revents & POLLIN) != 0) {
+#ifdef __linux__
+		uint64_t count;
+		auto result = ::read(_Wake_read_fd, &count, sizeof(count));
+		(void)result;
+#else
+		char buffer[64];
+		while (::read(_Wake_read_fd, buffer, sizeof(buffer)) > 0) {
+		}
+#endif
+	}
+}
+#endif
@@ -83,6 +83,7 @@ void display_surface::_Make_native_surface_and_context() {
 	}
 	// Release the DC to avoid a handle leak.
 	ReleaseDC(_Hwnd, hdc);
+	_Dirty_region._Add_everything();
 }
 
 
@@ -187,6 +188,8 @@ LRESULT display_surface::_Window_proc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM
 			_Draw_fn(*this);
 		}
 
+		// Whatever the window showed has to be presented again, not just what was drawn.
+		_Dirty_region._Add_everything();
 		_Render_to_native_surface();
 
 		EndPaint(hwnd, &ps);
@@ -363,6 +366,7 @@ display_surface::display_surface(int preferredWidth, int preferredHeight, experi
 	// We render to the fixed size surface.
 	_Surface = unique_ptr<cairo_surface_t, decltype(&cairo_surface_destroy)>(cairo_image_surface_create(_Format_to_cairo_format_t(_Format), _Width, _Height), &cairo_surface_destroy);
 	_Context = unique_ptr<cairo_t, decltype(&cairo_destroy)>(cairo_create(_Surface.get()), &cairo_destroy);
+	_Track_damage = true;
 	_Ensure_state();
 }
 
@@ -2,10 +2,17 @@
 #include "xio2dhelpers.h"
 #include "xcairoenumhelpers.h"
 #include <cairo-xcb.h>
+#ifdef USE_XCB_SHM
+#include <xcb/shm.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#endif
 // #include <sstream>
 // #include <string>
 // #include <iostream>
 #include <chrono>
+#include <cstdlib>
+#include <cstring>
 
 using namespace std;
 using namespace std::chrono;
@@ -36,7 +43,10 @@ display_surface::display_surface(display_surface&& other) noexcept
 	, _Redraw_requested(other._Redraw_requested.load())
 	, _Elapsed_draw_time(move(other._Elapsed_draw_time))
 	, _Native_surface(move(other._Native_surface))
-	, _Native_context(move(other._Native_context)) {
+	, _Native_context(move(other._Native_context))
+	, _Shm(move(other._Shm))
+	, _Held_events(move(other._Held_events)) {
+	_Take_wake_fds(other);
 	other._Draw_fn = nullptr;
 	other._Size_change_fn = nullptr;
 	other._Screen = nullptr;
@@ -66,6 +76,9 @@ display_surface& display_surface::operator=(display_surface&& other) noexcept {
 		_Elapsed_draw_time = move(other._Elapsed_draw_time);
 		_Native_surface = move(other._Native_surface);
 		_Native_context = move(other._Native_context);
+		_Shm = move(other._Shm);
+		_Held_events = move(other._Held_events);
+		_Take_wake_fds(other);
 
 		other._Screen = nullptr;
 		other._Wndw = 0;
@@ -103,10 +116,190 @@ void display_surface::_Make_native_surface_and_context() {
 		_Throw_if_failed_cairo_status_t(CAIRO_STATUS_NULL_POINTER);
 	}
 	
-	_Native_surface = unique_ptr<cairo_surface_t, decltype(&cairo_surface_destroy)>(cairo_xcb_surface_create(_Connection.get(), _Wndw, visual, _Display_width, _Display_height), &cairo_surface_destroy);
+	// The old image has to go before the segment it lives in.
+	_Native_context.reset();
+	_Native_surface.reset();
+	_Shm.reset();
+	_Native_surface = unique_ptr<cairo_surface_t, decltype(&cairo_surface_destroy)>(_Create_shm_native_surface(visual), &cairo_surface_destroy);
+	if (_Native_surface == nullptr) {
+		_Native_surface = unique_ptr<cairo_surface_t, decltype(&cairo_surface_destroy)>(cairo_xcb_surface_create(_Connection.get(), _Wndw, visual, _Display_width, _Display_height), &cairo_surface_destroy);
+	}
 	_Native_context = unique_ptr<cairo_t, decltype(&cairo_destroy)>(cairo_create(_Native_surface.get()), &cairo_destroy);
 	_Throw_if_failed_cairo_status_t(cairo_surface_status(_Native_surface.get()));
 	_Throw_if_failed_cairo_status_t(cairo_status(_Native_context.get()));
+	_Dirty_region._Add_everything();
+}
+
+struct display_surface::_Shm_buffer {
+	xcb_connection_t* connection;
+	unsigned char* data;
+	// Zero until the server has attached the segment.
+	uint32_t segment;
+	uint32_t gc;
+	uint8_t depth;
+	// The response_type of the extension's ShmCompletion event.
+	uint8_t completionEvent;
+	bool putPending;
+};
+
+void display_surface::_Shm_buffer_delete(_Shm_buffer* buffer) noexcept {
+#ifdef USE_XCB_SHM
+	if (buffer->gc != 0) {
+		xcb_free_gc(buffer->connection, buffer->gc);
+	}
+	if (buffer->segment != 0) {
+		xcb_shm_detach(buffer->connection, buffer->segment);
+	}
+	shmdt(buffer->data);
+#endif
+	delete buffer;
+}
+
+cairo_surface_t* display_surface::_Create_shm_native_surface(xcb_visualtype_t* visual) noexcept {
+#ifdef USE_XCB_SHM
+	// Like IO2D_DISABLE=avx2, for measuring what presenting over the connection costs.
+	auto disabled = getenv("IO2D_DISABLE");
+	if (disabled != nullptr && strstr(disabled, "shm") != nullptr) {
+		return nullptr;
+	}
+	auto connection = _Connection.get();
+	// libxcb closes the connection if it is sent a request for an extension that the server does not have.
+	auto extension = xcb_get_extension_data(connection, &xcb_shm_id);
+	if (extension == nullptr || !extension->present) {
+		return nullptr;
+	}
+	unique_ptr<xcb_shm_query_version_reply_t, decltype(&::free)> versionReply(xcb_shm_query_version_reply(connection, xcb_shm_query_version(connection), nullptr), &::free);
+	if (versionReply == nullptr) {
+		return nullptr;
+	}
+	// The window's pixels have to be laid out the way cairo lays out RGB24 (or ARGB32 at depth 32) for the segment to be copied to it as is.
+	if ((_Screen->root_depth != 24 && _Screen->root_depth != 32) || visual->_class != XCB_VISUAL_CLASS_TRUE_COLOR || visual->red_mask != 0xFF0000u || visual->green_mask != 0xFF00u || visual->blue_mask != 0xFFu) {
+		return nullptr;
+	}
+	auto setup = xcb_get_setup(connection);
+	const uint16_t endiannessTest = 1;
+	const auto hostByteOrder = (*reinterpret_cast<const uint8_t*>(&endiannessTest) == 1) ? XCB_IMAGE_ORDER_LSB_FIRST : XCB_IMAGE_ORDER_MSB_FIRST;
+	if (setup->image_byte_order != hostByteOrder) {
+		return nullptr;
+	}
+	bool rowsMatch = false;
+	for (auto formatIter = xcb_setup_pixmap_formats_iterator(setup); formatIter.rem != 0; xcb_format_next(&formatIter)) {
+		if (formatIter.data->depth == _Screen->root_depth) {
+			rowsMatch = formatIter.data->bits_per_pixel == 32 && formatIter.data->scanline_pad == 32;
+		}
+	}
+	if (!rowsMatch) {
+		return nullptr;
+	}
+
+	const auto cairoFormat = (_Screen->root_depth == 32) ? CAIRO_FORMAT_ARGB32 : CAIRO_FORMAT_RGB24;
+	const auto stride = cairo_format_stride_for_width(cairoFormat, _Display_width);
+	auto id = shmget(IPC_PRIVATE, static_cast<size_t>(stride) * static_cast<size_t>(_Display_height), IPC_CREAT | 0600);
+	if (id == -1) {
+		return nullptr;
+	}
+	auto data = shmat(id, nullptr, 0);
+	if (data == reinterpret_cast<void*>(-1)) {
+		shmctl(id, IPC_RMID, nullptr);
+		return nullptr;
+	}
+	unique_ptr<_Shm_buffer, void(*)(_Shm_buffer*)> buffer(new (nothrow) _Shm_buffer{ connection, static_cast<unsigned char*>(data), 0, 0, _Screen->root_depth, static_cast<uint8_t>(extension->first_event + XCB_SHM_COMPLETION), false }, &_Shm_buffer_delete);
+	if (buffer == nullptr) {
+		shmdt(data);
+		shmctl(id, IPC_RMID, nullptr);
+		return nullptr;
+	}
+	// A server on another machine has the extension but cannot attach, so attaching is the real test.
+	auto segment = xcb_generate_id(connection);
+	unique_ptr<xcb_generic_error_t, decltype(&::free)> attachError(xcb_request_check(connection, xcb_shm_attach_checked(connection, segment, static_cast<uint32_t>(id), 0)), &::free);
+	// The segment now lives until both sides have detached from it.
+	shmctl(id, IPC_RMID, nullptr);
+	if (attachError != nullptr) {
+		return nullptr;
+	}
+	buffer->segment = segment;
+	buffer->gc = xcb_generate_id(connection);
+	xcb_create_gc(connection, buffer->gc, _Wndw, 0, nullptr);
+
+	auto sfce = cairo_image_surface_create_for_data(buffer->data, cairoFormat, _Display_width, _Display_height, stride);
+	if (cairo_surface_status(sfce) != CAIRO_STATUS_SUCCESS) {
+		cairo_surface_destroy(sfce);
+		return nullptr;
+	}
+	_Shm = move(buffer);
+	return sfce;
+#else
+	(void)visual;
+	return nullptr;
+#endif
+}
+
+void display_surface::_Put_shm_image() noexcept {
+#ifdef USE_XCB_SHM
+	auto connection = _Connection.get();
+	cairo_surface_flush(_Native_surface.get());
+	// The native context's matrix is the identity, so its clip rectangles are already in window coordinates.
+	unique_ptr<cairo_rectangle_list_t, decltype(&cairo_rectangle_list_destroy)> clipRects(cairo_copy_clip_rectangle_list(_Native_context.get()), &cairo_rectangle_list_destroy);
+	const bool clipped = clipRects != nullptr && clipRects->status == CAIRO_STATUS_SUCCESS;
+	const int count = clipped ? clipRects->num_rectangles : 1;
+	auto boxAt = [&](int i) {
+		double x0 = 0.0;
+		double y0 = 0.0;
+		double x1 = _Display_width;
+		double y1 = _Display_height;
+		if (clipped) {
+			const auto& r = clipRects->rectangles[i];
+			x0 = max(r.x, x0);
+			y0 = max(r.y, y0);
+			x1 = min(r.x + r.width, x1);
+			y1 = min(r.y + r.height, y1);
+		}
+		return _Device_box_covering(x0, y0, x1, y1);
+	};
+	int last = -1;
+	for (int i = 0; i < count; i++) {
+		auto box = boxAt(i);
+		if (box.x0 < box.x1 && box.y0 < box.y1) {
+			last = i;
+		}
+	}
+	for (int i = 0; i <= last; i++) {
+		auto box = boxAt(i);
+		if (box.x0 < box.x1 && box.y0 < box.y1) {
+			// Only the last put asks for a ShmCompletion: the server handles the puts in order, so once it has done that one it is done with the segment.
+			const uint8_t sendEvent = (i == last) ? 1 : 0;
+			xcb_shm_put_image(connection, _Wndw, _Shm->gc, static_cast<uint16_t>(_Display_width), static_cast<uint16_t>(_Display_height), static_cast<uint16_t>(box.x0), static_cast<uint16_t>(box.y0), static_cast<uint16_t>(box.x1 - box.x0), static_cast<uint16_t>(box.y1 - box.y0), static_cast<int16_t>(box.x0), static_cast<int16_t>(box.y0), _Shm->depth, XCB_IMAGE_FORMAT_Z_PIXMAP, sendEvent, _Shm->segment, 0);
+		}
+	}
+	_Shm->putPending = last >= 0;
+#endif
+}
+
+void display_surface::_Wait_for_shm_put() {
+#ifdef USE_XCB_SHM
+	if (_Shm == nullptr || !_Shm->putPending) {
+		return;
+	}
+	// show() has usually seen the ShmCompletion already, while it waited for the next frame to be due.
+	auto connection = _Connection.get();
+	xcb_flush(connection);
+	while (_Shm->putPending) {
+		unique_ptr<xcb_generic_event_t, decltype(&::free)> event(xcb_wait_for_event(connection), &::free);
+		if (event == nullptr) {
+			// The connection is gone, and with it the server's use of the segment.
+			_Shm->putPending = false;
+		}
+		else if ((event->response_type & ~0x80) == _Shm->completionEvent && reinterpret_cast<xcb_shm_completion_event_t*>(event.get())->shmseg == _Shm->segment) {
+			_Shm->putPending = false;
+		}
+		else {
+			if (_Held_events == nullptr) {
+				_Held_events = make_unique<deque<unique_ptr<xcb_generic_event_t, decltype(&::free)>>>();
+			}
+			_Held_events->push_back(move(event));
+		}
+	}
+#endif
 }
 
 void display_surface::_Resize_window() {
@@ -237,12 +430,16 @@ display_surface::display_surface(int preferredWidth, int preferredHeight, experi
 
 	_Surface = unique_ptr<cairo_surface_t, decltype(&cairo_surface_destroy)>(cairo_image_surface_create(_Format_to_cairo_format_t(_Format), _Width, _Height), &cairo_surface_destroy);
 	_Context = unique_ptr<cairo_t, decltype(&cairo_destroy)>(cairo_create(_Surface.get()), &cairo_destroy);
+	_Track_damage = true;
 	_Ensure_state();
+	_Open_wake_fds();
 }
 
 display_surface::~display_surface() {
+	_Close_wake_fds();
 	_Native_context.reset();
 	_Native_surface.reset();
+	_Shm.reset();
 	if (_Wndw != 0) {
 		xcb_destroy_window(_Connection.get(), _Wndw);
 		_Wndw = 0;
@@ -256,16 +453,21 @@ display_surface::~display_surface() {
 	}
 }
 
-namespace {
-	bool _Poll_for_xcb_event(unique_ptr<xcb_generic_event_t, decltype(&::free)>& event, xcb_connection_t* c) {
-		event.reset(xcb_poll_for_event(c));
-// 		if (event != nullptr) {
-// 			stringstream errorString;
-// 			errorString << "response_type: '" << to_string(event->response_type) << "'" << endl;
-// 			cerr << errorString.str().c_str();
-// 		}
-		return event != nullptr;
+// event may already hold one that show() took off the queue while deciding whether to wait.
+bool display_surface::_Poll_for_event(unique_ptr<xcb_generic_event_t, decltype(&::free)>& event) {
+	if (event == nullptr && _Has_held_events()) {
+		event = move(_Held_events->front());
+		_Held_events->pop_front();
 	}
+	if (event == nullptr) {
+		event.reset(xcb_poll_for_event(_Connection.get()));
+	}
+// 	if (event != nullptr) {
+// 		stringstream errorString;
+// 		errorString << "response_type: '" << to_string(event->response_type) << "'" << endl;
+// 		cerr << errorString.str().c_str();
+// 	}
+	return event != nullptr;
 }
 
 int display_surface::show() {
@@ -279,7 +481,17 @@ int display_surface::show() {
 		auto elapsedTimeIncrement = static_cast<double>(duration_cast<nanoseconds>(currentTime - previousTime).count());
 		_Elapsed_draw_time += elapsedTimeIncrement;
 		previousTime = currentTime;
-		while (_Poll_for_xcb_event(event, _Connection.get())) {
+		while (_Poll_for_event(event)) {
+#ifdef USE_XCB_SHM
+			// Its response_type is only known at run time, so it cannot be one of the cases below.
+			if (_Shm != nullptr && (event->response_type & ~0x80) == _Shm->completionEvent) {
+				if (reinterpret_cast<xcb_shm_completion_event_t*>(event.get())->shmseg == _Shm->segment) {
+					_Shm->putPending = false;
+				}
+				event.reset();
+				continue;
+			}
+#endif
 // 			const uint8_t userGeneratedEventMask = ~0x80;
 			switch (event->response_type & ~0x80) {
 			case 0:
@@ -307,6 +519,8 @@ int display_surface::show() {
 				else {
 					throw system_error(make_error_code(errc::operation_would_block));
 				}
+				// Whatever the window showed has to be presented again, not just what was drawn.
+				_Dirty_region._Add_everything();
 				_Render_to_native_surface();
 
 				_Elapsed_draw_time = 0.0;
@@ -334,7 +548,13 @@ int display_surface::show() {
 					resized = true;
 				}
 				if (resized) {
-					cairo_xcb_surface_set_size(_Native_surface.get(), _Display_width, _Display_height);
+					if (_Shm != nullptr) {
+						// The segment is the size of the old window, so it has to be made again.
+						_Make_native_surface_and_context();
+					}
+					else {
+						cairo_xcb_surface_set_size(_Native_surface.get(), _Display_width, _Display_height);
+					}
 					if (_Size_change_fn != nullptr) {
 						_Size_change_fn(*this);
 					}
@@ -383,6 +603,7 @@ int display_surface::show() {
 					else {
 						throw system_error(make_error_code(errc::operation_would_block));
 					}
+					_Dirty_region._Add_everything();
 					_Render_to_native_surface();
 
 					_Elapsed_draw_time = 0.0;
@@ -478,6 +699,7 @@ int display_surface::show() {
 // // 				assert(event->response_type >= 64 && event->response_type <= 127);
 			} break;
 			}
+			event.reset();
 		}
 		if (_Can_draw) {
 			bool redraw = true;
@@ -513,6 +735,16 @@ int display_surface::show() {
 				}
 			}
 		}
+		if (!exit) {
+			// Drawing may have read events into xcb's queue, where poll() cannot see them.
+			xcb_flush(_Connection.get());
+			if (!_Has_held_events()) {
+				event.reset(xcb_poll_for_queued_event(_Connection.get()));
+			}
+			if (event == nullptr && !_Has_held_events()) {
+				_Wait_for_input(xcb_get_file_descriptor(_Connection.get()), _Show_wait_timeout());
+			}
+		}
 	}
 	_Elapsed_draw_time = 0.0;
 	return 0;
@@ -157,6 +157,7 @@ display_surface::display_surface(display_surface&& other) noexcept
 	, _Elapsed_draw_time(move(other._Elapsed_draw_time))
 	, _Native_surface(move(other._Native_surface))
 	, _Native_context(move(other._Native_context)) {
+	_Take_wake_fds(other);
 	other._Draw_fn = nullptr;
 	other._Size_change_fn = nullptr;
 	other._Wndw = None;
@@ -184,6 +185,7 @@ display_surface& display_surface::operator=(display_surface&& other) noexcept {
 		_Elapsed_draw_time = move(other._Elapsed_draw_time);
 		_Native_surface = move(other._Native_surface);
 		_Native_context = move(other._Native_context);
+		_Take_wake_fds(other);
 
 		other._Wndw = None;
 		other._Draw_fn = nullptr;
@@ -208,6 +210,7 @@ void display_surface::_Make_native_surface_and_context() {
 	_Throw_if_failed_cairo_status_t(cairo_surface_status(_Native_surface.get()));
 	_Throw_if_failed_cairo_status_t(cairo_status(_Native_context.get()));
 	//cairo_xlib_surface_set_size(_Native_surface.get(), _Display_width, _Display_height);
+	_Dirty_region._Add_everything();
 }
 
 void display_surface::_Resize_window() {
@@ -293,10 +296,13 @@ display_surface::display_surface(int preferredWidth, int preferredHeight, experi
 	XMapWindow(display, _Wndw);
 	_Surface = unique_ptr<cairo_surface_t, decltype(&cairo_surface_destroy)>(cairo_image_surface_create(_Format_to_cairo_format_t(_Format), _Width, _Height), &cairo_surface_destroy);
 	_Context = unique_ptr<cairo_t, decltype(&cairo_destroy)>(cairo_create(_Surface.get()), &cairo_destroy);
+	_Track_damage = true;
 	_Ensure_state();
+	_Open_wake_fds();
 }
 
 display_surface::~display_surface() {
+	_Close_wake_fds();
 	_Native_context.reset();
 	_Native_surface.reset();
 	if (_Wndw != None) {
@@ -342,6 +348,8 @@ int display_surface::show() {
 				else {
 					throw system_error(make_error_code(errc::operation_would_block));
 				}
+				// Whatever the window showed has to be presented again, not just what was drawn.
+				_Dirty_region._Add_everything();
 				_Render_to_native_surface();
 
 				_Elapsed_draw_time = 0.0;
@@ -411,6 +419,7 @@ int display_surface::show() {
 					else {
 						throw system_error(make_error_code(errc::operation_would_block));
 					}
+					_Dirty_region._Add_everything();
 					_Render_to_native_surface();
 
 					_Elapsed_draw_time = 0.0;
@@ -495,6 +504,7 @@ int display_surface::show() {
 			} break;
 			}
 		}
+		auto queuedAfterDrain = XEventsQueued(_Display.get(), QueuedAlready);
 		if (_Can_draw) {
 			bool redraw = true;
 			if (_Refresh_rate == experimental::io2d::refresh_rate::as_needed) {
@@ -529,6 +539,13 @@ int display_surface::show() {
 				}
 			}
 		}
+		if (!exit) {
+			// XPending flushes and also takes in events that drawing's round trips left in xcb's buffer, where poll() cannot see
+			// them. Events for other windows stay queued, so only a change in the count means there is something of ours.
+			if (XPending(_Display.get()) == queuedAfterDrain) {
+				_Wait_for_input(ConnectionNumber(_Display.get()), _Show_wait_timeout());
+			}
+		}
 	}
 	_Elapsed_draw_time = 0.0;
 	return 0;
@@ -1,16 +1,204 @@
 #include "io2d.h"
 #include "xio2dhelpers.h"
 #include "xcairoenumhelpers.h"
+#include <list>
+#include <mutex>
+#include <unordered_map>
 
 using namespace std;
 using namespace std::experimental::io2d;
 
+namespace {
+	// Everything a font_resource_factory says about the font, which is everything cairo_scaled_font_create is given.
+	struct _Font_cache_key {
+		string _Family;
+		::std::experimental::io2d::font_slant _Slant;
+		::std::experimental::io2d::font_weight _Weight;
+		::std::experimental::io2d::antialias _Antialias;
+		::std::experimental::io2d::subpixel_order _Subpixel_order;
+		double _Font_matrix[6];
+		double _Surface_matrix[6];
+
+		// Empty, for the error_code constructor to assign to where it can catch bad_alloc.
+		_Font_cache_key() noexcept = default;
+		explicit _Font_cache_key(const font_resource_factory& f)
+			: _Family(f.font_family())
+			, _Slant(f.font_slant())
+			, _Weight(f.font_weight())
+			, _Antialias(f.font_options().antialias())
+			, _Subpixel_order(f.font_options().subpixel_order())
+			, _Font_matrix{ f.font_matrix().m00(), f.font_matrix().m01(), f.font_matrix().m10(), f.font_matrix().m11(), f.font_matrix().m20(), f.font_matrix().m21() }
+			, _Surface_matrix{ f.surface_matrix().m00(), f.surface_matrix().m01(), f.surface_matrix().m10(), f.surface_matrix().m11(), f.surface_matrix().m20(), f.surface_matrix().m21() } {
+		}
+
+		bool operator==(const _Font_cache_key& other) const noexcept {
+			return _Slant == other._Slant && _Weight == other._Weight && _Antialias == other._Antialias && _Subpixel_order == other._Subpixel_order &&
+				equal(begin(_Font_matrix), end(_Font_matrix), begin(other._Font_matrix)) && equal(begin(_Surface_matrix), end(_Surface_matrix), begin(other._Surface_matrix)) &&
+				_Family == other._Family;
+		}
+	};
+
+	struct _Font_cache_key_hash {
+		size_t operator()(const _Font_cache_key& k) const noexcept {
+			auto h = hash<string>()(k._Family);
+			// -0.0 == 0.0, so equal keys have to hash the same whichever zero they hold; hash<double> need not see to that.
+			auto mix = [&h](size_t v) { h ^= v + 0x9e3779b9 + (h << 6) + (h >> 2); };
+			auto hashDouble = [](double d) { return hash<double>()(d == 0.0 ? 0.0 : d); };
+			mix(static_cast<size_t>(k._Slant) | static_cast<size_t>(k._Weight) << 4 | static_cast<size_t>(k._Antialias) << 12 | static_cast<size_t>(k._Subpixel_order) << 16);
+			for (auto d : k._Font_matrix) {
+				mix(hashDouble(d));
+			}
+			for (auto d : k._Surface_matrix) {
+				mix(hashDouble(d));
+			}
+			return h;
+		}
+	};
+
+	// Least recently used first out. Fonts leave the cache under the lock but are only released after it, since releasing the last reference to a scaled font takes cairo's own locks.
+	class _Font_cache {
+		typedef list<pair<_Font_cache_key, font_resource>> _Entry_list;
+		mutex _Lock;
+		// Most recently used first.
+		_Entry_list _Entries;
+		unordered_map<_Font_cache_key, _Entry_list::iterator, _Font_cache_key_hash> _Index;
+		size_t _Capacity = 64;
+		size_t _Hits = 0;
+		size_t _Misses = 0;
+		size_t _Evictions = 0;
+
+		void _Trim(_Entry_list& evicted) noexcept {
+			while (_Entries.size() > _Capacity) {
+				_Index.erase(_Entries.back().first);
+				evicted.splice(evicted.begin(), _Entries, prev(_Entries.end()));
+				++_Evictions;
+			}
+		}
+	public:
+		bool find(const _Font_cache_key& key, font_resource& f) noexcept {
+			lock_guard<mutex> lg(_Lock);
+			auto it = _Index.find(key);
+			if (it == _Index.end()) {
+				++_Misses;
+				return false;
+			}
+			++_Hits;
+			_Entries.splice(_Entries.begin(), _Entries, it->second);
+			f = it->second->second;
+			return true;
+		}
+
+		// If another thread put the same font in first, f is given that one instead, so that both share it. f's own font is
+		// held in a local until then, so that it too is only released after the lock.
+		void insert(_Font_cache_key&& key, font_resource& f) {
+			_Entry_list evicted;
+			font_resource own(move(f));
+			lock_guard<mutex> lg(_Lock);
+			// With a capacity of 0 the cache is empty, so nothing is found.
+			auto it = _Index.find(key);
+			if (it != _Index.end()) {
+				f = it->second->second;
+				return;
+			}
+			f = move(own);
+			if (_Capacity == 0) {
+				return;
+			}
+			_Entry_list entry;
+			entry.emplace_back(move(key), f);
+			_Index.emplace(entry.front().first, entry.begin());
+			_Entries.splice(_Entries.begin(), entry);
+			_Trim(evicted);
+		}
+
+		size_t capacity() noexcept {
+			lock_guard<mutex> lg(_Lock);
+			return _Capacity;
+		}
+
+		size_t capacity(size_t n) noexcept {
+			_Entry_list evicted;
+			lock_guard<mutex> lg(_Lock);
+			auto old = _Capacity;
+			_Capacity = n;
+			_Trim(evicted);
+			return old;
+		}
+
+		font_resource_cache_stats stats() noexcept {
+			lock_guard<mutex> lg(_Lock);
+			return font_resource_cache_stats{ _Hits, _Misses, _Evictions, _Entries.size(), _Capacity };
+		}
+
+		void reset_stats() noexcept {
+			lock_guard<mutex> lg(_Lock);
+			_Hits = _Misses = _Evictions = 0;
+		}
+
+		void clear() noexcept {
+			_Entry_list evicted;
+			lock_guard<mutex> lg(_Lock);
+			_Index.clear();
+			evicted.swap(_Entries);
+		}
+	};
+
+	_Font_cache& _The_font_cache() noexcept {
+		static _Font_cache cache;
+		return cache;
+	}
+}
+
+namespace std {
+	namespace experimental {
+		namespace io2d {
+#if _Inline_namespace_conditional_support_test
+			inline namespace v1 {
+#endif
+				size_t get_font_resource_cache_capacity() noexcept {
+					return _The_font_cache().capacity();
+				}
+
+				size_t set_font_resource_cache_capacity(size_t n) noexcept {
+					return _The_font_cache().capacity(n);
+				}
+
+				font_resource_cache_stats get_font_resource_cache_stats() noexcept {
+					return _The_font_cache().stats();
+				}
+
+				void reset_font_resource_cache_stats() noexcept {
+					_The_font_cache().reset_stats();
+				}
+
+				void clear_font_resource_cache() noexcept {
+					_The_font_cache().clear();
+				}
+#if _Inline_namespace_conditional_support_test
+			}
+#endif
+		}
+	}
+}
+
+font_resource::font_resource(nullptr_t) noexcept
+	: _Scaled_font()
+	, _Font_family()
+	, _Font_slant(::std::experimental::io2d::font_slant::normal)
+	, _Font_weight(::std::experimental::io2d::font_weight::normal)
+	, _Font_options() {
+}
+
 font_resource::font_resource(const font_resource_factory& f)
 	: _Scaled_font()
 	, _Font_family()
 	, _Font_slant(f.font_slant())
 	, _Font_weight(f.font_weight())
 	, _Font_options() {
+	_Font_cache_key key(f);
+	if (_The_font_cache().find(key, *this)) {
+		return;
+	}
 	cairo_matrix_t fm{ f.font_matrix().m00(), f.font_matrix().m01(), f.font_matrix().m10(), f.font_matrix().m11(), f.font_matrix().m20(), f.font_matrix().m21() };
 	cairo_matrix_t sm{ f.surface_matrix().m00(), f.surface_matrix().m01(), f.surface_matrix().m10(), f.surface_matrix().m11(), f.surface_matrix().m20(), f.surface_matrix().m21() };
 	auto fo = cairo_font_options_create();
@@ -20,10 +208,13 @@ font_resource::font_resource(const font_resource_factory& f)
 	cairo_font_options_set_subpixel_order(fo, _Subpixel_order_to_cairo_subpixel_order_t(f.font_options().subpixel_order()));
 	_Font_family = make_shared<string>(f.font_family());
 	_Throw_if_failed_cairo_status_t(cairo_font_options_status(fo));
-	auto sf = cairo_scaled_font_create(cairo_toy_font_face_create(f.font_family().c_str(), _Font_slant_to_cairo_font_slant_t(f.font_slant()),
-		_Font_weight_to_cairo_font_weight_t(f.font_weight())), &fm, &sm, fo);
+	// The scaled font holds its own reference to the face.
+	unique_ptr<cairo_font_face_t, decltype(&cairo_font_face_destroy)> face(cairo_toy_font_face_create(f.font_family().c_str(), _Font_slant_to_cairo_font_slant_t(f.font_slant()),
+		_Font_weight_to_cairo_font_weight_t(f.font_weight())), &cairo_font_face_destroy);
+	auto sf = cairo_scaled_font_create(face.get(), &fm, &sm, fo);
 	_Scaled_font = shared_ptr<cairo_scaled_font_t>(sf, &cairo_scaled_font_destroy);
 	_Throw_if_failed_cairo_status_t(cairo_scaled_font_status(sf));
+	_The_font_cache().insert(move(key), *this);
 }
 
 font_resource::font_resource(const font_resource_factory& f, error_code& ec) noexcept
@@ -32,6 +223,18 @@ font_resource::font_resource(const font_resource_factory& f, error_code& ec) noe
 	, _Font_slant(f.font_slant())
 	, _Font_weight(f.font_weight())
 	, _Font_options() {
+	_Font_cache_key key{};
+	try {
+		key = _Font_cache_key(f);
+	}
+	catch (const bad_alloc&) {
+		ec = make_error_code(errc::not_enough_memory);
+		return;
+	}
+	if (_The_font_cache().find(key, *this)) {
+		ec.clear();
+		return;
+	}
 	cairo_matrix_t fm{ f.font_matrix().m00(), f.font_matrix().m01(), f.font_matrix().m10(), f.font_matrix().m11(), f.font_matrix().m20(), f.font_matrix().m21() };
 	cairo_matrix_t sm{ f.surface_matrix().m00(), f.surface_matrix().m01(), f.surface_matrix().m10(), f.surface_matrix().m11(), f.surface_matrix().m20(), f.surface_matrix().m21() };
 	auto fo = cairo_font_options_create();
@@ -79,8 +282,9 @@ font_resource::font_resource(const font_resource_factory& f, error_code& ec) noe
 		return;
 	}
 
-	auto sf = cairo_scaled_font_create(cairo_toy_font_face_create(f.font_family().c_str(), _Font_slant_to_cairo_font_slant_t(f.font_slant()),
-		_Font_weight_to_cairo_font_weight_t(f.font_weight())), &fm, &sm, fo);
+	unique_ptr<cairo_font_face_t, decltype(&cairo_font_face_destroy)> face(cairo_toy_font_face_create(key._Family.c_str(), _Font_slant_to_cairo_font_slant_t(f.font_slant()),
+		_Font_weight_to_cairo_font_weight_t(f.font_weight())), &cairo_font_face_destroy);
+	auto sf = cairo_scaled_font_create(face.get(), &fm, &sm, fo);
 	ec = _Cairo_status_t_to_std_error_code(cairo_scaled_font_status(sf));
 	if (static_cast<bool>(ec)) {
 		return;
@@ -96,6 +300,12 @@ font_resource::font_resource(const font_resource_factory& f, error_code& ec) noe
 		ec = make_error_code(io2d_error::invalid_status);
 		return;
 	}
+	try {
+		_The_font_cache().insert(move(key), *this);
+	}
+	catch (const bad_alloc&) {
+		// The font is fine; it just will not be shared.
+	}
 	ec.clear();
 }
 
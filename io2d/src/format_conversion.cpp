@@ -0,0 +1,342 @@
+#include "io2d.h"
+#include "xio2dhelpers.h"
+#include "xcairoenumhelpers.h"
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define _IO2D_USE_SSE2
+#endif
+
+using namespace std;
+using namespace std::experimental::io2d;
+
+namespace {
+	bool _Is_little_endian() noexcept {
+		const uint32_t one = 1;
+		unsigned char first;
+		::std::memcpy(&first, &one, 1);
+		return first == 1;
+	}
+
+	// cairo packs a1 pixels into native-endian 32-bit words starting at the least significant bit on little-endian machines and at the most significant bit on big-endian ones, which works out to this bit of byte x / 8.
+	int _A1_bit(int x, bool littleEndian) noexcept {
+		return littleEndian ? (x & 7) : (7 - (x & 7));
+	}
+
+	template <bool Bgra>
+	void _Store_interchange(unsigned char* dest, rgba_pixel p) noexcept {
+		dest[0] = Bgra ? p.b : p.r;
+		dest[1] = p.g;
+		dest[2] = Bgra ? p.r : p.b;
+		dest[3] = p.a;
+	}
+
+	template <bool Bgra>
+	rgba_pixel _Load_interchange(const unsigned char* src) noexcept {
+		return{ Bgra ? src[2] : src[0], src[1], Bgra ? src[0] : src[2], src[3] };
+	}
+
+	uint32_t _Load_32(const unsigned char* src) noexcept {
+		uint32_t v;
+		::std::memcpy(&v, src, sizeof(v));
+		return v;
+	}
+
+	void _Store_32(unsigned char* dest, uint32_t v) noexcept {
+		::std::memcpy(dest, &v, sizeof(v));
+	}
+
+#ifdef _IO2D_USE_SSE2
+	// Clamps each 32-bit lane to [0, 255]; lanes holding INT_MIN, which is what truncating NaN or infinity gives, become 0.
+	__m128i _Clamp_to_byte(__m128i v) noexcept {
+		v = _mm_andnot_si128(_mm_cmplt_epi32(v, _mm_setzero_si128()), v);
+		auto over = _mm_cmpgt_epi32(v, _mm_set1_epi32(255));
+		return _mm_or_si128(_mm_and_si128(over, _mm_set1_epi32(255)), _mm_andnot_si128(over, v));
+	}
+
+	// Exactly (c * 255 + a / 2) / a as the scalar code computes it, with one division per pixel rather than per channel. The quotient is
+	// either an integer or at least 1/255 below the next one, and multiplying by a float reciprocal is off by less than 1/32768, so adding
+	// 1/2048 before truncating gives the right integer either way. The AVX2 version in simd_avx2.cpp does the same.
+	__m128i _Unpremultiply_lanes(__m128i c, __m128 reciprocal, __m128 halfAlpha) noexcept {
+		auto n = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(c), _mm_set1_ps(255.0f)), halfAlpha);
+		return _Clamp_to_byte(_mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(n, reciprocal), _mm_set1_ps(1.0f / 2048.0f))));
+	}
+
+	// (c * a + 128 + ((c * a + 128) >> 8)) >> 8, i.e. round(c * a / 255). Lanes hold values below 256, so the 16-bit multiply is exact.
+	__m128i _Premultiply_lanes(__m128i c, __m128i a) noexcept {
+		auto t = _mm_add_epi32(_mm_mullo_epi16(c, a), _mm_set1_epi32(128));
+		return _mm_srli_epi32(_mm_add_epi32(t, _mm_srli_epi32(t, 8)), 8);
+	}
+#endif
+
+	template <bool Bgra>
+	void _Argb32_to_interchange(const unsigned char* src, unsigned char* dest, int width) noexcept {
+		int x = 0;
+#if defined(USE_AVX2)
+		if (_Has_avx2()) {
+			x = _Argb32_to_interchange_avx2(src, dest, width, Bgra);
+		}
+#endif
+#ifdef _IO2D_USE_SSE2
+		const auto byteMask = _mm_set1_epi32(0xff);
+		for (; x + 4 <= width; x += 4) {
+			auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 4));
+			auto a = _mm_srli_epi32(v, 24);
+			// Alpha 0 gives infinity, and then 0 from _Clamp_to_byte, as the scalar code does.
+			auto reciprocal = _mm_div_ps(_mm_set1_ps(1.0f), _mm_cvtepi32_ps(a));
+			auto halfAlpha = _mm_cvtepi32_ps(_mm_srli_epi32(a, 1));
+			auto r = _Unpremultiply_lanes(_mm_and_si128(_mm_srli_epi32(v, 16), byteMask), reciprocal, halfAlpha);
+			auto g = _Unpremultiply_lanes(_mm_and_si128(_mm_srli_epi32(v, 8), byteMask), reciprocal, halfAlpha);
+			auto b = _Unpremultiply_lanes(_mm_and_si128(v, byteMask), reciprocal, halfAlpha);
+			auto first = Bgra ? b : r;
+			auto third = Bgra ? r : b;
+			auto out = _mm_or_si128(_mm_or_si128(first, _mm_slli_epi32(g, 8)), _mm_or_si128(_mm_slli_epi32(third, 16), _mm_slli_epi32(a, 24)));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + x * 4), out);
+		}
+#endif
+		for (; x < width; ++x) {
+			_Store_interchange<Bgra>(dest + x * 4, pixel_traits<format::argb32>::to_rgba(_Load_32(src + x * 4)));
+		}
+	}
+
+	template <bool Bgra>
+	void _Interchange_to_argb32(const unsigned char* src, unsigned char* dest, int width) noexcept {
+		int x = 0;
+#if defined(USE_AVX2)
+		if (_Has_avx2()) {
+			x = _Interchange_to_argb32_avx2(src, dest, width, Bgra);
+		}
+#endif
+#ifdef _IO2D_USE_SSE2
+		const auto byteMask = _mm_set1_epi32(0xff);
+		for (; x + 4 <= width; x += 4) {
+			auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 4));
+			auto first = _mm_and_si128(v, byteMask);
+			auto g = _mm_and_si128(_mm_srli_epi32(v, 8), byteMask);
+			auto third = _mm_and_si128(_mm_srli_epi32(v, 16), byteMask);
+			auto a = _mm_srli_epi32(v, 24);
+			auto r = _Premultiply_lanes(Bgra ? third : first, a);
+			auto b = _Premultiply_lanes(Bgra ? first : third, a);
+			g = _Premultiply_lanes(g, a);
+			auto out = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(a, 24), _mm_slli_epi32(r, 16)), _mm_or_si128(_mm_slli_epi32(g, 8), b));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + x * 4), out);
+		}
+#endif
+		for (; x < width; ++x) {
+			_Store_32(dest + x * 4, pixel_traits<format::argb32>::from_rgba(_Load_interchange<Bgra>(src + x * 4)));
+		}
+	}
+
+	template <format Fmt, bool Bgra>
+	void _Typed_to_interchange(const unsigned char* src, unsigned char* dest, int width) noexcept {
+		typedef typename pixel_traits<Fmt>::value_type value_type;
+		for (int x = 0; x < width; ++x) {
+			value_type v;
+			::std::memcpy(&v, src + x * sizeof(value_type), sizeof(value_type));
+			_Store_interchange<Bgra>(dest + x * 4, pixel_traits<Fmt>::to_rgba(v));
+		}
+	}
+
+	template <format Fmt, bool Bgra>
+	void _Interchange_to_typed(const unsigned char* src, unsigned char* dest, int width) noexcept {
+		typedef typename pixel_traits<Fmt>::value_type value_type;
+		for (int x = 0; x < width; ++x) {
+			auto v = pixel_traits<Fmt>::from_rgba(_Load_interchange<Bgra>(src + x * 4));
+			::std::memcpy(dest + x * sizeof(value_type), &v, sizeof(value_type));
+		}
+	}
+
+	template <bool Bgra>
+	void _Rgb30_to_interchange(const unsigned char* src, unsigned char* dest, int width) noexcept {
+		for (int x = 0; x < width; ++x) {
+			auto v = _Load_32(src + x * 4);
+			auto to8 = [](uint32_t c) { return static_cast<uint8_t>((c * 255u + 511u) / 1023u); };
+			_Store_interchange<Bgra>(dest + x * 4, { to8((v >> 20) & 0x3ffu), to8((v >> 10) & 0x3ffu), to8(v & 0x3ffu), 255 });
+		}
+	}
+
+	template <bool Bgra>
+	void _Interchange_to_rgb30(const unsigned char* src, unsigned char* dest, int width) noexcept {
+		for (int x = 0; x < width; ++x) {
+			auto p = _Load_interchange<Bgra>(src + x * 4);
+			auto to10 = [](uint32_t c) { return (c << 2) | (c >> 6); };
+			_Store_32(dest + x * 4, (to10(p.r) << 20) | (to10(p.g) << 10) | to10(p.b));
+		}
+	}
+
+	template <bool Bgra>
+	void _A1_to_interchange(const unsigned char* src, unsigned char* dest, int width) noexcept {
+		const auto littleEndian = _Is_little_endian();
+		for (int x = 0; x < width; ++x) {
+			uint8_t a = ((src[x >> 3] >> _A1_bit(x, littleEndian)) & 1) ? 255 : 0;
+			_Store_interchange<Bgra>(dest + x * 4, { 0, 0, 0, a });
+		}
+	}
+
+	template <bool Bgra>
+	void _Interchange_to_a1(const unsigned char* src, unsigned char* dest, int width) noexcept {
+		const auto littleEndian = _Is_little_endian();
+		::std::memset(dest, 0, static_cast<size_t>(_Row_size(format::a1, width)));
+		for (int x = 0; x < width; ++x) {
+			if (src[x * 4 + 3] >= 128) {
+				dest[x >> 3] = static_cast<unsigned char>(dest[x >> 3] | (1 << _A1_bit(x, littleEndian)));
+			}
+		}
+	}
+
+	template <bool Bgra>
+	void _Row_to_interchange(const unsigned char* src, format fmt, unsigned char* dest, int width) noexcept {
+		switch (fmt) {
+		case format::argb32:
+			_Argb32_to_interchange<Bgra>(src, dest, width);
+			break;
+		case format::xrgb32:
+			_Typed_to_interchange<format::xrgb32, Bgra>(src, dest, width);
+			break;
+		case format::a8:
+			_Typed_to_interchange<format::a8, Bgra>(src, dest, width);
+			break;
+		case format::a1:
+			_A1_to_interchange<Bgra>(src, dest, width);
+			break;
+		case format::rgb16_565:
+			_Typed_to_interchange<format::rgb16_565, Bgra>(src, dest, width);
+			break;
+		case format::rgb30:
+			_Rgb30_to_interchange<Bgra>(src, dest, width);
+			break;
+		default:
+			assert(false && "Unexpected format.");
+			break;
+		}
+	}
+
+	template <bool Bgra>
+	void _Row_from_interchange(const unsigned char* src, unsigned char* dest, format fmt, int width) noexcept {
+		switch (fmt) {
+		case format::argb32:
+			_Interchange_to_argb32<Bgra>(src, dest, width);
+			break;
+		case format::xrgb32:
+			_Interchange_to_typed<format::xrgb32, Bgra>(src, dest, width);
+			break;
+		case format::a8:
+			_Interchange_to_typed<format::a8, Bgra>(src, dest, width);
+			break;
+		case format::a1:
+			_Interchange_to_a1<Bgra>(src, dest, width);
+			break;
+		case format::rgb16_565:
+			_Interchange_to_typed<format::rgb16_565, Bgra>(src, dest, width);
+			break;
+		case format::rgb30:
+			_Interchange_to_rgb30<Bgra>(src, dest, width);
+			break;
+		default:
+			assert(false && "Unexpected format.");
+			break;
+		}
+	}
+
+	cairo_status_t _Check_conversion(const unsigned char* src, int srcStride, int srcRowSize, unsigned char* dest, int destStride, int destRowSize, format fmt, int width, int height) noexcept {
+		if (src == nullptr || dest == nullptr) {
+			return CAIRO_STATUS_NULL_POINTER;
+		}
+		if (fmt == format::invalid) {
+			return CAIRO_STATUS_INVALID_FORMAT;
+		}
+		if (width < 0 || height < 0) {
+			return CAIRO_STATUS_INVALID_SIZE;
+		}
+		if (srcStride < srcRowSize || destStride < destRowSize) {
+			return CAIRO_STATUS_INVALID_STRIDE;
+		}
+		return CAIRO_STATUS_SUCCESS;
+	}
+
+	void _Convert_to_interchange(const unsigned char* src, int srcStride, format srcFormat, unsigned char* dest, int destStride, interchange_format destFormat, int width, int height, parallelism p) {
+		auto band = [=](int first, int last) {
+			for (int y = first; y < last; ++y) {
+				auto srcRow = src + static_cast<ptrdiff_t>(y) * srcStride;
+				auto destRow = dest + static_cast<ptrdiff_t>(y) * destStride;
+				if (destFormat == interchange_format::bgra8) {
+					_Row_to_interchange<true>(srcRow, srcFormat, destRow, width);
+				}
+				else {
+					_Row_to_interchange<false>(srcRow, srcFormat, destRow, width);
+				}
+			}
+		};
+		_For_each_row_band(width, height, p, band);
+	}
+
+	void _Convert_from_interchange(const unsigned char* src, int srcStride, interchange_format srcFormat, unsigned char* dest, int destStride, format destFormat, int width, int height, parallelism p) {
+		auto band = [=](int first, int last) {
+			for (int y = first; y < last; ++y) {
+				auto srcRow = src + static_cast<ptrdiff_t>(y) * srcStride;
+				auto destRow = dest + static_cast<ptrdiff_t>(y) * destStride;
+				if (srcFormat == interchange_format::bgra8) {
+					_Row_from_interchange<true>(srcRow, destRow, destFormat, width);
+				}
+				else {
+					_Row_from_interchange<false>(srcRow, destRow, destFormat, width);
+				}
+			}
+		};
+		_For_each_row_band(width, height, p, band);
+	}
+}
+
+namespace std {
+	namespace experimental {
+		namespace io2d {
+#if _Inline_namespace_conditional_support_test
+			inline namespace v1 {
+#endif
+				static_assert(sizeof(rgba_pixel) == 4, "rgba_pixel must have the layout of rgba8.");
+
+				void _Argb32_to_rgba_pixels(const uint32_t* src, rgba_pixel* dest, int count) noexcept {
+					_Argb32_to_interchange<false>(reinterpret_cast<const unsigned char*>(src), reinterpret_cast<unsigned char*>(dest), count);
+				}
+
+				void _Rgba_pixels_to_argb32(const rgba_pixel* src, uint32_t* dest, int count) noexcept {
+					_Interchange_to_argb32<false>(reinterpret_cast<const unsigned char*>(src), reinterpret_cast<unsigned char*>(dest), count);
+				}
+
+				void convert_pixels(const unsigned char* src, int srcStride, format srcFormat, unsigned char* dest, int destStride, interchange_format destFormat, int width, int height, parallelism p) {
+					_Throw_if_failed_cairo_status_t(_Check_conversion(src, srcStride, _Row_size(srcFormat, width), dest, destStride, width * 4, srcFormat, width, height));
+					_Convert_to_interchange(src, srcStride, srcFormat, dest, destStride, destFormat, width, height, p);
+				}
+
+				void convert_pixels(const unsigned char* src, int srcStride, format srcFormat, unsigned char* dest, int destStride, interchange_format destFormat, int width, int height, error_code& ec, parallelism p) noexcept {
+					auto status = _Check_conversion(src, srcStride, _Row_size(srcFormat, width), dest, destStride, width * 4, srcFormat, width, height);
+					if (status != CAIRO_STATUS_SUCCESS) {
+						ec = _Cairo_status_t_to_std_error_code(status);
+						return;
+					}
+					// Nothing in here throws: the row kernels do not, and _Run_row_bands only rethrows what they throw.
+					_Convert_to_interchange(src, srcStride, srcFormat, dest, destStride, destFormat, width, height, p);
+					ec.clear();
+				}
+
+				void convert_pixels(const unsigned char* src, int srcStride, interchange_format srcFormat, unsigned char* dest, int destStride, format destFormat, int width, int height, parallelism p) {
+					_Throw_if_failed_cairo_status_t(_Check_conversion(src, srcStride, width * 4, dest, destStride, _Row_size(destFormat, width), destFormat, width, height));
+					_Convert_from_interchange(src, srcStride, srcFormat, dest, destStride, destFormat, width, height, p);
+				}
+
+				void convert_pixels(const unsigned char* src, int srcStride, interchange_format srcFormat, unsigned char* dest, int destStride, format destFormat, int width, int height, error_code& ec, parallelism p) noexcept {
+					auto status = _Check_conversion(src, srcStride, width * 4, dest, destStride, _Row_size(destFormat, width), destFormat, width, height);
+					if (status != CAIRO_STATUS_SUCCESS) {
+						ec = _Cairo_status_t_to_std_error_code(status);
+						return;
+					}
+					_Convert_from_interchange(src, srcStride, srcFormat, dest, destStride, destFormat, width, height, p);
+					ec.clear();
+				}
+#if _Inline_namespace_conditional_support_test
+			}
+#endif
+		}
+	}
+}
@@ -6,6 +6,45 @@
 using namespace std;
 using namespace std::experimental::io2d;
 
+namespace {
+	struct _Pixel_release {
+		unsigned char* data;
+		function<void(unsigned char*)> release;
+	};
+
+	const cairo_user_data_key_t _Pixel_release_key{};
+
+	void _Call_pixel_release(void* p) {
+		unique_ptr<_Pixel_release> r(static_cast<_Pixel_release*>(p));
+		r->release(r->data);
+	}
+
+	// Makes cairo call release when it destroys sfce, which may be after the image_surface is gone if something else still refers to sfce. Calls it right away instead if that cannot be arranged, which includes sfce having failed to be created.
+	cairo_status_t _Attach_pixel_release(cairo_surface_t* sfce, unsigned char* data, function<void(unsigned char*)>& release) noexcept {
+		if (!release) {
+			return cairo_surface_status(sfce);
+		}
+		auto status = cairo_surface_status(sfce);
+		if (status != CAIRO_STATUS_SUCCESS) {
+			release(data);
+			return status;
+		}
+		_Pixel_release* r;
+		try {
+			r = new _Pixel_release{ data, move(release) };
+		}
+		catch (const bad_alloc&) {
+			release(data);
+			return CAIRO_STATUS_NO_MEMORY;
+		}
+		status = cairo_surface_set_user_data(sfce, &_Pixel_release_key, r, &_Call_pixel_release);
+		if (status != CAIRO_STATUS_SUCCESS) {
+			_Call_pixel_release(r);
+		}
+		return status;
+	}
+}
+
 image_surface::image_surface(image_surface&& other) noexcept
 	: surface(move(other)) {
 }
@@ -71,6 +110,41 @@ image_surface::image_surface(vector<unsigned char>& data, experimental::io2d::fo
 	_Ensure_state();
 }
 
+image_surface::image_surface(unsigned char* data, experimental::io2d::format fmt, int width, int height, int stride, function<void(unsigned char*)> release)
+	: surface({ nullptr, nullptr }, fmt, _Content_for_format(fmt)) {
+	if (data == nullptr) {
+		// cairo would allocate a buffer of its own rather than fail.
+		if (release) {
+			release(data);
+		}
+		_Throw_if_failed_cairo_status_t(CAIRO_STATUS_NULL_POINTER);
+	}
+	_Surface = unique_ptr<cairo_surface_t, decltype(&cairo_surface_destroy)>(cairo_image_surface_create_for_data(data, _Format_to_cairo_format_t(fmt), width, height, stride), &cairo_surface_destroy);
+	_Throw_if_failed_cairo_status_t(_Attach_pixel_release(_Surface.get(), data, release));
+	_Context = unique_ptr<cairo_t, decltype(&cairo_destroy)>(cairo_create(_Surface.get()), &cairo_destroy);
+	_Throw_if_failed_cairo_status_t(cairo_status(_Context.get()));
+	cairo_set_miter_limit(_Context.get(), _Line_join_miter_miter_limit);
+	_Ensure_state();
+}
+
+image_surface::image_surface(unsigned char* data, experimental::io2d::format fmt, int width, int height, int stride, error_code& ec, function<void(unsigned char*)> release) noexcept
+	: surface({ (data == nullptr) ? nullptr : cairo_image_surface_create_for_data(data, _Format_to_cairo_format_t(fmt), width, height, stride), nullptr }, fmt, _Content_for_format(fmt), ec) {
+	if (static_cast<bool>(ec)) {
+		// The base class has already destroyed the surface, so release has not been attached to anything.
+		if (release) {
+			release(data);
+		}
+		return;
+	}
+	ec = _Cairo_status_t_to_std_error_code(_Attach_pixel_release(_Surface.get(), data, release));
+	if (static_cast<bool>(ec)) {
+		_Surface = nullptr;
+		_Context = nullptr;
+		return;
+	}
+	ec.clear();
+}
+
 image_surface::~image_surface() {
 }
 
@@ -156,6 +230,78 @@ vector<unsigned char> image_surface::data(error_code& ec) noexcept {
 	return data;
 }
 
+pixel_view image_surface::pixels() {
+	cairo_surface_flush(_Surface.get());
+	if (cairo_image_surface_get_data(_Surface.get()) == nullptr) {
+		_Throw_if_failed_cairo_status_t(CAIRO_STATUS_NULL_POINTER);
+	}
+	return pixel_view(_Surface.get());
+}
+
+pixel_view image_surface::pixels(error_code& ec) noexcept {
+	cairo_surface_flush(_Surface.get());
+	if (cairo_image_surface_get_data(_Surface.get()) == nullptr) {
+		ec = _Cairo_status_t_to_std_error_code(CAIRO_STATUS_NULL_POINTER);
+		return pixel_view(nullptr);
+	}
+	ec.clear();
+	return pixel_view(_Surface.get());
+}
+
+const_pixel_view image_surface::const_pixels() const {
+	cairo_surface_flush(_Surface.get());
+	if (cairo_image_surface_get_data(_Surface.get()) == nullptr) {
+		_Throw_if_failed_cairo_status_t(CAIRO_STATUS_NULL_POINTER);
+	}
+	return const_pixel_view(_Surface.get());
+}
+
+const_pixel_view image_surface::const_pixels(error_code& ec) const noexcept {
+	cairo_surface_flush(_Surface.get());
+	if (cairo_image_surface_get_data(_Surface.get()) == nullptr) {
+		ec = _Cairo_status_t_to_std_error_code(CAIRO_STATUS_NULL_POINTER);
+		return const_pixel_view(nullptr);
+	}
+	ec.clear();
+	return const_pixel_view(_Surface.get());
+}
+
+void image_surface::copy_to(unsigned char* buffer, int stride) const {
+	if (buffer == nullptr) {
+		_Throw_if_failed_cairo_status_t(CAIRO_STATUS_NULL_POINTER);
+	}
+	cairo_surface_flush(_Surface.get());
+	auto imageData = cairo_image_surface_get_data(_Surface.get());
+	if (imageData == nullptr) {
+		_Throw_if_failed_cairo_status_t(CAIRO_STATUS_NULL_POINTER);
+	}
+	auto sfce = _Surface.get();
+	if (stride < _Row_size(_Cairo_format_t_to_format(cairo_image_surface_get_format(sfce)), cairo_image_surface_get_width(sfce))) {
+		_Throw_if_failed_cairo_status_t(CAIRO_STATUS_INVALID_STRIDE);
+	}
+	_Copy_rows(buffer, stride, imageData, cairo_image_surface_get_stride(sfce), cairo_image_surface_get_height(sfce));
+}
+
+void image_surface::copy_to(unsigned char* buffer, int stride, error_code& ec) const noexcept {
+	if (buffer == nullptr) {
+		ec = _Cairo_status_t_to_std_error_code(CAIRO_STATUS_NULL_POINTER);
+		return;
+	}
+	cairo_surface_flush(_Surface.get());
+	auto imageData = cairo_image_surface_get_data(_Surface.get());
+	if (imageData == nullptr) {
+		ec = _Cairo_status_t_to_std_error_code(CAIRO_STATUS_NULL_POINTER);
+		return;
+	}
+	auto sfce = _Surface.get();
+	if (stride < _Row_size(_Cairo_format_t_to_format(cairo_image_surface_get_format(sfce)), cairo_image_surface_get_width(sfce))) {
+		ec = make_error_code(io2d_error::invalid_stride);
+		return;
+	}
+	_Copy_rows(buffer, stride, imageData, cairo_image_surface_get_stride(sfce), cairo_image_surface_get_height(sfce));
+	ec.clear();
+}
+
 format image_surface::format() const noexcept {
 	return _Cairo_format_t_to_format(cairo_image_surface_get_format(_Surface.get()));
 }
@@ -18,6 +18,8 @@ mapped_surface::mapped_surface(surface::native_handle_type nh, surface::native_h
 	}
 	// Reference the surface that is mapped to ensure it isn't accidentally destroyed while the map still exists.
 	cairo_surface_reference(_Map_of.csfce);
+	// Mapping an image surface hands out its own pixels.
+	_Add_pixel_writer(_Map_of.csfce, 1);
 }
 
 mapped_surface::mapped_surface(surface::native_handle_type nh, surface::native_handle_type map_of, error_code& ec) noexcept
@@ -34,12 +36,15 @@ mapped_surface::mapped_surface(surface::native_handle_type nh, surface::native_h
 	}
 	// Reference the surface that is mapped to ensure it isn't accidentally destroyed while the map still exists.
 	cairo_surface_reference(_Map_of.csfce);
+	// Mapping an image surface hands out its own pixels.
+	_Add_pixel_writer(_Map_of.csfce, 1);
 	ec.clear();
 }
 
 mapped_surface::~mapped_surface() {
 	if (_Mapped_surface.csfce != nullptr) {
 		cairo_surface_unmap_image(_Map_of.csfce, _Mapped_surface.csfce);
+		_Add_pixel_writer(_Map_of.csfce, -1);
 		// Remove the reference we added to the surface that was mapped.
 		cairo_surface_destroy(_Map_of.csfce);
 		_Mapped_surface.csfce = nullptr;
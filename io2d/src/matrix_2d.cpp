@@ -2,113 +2,14 @@
 #include "xio2dhelpers.h"
 #include "xcairoenumhelpers.h"
 #include <cmath>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define _IO2D_HAS_SSE2 1
+#include <emmintrin.h>
+#endif
 
 using namespace std;
 using namespace std::experimental::io2d;
 
-matrix_2d::matrix_2d() noexcept
-	: _M00{ 1.0 }
-	, _M01{ 0.0 }
-	, _M10{ 0.0 }
-	, _M11{ 1.0 }
-	, _M20{ 0.0 }
-	, _M21{ 0.0 } {
-}
-
-matrix_2d::matrix_2d(matrix_2d&& other) noexcept
-	: _M00(move(other._M00))
-	, _M01(move(other._M01))
-	, _M10(move(other._M10))
-	, _M11(move(other._M11))
-	, _M20(move(other._M20))
-	, _M21(move(other._M21)) {
-	other._M00 = 0.0;
-	other._M01 = 0.0;
-	other._M10 = 0.0;
-	other._M11 = 0.0;
-	other._M20 = 0.0;
-	other._M21 = 0.0;
-}
-
-matrix_2d& matrix_2d::operator=(matrix_2d&& other) noexcept {
-	if (this != &other) {
-		_M00 = move(other._M00);
-		_M01 = move(other._M01);
-		_M10 = move(other._M10);
-		_M11 = move(other._M11);
-		_M20 = move(other._M20);
-		_M21 = move(other._M21);
-
-		other._M00 = 0.0;
-		other._M01 = 0.0;
-		other._M10 = 0.0;
-		other._M11 = 0.0;
-		other._M20 = 0.0;
-		other._M21 = 0.0;
-	}
-	return *this;
-}
-
-matrix_2d::matrix_2d(double m00, double m01, double m10, double m11, double m20, double m21) noexcept
-	: _M00{ m00 }
-	, _M01{ m01 }
-	, _M10{ m10 }
-	, _M11{ m11 }
-	, _M20{ m20 }
-	, _M21{ m21 } {
-}
-
-matrix_2d matrix_2d::init_identity() noexcept {
-	return{ 1.0, 0.0, 0.0, 1.0, 0.0, 0.0 };
-}
-
-matrix_2d matrix_2d::init_translate(const vector_2d& value) noexcept {
-	return{ 1.0, 0.0, 0.0, 1.0, value.x(), value.y() };
-}
-
-matrix_2d matrix_2d::init_scale(const vector_2d& value) noexcept {
-	return{ value.x(), 0.0, 0.0, value.y(), 0.0, 0.0 };
-}
-
-matrix_2d matrix_2d::init_rotate(double radians) noexcept {
-	auto sine = sin(radians);
-	auto cosine = cos(radians);
-	return{ cosine, sine, -sine, cosine, 0.0, 0.0 };
-}
-
-matrix_2d matrix_2d::init_shear_x(double factor) noexcept {
-	return{ 1.0, 0.0, factor, 1.0, 0.0, 0.0 };
-}
-
-matrix_2d matrix_2d::init_shear_y(double factor) noexcept {
-	return{ 1.0, factor, 0.0, 1.0, 0.0, 0.0 };
-}
-
-matrix_2d& matrix_2d::translate(const vector_2d& value) noexcept {
-	*this = init_translate(value) * (*this);
-	return *this;
-}
-
-matrix_2d& matrix_2d::scale(const vector_2d& value) noexcept {
-	*this = init_scale(value) * (*this);
-	return *this;
-}
-
-matrix_2d& matrix_2d::rotate(double radians) noexcept {
-	*this = init_rotate(radians) * (*this);
-	return *this;
-}
-
-matrix_2d& matrix_2d::shear_x(double factor) noexcept {
-	*this = init_shear_x(factor) * (*this);
-	return *this;
-}
-
-matrix_2d& matrix_2d::shear_y(double factor) noexcept {
-	*this = init_shear_y(factor) * (*this);
-	return *this;
-}
-
 matrix_2d& matrix_2d::invert() {
 	error_code ec;
 	auto lm00 = _M00;
@@ -193,103 +94,65 @@ double matrix_2d::determinant(error_code& ec) const noexcept {
 	return _M00 * _M11 - _M01 * _M10;
 }
 
-vector_2d matrix_2d::transform_distance(const vector_2d& dist) const noexcept {
-	return{ _M00 * dist.x() + _M10 * dist.y(), _M01 * dist.x() + _M11 * dist.y() };
-}
-
-vector_2d matrix_2d::transform_point(const vector_2d& pt) const noexcept {
-	return{ _M00 * pt.x() + _M10 * pt.y() + _M20, _M01 * pt.x() + _M11 * pt.y() + _M21 };
-}
-
-void matrix_2d::m00(double value) noexcept {
-	_M00 = value;
+void matrix_2d::transform_points(vector_2d* pts, size_t count) const noexcept {
+	transform_points(pts, count, pts);
 }
 
-void matrix_2d::m01(double value) noexcept {
-	_M01 = value;
-}
-
-void matrix_2d::m10(double value) noexcept {
-	_M10 = value;
-}
-
-void matrix_2d::m11(double value) noexcept {
-	_M11 = value;
-}
-
-void matrix_2d::m20(double value) noexcept {
-	_M20 = value;
-}
-
-void matrix_2d::m21(double value) noexcept {
-	_M21 = value;
-}
-
-double matrix_2d::m00() const noexcept {
-	return _M00;
-}
-
-double matrix_2d::m01() const noexcept {
-	return _M01;
-}
-
-double matrix_2d::m10() const noexcept {
-	return _M10;
-}
-
-double matrix_2d::m11() const noexcept {
-	return _M11;
-}
-
-double matrix_2d::m20() const noexcept {
-	return _M20;
-}
-
-double matrix_2d::m21() const noexcept {
-	return _M21;
-}
-
-bool matrix_2d::is_invertible() const noexcept {
-	if (!isfinite(_M00) || !isfinite(_M01) || !isfinite(_M10) || !isfinite(_M11) || !isfinite(_M20) || !isfinite(_M21)) {
-		return false;
+void matrix_2d::transform_points(const vector_2d* pts, size_t count, vector_2d* out) const noexcept {
+	static_assert(sizeof(vector_2d) == 2 * sizeof(double), "transform_points requires vector_2d to be two packed doubles.");
+	if (count == 0) {
+		return;
 	}
-	return (_M00 * _M11 - _M01 * _M10) != 0.0;
-}
-
-matrix_2d& matrix_2d::operator*=(const matrix_2d& rhs) noexcept {
-	*this = *this * rhs;
-	return *this;
-}
-
-namespace std {
-	namespace experimental {
-		namespace io2d {
-#if _Inline_namespace_conditional_support_test
-			inline namespace v1 {
-#endif
-				matrix_2d operator*(const matrix_2d& lhs, const matrix_2d& rhs) noexcept {
-					return matrix_2d{
-						(lhs.m00() * rhs.m00()) + (lhs.m01() * rhs.m10()),
-						(lhs.m00() * rhs.m01()) + (lhs.m01() * rhs.m11()),
-						(lhs.m10() * rhs.m00()) + (lhs.m11() * rhs.m10()),
-						(lhs.m10() * rhs.m01()) + (lhs.m11() * rhs.m11()),
-						(lhs.m20() * rhs.m00()) + (lhs.m21() * rhs.m10()) + rhs.m20(),
-						(lhs.m20() * rhs.m01()) + (lhs.m21() * rhs.m11()) + rhs.m21()
-					};
+	// Paths are nearly always built under an identity, translation, or axis aligned scale matrix so those get their own loops.
+	if (_M01 == 0.0 && _M10 == 0.0) {
+		if (_M00 == 1.0 && _M11 == 1.0) {
+			if (_M20 == 0.0 && _M21 == 0.0) {
+				if (out != pts) {
+					memmove(out, pts, count * sizeof(vector_2d));
 				}
-
-				bool operator==(const matrix_2d& lhs, const matrix_2d& rhs) noexcept {
-					return lhs.m00() == rhs.m00() && lhs.m01() == rhs.m01() &&
-						lhs.m10() == rhs.m10() && lhs.m11() == rhs.m11() &&
-						lhs.m20() == rhs.m20() && lhs.m21() == rhs.m21();
-				}
-
-				bool operator!=(const matrix_2d& lhs, const matrix_2d& rhs) noexcept {
-					return !(lhs == rhs);
-				}
-#if _Inline_namespace_conditional_support_test
+				return;
 			}
-#endif
+			const vector_2d t{ _M20, _M21 };
+			for (size_t i = 0; i < count; i++) {
+				out[i] = pts[i] + t;
+			}
+			return;
 		}
+		for (size_t i = 0; i < count; i++) {
+			out[i] = { _M00 * pts[i].x() + _M20, _M11 * pts[i].y() + _M21 };
+		}
+		return;
+	}
+#if defined(USE_AVX2)
+	if (_Has_avx2()) {
+		const double m[6] = { _M00, _M01, _M10, _M11, _M20, _M21 };
+		_Transform_points_avx2(m, reinterpret_cast<const double*>(pts), count, reinterpret_cast<double*>(out));
+		return;
 	}
+#endif
+#if _IO2D_HAS_SSE2
+	// Each point is one register; the x and y terms are formed in the same order as transform_point so the results are identical.
+	const auto c0 = _mm_set_pd(_M01, _M00);
+	const auto c1 = _mm_set_pd(_M11, _M10);
+	const auto t = _mm_set_pd(_M21, _M20);
+	const auto src = reinterpret_cast<const double*>(pts);
+	const auto dst = reinterpret_cast<double*>(out);
+	size_t i = 0;
+	for (; i + 2 <= count; i += 2) {
+		const auto p0 = _mm_loadu_pd(src + i * 2);
+		const auto p1 = _mm_loadu_pd(src + i * 2 + 2);
+		const auto r0 = _mm_add_pd(_mm_add_pd(_mm_mul_pd(_mm_unpacklo_pd(p0, p0), c0), _mm_mul_pd(_mm_unpackhi_pd(p0, p0), c1)), t);
+		const auto r1 = _mm_add_pd(_mm_add_pd(_mm_mul_pd(_mm_unpacklo_pd(p1, p1), c0), _mm_mul_pd(_mm_unpackhi_pd(p1, p1), c1)), t);
+		_mm_storeu_pd(dst + i * 2, r0);
+		_mm_storeu_pd(dst + i * 2 + 2, r1);
+	}
+	if (i < count) {
+		const auto p = _mm_loadu_pd(src + i * 2);
+		_mm_storeu_pd(dst + i * 2, _mm_add_pd(_mm_add_pd(_mm_mul_pd(_mm_unpacklo_pd(p, p), c0), _mm_mul_pd(_mm_unpackhi_pd(p, p), c1)), t));
+	}
+#else
+	for (size_t i = 0; i < count; i++) {
+		out[i] = transform_point(pts[i]);
+	}
+#endif
 }
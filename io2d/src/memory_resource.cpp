@@ -0,0 +1,182 @@
+#include "io2d.h"
+#include "xio2dhelpers.h"
+#include "xcairoenumhelpers.h"
+#include <new>
+#include <limits>
+
+using namespace std;
+using namespace std::experimental::io2d;
+
+namespace {
+	const size_t _Default_chunk_size = 4096;
+
+	class _New_delete_resource : public memory_resource {
+		virtual void* do_allocate(size_t bytes, size_t alignment) override {
+			// operator new only guarantees fundamental alignment before C++17, which is all io2d's own types need.
+			assert(alignment <= alignof(max_align_t));
+			(void)alignment;
+			return ::operator new(bytes);
+		}
+
+		virtual void do_deallocate(void* p, size_t, size_t) override {
+			::operator delete(p);
+		}
+
+		virtual bool do_is_equal(const memory_resource& other) const noexcept override {
+			return this == &other;
+		}
+	};
+
+	atomic<memory_resource*> _Default_resource{ nullptr };
+}
+
+memory_resource::~memory_resource() {
+}
+
+void* memory_resource::allocate(size_t bytes, size_t alignment) {
+	return do_allocate(bytes, alignment);
+}
+
+void memory_resource::deallocate(void* p, size_t bytes, size_t alignment) {
+	do_deallocate(p, bytes, alignment);
+}
+
+bool memory_resource::is_equal(const memory_resource& other) const noexcept {
+	return do_is_equal(other);
+}
+
+namespace std {
+	namespace experimental {
+		namespace io2d {
+#if _Inline_namespace_conditional_support_test
+			inline namespace v1 {
+#endif
+				bool operator==(const memory_resource& lhs, const memory_resource& rhs) noexcept {
+					return &lhs == &rhs || lhs.is_equal(rhs);
+				}
+
+				bool operator!=(const memory_resource& lhs, const memory_resource& rhs) noexcept {
+					return !(lhs == rhs);
+				}
+
+				memory_resource* new_delete_resource() noexcept {
+					static _New_delete_resource resource;
+					return &resource;
+				}
+
+				memory_resource* get_default_resource() noexcept {
+					auto r = _Default_resource.load();
+					return r == nullptr ? new_delete_resource() : r;
+				}
+
+				memory_resource* set_default_resource(memory_resource* r) noexcept {
+					auto previous = _Default_resource.exchange(r);
+					return previous == nullptr ? new_delete_resource() : previous;
+				}
+#if _Inline_namespace_conditional_support_test
+			}
+#endif
+		}
+	}
+}
+
+monotonic_buffer_resource::monotonic_buffer_resource(memory_resource* upstream) noexcept
+	: _Upstream(upstream)
+	, _Initial_buffer(nullptr)
+	, _Initial_size(0)
+	, _Chunks(nullptr)
+	, _Current(nullptr)
+	, _Space(0)
+	, _Next_size(_Default_chunk_size) {
+}
+
+monotonic_buffer_resource::monotonic_buffer_resource(size_t initialSize, memory_resource* upstream) noexcept
+	: _Upstream(upstream)
+	, _Initial_buffer(nullptr)
+	, _Initial_size(0)
+	, _Chunks(nullptr)
+	, _Current(nullptr)
+	, _Space(0)
+	, _Next_size(max(initialSize, sizeof(_Chunk) + 1)) {
+}
+
+monotonic_buffer_resource::monotonic_buffer_resource(void* buffer, size_t bufferSize, memory_resource* upstream) noexcept
+	: _Upstream(upstream)
+	, _Initial_buffer(buffer)
+	, _Initial_size(bufferSize)
+	, _Chunks(nullptr)
+	, _Current(static_cast<unsigned char*>(buffer))
+	, _Space(bufferSize)
+	, _Next_size(max(bufferSize * 2, _Default_chunk_size)) {
+}
+
+monotonic_buffer_resource::~monotonic_buffer_resource() {
+	release();
+}
+
+void monotonic_buffer_resource::_Release_chunks(_Chunk* keep) noexcept {
+	auto chunk = _Chunks;
+	while (chunk != nullptr) {
+		auto next = chunk->next;
+		if (chunk != keep) {
+			_Upstream->deallocate(chunk, chunk->size, alignof(max_align_t));
+		}
+		chunk = next;
+	}
+	_Chunks = keep;
+	if (keep != nullptr) {
+		keep->next = nullptr;
+	}
+}
+
+void* monotonic_buffer_resource::do_allocate(size_t bytes, size_t alignment) {
+	void* p = _Current;
+	auto space = _Space;
+	if (p == nullptr || align(alignment, bytes, p, space) == nullptr) {
+		if (bytes > numeric_limits<size_t>::max() - sizeof(_Chunk) - alignment) {
+			throw bad_alloc();
+		}
+		auto size = max(_Next_size, sizeof(_Chunk) + alignment + bytes);
+		auto chunk = static_cast<_Chunk*>(_Upstream->allocate(size, alignof(max_align_t)));
+		chunk->next = _Chunks;
+		chunk->size = size;
+		_Chunks = chunk;
+		_Next_size = (size > numeric_limits<size_t>::max() / 2) ? size : size * 2;
+		p = reinterpret_cast<unsigned char*>(chunk) + sizeof(_Chunk);
+		space = size - sizeof(_Chunk);
+		p = align(alignment, bytes, p, space);
+		assert(p != nullptr);
+	}
+	_Current = static_cast<unsigned char*>(p) + bytes;
+	_Space = space - bytes;
+	return p;
+}
+
+void monotonic_buffer_resource::do_deallocate(void*, size_t, size_t) {
+}
+
+bool monotonic_buffer_resource::do_is_equal(const memory_resource& other) const noexcept {
+	return this == &other;
+}
+
+void monotonic_buffer_resource::release() noexcept {
+	_Release_chunks(nullptr);
+	_Current = static_cast<unsigned char*>(_Initial_buffer);
+	_Space = _Initial_size;
+}
+
+void monotonic_buffer_resource::reset() noexcept {
+	_Release_chunks(_Chunks);
+	if (_Chunks != nullptr) {
+		_Current = reinterpret_cast<unsigned char*>(_Chunks) + sizeof(_Chunk);
+		_Space = _Chunks->size - sizeof(_Chunk);
+	}
+	else {
+		_Current = static_cast<unsigned char*>(_Initial_buffer);
+		_Space = _Initial_size;
+	}
+}
+
+memory_resource* monotonic_buffer_resource::upstream_resource() const noexcept {
+	return _Upstream;
+}
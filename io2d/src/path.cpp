@@ -5,193 +5,196 @@
 using namespace std;
 using namespace std::experimental::io2d;
 
-void _Free_manual_cairo_path(cairo_path_t* path) noexcept;
-void _Free_manual_cairo_path(cairo_path_t* path) noexcept {
-	if (path != nullptr) {
-		if (path->data != nullptr) {
-			delete[] path->data;
-			path->data = nullptr;
-			path->status = CAIRO_STATUS_NULL_POINTER;
-		}
-		delete path;
-		path = nullptr;
+namespace {
+	path_factory _Make_path_factory(const vector<path_data_item>& pathData) {
+		path_factory pb;
+		pb.append(pathData);
+		return pb;
 	}
 }
 
-path::native_handle_type path::native_handle() const noexcept {
-	return _Cairo_path.get();
+struct path::_Native_path {
+	vector<cairo_path_data_t> _Data;
+	cairo_path_t _Cairo_path;
+	// Made lazily by _Set_on for the transformation it was last set under. Only accessed with atomic_load and atomic_store since copies of a path can be used from different threads.
+	shared_ptr<cairo_compiled_path_t> _Compiled;
+
+	// Takes ownership of the converted data without copying it.
+	explicit _Native_path(_Cairo_path_converter& converter) noexcept
+		: _Data(converter.release_data())
+		, _Cairo_path()
+		, _Compiled() {
+		_Cairo_path.status = CAIRO_STATUS_SUCCESS;
+		_Cairo_path.data = _Data.data();
+		_Cairo_path.num_data = static_cast<int>(_Data.size());
+	}
+};
+
+void _Cairo_path_converter::_Add_header(cairo_path_data_type_t type, int length) {
+	cairo_path_data_t cpdItem{ };
+	cpdItem.header.type = type;
+	cpdItem.header.length = length;
+	_Headers.push_back(cpdItem);
 }
 
-path::path(const path_factory& pb)
-: path(pb.data_ref()) {
+void _Cairo_path_converter::_Transform_run() noexcept {
+	_Matrix.transform_points(_Points.data() + _Run_start, _Points.size() - _Run_start);
+	_Run_start = _Points.size();
 }
 
-path::path(const vector<path_data_item>& pathData)
-: _Data(new vector<path_data_item>)
-, _Cairo_path(new cairo_path_t, &_Free_manual_cairo_path) {
-	auto matrix = matrix_2d::init_identity();
-	vector_2d origin{ };
-	bool hasCurrentPoint = false;
-	// Untransformed because we use it to add to raw relative points for transformation.
-	vector_2d currentPoint{ };
-	// Transformed because we need to know where the transformed last move to point is when we receive a close path instruction and the matrix and origin may have since changed such that we wouldn't be able to calculate it correctly anymore.
-	vector_2d lastMoveToPoint{ };
-	auto pdSize = pathData.size();
-	vector<cairo_path_data_t> vec;
-	for (unsigned int i = 0; i < pdSize; i++) {
-		const auto& item = pathData[i];
-		cairo_path_data_t cpdItem{ };
-		auto pdt = item.type();
+void _Cairo_path_converter::_Transform(const matrix_2d& matrix, const vector_2d& origin) noexcept {
+	_Transform_run();
+	if (_Last_move_to_in_run) {
+		_Last_move_to = _Matrix.transform_point(_Last_move_to);
+		_Last_move_to_in_run = false;
+	}
+	_Matrix = _Origin_adjusted_matrix(matrix, origin);
+}
+
+void _Cairo_path_converter::_Move_to(const vector_2d& pt) {
+	_Add_header(CAIRO_PATH_MOVE_TO, 2);
+	_Points.push_back(pt);
+	_Last_move_to = pt;
+	_Last_move_to_in_run = true;
+}
+
+void _Cairo_path_converter::_Line_to(const vector_2d& pt) {
+	_Add_header(CAIRO_PATH_LINE_TO, 2);
+	_Points.push_back(pt);
+}
+
+void _Cairo_path_converter::_Curve_to(const vector_2d& pt1, const vector_2d& pt2, const vector_2d& pt3) {
+	_Add_header(CAIRO_PATH_CURVE_TO, 4);
+	_Points.push_back(pt1);
+	_Points.push_back(pt2);
+	_Points.push_back(pt3);
+}
+
+// Closes the sub-path and begins a new one at its first point, which becomes _Current_point untransformed by the current matrix and origin. Returns false if the matrix changed since the sub-path began and the current one is not invertible.
+bool _Cairo_path_converter::_Close_path() {
+	if (_Last_move_to_in_run) {
+		_Current_point = _Last_move_to;
+	}
+	else {
+		// The first point was transformed with an earlier matrix and origin so map it back through the current ones.
+		error_code ec;
+		auto inverseMatrix = matrix_2d(_Matrix).invert(ec);
+		if (static_cast<bool>(ec)) {
+			return false;
+		}
+		_Current_point = inverseMatrix.transform_point(_Last_move_to);
+	}
+	_Add_header(CAIRO_PATH_CLOSE_PATH, 1);
+	_Move_to(_Current_point);
+	return true;
+}
+
+// Transforms the pending points and interleaves them with their headers at the end of _Data.
+void _Cairo_path_converter::_Flush() {
+	_Transform_run();
+	const auto numDataST = _Data.size() + _Headers.size() + _Points.size();
+	if (numDataST > _Data.capacity()) {
+		_Data.reserve(max(numDataST, _Data.capacity() * 2));
+	}
+	auto pointIter = _Points.cbegin();
+	for (const auto& header : _Headers) {
+		_Data.push_back(header);
+		for (int i = 1; i < header.header.length; i++) {
+			cairo_path_data_t cpdItem{ };
+			cpdItem.point = { pointIter->x(), pointIter->y() };
+			_Data.push_back(cpdItem);
+			++pointIter;
+		}
+	}
+	assert(_Data.size() == numDataST && pointIter == _Points.cend());
+	_Headers.clear();
+	_Points.clear();
+	_Run_start = 0;
+}
+
+// Converts the items of pf that have not been converted yet. Only throws bad_alloc; on any failure the caller must reset.
+cairo_status_t _Cairo_path_converter::_Convert(const path_factory& pf) {
+	if (pf._Revision != _Revision || pf._Verbs.size() < _Verb_count || pf._Coords.size() < _Coord_count) {
+		reset();
+		_Revision = pf._Revision;
+	}
+	const auto verbCount = pf._Verbs.size();
+	if (_Verb_count == verbCount) {
+		return CAIRO_STATUS_SUCCESS;
+	}
+	_Headers.reserve(verbCount - _Verb_count);
+	_Points.reserve((verbCount - _Verb_count) * 2);
+	auto coords = pf._Coords.data() + _Coord_count;
+	for (auto verbIndex = _Verb_count; verbIndex < verbCount; verbIndex++) {
+		const auto pdt = static_cast<path_data_type>(pf._Verbs[verbIndex]);
 		switch (pdt) {
 		case std::experimental::io2d::path_data_type::move_to:
 		{
-			currentPoint = item.get<path_data_item::move_to>().to();
-			auto pt = matrix.transform_point(currentPoint - origin) + origin;
-			cpdItem.header.type = CAIRO_PATH_MOVE_TO;
-			cpdItem.header.length = 2;
-			vec.push_back(cpdItem);
-			cpdItem = { };
-			cpdItem.point = { pt.x(), pt.y() };
-			vec.push_back(cpdItem);
-			hasCurrentPoint = true;
-			lastMoveToPoint = pt;
+			_Current_point = { coords[0], coords[1] };
+			_Move_to(_Current_point);
+			_Has_current_point = true;
 		} break;
 		case std::experimental::io2d::path_data_type::line_to:
 		{
-			currentPoint = item.get<path_data_item::line_to>().to();
-			auto pt = matrix.transform_point(currentPoint - origin) + origin;
-			if (hasCurrentPoint) {
-				cpdItem.header.type = CAIRO_PATH_LINE_TO;
-				cpdItem.header.length = 2;
-				vec.push_back(cpdItem);
-				cpdItem = { };
-				cpdItem.point = { pt.x(), pt.y() };
-				vec.push_back(cpdItem);
+			_Current_point = { coords[0], coords[1] };
+			if (_Has_current_point) {
+				_Line_to(_Current_point);
 			}
 			else {
-				cpdItem.header.type = CAIRO_PATH_MOVE_TO;
-				cpdItem.header.length = 2;
-				vec.push_back(cpdItem);
-				cpdItem = { };
-				cpdItem.point = { pt.x(), pt.y() };
-				vec.push_back(cpdItem);
-				hasCurrentPoint = true;
-				lastMoveToPoint = pt;
+				_Move_to(_Current_point);
+				_Has_current_point = true;
 			}
 		} break;
 		case std::experimental::io2d::path_data_type::curve_to:
 		{
-			auto dataItem = item.get<path_data_item::curve_to>();
-			auto pt1 = matrix.transform_point(dataItem.control_point_1() - origin) + origin;
-			auto pt2 = matrix.transform_point(dataItem.control_point_2() - origin) + origin;
-			auto pt3 = matrix.transform_point(dataItem.end_point() - origin) + origin;
-			if (!hasCurrentPoint) {
-				cpdItem.header.type = CAIRO_PATH_MOVE_TO;
-				cpdItem.header.length = 2;
-				vec.push_back(cpdItem);
-				cpdItem = { };
-				cpdItem.point = { pt1.x(), pt1.y() };
-				vec.push_back(cpdItem);
-				currentPoint = dataItem.control_point_1();
-				lastMoveToPoint = pt1;
-				hasCurrentPoint = true;
+			const vector_2d cpt1{ coords[0], coords[1] };
+			if (!_Has_current_point) {
+				_Move_to(cpt1);
+				_Has_current_point = true;
 			}
-			cpdItem.header.type = CAIRO_PATH_CURVE_TO;
-			cpdItem.header.length = 4;
-			vec.push_back(cpdItem);
-			cpdItem = { };
-			cpdItem.point = { pt1.x(), pt1.y() };
-			vec.push_back(cpdItem);
-			cpdItem = { };
-			cpdItem.point = { pt2.x(), pt2.y() };
-			vec.push_back(cpdItem);
-			cpdItem = { };
-			cpdItem.point = { pt3.x(), pt3.y() };
-			vec.push_back(cpdItem);
-			currentPoint = dataItem.end_point();
+			_Curve_to(cpt1, { coords[2], coords[3] }, { coords[4], coords[5] });
+			_Current_point = { coords[4], coords[5] };
 		} break;
 		case std::experimental::io2d::path_data_type::new_sub_path:
 		{
-			hasCurrentPoint = false;
+			_Has_current_point = false;
 		} break;
 		case std::experimental::io2d::path_data_type::close_path:
 		{
-			if (hasCurrentPoint) {
-				cpdItem.header.type = CAIRO_PATH_CLOSE_PATH;
-				cpdItem.header.length = 1;
-				vec.push_back(cpdItem);
-				cpdItem.header.type = CAIRO_PATH_MOVE_TO;
-				cpdItem.header.length = 2;
-				vec.push_back(cpdItem);
-				cpdItem = { };
-				cpdItem.point = { lastMoveToPoint.x(), lastMoveToPoint.y() };
-				vec.push_back(cpdItem);
-				// Calculate the untransformed current point from the transformed lastMoveToPoint.
-				auto inverseMatrix = matrix_2d(matrix).invert();
-				currentPoint = inverseMatrix.transform_point(lastMoveToPoint - origin) + origin;
-				lastMoveToPoint = currentPoint;
+			if (_Has_current_point && !_Close_path()) {
+				return CAIRO_STATUS_INVALID_MATRIX;
 			}
 		} break;
 		case std::experimental::io2d::path_data_type::rel_move_to:
 		{
-			if (!hasCurrentPoint) {
-				_Throw_if_failed_cairo_status_t(CAIRO_STATUS_NO_CURRENT_POINT);
+			if (!_Has_current_point) {
+				return CAIRO_STATUS_NO_CURRENT_POINT;
 			}
-			currentPoint = item.get<path_data_item::rel_move_to>().to() + currentPoint;
-			auto pt = matrix.transform_point(currentPoint - origin) + origin;
-			cpdItem.header.type = CAIRO_PATH_MOVE_TO;
-			cpdItem.header.length = 2;
-			vec.push_back(cpdItem);
-			cpdItem = { };
-			cpdItem.point = { pt.x(), pt.y() };
-			vec.push_back(cpdItem);
-			hasCurrentPoint = true;
-			lastMoveToPoint = pt;
+			_Current_point = vector_2d{ coords[0], coords[1] } + _Current_point;
+			_Move_to(_Current_point);
 		} break;
 		case std::experimental::io2d::path_data_type::rel_line_to:
 		{
-			if (!hasCurrentPoint) {
-				_Throw_if_failed_cairo_status_t(CAIRO_STATUS_NO_CURRENT_POINT);
+			if (!_Has_current_point) {
+				return CAIRO_STATUS_NO_CURRENT_POINT;
 			}
-			currentPoint = item.get<path_data_item::rel_line_to>().to() + currentPoint;
-			auto pt = matrix.transform_point(currentPoint - origin) + origin;
-			cpdItem.header.type = CAIRO_PATH_LINE_TO;
-			cpdItem.header.length = 2;
-			vec.push_back(cpdItem);
-			cpdItem = { };
-			cpdItem.point = { pt.x(), pt.y() };
-			vec.push_back(cpdItem);
+			_Current_point = vector_2d{ coords[0], coords[1] } + _Current_point;
+			_Line_to(_Current_point);
 		} break;
 		case std::experimental::io2d::path_data_type::rel_curve_to:
 		{
-			if (!hasCurrentPoint) {
-				_Throw_if_failed_cairo_status_t(CAIRO_STATUS_NO_CURRENT_POINT);
+			if (!_Has_current_point) {
+				return CAIRO_STATUS_NO_CURRENT_POINT;
 			}
-			auto dataItem = item.get<path_data_item::rel_curve_to>();
-			auto pt1 = matrix.transform_point(dataItem.control_point_1() + currentPoint - origin) + origin;
-			auto pt2 = matrix.transform_point(dataItem.control_point_2() + currentPoint - origin) + origin;
-			auto pt3 = matrix.transform_point(dataItem.end_point() + currentPoint - origin) + origin;
-			cpdItem.header.type = CAIRO_PATH_CURVE_TO;
-			cpdItem.header.length = 4;
-			vec.push_back(cpdItem);
-			cpdItem = { };
-			cpdItem.point = { pt1.x(), pt1.y() };
-			vec.push_back(cpdItem);
-			cpdItem = { };
-			cpdItem.point = { pt2.x(), pt2.y() };
-			vec.push_back(cpdItem);
-			cpdItem = { };
-			cpdItem.point = { pt3.x(), pt3.y() };
-			vec.push_back(cpdItem);
-			currentPoint = dataItem.end_point() + currentPoint;
+			_Curve_to(vector_2d{ coords[0], coords[1] } + _Current_point, vector_2d{ coords[2], coords[3] } + _Current_point, vector_2d{ coords[4], coords[5] } + _Current_point);
+			_Current_point = vector_2d{ coords[4], coords[5] } + _Current_point;
 		} break;
 		case std::experimental::io2d::path_data_type::arc:
 		{
-			auto ad = item.get<path_data_item::arc>();
-			auto ctr = ad.center();
-			auto rad = ad.radius();
-			auto ang1 = ad.angle_1();
-			auto ang2 = ad.angle_2();
+			const vector_2d ctr{ coords[0], coords[1] };
+			auto rad = coords[2];
+			auto ang1 = coords[3];
+			auto ang2 = coords[4];
 			while (ang2 < ang1) {
 #if _Variable_templates_conditional_support_test
                                 ang2 += two_pi<double>;
@@ -238,60 +241,30 @@ path::path(const vector<path_data_item>& pathData)
 			auto currTheta = ang1;
 			const auto startPt =
 				ctr + rotCwFn({ pt0.x() * rad, pt0.y() * rad }, currTheta);
-			if (hasCurrentPoint) {
-				auto pt = matrix.transform_point(startPt - origin) + origin;
-				cpdItem.header.type = CAIRO_PATH_LINE_TO;
-				cpdItem.header.length = 2;
-				vec.push_back(cpdItem);
-				cpdItem = { };
-				cpdItem.point = { pt.x(), pt.y() };
-				vec.push_back(cpdItem);
-				currentPoint = startPt;
+			if (_Has_current_point) {
+				_Line_to(startPt);
 			}
 			else {
-				auto pt = matrix.transform_point(startPt - origin) + origin;
-				cpdItem.header.type = CAIRO_PATH_MOVE_TO;
-				cpdItem.header.length = 2;
-				vec.push_back(cpdItem);
-				cpdItem = { };
-				cpdItem.point = { pt.x(), pt.y() };
-				vec.push_back(cpdItem);
-				currentPoint = startPt;
-				hasCurrentPoint = true;
-				lastMoveToPoint = pt;
+				_Move_to(startPt);
+				_Has_current_point = true;
 			}
+			_Current_point = startPt;
 			for (; bezCount > 0; bezCount--) {
 				auto cpt1 = ctr + rotCwFn({ pt1.x() * rad, pt1.y() * rad }, currTheta);
 				auto cpt2 = ctr + rotCwFn({ pt2.x() * rad, pt2.y() * rad }, currTheta);
 				auto cpt3 = ctr + rotCwFn({ pt3.x() * rad, pt3.y() * rad }, currTheta);
-				currentPoint = cpt3;
-				cpt1 = matrix.transform_point(cpt1 - origin) + origin;
-				cpt2 = matrix.transform_point(cpt2 - origin) + origin;
-				cpt3 = matrix.transform_point(cpt3 - origin) + origin;
-				cpdItem.header.type = CAIRO_PATH_CURVE_TO;
-				cpdItem.header.length = 4;
-				vec.push_back(cpdItem);
-				cpdItem = { };
-				cpdItem.point = { cpt1.x(), cpt1.y() };
-				vec.push_back(cpdItem);
-				cpdItem = { };
-				cpdItem.point = { cpt2.x(), cpt2.y() };
-				vec.push_back(cpdItem);
-				cpdItem = { };
-				cpdItem.point = { cpt3.x(), cpt3.y() };
-				vec.push_back(cpdItem);
+				_Curve_to(cpt1, cpt2, cpt3);
+				_Current_point = cpt3;
 				currTheta += theta;
 			}
-//			currentPoint = _Rotate_point_absolute_angle(ad.center(), ad.radius(), ad.angle_2(), true);
 		}
 		break;
 		case std::experimental::io2d::path_data_type::arc_negative:
 		{
-			auto ad = item.get<path_data_item::arc_negative>();
-			auto ctr = ad.center();
-			auto rad = ad.radius();
-			auto ang1 = ad.angle_1();
-			auto ang2 = ad.angle_2();
+			const vector_2d ctr{ coords[0], coords[1] };
+			auto rad = coords[2];
+			auto ang1 = coords[3];
+			auto ang2 = coords[4];
 			while (ang2 > ang1) {
 #if _Variable_templates_conditional_support_test
                                 ang2 -= two_pi<double>;
@@ -342,696 +315,192 @@ path::path(const vector<path_data_item>& pathData)
 			auto currTheta = ang1;
 			const auto startPt =
 				ctr + rotCwFn({ pt0.x() * rad, pt0.y() * rad }, currTheta);
-			if (hasCurrentPoint) {
-				auto pt = matrix.transform_point(startPt - origin) + origin;
-				cpdItem.header.type = CAIRO_PATH_LINE_TO;
-				cpdItem.header.length = 2;
-				vec.push_back(cpdItem);
-				cpdItem = { };
-				cpdItem.point = { pt.x(), pt.y() };
-				vec.push_back(cpdItem);
-				currentPoint = startPt;
+			if (_Has_current_point) {
+				_Line_to(startPt);
 			}
 			else {
-				auto pt = matrix.transform_point(startPt - origin) + origin;
-				cpdItem.header.type = CAIRO_PATH_MOVE_TO;
-				cpdItem.header.length = 2;
-				vec.push_back(cpdItem);
-				cpdItem = { };
-				cpdItem.point = { pt.x(), pt.y() };
-				vec.push_back(cpdItem);
-				currentPoint = startPt;
-				hasCurrentPoint = true;
-				lastMoveToPoint = pt;
+				_Move_to(startPt);
+				_Has_current_point = true;
 			}
+			_Current_point = startPt;
 			for (; bezCount > 0; bezCount--) {
 				auto cpt1 = ctr + rotCwFn({ pt1.x() * rad, pt1.y() * rad }, currTheta);
 				auto cpt2 = ctr + rotCwFn({ pt2.x() * rad, pt2.y() * rad }, currTheta);
 				auto cpt3 = ctr + rotCwFn({ pt3.x() * rad, pt3.y() * rad }, currTheta);
-				currentPoint = cpt3;
-				cpt1 = matrix.transform_point(cpt1 - origin) + origin;
-				cpt2 = matrix.transform_point(cpt2 - origin) + origin;
-				cpt3 = matrix.transform_point(cpt3 - origin) + origin;
-				cpdItem.header.type = CAIRO_PATH_CURVE_TO;
-				cpdItem.header.length = 4;
-				vec.push_back(cpdItem);
-				cpdItem = { };
-				cpdItem.point = { cpt1.x(), cpt1.y() };
-				vec.push_back(cpdItem);
-				cpdItem = { };
-				cpdItem.point = { cpt2.x(), cpt2.y() };
-				vec.push_back(cpdItem);
-				cpdItem = { };
-				cpdItem.point = { cpt3.x(), cpt3.y() };
-				vec.push_back(cpdItem);
+				_Curve_to(cpt1, cpt2, cpt3);
+				_Current_point = cpt3;
 				currTheta -= theta;
 			}
-
-			//auto dataItem = item.get<arc_negative>();
-			//auto data = _Get_arc_as_beziers(dataItem.center(), dataItem.radius(), dataItem.angle_1(), dataItem.angle_2(), true, hasCurrentPoint, currentPoint, origin, matrix);
-			//for (const auto& arcItem : data) {
-			//	switch (arcItem.type()) {
-			//	case std::experimental::io2d::path_data_type::move_to:
-			//	{
-			//		currentPoint = arcItem.get<move_to>().to();
-			//		auto pt = matrix.transform_point(currentPoint - origin) + origin;
-			//		cpdItem.header.type = CAIRO_PATH_MOVE_TO;
-			//		cpdItem.header.length = 2;
-			//		vec.push_back(cpdItem);
-			//		cpdItem = { };
-			//		cpdItem.point = { pt.x(), pt.y() };
-			//		vec.push_back(cpdItem);
-			//		hasCurrentPoint = true;
-			//		lastMoveToPoint = pt;
-			//	} break;
-			//	case std::experimental::io2d::path_data_type::line_to:
-			//	{
-			//		currentPoint = arcItem.get<line_to>().to();
-			//		auto pt = matrix.transform_point(currentPoint - origin) + origin;
-			//		if (hasCurrentPoint) {
-			//			cpdItem.header.type = CAIRO_PATH_LINE_TO;
-			//			cpdItem.header.length = 2;
-			//			vec.push_back(cpdItem);
-			//			cpdItem = { };
-			//			cpdItem.point = { pt.x(), pt.y() };
-			//			vec.push_back(cpdItem);
-			//		}
-			//		else {
-			//			cpdItem.header.type = CAIRO_PATH_MOVE_TO;
-			//			cpdItem.header.length = 2;
-			//			vec.push_back(cpdItem);
-			//			cpdItem = { };
-			//			cpdItem.point = { pt.x(), pt.y() };
-			//			vec.push_back(cpdItem);
-			//			hasCurrentPoint = true;
-			//			lastMoveToPoint = pt;
-			//		}
-			//	} break;
-			//	case std::experimental::io2d::path_data_type::curve_to:
-			//	{
-			//		auto curveItem = arcItem.get<curve_to>();
-			//		auto pt1 = matrix.transform_point(curveItem.control_point_1() - origin) + origin;
-			//		auto pt2 = matrix.transform_point(curveItem.control_point_2() - origin) + origin;
-			//		auto pt3 = matrix.transform_point(curveItem.end_point() - origin) + origin;
-			//		if (!hasCurrentPoint) {
-			//			cpdItem.header.type = CAIRO_PATH_MOVE_TO;
-			//			cpdItem.header.length = 2;
-			//			vec.push_back(cpdItem);
-			//			cpdItem = { };
-			//			cpdItem.point = { pt1.x(), pt1.y() };
-			//			vec.push_back(cpdItem);
-			//			currentPoint = curveItem.control_point_1();
-			//			lastMoveToPoint = pt1;
-			//			hasCurrentPoint = true;
-			//		}
-			//		cpdItem.header.type = CAIRO_PATH_CURVE_TO;
-			//		cpdItem.header.length = 4;
-			//		vec.push_back(cpdItem);
-			//		cpdItem = { };
-			//		cpdItem.point = { pt1.x(), pt1.y() };
-			//		vec.push_back(cpdItem);
-			//		cpdItem = { };
-			//		cpdItem.point = { pt2.x(), pt2.y() };
-			//		vec.push_back(cpdItem);
-			//		cpdItem = { };
-			//		cpdItem.point = { pt3.x(), pt3.y() };
-			//		vec.push_back(cpdItem);
-			//		currentPoint = curveItem.end_point();
-			//	} break;
-			//	case path_data_type::new_sub_path:
-			//	{
-			//		assert("Unexpected value path_data_type::new_sub_path." && false);
-			//	} break;
-			//	case path_data_type::close_path:
-			//	{
-			//		assert("Unexpected value path_data_type::close_path." && false);
-			//	} break;
-			//	case path_data_type::rel_move_to:
-			//	{
-			//		assert("Unexpected value path_data_type::rel_move_to." && false);
-			//	} break;
-			//	case path_data_type::rel_line_to:
-			//	{
-			//		assert("Unexpected value path_data_type::rel_line_to." && false);
-			//	} break;
-			//	case path_data_type::rel_curve_to:
-			//	{
-			//		assert("Unexpected value path_data_type::rel_curve_to." && false);
-			//	} break;
-			//	case path_data_type::arc:
-			//	{
-			//		assert("Unexpected value path_data_type::arc." && false);
-			//	} break;
-			//	case path_data_type::arc_negative:
-			//	{
-			//		assert("Unexpected value path_data_type::arc_negative." && false);
-			//	} break;
-			//	case path_data_type::change_origin:
-			//	{
-			//		// Ignore, it's just spitting out the value we handed it.
-			//	} break;
-			//	case path_data_type::change_matrix:
-			//	{
-			//		// Ignore, it's just spitting out the value we handed it.
-			//	} break;
-			//	default:
-			//		assert("Unexpected path_data_type in arc." && false);
-			//		break;
-			//	}
-			//}
-			//currentPoint = _Rotate_point_absolute_angle(ad.center(), ad.radius(), ad.angle_2());
-			//hasCurrentPoint = true;
 		}
 		break;
 		case std::experimental::io2d::path_data_type::change_matrix:
 		{
-			matrix = item.get<path_data_item::change_matrix>().matrix();
+			_Item_matrix = { coords[0], coords[1], coords[2], coords[3], coords[4], coords[5] };
+			_Transform(_Item_matrix, _Item_origin);
 		} break;
 		case std::experimental::io2d::path_data_type::change_origin:
 		{
-			origin = item.get<path_data_item::change_origin>().origin();
+			_Item_origin = { coords[0], coords[1] };
+			_Transform(_Item_matrix, _Item_origin);
 		} break;
+#ifdef __clang__
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wunreachable-code-break"
+#endif
 		default:
 		{
-			_Throw_if_failed_cairo_status_t(CAIRO_STATUS_INVALID_PATH_DATA);
+			return CAIRO_STATUS_INVALID_PATH_DATA;
 		} break;
+#ifdef __clang__
+#pragma clang diagnostic pop
+#endif
 		}
+		coords += path_factory::_Coord_count(pdt);
 	}
+	_Flush();
+	_Verb_count = verbCount;
+	_Coord_count = pf._Coords.size();
+	return CAIRO_STATUS_SUCCESS;
+}
 
-	_Cairo_path->num_data = static_cast<int>(vec.size());
-	const auto numDataST = vec.size();
-	_Cairo_path->data = new cairo_path_data_t[numDataST];
-	for (size_t currItemIndex = 0; currItemIndex < numDataST; currItemIndex++) {
-		_Cairo_path->data[currItemIndex] = vec[currItemIndex];
+void _Cairo_path_converter::convert(const path_factory& pf) {
+	cairo_status_t status;
+	try {
+		status = _Convert(pf);
 	}
-	_Cairo_path->status = CAIRO_STATUS_SUCCESS;
-
-	for (const auto& item : pathData) {
-		_Data->push_back(item);
+	catch (...) {
+		reset();
+		throw;
+	}
+	if (status != CAIRO_STATUS_SUCCESS) {
+		reset();
+		_Throw_if_failed_cairo_status_t(status);
 	}
 }
 
-path::path(const path_factory& pb, error_code& ec) noexcept
-	: path(pb.data_ref(), ec) {
-}
-
-path::path(const vector<path_data_item>& pathData, error_code& ec) noexcept
-	: _Data()
-	, _Cairo_path() {
+void _Cairo_path_converter::convert(const path_factory& pf, error_code& ec) noexcept {
 	try {
-		_Data = make_shared<vector<path_data_item>>();
+		auto status = _Convert(pf);
+		if (status != CAIRO_STATUS_SUCCESS) {
+			reset();
+			ec = _Cairo_status_t_to_std_error_code(status);
+			return;
+		}
 	}
 	catch (const bad_alloc&) {
+		reset();
 		ec = make_error_code(errc::not_enough_memory);
 		return;
 	}
-	auto p_cairoPath = new (nothrow) cairo_path_t;
-	if (p_cairoPath == nullptr) {
-		ec = make_error_code(errc::not_enough_memory);
+	ec.clear();
+}
+
+void _Cairo_path_converter::reset() noexcept {
+	_Revision = 0;
+	_Verb_count = 0;
+	_Coord_count = 0;
+	_Item_matrix = matrix_2d::init_identity();
+	_Item_origin = { };
+	_Has_current_point = false;
+	_Current_point = { };
+	_Headers.clear();
+	_Points.clear();
+	_Run_start = 0;
+	_Matrix = matrix_2d::init_identity();
+	_Last_move_to = { };
+	_Last_move_to_in_run = false;
+	_Data.clear();
+}
+
+vector<cairo_path_data_t> _Cairo_path_converter::release_data() noexcept {
+	auto data = move(_Data);
+	reset();
+	return data;
+}
+
+cairo_path_t _Cairo_path_converter::native_path() const noexcept {
+	cairo_path_t result;
+	result.status = CAIRO_STATUS_SUCCESS;
+	result.data = const_cast<cairo_path_data_t*>(_Data.data());
+	result.num_data = static_cast<int>(_Data.size());
+	return result;
+}
+
+path::native_handle_type path::native_handle() const noexcept {
+	return _Native == nullptr ? nullptr : &_Native->_Cairo_path;
+}
+
+void path::_Set_on(cairo_t* context) const noexcept {
+	if (_Native == nullptr) {
+		cairo_new_path(context);
 		return;
 	}
-	try {
-		_Cairo_path = shared_ptr<cairo_path_t>(p_cairoPath, &_Free_manual_cairo_path);
-		p_cairoPath = nullptr;
-	}
-	catch (const exception& ex) {
-		// The constructor we use ensures that our custom deleter is called on p_cairoPath in the event of an exception.
-		assert(ex.what());
-		ec = make_error_code(io2d_error::invalid_status);
+	auto compiled = atomic_load(&_Native->_Compiled);
+	if (compiled != nullptr && cairo_set_compiled_path(context, compiled.get())) {
 		return;
 	}
-	auto matrix = matrix_2d::init_identity();
-	vector_2d origin{ };
-	bool hasCurrentPoint = false;
-	// Untransformed because we use it to add to raw relative points for transformation.
-	vector_2d currentPoint{ };
-	// Transformed because we need to know where the transformed last move to point is when we receive a close path instruction and the matrix and origin may have since changed such that we wouldn't be able to calculate it correctly anymore.
-	vector_2d lastMoveToPoint{ };
-	auto pdSize = pathData.size();
-	try {
-		vector<cairo_path_data_t> vec;
-		for (unsigned int i = 0; i < pdSize; i++) {
-			const auto& item = pathData[i];
-			cairo_path_data_t cpdItem{ };
-			auto pdt = item.type();
-			switch (pdt) {
-			case std::experimental::io2d::path_data_type::move_to:
-			{
-				currentPoint = item.get<path_data_item::move_to>().to();
-				auto pt = matrix.transform_point(currentPoint - origin) + origin;
-				cpdItem.header.type = CAIRO_PATH_MOVE_TO;
-				cpdItem.header.length = 2;
-				vec.push_back(cpdItem);
-				cpdItem = { };
-				cpdItem.point = { pt.x(), pt.y() };
-				vec.push_back(cpdItem);
-				hasCurrentPoint = true;
-				lastMoveToPoint = pt;
-			} break;
-			case std::experimental::io2d::path_data_type::line_to:
-			{
-				currentPoint = item.get<path_data_item::line_to>().to();
-				auto pt = matrix.transform_point(currentPoint - origin) + origin;
-				if (hasCurrentPoint) {
-					cpdItem.header.type = CAIRO_PATH_LINE_TO;
-					cpdItem.header.length = 2;
-					vec.push_back(cpdItem);
-					cpdItem = { };
-					cpdItem.point = { pt.x(), pt.y() };
-					vec.push_back(cpdItem);
-				}
-				else {
-					cpdItem.header.type = CAIRO_PATH_MOVE_TO;
-					cpdItem.header.length = 2;
-					vec.push_back(cpdItem);
-					cpdItem = { };
-					cpdItem.point = { pt.x(), pt.y() };
-					vec.push_back(cpdItem);
-					hasCurrentPoint = true;
-					lastMoveToPoint = pt;
-				}
-			} break;
-			case std::experimental::io2d::path_data_type::curve_to:
-			{
-				auto dataItem = item.get<path_data_item::curve_to>();
-				auto pt1 = matrix.transform_point(dataItem.control_point_1() - origin) + origin;
-				auto pt2 = matrix.transform_point(dataItem.control_point_2() - origin) + origin;
-				auto pt3 = matrix.transform_point(dataItem.end_point() - origin) + origin;
-				if (!hasCurrentPoint) {
-					cpdItem.header.type = CAIRO_PATH_MOVE_TO;
-					cpdItem.header.length = 2;
-					vec.push_back(cpdItem);
-					cpdItem = { };
-					cpdItem.point = { pt1.x(), pt1.y() };
-					vec.push_back(cpdItem);
-					currentPoint = dataItem.control_point_1();
-					lastMoveToPoint = pt1;
-					hasCurrentPoint = true;
-				}
-				cpdItem.header.type = CAIRO_PATH_CURVE_TO;
-				cpdItem.header.length = 4;
-				vec.push_back(cpdItem);
-				cpdItem = { };
-				cpdItem.point = { pt1.x(), pt1.y() };
-				vec.push_back(cpdItem);
-				cpdItem = { };
-				cpdItem.point = { pt2.x(), pt2.y() };
-				vec.push_back(cpdItem);
-				cpdItem = { };
-				cpdItem.point = { pt3.x(), pt3.y() };
-				vec.push_back(cpdItem);
-				currentPoint = dataItem.end_point();
-			} break;
-			case std::experimental::io2d::path_data_type::new_sub_path:
-			{
-				hasCurrentPoint = false;
-			} break;
-			case std::experimental::io2d::path_data_type::close_path:
-			{
-				if (hasCurrentPoint) {
-					cpdItem.header.type = CAIRO_PATH_CLOSE_PATH;
-					cpdItem.header.length = 1;
-					vec.push_back(cpdItem);
-					cpdItem.header.type = CAIRO_PATH_MOVE_TO;
-					cpdItem.header.length = 2;
-					vec.push_back(cpdItem);
-					cpdItem = { };
-					cpdItem.point = { lastMoveToPoint.x(), lastMoveToPoint.y() };
-					vec.push_back(cpdItem);
-					// Calculate the untransformed current point from the transformed lastMoveToPoint.
-					auto inverseMatrix = matrix_2d(matrix).invert(ec);
-					if (static_cast<bool>(ec)) {
-						_Data.reset();
-						_Cairo_path.reset();
-						return;
-					}
-					currentPoint = inverseMatrix.transform_point(lastMoveToPoint - origin) + origin;
-					lastMoveToPoint = currentPoint;
-				}
-			} break;
-			case std::experimental::io2d::path_data_type::rel_move_to:
-			{
-				if (!hasCurrentPoint) {
-					ec = _Cairo_status_t_to_std_error_code(CAIRO_STATUS_NO_CURRENT_POINT);
-					_Data.reset();
-					_Cairo_path.reset();
-					return;
-				}
-				currentPoint = item.get<path_data_item::rel_move_to>().to() + currentPoint;
-				auto pt = matrix.transform_point(currentPoint - origin) + origin;
-				cpdItem.header.type = CAIRO_PATH_MOVE_TO;
-				cpdItem.header.length = 2;
-				vec.push_back(cpdItem);
-				cpdItem = { };
-				cpdItem.point = { pt.x(), pt.y() };
-				vec.push_back(cpdItem);
-				hasCurrentPoint = true;
-				lastMoveToPoint = pt;
-			} break;
-			case std::experimental::io2d::path_data_type::rel_line_to:
-			{
-				if (!hasCurrentPoint) {
-					ec = _Cairo_status_t_to_std_error_code(CAIRO_STATUS_NO_CURRENT_POINT);
-					_Data.reset();
-					_Cairo_path.reset();
-					return;
-				}
-				currentPoint = item.get<path_data_item::rel_line_to>().to() + currentPoint;
-				auto pt = matrix.transform_point(currentPoint - origin) + origin;
-				cpdItem.header.type = CAIRO_PATH_LINE_TO;
-				cpdItem.header.length = 2;
-				vec.push_back(cpdItem);
-				cpdItem = { };
-				cpdItem.point = { pt.x(), pt.y() };
-				vec.push_back(cpdItem);
-			} break;
-			case std::experimental::io2d::path_data_type::rel_curve_to:
-			{
-				if (!hasCurrentPoint) {
-					ec = _Cairo_status_t_to_std_error_code(CAIRO_STATUS_NO_CURRENT_POINT);
-					_Data.reset();
-					_Cairo_path.reset();
-					return;
-				}
-				auto dataItem = item.get<path_data_item::rel_curve_to>();
-				auto pt1 = matrix.transform_point(dataItem.control_point_1() + currentPoint - origin) + origin;
-				auto pt2 = matrix.transform_point(dataItem.control_point_2() + currentPoint - origin) + origin;
-				auto pt3 = matrix.transform_point(dataItem.end_point() + currentPoint - origin) + origin;
-				cpdItem.header.type = CAIRO_PATH_CURVE_TO;
-				cpdItem.header.length = 4;
-				vec.push_back(cpdItem);
-				cpdItem = { };
-				cpdItem.point = { pt1.x(), pt1.y() };
-				vec.push_back(cpdItem);
-				cpdItem = { };
-				cpdItem.point = { pt2.x(), pt2.y() };
-				vec.push_back(cpdItem);
-				cpdItem = { };
-				cpdItem.point = { pt3.x(), pt3.y() };
-				vec.push_back(cpdItem);
-				currentPoint = dataItem.end_point() + currentPoint;
-			} break;
-			case std::experimental::io2d::path_data_type::arc:
-			{
-				auto dataItem = item.get<path_data_item::arc>();
-				auto data = _Get_arc_as_beziers(dataItem.center(), dataItem.radius(), dataItem.angle_1(), dataItem.angle_2(), ec, false, hasCurrentPoint, currentPoint, origin, matrix);
-				if (static_cast<bool>(ec)) {
-					_Data.reset();
-					_Cairo_path.reset();
-					return;
-				}
-				for (const auto& arcItem : data) {
-					switch (arcItem.type()) {
-					case std::experimental::io2d::path_data_type::move_to:
-					{
-						currentPoint = arcItem.get<path_data_item::move_to>().to();
-						auto pt = matrix.transform_point(currentPoint - origin) + origin;
-						cpdItem.header.type = CAIRO_PATH_MOVE_TO;
-						cpdItem.header.length = 2;
-						vec.push_back(cpdItem);
-						cpdItem = { };
-						cpdItem.point = { pt.x(), pt.y() };
-						vec.push_back(cpdItem);
-						hasCurrentPoint = true;
-						lastMoveToPoint = pt;
-					} break;
-					case std::experimental::io2d::path_data_type::line_to:
-					{
-						currentPoint = arcItem.get<path_data_item::line_to>().to();
-						auto pt = matrix.transform_point(currentPoint - origin) + origin;
-						if (hasCurrentPoint) {
-							cpdItem.header.type = CAIRO_PATH_LINE_TO;
-							cpdItem.header.length = 2;
-							vec.push_back(cpdItem);
-							cpdItem = { };
-							cpdItem.point = { pt.x(), pt.y() };
-							vec.push_back(cpdItem);
-						}
-						else {
-							cpdItem.header.type = CAIRO_PATH_MOVE_TO;
-							cpdItem.header.length = 2;
-							vec.push_back(cpdItem);
-							cpdItem = { };
-							cpdItem.point = { pt.x(), pt.y() };
-							vec.push_back(cpdItem);
-							hasCurrentPoint = true;
-							lastMoveToPoint = pt;
-						}
-					} break;
-					case std::experimental::io2d::path_data_type::curve_to:
-					{
-						auto curveItem = arcItem.get<path_data_item::curve_to>();
-						auto pt1 = matrix.transform_point(curveItem.control_point_1() - origin) + origin;
-						auto pt2 = matrix.transform_point(curveItem.control_point_2() - origin) + origin;
-						auto pt3 = matrix.transform_point(curveItem.end_point() - origin) + origin;
-						if (!hasCurrentPoint) {
-							cpdItem.header.type = CAIRO_PATH_MOVE_TO;
-							cpdItem.header.length = 2;
-							vec.push_back(cpdItem);
-							cpdItem = { };
-							cpdItem.point = { pt1.x(), pt1.y() };
-							vec.push_back(cpdItem);
-							currentPoint = curveItem.control_point_1();
-							lastMoveToPoint = pt1;
-							hasCurrentPoint = true;
-						}
-						cpdItem.header.type = CAIRO_PATH_CURVE_TO;
-						cpdItem.header.length = 4;
-						vec.push_back(cpdItem);
-						cpdItem = { };
-						cpdItem.point = { pt1.x(), pt1.y() };
-						vec.push_back(cpdItem);
-						cpdItem = { };
-						cpdItem.point = { pt2.x(), pt2.y() };
-						vec.push_back(cpdItem);
-						cpdItem = { };
-						cpdItem.point = { pt3.x(), pt3.y() };
-						vec.push_back(cpdItem);
-						currentPoint = curveItem.end_point();
-					} break;
-					case path_data_type::new_sub_path:
-					{
-						assert("Unexpected value path_data_type::new_sub_path." && false);
-					} break;
-					case path_data_type::close_path:
-					{
-						assert("Unexpected value path_data_type::close_path." && false);
-					} break;
-					case path_data_type::rel_move_to:
-					{
-						assert("Unexpected value path_data_type::rel_move_to." && false);
-					} break;
-					case path_data_type::rel_line_to:
-					{
-						assert("Unexpected value path_data_type::rel_line_to." && false);
-					} break;
-					case path_data_type::rel_curve_to:
-					{
-						assert("Unexpected value path_data_type::rel_curve_to." && false);
-					} break;
-					case path_data_type::arc:
-					{
-						assert("Unexpected value path_data_type::arc." && false);
-					} break;
-					case path_data_type::arc_negative:
-					{
-						assert("Unexpected value path_data_type::arc_negative." && false);
-					} break;
-					case path_data_type::change_origin:
-					{
-						// Ignore, it's just spitting out the value we handed it.
-					} break;
-					case path_data_type::change_matrix:
-					{
-						// Ignore, it's just spitting out the value we handed it.
-					} break;
-					default:
-						assert("Unexpected path_data_type in arc." && false);
-						break;
-					}
-				}
-				currentPoint = _Rotate_point_absolute_angle(dataItem.center(), dataItem.radius(), dataItem.angle_2(), true);
-				hasCurrentPoint = true;
-			}
-			break;
-			case std::experimental::io2d::path_data_type::arc_negative:
-			{
-				auto dataItem = item.get<path_data_item::arc_negative>();
-				auto data = _Get_arc_as_beziers(dataItem.center(), dataItem.radius(), dataItem.angle_1(), dataItem.angle_2(), ec, true, hasCurrentPoint, currentPoint, origin, matrix);
-				if (static_cast<bool>(ec)) {
-					_Data.reset();
-					_Cairo_path.reset();
-					return;
-				}
-				for (const auto& arcItem : data) {
-					switch (arcItem.type()) {
-					case std::experimental::io2d::path_data_type::move_to:
-					{
-						currentPoint = arcItem.get<path_data_item::move_to>().to();
-						auto pt = matrix.transform_point(currentPoint - origin) + origin;
-						cpdItem.header.type = CAIRO_PATH_MOVE_TO;
-						cpdItem.header.length = 2;
-						vec.push_back(cpdItem);
-						cpdItem = { };
-						cpdItem.point = { pt.x(), pt.y() };
-						vec.push_back(cpdItem);
-						hasCurrentPoint = true;
-						lastMoveToPoint = pt;
-					} break;
-					case std::experimental::io2d::path_data_type::line_to:
-					{
-						currentPoint = arcItem.get<path_data_item::line_to>().to();
-						auto pt = matrix.transform_point(currentPoint - origin) + origin;
-						if (hasCurrentPoint) {
-							cpdItem.header.type = CAIRO_PATH_LINE_TO;
-							cpdItem.header.length = 2;
-							vec.push_back(cpdItem);
-							cpdItem = { };
-							cpdItem.point = { pt.x(), pt.y() };
-							vec.push_back(cpdItem);
-						}
-						else {
-							cpdItem.header.type = CAIRO_PATH_MOVE_TO;
-							cpdItem.header.length = 2;
-							vec.push_back(cpdItem);
-							cpdItem = { };
-							cpdItem.point = { pt.x(), pt.y() };
-							vec.push_back(cpdItem);
-							hasCurrentPoint = true;
-							lastMoveToPoint = pt;
-						}
-					} break;
-					case std::experimental::io2d::path_data_type::curve_to:
-					{
-						auto curveItem = arcItem.get<path_data_item::curve_to>();
-						auto pt1 = matrix.transform_point(curveItem.control_point_1() - origin) + origin;
-						auto pt2 = matrix.transform_point(curveItem.control_point_2() - origin) + origin;
-						auto pt3 = matrix.transform_point(curveItem.end_point() - origin) + origin;
-						if (!hasCurrentPoint) {
-							cpdItem.header.type = CAIRO_PATH_MOVE_TO;
-							cpdItem.header.length = 2;
-							vec.push_back(cpdItem);
-							cpdItem = { };
-							cpdItem.point = { pt1.x(), pt1.y() };
-							vec.push_back(cpdItem);
-							currentPoint = curveItem.control_point_1();
-							lastMoveToPoint = pt1;
-							hasCurrentPoint = true;
-						}
-						cpdItem.header.type = CAIRO_PATH_CURVE_TO;
-						cpdItem.header.length = 4;
-						vec.push_back(cpdItem);
-						cpdItem = { };
-						cpdItem.point = { pt1.x(), pt1.y() };
-						vec.push_back(cpdItem);
-						cpdItem = { };
-						cpdItem.point = { pt2.x(), pt2.y() };
-						vec.push_back(cpdItem);
-						cpdItem = { };
-						cpdItem.point = { pt3.x(), pt3.y() };
-						vec.push_back(cpdItem);
-						currentPoint = curveItem.end_point();
-					} break;
-					case path_data_type::new_sub_path:
-					{
-						assert("Unexpected value path_data_type::new_sub_path." && false);
-					} break;
-					case path_data_type::close_path:
-					{
-						assert("Unexpected value path_data_type::close_path." && false);
-					} break;
-					case path_data_type::rel_move_to:
-					{
-						assert("Unexpected value path_data_type::rel_move_to." && false);
-					} break;
-					case path_data_type::rel_line_to:
-					{
-						assert("Unexpected value path_data_type::rel_line_to." && false);
-					} break;
-					case path_data_type::rel_curve_to:
-					{
-						assert("Unexpected value path_data_type::rel_curve_to." && false);
-					} break;
-					case path_data_type::arc:
-					{
-						assert("Unexpected value path_data_type::arc." && false);
-					} break;
-					case path_data_type::arc_negative:
-					{
-						assert("Unexpected value path_data_type::arc_negative." && false);
-					} break;
-					case path_data_type::change_origin:
-					{
-						// Ignore, it's just spitting out the value we handed it.
-					} break;
-					case path_data_type::change_matrix:
-					{
-						// Ignore, it's just spitting out the value we handed it.
-					} break;
-					default:
-						assert("Unexpected path_data_type in arc." && false);
-						break;
-					}
-				}
-				currentPoint = _Rotate_point_absolute_angle(dataItem.center(), dataItem.radius(), dataItem.angle_2());
-				hasCurrentPoint = true;
-			}
-			break;
-			case std::experimental::io2d::path_data_type::change_matrix:
-			{
-				matrix = item.get<path_data_item::change_matrix>().matrix();
-			} break;
-			case std::experimental::io2d::path_data_type::change_origin:
-			{
-				origin = item.get<path_data_item::change_origin>().origin();
-			} break;
-#ifdef __clang__
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wunreachable-code-break"
-#endif
-			default:
-			{
-				ec = _Cairo_status_t_to_std_error_code(CAIRO_STATUS_INVALID_PATH_DATA);
-				_Data.reset();
-				_Cairo_path.reset();
+	auto p_compiled = cairo_compiled_path_create(context, &_Native->_Cairo_path);
+	if (p_compiled != nullptr) {
+		try {
+			// The constructor we use ensures that our custom deleter is called on p_compiled in the event of an exception.
+			compiled = shared_ptr<cairo_compiled_path_t>(p_compiled, &cairo_compiled_path_destroy);
+			atomic_store(&_Native->_Compiled, compiled);
+			if (cairo_set_compiled_path(context, compiled.get())) {
 				return;
-			} break;
-#ifdef __clang__
-#pragma clang diagnostic pop
-#endif
 			}
 		}
-
-		_Cairo_path->num_data = static_cast<int>(vec.size());
-		const auto numDataST = vec.size();
-		_Cairo_path->data = new cairo_path_data_t[numDataST];
-		for (size_t currItemIndex = 0; currItemIndex < numDataST; currItemIndex++) {
-			_Cairo_path->data[currItemIndex] = vec[currItemIndex];
+		catch (const bad_alloc&) {
 		}
-		_Cairo_path->status = CAIRO_STATUS_SUCCESS;
+	}
+	cairo_new_path(context);
+	cairo_append_path(context, &_Native->_Cairo_path);
+}
 
-		for (const auto& item : pathData) {
-			_Data->push_back(item);
-		}
+path::path(const vector<path_data_item>& pathData)
+: path(_Make_path_factory(pathData)) {
+}
+
+path::path(const path_factory& pb)
+: _Native() {
+	_Cairo_path_converter converter;
+	converter.convert(pb);
+	_Native = make_shared<_Native_path>(converter);
+}
+
+path::path(const vector<path_data_item>& pathData, error_code& ec) noexcept
+	: _Native() {
+	path_factory pb;
+	pb.append(pathData, ec);
+	if (static_cast<bool>(ec)) {
+		return;
+	}
+	*this = path(pb, ec);
+}
+
+path::path(const path_factory& pb, error_code& ec) noexcept
+	: _Native() {
+	_Cairo_path_converter converter;
+	converter.convert(pb, ec);
+	if (static_cast<bool>(ec)) {
+		return;
+	}
+	try {
+		_Native = make_shared<_Native_path>(converter);
 	}
 	catch (const bad_alloc&) {
 		ec = make_error_code(errc::not_enough_memory);
-		_Data.reset();
-		_Cairo_path.reset();
 		return;
 	}
 	ec.clear();
 }
 
 path::path(path&& other) noexcept
-	: _Data(move(other._Data))
-	, _Cairo_path(move(other._Cairo_path)) {
+	: _Native(move(other._Native)) {
 }
 
 path& path::operator=(path&& other) noexcept {
 	if (this != &other) {
-		_Data = move(other._Data);
-		_Cairo_path = move(other._Cairo_path);
+		_Native = move(other._Native);
 	}
 	return *this;
 }
@@ -7,36 +7,279 @@
 using namespace std;
 using namespace std::experimental::io2d;
 
-path_factory::path_factory(path_factory&& other) noexcept
-	: _Data()
-	, _Has_current_point()
-	, _Current_point()
-	, _Transform_matrix()
-	, _Origin() {
-	_Data = move(other._Data);
-	_Has_current_point = move(other._Has_current_point);
-	_Current_point = move(other._Current_point);
-	_Last_move_to_point = move(other._Last_move_to_point);
-	_Transform_matrix = move(other._Transform_matrix);
-	_Origin = move(other._Origin);
+uint_least64_t path_factory::_Next_revision() noexcept {
+	static atomic<uint_least64_t> revision{ 0 };
+	return ++revision;
 }
 
-path_factory& path_factory::operator=(path_factory&& other) noexcept {
+size_t path_factory::_Coord_count(path_data_type type) noexcept {
+	switch (type) {
+	case std::experimental::io2d::path_data_type::move_to:
+	case std::experimental::io2d::path_data_type::line_to:
+	case std::experimental::io2d::path_data_type::rel_move_to:
+	case std::experimental::io2d::path_data_type::rel_line_to:
+	case std::experimental::io2d::path_data_type::change_origin:
+		return 2;
+	case std::experimental::io2d::path_data_type::curve_to:
+	case std::experimental::io2d::path_data_type::rel_curve_to:
+	case std::experimental::io2d::path_data_type::change_matrix:
+		return 6;
+	case std::experimental::io2d::path_data_type::arc:
+	case std::experimental::io2d::path_data_type::arc_negative:
+		// center x and y, radius, angle 1, angle 2
+		return 5;
+	case std::experimental::io2d::path_data_type::new_sub_path:
+	case std::experimental::io2d::path_data_type::close_path:
+		return 0;
+	default:
+		assert("Unknown path_data_type." && false);
+		return 0;
+	}
+}
+
+path_data_item path_factory::_Make_data_item(path_data_type type, const double* coords) noexcept {
+	switch (type) {
+	case std::experimental::io2d::path_data_type::move_to:
+		return experimental::io2d::path_data_item::move_to({ coords[0], coords[1] });
+	case std::experimental::io2d::path_data_type::line_to:
+		return experimental::io2d::path_data_item::line_to({ coords[0], coords[1] });
+	case std::experimental::io2d::path_data_type::curve_to:
+		return experimental::io2d::path_data_item::curve_to({ coords[0], coords[1] }, { coords[2], coords[3] }, { coords[4], coords[5] });
+	case std::experimental::io2d::path_data_type::new_sub_path:
+		return experimental::io2d::path_data_item::new_sub_path();
+	case std::experimental::io2d::path_data_type::close_path:
+		return experimental::io2d::path_data_item::close_path();
+	case std::experimental::io2d::path_data_type::rel_move_to:
+		return experimental::io2d::path_data_item::rel_move_to({ coords[0], coords[1] });
+	case std::experimental::io2d::path_data_type::rel_line_to:
+		return experimental::io2d::path_data_item::rel_line_to({ coords[0], coords[1] });
+	case std::experimental::io2d::path_data_type::rel_curve_to:
+		return experimental::io2d::path_data_item::rel_curve_to({ coords[0], coords[1] }, { coords[2], coords[3] }, { coords[4], coords[5] });
+	case std::experimental::io2d::path_data_type::arc:
+		return experimental::io2d::path_data_item::arc({ coords[0], coords[1] }, coords[2], coords[3], coords[4]);
+	case std::experimental::io2d::path_data_type::arc_negative:
+		return experimental::io2d::path_data_item::arc_negative({ coords[0], coords[1] }, coords[2], coords[3], coords[4]);
+	case std::experimental::io2d::path_data_type::change_matrix:
+		return experimental::io2d::path_data_item::change_matrix({ coords[0], coords[1], coords[2], coords[3], coords[4], coords[5] });
+	case std::experimental::io2d::path_data_type::change_origin:
+		return experimental::io2d::path_data_item::change_origin({ coords[0], coords[1] });
+	default:
+		assert("Unknown path_data_type." && false);
+		return path_data_item{ };
+	}
+}
+
+void path_factory::_Add(path_data_type type, initializer_list<double> coords) {
+	assert(coords.size() == _Coord_count(type));
+	_Coords.insert(_Coords.end(), coords);
+	try {
+		_Verbs.push_back(static_cast<unsigned char>(type));
+	}
+	catch (...) {
+		// Keep the two streams in step.
+		_Coords.resize(_Coords.size() - coords.size());
+		throw;
+	}
+}
+
+void path_factory::_Add(const path_data_item& item) {
+	switch (item.type()) {
+	case std::experimental::io2d::path_data_type::move_to:
+	{
+		auto pt = item.get<experimental::io2d::path_data_item::move_to>().to();
+		_Add(path_data_type::move_to, { pt.x(), pt.y() });
+	} break;
+	case std::experimental::io2d::path_data_type::line_to:
+	{
+		auto pt = item.get<experimental::io2d::path_data_item::line_to>().to();
+		_Add(path_data_type::line_to, { pt.x(), pt.y() });
+	} break;
+	case std::experimental::io2d::path_data_type::curve_to:
+	{
+		auto dataItem = item.get<experimental::io2d::path_data_item::curve_to>();
+		auto pt0 = dataItem.control_point_1();
+		auto pt1 = dataItem.control_point_2();
+		auto pt2 = dataItem.end_point();
+		_Add(path_data_type::curve_to, { pt0.x(), pt0.y(), pt1.x(), pt1.y(), pt2.x(), pt2.y() });
+	} break;
+	case std::experimental::io2d::path_data_type::new_sub_path:
+	{
+		_Add(path_data_type::new_sub_path, { });
+	} break;
+	case std::experimental::io2d::path_data_type::close_path:
+	{
+		_Add(path_data_type::close_path, { });
+	} break;
+	case std::experimental::io2d::path_data_type::rel_move_to:
+	{
+		auto dpt = item.get<experimental::io2d::path_data_item::rel_move_to>().to();
+		_Add(path_data_type::rel_move_to, { dpt.x(), dpt.y() });
+	} break;
+	case std::experimental::io2d::path_data_type::rel_line_to:
+	{
+		auto dpt = item.get<experimental::io2d::path_data_item::rel_line_to>().to();
+		_Add(path_data_type::rel_line_to, { dpt.x(), dpt.y() });
+	} break;
+	case std::experimental::io2d::path_data_type::rel_curve_to:
+	{
+		auto dataItem = item.get<experimental::io2d::path_data_item::rel_curve_to>();
+		auto dpt0 = dataItem.control_point_1();
+		auto dpt1 = dataItem.control_point_2();
+		auto dpt2 = dataItem.end_point();
+		_Add(path_data_type::rel_curve_to, { dpt0.x(), dpt0.y(), dpt1.x(), dpt1.y(), dpt2.x(), dpt2.y() });
+	} break;
+	case std::experimental::io2d::path_data_type::arc:
+	{
+		auto dataItem = item.get<experimental::io2d::path_data_item::arc>();
+		_Add(path_data_type::arc, { dataItem.center().x(), dataItem.center().y(), dataItem.radius(), dataItem.angle_1(), dataItem.angle_2() });
+	} break;
+	case std::experimental::io2d::path_data_type::arc_negative:
+	{
+		auto dataItem = item.get<experimental::io2d::path_data_item::arc_negative>();
+		_Add(path_data_type::arc_negative, { dataItem.center().x(), dataItem.center().y(), dataItem.radius(), dataItem.angle_1(), dataItem.angle_2() });
+	} break;
+	case std::experimental::io2d::path_data_type::change_matrix:
+	{
+		auto m = item.get<experimental::io2d::path_data_item::change_matrix>().matrix();
+		_Add(path_data_type::change_matrix, { m.m00(), m.m01(), m.m10(), m.m11(), m.m20(), m.m21() });
+	} break;
+	case std::experimental::io2d::path_data_type::change_origin:
+	{
+		auto pt = item.get<experimental::io2d::path_data_item::change_origin>().origin();
+		_Add(path_data_type::change_origin, { pt.x(), pt.y() });
+	} break;
+	default:
+	{
+		assert("Unknown path_data_type." && false);
+	} break;
+	}
+}
+
+path_factory::path_factory(experimental::io2d::memory_resource* mr) noexcept
+	: _Verbs(polymorphic_allocator<unsigned char>(mr))
+	, _Coords(polymorphic_allocator<double>(mr)) {
+}
+
+// Copies and moves take a new revision (and a moved from object gets one too) so that a _Cairo_path_converter never mistakes different items for the ones it already converted.
+path_factory::path_factory(const path_factory& other)
+	: _Verbs(other._Verbs)
+	, _Coords(other._Coords)
+	, _Has_current_point(other._Has_current_point)
+	, _Current_point(other._Current_point)
+	, _Last_move_to_point(other._Last_move_to_point)
+	, _Transform_matrix(other._Transform_matrix)
+	, _Origin(other._Origin) {
+}
+
+path_factory::path_factory(const path_factory& other, experimental::io2d::memory_resource* mr)
+	: _Verbs(other._Verbs, polymorphic_allocator<unsigned char>(mr))
+	, _Coords(other._Coords, polymorphic_allocator<double>(mr))
+	, _Has_current_point(other._Has_current_point)
+	, _Current_point(other._Current_point)
+	, _Last_move_to_point(other._Last_move_to_point)
+	, _Transform_matrix(other._Transform_matrix)
+	, _Origin(other._Origin) {
+}
+
+path_factory& path_factory::operator=(const path_factory& other) {
+	if (this != &other) {
+		_Move_items_to_save_point();
+		_Verbs = other._Verbs;
+		_Coords = other._Coords;
+		_Has_current_point = other._Has_current_point;
+		_Current_point = other._Current_point;
+		_Last_move_to_point = other._Last_move_to_point;
+		_Transform_matrix = other._Transform_matrix;
+		_Origin = other._Origin;
+		_Revision = _Next_revision();
+	}
+	return *this;
+}
+
+namespace {
+	// Moves v, or copies it with the same allocator when its contents have to stay where they are.
+	template <class Vector>
+	Vector _Move_or_copy(Vector& v, bool copy) {
+		return copy ? Vector(v, v.get_allocator()) : Vector(move(v));
+	}
+}
+
+// A saved surface state may still refer to other's items, in which case other has to keep them. Copying before anything is moved leaves other as it was if that throws.
+path_factory::path_factory(path_factory&& other)
+	: _Verbs(_Move_or_copy(other._Verbs, other._Active_save_point != nullptr))
+	, _Coords(_Move_or_copy(other._Coords, other._Active_save_point != nullptr))
+	, _Has_current_point(move(other._Has_current_point))
+	, _Current_point(move(other._Current_point))
+	, _Last_move_to_point(move(other._Last_move_to_point))
+	, _Transform_matrix(move(other._Transform_matrix))
+	, _Origin(move(other._Origin)) {
+	if (other._Active_save_point == nullptr) {
+		other._Revision = _Next_revision();
+	}
+}
+
+// Keeps this object's memory resource, so if other uses a different one the items are copied rather than moved.
+path_factory& path_factory::operator=(path_factory&& other) {
+	if (other._Active_save_point != nullptr) {
+		return *this = other;
+	}
 	if (this != &other) {
-		_Data = move(other._Data);
+		_Move_items_to_save_point();
+		_Verbs = move(other._Verbs);
+		_Coords = move(other._Coords);
 		_Has_current_point = move(other._Has_current_point);
 		_Current_point = move(other._Current_point);
 		_Last_move_to_point = move(other._Last_move_to_point);
 		_Transform_matrix = move(other._Transform_matrix);
 		_Origin = move(other._Origin);
+		_Revision = _Next_revision();
+		other._Revision = _Next_revision();
 	}
 	return *this;
 }
 
-void path_factory::append(const path_factory& p) {
-	for (const auto& item : p._Data) {
-		_Data.push_back(item);
+path_factory::_Save_point path_factory::_Make_save_point() const noexcept {
+	// The save point's (empty) vectors use this object's allocator so that _Move_items_to_save_point and _Restore_save_point can swap with them.
+	return{ _Verbs.size(), _Coords.size(), _Has_current_point, _Current_point, _Last_move_to_point, _Transform_matrix, _Origin, false, decltype(_Verbs)(_Verbs.get_allocator()), decltype(_Coords)(_Coords.get_allocator()) };
+}
+
+void path_factory::_Restore_save_point(_Save_point& sp) noexcept {
+	if (sp._Items_moved) {
+		_Verbs.swap(sp._Verbs);
+		_Coords.swap(sp._Coords);
+	}
+	assert(_Verbs.size() >= sp._Verb_count && _Coords.size() >= sp._Coord_count);
+	if (sp._Items_moved || _Verbs.size() != sp._Verb_count) {
+		_Verbs.erase(_Verbs.begin() + static_cast<ptrdiff_t>(sp._Verb_count), _Verbs.end());
+		_Coords.erase(_Coords.begin() + static_cast<ptrdiff_t>(sp._Coord_count), _Coords.end());
+		_Revision = _Next_revision();
+	}
+	_Has_current_point = sp._Has_current_point;
+	_Current_point = sp._Current_point;
+	_Last_move_to_point = sp._Last_move_to_point;
+	_Transform_matrix = sp._Transform_matrix;
+	_Origin = sp._Origin;
+}
+
+void path_factory::_Move_items_to_save_point() noexcept {
+	if (_Active_save_point != nullptr) {
+		_Verbs.swap(_Active_save_point->_Verbs);
+		_Coords.swap(_Active_save_point->_Coords);
+		_Active_save_point->_Items_moved = true;
+		_Active_save_point = nullptr;
 	}
+}
+
+path_factory&& path_factory::_Without_save_point() noexcept {
+	_Active_save_point = nullptr;
+	return move(*this);
+}
+
+void path_factory::append(const path_factory& p) {
+	_Verbs.reserve(_Verbs.size() + p._Verbs.size());
+	_Coords.reserve(_Coords.size() + p._Coords.size());
+	_Verbs.insert(_Verbs.end(), p._Verbs.cbegin(), p._Verbs.cend());
+	_Coords.insert(_Coords.end(), p._Coords.cbegin(), p._Coords.cend());
 	_Has_current_point = p._Has_current_point;
 	_Current_point = p._Current_point;
 	_Last_move_to_point = p._Last_move_to_point;
@@ -44,7 +287,8 @@ void path_factory::append(const path_factory& p) {
 
 void path_factory::append(const path_factory& p, error_code& ec) noexcept {
 	try {
-		_Data.reserve(_Data.size() + p._Data.size());
+		_Verbs.reserve(_Verbs.size() + p._Verbs.size());
+		_Coords.reserve(_Coords.size() + p._Coords.size());
 	}
 	catch (const length_error&) {
 		ec = make_error_code(errc::not_enough_memory);
@@ -54,9 +298,8 @@ void path_factory::append(const path_factory& p, error_code& ec) noexcept {
 		ec = make_error_code(errc::not_enough_memory);
 		return;
 	}
-	for (const auto& item : p._Data) {
-		_Data.push_back(item);
-	}
+	_Verbs.insert(_Verbs.end(), p._Verbs.cbegin(), p._Verbs.cend());
+	_Coords.insert(_Coords.end(), p._Coords.cbegin(), p._Coords.cend());
 	_Has_current_point = p._Has_current_point;
 	_Current_point = p._Current_point;
 	_Last_move_to_point = p._Last_move_to_point;
@@ -193,11 +436,11 @@ void path_factory::append(const vector<path_data_item>& p) {
 		}
 	}
 
-	_Data.reserve(_Data.size() + p.size());
+	_Verbs.reserve(_Verbs.size() + p.size());
 
 	// Add items
 	for (const auto& item : p) {
-		_Data.push_back(item);
+		_Add(item);
 	}
 
 	_Has_current_point = hasCurrentPoint;
@@ -346,23 +589,28 @@ void path_factory::append(const vector<path_data_item>& p, error_code& ec) noexc
 		}
 	}
 
+	const auto verbsSize = _Verbs.size();
+	const auto coordsSize = _Coords.size();
 	try {
-		_Data.reserve(_Data.size() + p.size());
+		_Verbs.reserve(verbsSize + p.size());
+		// Add items
+		for (const auto& item : p) {
+			_Add(item);
+		}
 	}
 	catch (const length_error&) {
+		_Verbs.resize(verbsSize);
+		_Coords.resize(coordsSize);
 		ec = make_error_code(errc::not_enough_memory);
 		return;
 	}
 	catch (const bad_alloc&) {
+		_Verbs.resize(verbsSize);
+		_Coords.resize(coordsSize);
 		ec = make_error_code(errc::not_enough_memory);
 		return;
 	}
 
-	// Add items
-	for (const auto& item : p) {
-		_Data.push_back(item);
-	}
-
 	_Has_current_point = hasCurrentPoint;
 	_Current_point = currentPoint;
 	_Last_move_to_point = lastMoveToPoint;
@@ -392,13 +640,13 @@ vector_2d path_factory::current_point(error_code& ec) const noexcept {
 }
 
 void path_factory::new_sub_path() {
-	_Data.emplace_back(experimental::io2d::path_data_item::new_sub_path());
+	_Add(path_data_type::new_sub_path, { });
 	_Has_current_point = false;
 }
 
 void path_factory::new_sub_path(error_code& ec) noexcept {
 	try {
-		_Data.emplace_back(experimental::io2d::path_data_item::new_sub_path());
+		_Add(path_data_type::new_sub_path, { });
 	}
 	catch (const bad_alloc&) {
 		ec = make_error_code(errc::not_enough_memory);
@@ -410,14 +658,14 @@ void path_factory::new_sub_path(error_code& ec) noexcept {
 
 void path_factory::close_path() {
 	if (_Has_current_point) {
-		_Data.emplace_back(experimental::io2d::path_data_item::close_path());
+		_Add(path_data_type::close_path, { });
 		_Current_point = _Last_move_to_point;
 	}
 }
 
 void path_factory::close_path(error_code& ec) noexcept {
 	try {
-		_Data.emplace_back(experimental::io2d::path_data_item::close_path());
+		_Add(path_data_type::close_path, { });
 	}
 	catch (const bad_alloc&) {
 		ec = make_error_code(errc::not_enough_memory);
@@ -430,7 +678,7 @@ void path_factory::close_path(error_code& ec) noexcept {
 }
 
 void path_factory::arc(const vector_2d& center, double radius, double angle1, double angle2) {
-	_Data.emplace_back(std::experimental::io2d::path_data_item::arc(center, radius, angle1, angle2));
+	_Add(path_data_type::arc, { center.x(), center.y(), radius, angle1, angle2 });
 	// Update the current point.
 	if (!_Has_current_point) {
 		_Last_move_to_point = _Rotate_point_absolute_angle(center, radius, angle1);
@@ -441,7 +689,7 @@ void path_factory::arc(const vector_2d& center, double radius, double angle1, do
 
 void path_factory::arc(const vector_2d& center, double radius, double angle1, double angle2, error_code& ec) noexcept {
 	try {
-		_Data.emplace_back(std::experimental::io2d::path_data_item::arc(center, radius, angle1, angle2));
+		_Add(path_data_type::arc, { center.x(), center.y(), radius, angle1, angle2 });
 	}
 	catch (const bad_alloc&) {
 		ec = make_error_code(errc::not_enough_memory);
@@ -457,7 +705,7 @@ void path_factory::arc(const vector_2d& center, double radius, double angle1, do
 }
 
 void path_factory::arc_negative(const vector_2d& center, double radius, double angle1, double angle2) {
-	_Data.emplace_back(std::experimental::io2d::path_data_item::arc_negative(center, radius, angle1, angle2));
+	_Add(path_data_type::arc_negative, { center.x(), center.y(), radius, angle1, angle2 });
 	// Update the current point.
 	if (!_Has_current_point) {
 		_Last_move_to_point = _Rotate_point_absolute_angle(center, radius, angle1, false);
@@ -467,7 +715,7 @@ void path_factory::arc_negative(const vector_2d& center, double radius, double a
 
 void path_factory::arc_negative(const vector_2d& center, double radius, double angle1, double angle2, error_code& ec) noexcept {
 	try {
-		_Data.emplace_back(std::experimental::io2d::path_data_item::arc_negative(center, radius, angle1, angle2));
+		_Add(path_data_type::arc_negative, { center.x(), center.y(), radius, angle1, angle2 });
 	}
 	catch (const bad_alloc&) {
 		ec = make_error_code(errc::not_enough_memory);
@@ -485,10 +733,11 @@ void path_factory::arc_negative(const vector_2d& center, double radius, double a
 
 void path_factory::curve_to(const vector_2d& pt0, const vector_2d& pt1, const vector_2d& pt2) {
 	if (!_Has_current_point) {
-		_Data.reserve(_Data.size() + 2U);
+		_Verbs.reserve(_Verbs.size() + 2U);
+		_Coords.reserve(_Coords.size() + 8U);
 		move_to(pt0);
 	}
-	_Data.emplace_back(std::experimental::io2d::path_data_item::curve_to(pt0, pt1, pt2));
+	_Add(path_data_type::curve_to, { pt0.x(), pt0.y(), pt1.x(), pt1.y(), pt2.x(), pt2.y() });
 	_Has_current_point = true;
 	_Current_point = pt2;
 }
@@ -496,7 +745,8 @@ void path_factory::curve_to(const vector_2d& pt0, const vector_2d& pt1, const ve
 void path_factory::curve_to(const vector_2d& pt0, const vector_2d& pt1, const vector_2d& pt2, error_code& ec) noexcept {
 	if (!_Has_current_point) {
 		try {
-			_Data.reserve(_Data.size() + 2U);
+			_Verbs.reserve(_Verbs.size() + 2U);
+			_Coords.reserve(_Coords.size() + 8U);
 		}
 		catch (const length_error&) {
 			ec = make_error_code(errc::not_enough_memory);
@@ -512,7 +762,7 @@ void path_factory::curve_to(const vector_2d& pt0, const vector_2d& pt1, const ve
 		}
 	}
 	try {
-		_Data.emplace_back(std::experimental::io2d::path_data_item::curve_to(pt0, pt1, pt2));
+		_Add(path_data_type::curve_to, { pt0.x(), pt0.y(), pt1.x(), pt1.y(), pt2.x(), pt2.y() });
 	}
 	catch (const bad_alloc&) {
 		ec = make_error_code(errc::not_enough_memory);
@@ -524,7 +774,7 @@ void path_factory::curve_to(const vector_2d& pt0, const vector_2d& pt1, const ve
 }
 
 void path_factory::line_to(const vector_2d& pt) {
-	_Data.emplace_back(std::experimental::io2d::path_data_item::line_to(pt));
+	_Add(path_data_type::line_to, { pt.x(), pt.y() });
 	if (!_Has_current_point) {
 		_Last_move_to_point = pt;
 		_Has_current_point = true;
@@ -534,7 +784,7 @@ void path_factory::line_to(const vector_2d& pt) {
 
 void path_factory::line_to(const vector_2d& pt, error_code& ec) noexcept {
 	try {
-		_Data.emplace_back(std::experimental::io2d::path_data_item::line_to(pt));
+		_Add(path_data_type::line_to, { pt.x(), pt.y() });
 	}
 	catch (const bad_alloc&) {
 		ec = make_error_code(errc::not_enough_memory);
@@ -549,14 +799,15 @@ void path_factory::line_to(const vector_2d& pt, error_code& ec) noexcept {
 }
 
 void path_factory::move_to(const vector_2d& pt) {
-	_Data.emplace_back(std::experimental::io2d::path_data_item::move_to(pt));
+	_Add(path_data_type::move_to, { pt.x(), pt.y() });
 	_Has_current_point = true;
 	_Current_point = pt;
+	_Last_move_to_point = pt;
 }
 
 void path_factory::move_to(const vector_2d& pt, error_code& ec) noexcept {
 	try {
-		_Data.emplace_back(std::experimental::io2d::path_data_item::move_to(pt));
+		_Add(path_data_type::move_to, { pt.x(), pt.y() });
 	}
 	catch (const bad_alloc&) {
 		ec = make_error_code(errc::not_enough_memory);
@@ -564,11 +815,13 @@ void path_factory::move_to(const vector_2d& pt, error_code& ec) noexcept {
 	}
 	_Has_current_point = true;
 	_Current_point = pt;
+	_Last_move_to_point = pt;
 	ec.clear();
 }
 
 void path_factory::rectangle(const experimental::io2d::rectangle& r, bool cw) {
-	_Data.reserve(_Data.size() + 5U);
+	_Verbs.reserve(_Verbs.size() + 5U);
+	_Coords.reserve(_Coords.size() + 8U);
 
 	if (cw) {
 		// Create a clockwise winding order rectangle.
@@ -590,7 +843,8 @@ void path_factory::rectangle(const experimental::io2d::rectangle& r, bool cw) {
 
 void path_factory::rectangle(const experimental::io2d::rectangle& r, error_code& ec, bool cw) noexcept {
 	try {
-		_Data.reserve(_Data.size() + 5U);
+		_Verbs.reserve(_Verbs.size() + 5U);
+		_Coords.reserve(_Coords.size() + 8U);
 	}
 	catch (const length_error&) {
 		ec = make_error_code(errc::not_enough_memory);
@@ -639,7 +893,7 @@ void path_factory::rel_curve_to(const vector_2d& dpt0, const vector_2d& dpt1, co
 	if (!_Has_current_point) {
 		_Throw_if_failed_cairo_status_t(CAIRO_STATUS_NO_CURRENT_POINT);
 	}
-	_Data.emplace_back(std::experimental::io2d::path_data_item::rel_curve_to(dpt0, dpt1, dpt2));
+	_Add(path_data_type::rel_curve_to, { dpt0.x(), dpt0.y(), dpt1.x(), dpt1.y(), dpt2.x(), dpt2.y() });
 	_Has_current_point = true;
 	_Current_point = _Current_point + dpt2;
 }
@@ -650,7 +904,7 @@ void path_factory::rel_curve_to(const vector_2d& dpt0, const vector_2d& dpt1, co
 		return;
 	}
 	try {
-		_Data.emplace_back(std::experimental::io2d::path_data_item::rel_curve_to(dpt0, dpt1, dpt2));
+		_Add(path_data_type::rel_curve_to, { dpt0.x(), dpt0.y(), dpt1.x(), dpt1.y(), dpt2.x(), dpt2.y() });
 	}
 	catch (const bad_alloc&) {
 		ec = make_error_code(errc::not_enough_memory);
@@ -665,7 +919,7 @@ void path_factory::rel_line_to(const vector_2d& dpt) {
 	if (!_Has_current_point) {
 		_Throw_if_failed_cairo_status_t(CAIRO_STATUS_NO_CURRENT_POINT);
 	}
-	_Data.emplace_back(std::experimental::io2d::path_data_item::rel_line_to(dpt));
+	_Add(path_data_type::rel_line_to, { dpt.x(), dpt.y() });
 	_Has_current_point = true;
 	_Current_point = _Current_point + dpt;
 }
@@ -676,10 +930,11 @@ void path_factory::rel_line_to(const vector_2d& dpt, error_code& ec) noexcept {
 		return;
 	}
 	try {
-		_Data.emplace_back(std::experimental::io2d::path_data_item::rel_line_to(dpt));
+		_Add(path_data_type::rel_line_to, { dpt.x(), dpt.y() });
 	}
 	catch (const bad_alloc&) {
 		ec = make_error_code(errc::not_enough_memory);
+		return;
 	}
 	_Has_current_point = true;
 	_Current_point = _Current_point + dpt;
@@ -690,9 +945,10 @@ void path_factory::rel_move_to(const vector_2d& dpt) {
 	if (!_Has_current_point) {
 		_Throw_if_failed_cairo_status_t(CAIRO_STATUS_NO_CURRENT_POINT);
 	}
-	_Data.emplace_back(std::experimental::io2d::path_data_item::rel_move_to(dpt));
+	_Add(path_data_type::rel_move_to, { dpt.x(), dpt.y() });
 	_Has_current_point = true;
 	_Current_point = _Current_point + dpt;
+	_Last_move_to_point = _Current_point;
 }
 
 void path_factory::rel_move_to(const vector_2d& dpt, error_code& ec) noexcept {
@@ -701,7 +957,7 @@ void path_factory::rel_move_to(const vector_2d& dpt, error_code& ec) noexcept {
 		return;
 	}
 	try {
-		_Data.emplace_back(std::experimental::io2d::path_data_item::rel_move_to(dpt));
+		_Add(path_data_type::rel_move_to, { dpt.x(), dpt.y() });
 	}
 	catch (const bad_alloc&) {
 		ec = make_error_code(errc::not_enough_memory);
@@ -709,17 +965,18 @@ void path_factory::rel_move_to(const vector_2d& dpt, error_code& ec) noexcept {
 	}
 	_Has_current_point = true;
 	_Current_point = _Current_point + dpt;
+	_Last_move_to_point = _Current_point;
 	ec.clear();
 }
 
 void path_factory::change_matrix(const matrix_2d& m) {
-	_Data.emplace_back(std::experimental::io2d::path_data_item::change_matrix(m));
+	_Add(path_data_type::change_matrix, { m.m00(), m.m01(), m.m10(), m.m11(), m.m20(), m.m21() });
 	_Transform_matrix = m;
 }
 
 void path_factory::change_matrix(const matrix_2d& m, error_code& ec) noexcept {
 	try {
-		_Data.emplace_back(std::experimental::io2d::path_data_item::change_matrix(m));
+		_Add(path_data_type::change_matrix, { m.m00(), m.m01(), m.m10(), m.m11(), m.m20(), m.m21() });
 	}
 	catch (const bad_alloc&) {
 		ec = make_error_code(errc::not_enough_memory);
@@ -734,13 +991,13 @@ matrix_2d path_factory::current_matrix() const noexcept {
 }
 
 void path_factory::change_origin(const vector_2d& pt) {
-	_Data.emplace_back(std::experimental::io2d::path_data_item::change_origin(pt));
+	_Add(path_data_type::change_origin, { pt.x(), pt.y() });
 	_Origin = pt;
 }
 
 void path_factory::change_origin(const vector_2d& pt, error_code& ec) noexcept {
 	try {
-		_Data.emplace_back(std::experimental::io2d::path_data_item::change_origin(pt));
+		_Add(path_data_type::change_origin, { pt.x(), pt.y() });
 	}
 	catch (const bad_alloc&) {
 		ec = make_error_code(errc::not_enough_memory);
@@ -754,10 +1011,18 @@ vector_2d path_factory::current_origin() const noexcept {
 	return _Origin;
 }
 
+experimental::io2d::memory_resource* path_factory::memory_resource() const noexcept {
+	return _Verbs.get_allocator().resource();
+}
+
 vector<path_data_item> path_factory::data() const {
 	vector<path_data_item> result;
-	for (const auto& item : _Data) {
-		result.push_back(item);
+	result.reserve(_Verbs.size());
+	auto coords = _Coords.data();
+	for (auto verb : _Verbs) {
+		const auto type = static_cast<path_data_type>(verb);
+		result.push_back(_Make_data_item(type, coords));
+		coords += _Coord_count(type);
 	}
 	return result;
 }
@@ -765,7 +1030,7 @@ vector<path_data_item> path_factory::data() const {
 vector<path_data_item> path_factory::data(error_code& ec) const noexcept {
 	vector<path_data_item> result;
 	try {
-		result.reserve(_Data.size());
+		result.reserve(_Verbs.size());
 	}
 	catch (const length_error&) {
 		ec = make_error_code(errc::not_enough_memory);
@@ -777,215 +1042,290 @@ vector<path_data_item> path_factory::data(error_code& ec) const noexcept {
 		// Relies on C++17 noexcept guarantee for vector default ctor (N4258, adopted 2014-11).
 		return vector<path_data_item>();
 	}
-	for (const auto& item : _Data) {
-		result.push_back(item);
+	auto coords = _Coords.data();
+	for (auto verb : _Verbs) {
+		const auto type = static_cast<path_data_type>(verb);
+		result.push_back(_Make_data_item(type, coords));
+		coords += _Coord_count(type);
 	}
 	ec.clear();
 	return result;
 }
 
 path_data_item path_factory::data_item(unsigned int index) const {
-	return _Data.at(index);
+	error_code ec;
+	auto result = data_item(index, ec);
+	if (static_cast<bool>(ec)) {
+		throw out_of_range("index is out of range.");
+	}
+	return result;
 }
 
 path_data_item path_factory::data_item(unsigned int index, error_code& ec) const noexcept {
-	try {
-		return _Data.at(index);
-	}
-	catch (const out_of_range&) {
+	if (index >= _Verbs.size()) {
 		ec = _Cairo_status_t_to_std_error_code(CAIRO_STATUS_INVALID_INDEX);
 		return path_data_item{ };
 	}
+	// Items are variable length so find the item's coordinates by walking the verbs that precede it.
+	size_t offset = 0;
+	for (unsigned int i = 0; i < index; i++) {
+		offset += _Coord_count(static_cast<path_data_type>(_Verbs[i]));
+	}
+	ec.clear();
+	return _Make_data_item(static_cast<path_data_type>(_Verbs[index]), _Coords.data() + offset);
 }
 
-const vector<path_data_item>& path_factory::data_ref() const noexcept {
-	return _Data;
+::std::experimental::io2d::rectangle path_factory::path_extents() const {
+	error_code ec;
+	auto result = path_extents(ec);
+	if (static_cast<bool>(ec)) {
+		throw system_error(ec);
+	}
+	return result;
 }
 
-::std::experimental::io2d::rectangle path_factory::path_extents() const {
-	//
-	// The code in this function should be fixed now. Needs testing.
-	//
+::std::experimental::io2d::rectangle path_factory::path_extents(error_code& ec) const noexcept {
+	// The first pass resolves every point to its absolute, untransformed value and transforms each run of points that shares a matrix and origin with one matrix_2d::transform_points call. The second pass walks the data again and accumulates the extents from the transformed points. Arcs are measured during the first pass since _Get_arc_extents does its own transformation.
 
 	vector_2d pt0;
 	vector_2d pt1;
-
-	matrix_2d currMatrix = matrix_2d::init_identity();
-	vector_2d currOrigin;
-
-	bool hasCurrentPoint = false;
 	bool hasExtents = false;
 
-	vector_2d lastMoveToPoint;
-	vector_2d transformedCurrentPoint;
-	vector_2d currentPoint;
+	// Includes the rectangle spanned by two points in the extents.
+	auto addExtents = [&pt0, &pt1, &hasExtents](const vector_2d& a, const vector_2d& b) noexcept {
+		if (!hasExtents) {
+			hasExtents = true;
+			pt0.x(min(a.x(), b.x()));
+			pt0.y(min(a.y(), b.y()));
+			pt1.x(max(a.x(), b.x()));
+			pt1.y(max(a.y(), b.y()));
+		}
+		else {
+			pt0.x(min(min(pt0.x(), a.x()), b.x()));
+			pt0.y(min(min(pt0.y(), a.y()), b.y()));
+			pt1.x(max(max(pt1.x(), a.x()), b.x()));
+			pt1.y(max(max(pt1.y(), a.y()), b.y()));
+		}
+	};
+
+	vector<vector_2d> points;
+	try {
+		points.reserve(_Coords.size() / 2 + _Verbs.size());
+
+		matrix_2d currMatrix = matrix_2d::init_identity();
+		vector_2d currOrigin;
+		// Origin adjusted.
+		matrix_2d runMatrix = currMatrix;
+		size_t runStart = 0;
+
+		bool hasCurrentPoint = false;
+		vector_2d currentPoint;
+		size_t lastMoveToIndex = 0;
+
+		auto transformRun = [&]() noexcept {
+			runMatrix.transform_points(points.data() + runStart, points.size() - runStart);
+			runStart = points.size();
+		};
+
+		auto coords = _Coords.data();
+		for (auto verb : _Verbs) {
+			const auto type = static_cast<path_data_type>(verb);
+			switch (type)
+			{
+			case std::experimental::io2d::path_data_type::move_to:
+			{
+				currentPoint = { coords[0], coords[1] };
+				lastMoveToIndex = points.size();
+				points.push_back(currentPoint);
+				hasCurrentPoint = true;
+			} break;
+			case std::experimental::io2d::path_data_type::line_to:
+			{
+				currentPoint = { coords[0], coords[1] };
+				if (!hasCurrentPoint) {
+					lastMoveToIndex = points.size();
+					hasCurrentPoint = true;
+				}
+				points.push_back(currentPoint);
+			} break;
+			case std::experimental::io2d::path_data_type::curve_to:
+			{
+				if (!hasCurrentPoint) {
+					lastMoveToIndex = points.size();
+					hasCurrentPoint = true;
+				}
+				points.push_back({ coords[0], coords[1] });
+				points.push_back({ coords[2], coords[3] });
+				currentPoint = { coords[4], coords[5] };
+				points.push_back(currentPoint);
+			} break;
+			case std::experimental::io2d::path_data_type::new_sub_path:
+			{
+				hasCurrentPoint = false;
+			} break;
+			case std::experimental::io2d::path_data_type::close_path:
+			{
+				if (hasCurrentPoint) {
+					if (lastMoveToIndex >= runStart) {
+						currentPoint = points[lastMoveToIndex];
+					}
+					else {
+						// The last move to point has already been transformed by an earlier matrix and origin.
+						auto inverseMatrix = matrix_2d(runMatrix).invert(ec);
+						if (static_cast<bool>(ec)) {
+							return{ };
+						}
+						currentPoint = inverseMatrix.transform_point(points[lastMoveToIndex]);
+					}
+				}
+			} break;
+			case std::experimental::io2d::path_data_type::rel_move_to:
+			{
+				assert(hasCurrentPoint);
+				currentPoint = vector_2d{ coords[0], coords[1] } + currentPoint;
+				lastMoveToIndex = points.size();
+				points.push_back(currentPoint);
+				hasCurrentPoint = true;
+			} break;
+			case std::experimental::io2d::path_data_type::rel_line_to:
+			{
+				assert(hasCurrentPoint);
+				currentPoint = vector_2d{ coords[0], coords[1] } + currentPoint;
+				points.push_back(currentPoint);
+			} break;
+			case std::experimental::io2d::path_data_type::rel_curve_to:
+			{
+				assert(hasCurrentPoint);
+				points.push_back(vector_2d{ coords[0], coords[1] } + currentPoint);
+				points.push_back(vector_2d{ coords[2], coords[3] } + currentPoint);
+				currentPoint = vector_2d{ coords[4], coords[5] } + currentPoint;
+				points.push_back(currentPoint);
+			} break;
+			case std::experimental::io2d::path_data_type::arc:
+			case std::experimental::io2d::path_data_type::arc_negative:
+			{
+				const bool hadCurrentPoint = hasCurrentPoint;
+				auto transformedCurrentPoint = runMatrix.transform_point(currentPoint);
+				vector_2d lastMoveToPoint;
+				_Get_arc_extents({ coords[0], coords[1] }, coords[2], coords[3], coords[4], type == path_data_type::arc_negative, hasCurrentPoint, currentPoint, transformedCurrentPoint, lastMoveToPoint, hasExtents, pt0, pt1, currOrigin, currMatrix);
+				// Record where the arc began a sub-path (if it did) and where it ended so that the second pass can follow along.
+				if (!hadCurrentPoint) {
+					lastMoveToIndex = points.size();
+					points.push_back(lastMoveToPoint);
+				}
+				points.push_back(currentPoint);
+			} break;
+			case std::experimental::io2d::path_data_type::change_matrix:
+			{
+				transformRun();
+				currMatrix = { coords[0], coords[1], coords[2], coords[3], coords[4], coords[5] };
+				runMatrix = _Origin_adjusted_matrix(currMatrix, currOrigin);
+			} break;
+			case std::experimental::io2d::path_data_type::change_origin:
+			{
+				transformRun();
+				currOrigin = { coords[0], coords[1] };
+				runMatrix = _Origin_adjusted_matrix(currMatrix, currOrigin);
+			} break;
+			default:
+			{
+				assert("Unknown path_data_type in path_data." && false);
+			} break;
+			}
+			coords += _Coord_count(type);
+		}
+		transformRun();
+	}
+	catch (const bad_alloc&) {
+		ec = make_error_code(errc::not_enough_memory);
+		return{ };
+	}
+	catch (const length_error&) {
+		ec = make_error_code(errc::not_enough_memory);
+		return{ };
+	}
 
 	// pt0 will hold min values; pt1 will hold max values.
-	for (auto i = 0U; i < _Data.size(); i++) {
-		const auto& item = _Data[i];
-		auto type = item.type();
-		switch (type)
+	bool hasCurrentPoint = false;
+	vector_2d transformedCurrentPoint;
+	size_t lastMoveToIndex = 0;
+	size_t pointIndex = 0;
+	for (auto verb : _Verbs) {
+		switch (static_cast<path_data_type>(verb))
 		{
 		case std::experimental::io2d::path_data_type::move_to:
+		case std::experimental::io2d::path_data_type::rel_move_to:
 		{
-			currentPoint = item.get<experimental::io2d::path_data_item::move_to>().to();
-			lastMoveToPoint = currentPoint;
-			transformedCurrentPoint = currMatrix.transform_point(currentPoint - currOrigin) + currOrigin;
+			lastMoveToIndex = pointIndex;
+			transformedCurrentPoint = points[pointIndex++];
 			hasCurrentPoint = true;
 		} break;
 		case std::experimental::io2d::path_data_type::line_to:
+		case std::experimental::io2d::path_data_type::rel_line_to:
 		{
-			currentPoint = item.get<experimental::io2d::path_data_item::line_to>().to();
-			auto itemPt = currMatrix.transform_point(currentPoint - currOrigin) + currOrigin;
+			const auto& itemPt = points[pointIndex];
 			if (!hasCurrentPoint) {
-				transformedCurrentPoint = itemPt;
-				lastMoveToPoint = currentPoint;
+				lastMoveToIndex = pointIndex;
 				hasCurrentPoint = true;
 			}
 			else {
 				// Path extents include lines (even degenerate ones).
-				if (!hasExtents) {
-					hasExtents = true;
-					pt0.x(min(transformedCurrentPoint.x(), itemPt.x()));
-					pt0.y(min(transformedCurrentPoint.y(), itemPt.y()));
-					pt1.x(max(transformedCurrentPoint.x(), itemPt.x()));
-					pt1.y(max(transformedCurrentPoint.y(), itemPt.y()));
-				}
-				else {
-					pt0.x(min(min(pt0.x(), transformedCurrentPoint.x()), itemPt.x()));
-					pt0.y(min(min(pt0.y(), transformedCurrentPoint.y()), itemPt.y()));
-					pt1.x(max(max(pt1.x(), transformedCurrentPoint.x()), itemPt.x()));
-					pt1.y(max(max(pt1.y(), transformedCurrentPoint.y()), itemPt.y()));
-				}
-				transformedCurrentPoint = itemPt;
+				addExtents(transformedCurrentPoint, itemPt);
 			}
+			transformedCurrentPoint = itemPt;
+			pointIndex++;
 		} break;
 		case std::experimental::io2d::path_data_type::curve_to:
+		case std::experimental::io2d::path_data_type::rel_curve_to:
 		{
 			vector_2d cte0{ };
 			vector_2d cte1{ };
-			auto dataItem = item.get<experimental::io2d::path_data_item::curve_to>();
-			auto itemPt1 = currMatrix.transform_point(dataItem.control_point_1() - currOrigin) + currOrigin;
-			auto itemPt2 = currMatrix.transform_point(dataItem.control_point_2() - currOrigin) + currOrigin;
-			auto itemPt3 = currMatrix.transform_point(dataItem.end_point() - currOrigin) + currOrigin;
 			if (!hasCurrentPoint) {
-				currentPoint = dataItem.control_point_1();
-				lastMoveToPoint = currentPoint;
-				transformedCurrentPoint = itemPt1;
+				lastMoveToIndex = pointIndex;
+				transformedCurrentPoint = points[pointIndex];
 				hasCurrentPoint = true;
 			}
-			_Curve_to_extents(transformedCurrentPoint, itemPt1, itemPt2, itemPt3, cte0, cte1);
-			if (!hasExtents) {
-				hasExtents = true;
-				pt0.x(min(cte0.x(), cte1.x()));
-				pt0.y(min(cte0.y(), cte1.y()));
-				pt1.x(max(cte0.x(), cte1.x()));
-				pt1.y(max(cte0.y(), cte1.y()));
-			}
-			else {
-				pt0.x(min(min(pt0.x(), cte0.x()), cte1.x()));
-				pt0.y(min(min(pt0.y(), cte0.y()), cte1.y()));
-				pt1.x(max(max(pt1.x(), cte0.x()), cte1.x()));
-				pt1.y(max(max(pt1.y(), cte0.y()), cte1.y()));
-			}
-			transformedCurrentPoint = itemPt3;
-			currentPoint = dataItem.end_point();
-		}
-		break;
+			_Curve_to_extents(transformedCurrentPoint, points[pointIndex], points[pointIndex + 1], points[pointIndex + 2], cte0, cte1);
+			addExtents(cte0, cte1);
+			transformedCurrentPoint = points[pointIndex + 2];
+			pointIndex += 3;
+		} break;
 		case std::experimental::io2d::path_data_type::new_sub_path:
+		{
 			hasCurrentPoint = false;
-			break;
+		} break;
 		case std::experimental::io2d::path_data_type::close_path:
+		{
 			// Close path cannot change the path extents since it either does nothing or it adds a line from an existing point to an existing point.
 			if (hasCurrentPoint) {
-				auto inverseMatrix = matrix_2d(currMatrix).invert();
-				currentPoint = inverseMatrix.transform_point(lastMoveToPoint - currOrigin) + currOrigin;
-				transformedCurrentPoint = currMatrix.transform_point(currentPoint - currOrigin) + currOrigin;
-				lastMoveToPoint = currentPoint;
-			}
-			break;
-		case std::experimental::io2d::path_data_type::rel_move_to:
-			assert(hasCurrentPoint);
-			currentPoint = item.get<experimental::io2d::path_data_item::rel_move_to>().to() + currentPoint;
-			lastMoveToPoint = currentPoint;
-			transformedCurrentPoint = currMatrix.transform_point(currentPoint - currOrigin) + currOrigin;
-			break;
-		case std::experimental::io2d::path_data_type::rel_line_to:
-		{
-			assert(hasCurrentPoint);
-			auto itemPt = currMatrix.transform_point((item.get<experimental::io2d::path_data_item::rel_line_to>().to() + currentPoint) - currOrigin) + currOrigin;
-			if (!hasExtents) {
-				hasExtents = true;
-				pt0.x(min(transformedCurrentPoint.x(), itemPt.x()));
-				pt0.y(min(transformedCurrentPoint.y(), itemPt.y()));
-				pt1.x(max(transformedCurrentPoint.x(), itemPt.x()));
-				pt1.y(max(transformedCurrentPoint.y(), itemPt.y()));
-			}
-			else {
-				pt0.x(min(min(pt0.x(), transformedCurrentPoint.x()), itemPt.x()));
-				pt0.y(min(min(pt0.y(), transformedCurrentPoint.y()), itemPt.y()));
-				pt1.x(max(max(pt1.x(), transformedCurrentPoint.x()), itemPt.x()));
-				pt1.y(max(max(pt1.y(), transformedCurrentPoint.y()), itemPt.y()));
+				transformedCurrentPoint = points[lastMoveToIndex];
 			}
-			currentPoint = item.get<experimental::io2d::path_data_item::rel_line_to>().to() + currentPoint;
-			transformedCurrentPoint = itemPt;
 		} break;
-		case std::experimental::io2d::path_data_type::rel_curve_to:
-		{
-			assert(hasCurrentPoint);
-			vector_2d cte0{ };
-			vector_2d cte1{ };
-			auto dataItem = item.get<experimental::io2d::path_data_item::rel_curve_to>();
-			auto itemPt1 = currMatrix.transform_point((dataItem.control_point_1() + currentPoint) - currOrigin) + currOrigin;
-			auto itemPt2 = currMatrix.transform_point((dataItem.control_point_2() + currentPoint) - currOrigin) + currOrigin;
-			auto itemPt3 = currMatrix.transform_point((dataItem.end_point() + currentPoint) - currOrigin) + currOrigin;
-			_Curve_to_extents(currentPoint, itemPt1, itemPt2, itemPt3, cte0, cte1);
-			if (!hasExtents) {
-				hasExtents = true;
-				pt0.x(min(cte0.x(), cte1.x()));
-				pt0.y(min(cte0.y(), cte1.y()));
-				pt1.x(max(cte0.x(), cte1.x()));
-				pt1.y(max(cte0.y(), cte1.y()));
-			}
-			else {
-				pt0.x(min(min(pt0.x(), cte0.x()), cte1.x()));
-				pt0.y(min(min(pt0.y(), cte0.y()), cte1.y()));
-				pt1.x(max(max(pt1.x(), cte0.x()), cte1.x()));
-				pt1.y(max(max(pt1.y(), cte0.y()), cte1.y()));
-			}
-			currentPoint = dataItem.end_point() + currentPoint;
-			transformedCurrentPoint = itemPt3;
-		}
-		break;
 		case std::experimental::io2d::path_data_type::arc:
-		{
-			auto dataItem = item.get<experimental::io2d::path_data_item::arc>();
-			_Get_arc_extents(dataItem.center(), dataItem.radius(), dataItem.angle_1(), dataItem.angle_2(), false, hasCurrentPoint, currentPoint, transformedCurrentPoint, lastMoveToPoint, hasExtents, pt0, pt1, currOrigin, currMatrix);
-		} break;
 		case std::experimental::io2d::path_data_type::arc_negative:
 		{
-			auto dataItem = item.get<experimental::io2d::path_data_item::arc_negative>();
-			_Get_arc_extents(dataItem.center(), dataItem.radius(), dataItem.angle_1(), dataItem.angle_2(), true, hasCurrentPoint, currentPoint, transformedCurrentPoint, lastMoveToPoint, hasExtents, pt0, pt1, currOrigin, currMatrix);
-		} break;
-		case std::experimental::io2d::path_data_type::change_matrix:
-		{
-			currMatrix = item.get<experimental::io2d::path_data_item::change_matrix>().matrix();
-		} break;
-		case std::experimental::io2d::path_data_type::change_origin:
-		{
-			currOrigin = item.get<experimental::io2d::path_data_item::change_origin>().origin();
+			// Already measured in the first pass.
+			if (!hasCurrentPoint) {
+				lastMoveToIndex = pointIndex++;
+				hasCurrentPoint = true;
+			}
+			transformedCurrentPoint = points[pointIndex++];
 		} break;
 		default:
 		{
-			assert("Unknown path_data_type in path_data." && false);
 		} break;
 		}
 	}
+	assert(pointIndex == points.size());
+	ec.clear();
 	return{ pt0.x(), pt0.y(), pt1.x() - pt0.x(), pt1.y() - pt0.y() };
 }
 
 void path_factory::clear() noexcept {
-	_Data.clear();
+	_Move_items_to_save_point();
+	_Verbs.clear();
+	_Coords.clear();
+	_Revision = _Next_revision();
 	_Has_current_point = false;
 	_Current_point = { };
 	_Transform_matrix = matrix_2d::init_identity();
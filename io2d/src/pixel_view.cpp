@@ -0,0 +1,348 @@
+#include "io2d.h"
+#include "xio2dhelpers.h"
+#include "xcairoenumhelpers.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <cstdlib>
+
+using namespace std;
+using namespace std::experimental::io2d;
+
+// sfce is null when the image_surface that was asked for the view could not provide one (error_code overloads only).
+const_pixel_view::const_pixel_view(cairo_surface_t* sfce) noexcept
+	: _Surface(sfce) {
+	if (_Surface != nullptr) {
+		cairo_surface_reference(_Surface);
+	}
+}
+
+const_pixel_view::const_pixel_view(const_pixel_view&& other) noexcept
+	: _Surface(other._Surface) {
+	other._Surface = nullptr;
+}
+
+const_pixel_view& const_pixel_view::operator=(const_pixel_view&& other) noexcept {
+	if (this != &other) {
+		if (_Surface != nullptr) {
+			cairo_surface_destroy(_Surface);
+		}
+		_Surface = other._Surface;
+		other._Surface = nullptr;
+	}
+	return *this;
+}
+
+const_pixel_view::~const_pixel_view() {
+	if (_Surface != nullptr) {
+		cairo_surface_destroy(_Surface);
+		_Surface = nullptr;
+	}
+}
+
+const unsigned char* const_pixel_view::data() const noexcept {
+	return (_Surface == nullptr) ? nullptr : cairo_image_surface_get_data(_Surface);
+}
+
+const unsigned char* const_pixel_view::row(int y) const noexcept {
+	return (_Surface == nullptr) ? nullptr : cairo_image_surface_get_data(_Surface) + static_cast<ptrdiff_t>(y) * cairo_image_surface_get_stride(_Surface);
+}
+
+size_t const_pixel_view::size() const noexcept {
+	return (_Surface == nullptr) ? 0 : static_cast<size_t>(cairo_image_surface_get_stride(_Surface)) * static_cast<size_t>(cairo_image_surface_get_height(_Surface));
+}
+
+::std::experimental::io2d::format const_pixel_view::format() const noexcept {
+	return (_Surface == nullptr) ? ::std::experimental::io2d::format::invalid : _Cairo_format_t_to_format(cairo_image_surface_get_format(_Surface));
+}
+
+int const_pixel_view::width() const noexcept {
+	return (_Surface == nullptr) ? 0 : cairo_image_surface_get_width(_Surface);
+}
+
+int const_pixel_view::height() const noexcept {
+	return (_Surface == nullptr) ? 0 : cairo_image_surface_get_height(_Surface);
+}
+
+int const_pixel_view::stride() const noexcept {
+	return (_Surface == nullptr) ? 0 : cairo_image_surface_get_stride(_Surface);
+}
+
+pixel_view::pixel_view(cairo_surface_t* sfce) noexcept
+	: _Surface(sfce) {
+	if (_Surface != nullptr) {
+		cairo_surface_reference(_Surface);
+		_Add_pixel_writer(_Surface, 1);
+	}
+}
+
+pixel_view::pixel_view(pixel_view&& other) noexcept
+	: _Surface(other._Surface) {
+	other._Surface = nullptr;
+}
+
+pixel_view& pixel_view::operator=(pixel_view&& other) noexcept {
+	if (this != &other) {
+		if (_Surface != nullptr) {
+			_Add_pixel_writer(_Surface, -1);
+			cairo_surface_mark_dirty(_Surface);
+			cairo_surface_destroy(_Surface);
+		}
+		_Surface = other._Surface;
+		other._Surface = nullptr;
+	}
+	return *this;
+}
+
+pixel_view::~pixel_view() {
+	if (_Surface != nullptr) {
+		_Add_pixel_writer(_Surface, -1);
+		cairo_surface_mark_dirty(_Surface);
+		cairo_surface_destroy(_Surface);
+		_Surface = nullptr;
+	}
+}
+
+unsigned char* pixel_view::data() noexcept {
+	return (_Surface == nullptr) ? nullptr : cairo_image_surface_get_data(_Surface);
+}
+
+unsigned char* pixel_view::row(int y) noexcept {
+	return (_Surface == nullptr) ? nullptr : cairo_image_surface_get_data(_Surface) + static_cast<ptrdiff_t>(y) * cairo_image_surface_get_stride(_Surface);
+}
+
+const unsigned char* pixel_view::data() const noexcept {
+	return (_Surface == nullptr) ? nullptr : cairo_image_surface_get_data(_Surface);
+}
+
+const unsigned char* pixel_view::row(int y) const noexcept {
+	return (_Surface == nullptr) ? nullptr : cairo_image_surface_get_data(_Surface) + static_cast<ptrdiff_t>(y) * cairo_image_surface_get_stride(_Surface);
+}
+
+size_t pixel_view::size() const noexcept {
+	return (_Surface == nullptr) ? 0 : static_cast<size_t>(cairo_image_surface_get_stride(_Surface)) * static_cast<size_t>(cairo_image_surface_get_height(_Surface));
+}
+
+::std::experimental::io2d::format pixel_view::format() const noexcept {
+	return (_Surface == nullptr) ? ::std::experimental::io2d::format::invalid : _Cairo_format_t_to_format(cairo_image_surface_get_format(_Surface));
+}
+
+int pixel_view::width() const noexcept {
+	return (_Surface == nullptr) ? 0 : cairo_image_surface_get_width(_Surface);
+}
+
+int pixel_view::height() const noexcept {
+	return (_Surface == nullptr) ? 0 : cairo_image_surface_get_height(_Surface);
+}
+
+int pixel_view::stride() const noexcept {
+	return (_Surface == nullptr) ? 0 : cairo_image_surface_get_stride(_Surface);
+}
+
+namespace {
+	// Below this many pixels per band, handing a band to a worker and waiting for it costs more than it saves.
+	const long long _Min_pixels_per_band = 1 << 16;
+
+	// True on a thread while it runs a band, on a worker or on the thread that made the call. Parallel work asked for from inside a band is run on that thread, without touching the pool: its workers are busy with the band's own call, and that call's thread already holds _Call_lock.
+	thread_local bool _In_row_band = false;
+
+	// The worker threads of _Run_row_bands. They run the bands of one call at a time, alongside the thread that made it.
+	class _Row_band_pool {
+		mutex _Lock;
+		condition_variable _Work_ready;
+		condition_variable _Work_done;
+		vector<thread> _Workers;
+		bool _Stopping = false;
+		// The current call; there are bands to run while _Next_band < _Bands.
+		void(*_Band)(void*, int, int) = nullptr;
+		void* _Context = nullptr;
+		int _Height = 0;
+		int _Bands = 0;
+		int _Next_band = 0;
+		int _Finished_bands = 0;
+		exception_ptr _Error;
+		// Held for the length of a call, so that a second one from another thread does not have to wait for the workers: it finds it taken and runs on its own thread.
+		mutex _Call_lock;
+
+		// Runs bands of the current call until none are left to claim. lock holds _Lock on entry and on return.
+		void _Run_bands(unique_lock<mutex>& lock) noexcept {
+			while (_Next_band < _Bands) {
+				auto b = _Next_band++;
+				auto first = static_cast<int>(static_cast<long long>(_Height) * b / _Bands);
+				auto last = static_cast<int>(static_cast<long long>(_Height) * (b + 1) / _Bands);
+				auto band = _Band;
+				auto context = _Context;
+				lock.unlock();
+				exception_ptr error;
+				_In_row_band = true;
+				try {
+					band(context, first, last);
+				}
+				catch (...) {
+					error = current_exception();
+				}
+				_In_row_band = false;
+				lock.lock();
+				if (error != nullptr && _Error == nullptr) {
+					_Error = move(error);
+				}
+				if (++_Finished_bands == _Bands) {
+					_Work_done.notify_all();
+				}
+			}
+		}
+
+		void _Work() noexcept {
+			unique_lock<mutex> lock(_Lock);
+			for (;;) {
+				_Work_ready.wait(lock, [this]() { return _Stopping || _Next_band < _Bands; });
+				if (_Stopping) {
+					return;
+				}
+				_Run_bands(lock);
+			}
+		}
+	public:
+		explicit _Row_band_pool(int workers) noexcept {
+			try {
+				_Workers.reserve(static_cast<size_t>(workers));
+				for (int i = 0; i < workers; ++i) {
+					_Workers.emplace_back(&_Row_band_pool::_Work, this);
+				}
+			}
+			catch (...) {
+				// Makes do with the threads it got.
+			}
+		}
+
+		~_Row_band_pool() {
+			{
+				lock_guard<mutex> lock(_Lock);
+				_Stopping = true;
+			}
+			_Work_ready.notify_all();
+			for (auto& t : _Workers) {
+				t.join();
+			}
+		}
+
+		// Including the calling thread.
+		int threads() const noexcept {
+			return static_cast<int>(_Workers.size()) + 1;
+		}
+
+		// Returns false, having run nothing, if another call has the workers or this one comes from inside a band.
+		bool run(void(*band)(void*, int, int), void* context, int height, int bands) {
+			if (_In_row_band) {
+				return false;
+			}
+			unique_lock<mutex> call(_Call_lock, try_to_lock);
+			if (!call.owns_lock()) {
+				return false;
+			}
+			exception_ptr error;
+			{
+				unique_lock<mutex> lock(_Lock);
+				_Band = band;
+				_Context = context;
+				_Height = height;
+				_Bands = bands;
+				_Next_band = 0;
+				_Finished_bands = 0;
+				_Work_ready.notify_all();
+				_Run_bands(lock);
+				_Work_done.wait(lock, [this]() { return _Finished_bands == _Bands; });
+				error = move(_Error);
+				_Error = nullptr;
+			}
+			if (error != nullptr) {
+				rethrow_exception(error);
+			}
+			return true;
+		}
+	};
+
+	int _Row_band_threads() noexcept {
+		auto threads = ::std::getenv("IO2D_THREADS");
+		if (threads != nullptr && ::std::atoi(threads) > 0) {
+			return min(::std::atoi(threads), 256);
+		}
+		return max(static_cast<int>(thread::hardware_concurrency()), 1);
+	}
+
+	// Null when there is only the one thread to work with.
+	_Row_band_pool* _Get_row_band_pool() noexcept {
+		static const int threads = _Row_band_threads();
+		if (threads <= 1) {
+			return nullptr;
+		}
+		static _Row_band_pool pool(threads - 1);
+		return &pool;
+	}
+}
+
+namespace std {
+	namespace experimental {
+		namespace io2d {
+#if _Inline_namespace_conditional_support_test
+			inline namespace v1 {
+#endif
+				// (255 * 65536 + a - 1) / a for a in [1, 255].
+				const uint32_t _Unpremultiply_factors[256] = {
+					0u, 16711680u, 8355840u, 5570560u, 4177920u, 3342336u, 2785280u, 2387383u,
+					2088960u, 1856854u, 1671168u, 1519244u, 1392640u, 1285514u, 1193692u, 1114112u,
+					1044480u, 983040u, 928427u, 879563u, 835584u, 795795u, 759622u, 726595u,
+					696320u, 668468u, 642757u, 618952u, 596846u, 576265u, 557056u, 539087u,
+					522240u, 506415u, 491520u, 477477u, 464214u, 451668u, 439782u, 428505u,
+					417792u, 407602u, 397898u, 388644u, 379811u, 371371u, 363298u, 355568u,
+					348160u, 341055u, 334234u, 327680u, 321379u, 315315u, 309476u, 303849u,
+					298423u, 293188u, 288133u, 283249u, 278528u, 273962u, 269544u, 265265u,
+					261120u, 257103u, 253208u, 249429u, 245760u, 242199u, 238739u, 235376u,
+					232107u, 228928u, 225834u, 222823u, 219891u, 217035u, 214253u, 211541u,
+					208896u, 206318u, 203801u, 201346u, 198949u, 196608u, 194322u, 192089u,
+					189906u, 187772u, 185686u, 183645u, 181649u, 179696u, 177784u, 175913u,
+					174080u, 172286u, 170528u, 168805u, 167117u, 165463u, 163840u, 162250u,
+					160690u, 159159u, 157658u, 156184u, 154738u, 153319u, 151925u, 150556u,
+					149212u, 147891u, 146594u, 145319u, 144067u, 142835u, 141625u, 140435u,
+					139264u, 138114u, 136981u, 135868u, 134772u, 133694u, 132633u, 131589u,
+					130560u, 129548u, 128552u, 127571u, 126604u, 125652u, 124715u, 123791u,
+					122880u, 121984u, 121100u, 120228u, 119370u, 118523u, 117688u, 116865u,
+					116054u, 115253u, 114464u, 113685u, 112917u, 112159u, 111412u, 110674u,
+					109946u, 109227u, 108518u, 107818u, 107127u, 106444u, 105771u, 105105u,
+					104448u, 103800u, 103159u, 102526u, 101901u, 101283u, 100673u, 100070u,
+					99475u, 98886u, 98304u, 97730u, 97161u, 96600u, 96045u, 95496u,
+					94953u, 94417u, 93886u, 93362u, 92843u, 92330u, 91823u, 91321u,
+					90825u, 90334u, 89848u, 89368u, 88892u, 88422u, 87957u, 87496u,
+					87040u, 86590u, 86143u, 85701u, 85264u, 84831u, 84403u, 83979u,
+					83559u, 83143u, 82732u, 82324u, 81920u, 81521u, 81125u, 80733u,
+					80345u, 79961u, 79580u, 79203u, 78829u, 78459u, 78092u, 77729u,
+					77369u, 77013u, 76660u, 76310u, 75963u, 75619u, 75278u, 74941u,
+					74606u, 74275u, 73946u, 73620u, 73297u, 72977u, 72660u, 72345u,
+					72034u, 71724u, 71418u, 71114u, 70813u, 70514u, 70218u, 69924u,
+					69632u, 69344u, 69057u, 68773u, 68491u, 68211u, 67934u, 67659u,
+					67386u, 67116u, 66847u, 66581u, 66317u, 66055u, 65795u, 65536u
+				};
+
+				void _Run_row_bands(int width, int height, parallelism p, void(*band)(void*, int, int), void* context) {
+					if (height <= 0) {
+						return;
+					}
+					auto pixels = static_cast<long long>(max(width, 0)) * height;
+					if (p == parallelism::parallel && pixels >= 2 * _Min_pixels_per_band) {
+						auto pool = _Get_row_band_pool();
+						if (pool != nullptr) {
+							auto bands = min({ static_cast<long long>(pool->threads()), static_cast<long long>(height), pixels / _Min_pixels_per_band });
+							if (bands > 1 && pool->run(band, context, height, static_cast<int>(bands))) {
+								return;
+							}
+						}
+					}
+					band(context, 0, height);
+				}
+#if _Inline_namespace_conditional_support_test
+			}
+#endif
+		}
+	}
+}
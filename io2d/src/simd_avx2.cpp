@@ -0,0 +1,106 @@
+// This file alone is compiled with AVX2 enabled, and its functions are only called once _Has_avx2() says the CPU can run them.
+// It takes only xio2d.h, for the namespace macros, and must not call any inline function of io2d's or the standard library's:
+// the copy instantiated here would be compiled for AVX2, and the linker is free to use it everywhere else as well.
+#include "xio2d.h"
+#include <immintrin.h>
+#include <cstddef>
+
+namespace {
+	const float _Unpremultiply_bias = 1.0f / 2048.0f;
+
+	// As format_conversion.cpp's _Unpremultiply_lanes, which explains why this is exact; the clamp also turns the INT_MIN that alpha 0 leads to into 0.
+	inline __m256i _Unpremultiply_lanes(__m256i c, __m256 reciprocal, __m256 halfAlpha) noexcept {
+		auto n = _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(c), _mm256_set1_ps(255.0f)), halfAlpha);
+		auto q = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(n, reciprocal), _mm256_set1_ps(_Unpremultiply_bias)));
+		return _mm256_min_epi32(_mm256_max_epi32(q, _mm256_setzero_si256()), _mm256_set1_epi32(255));
+	}
+
+	// round(c * a / 255), as format_conversion.cpp's _Premultiply_lanes.
+	inline __m256i _Premultiply_lanes(__m256i c, __m256i a) noexcept {
+		auto t = _mm256_add_epi32(_mm256_mullo_epi16(c, a), _mm256_set1_epi32(128));
+		return _mm256_srli_epi32(_mm256_add_epi32(t, _mm256_srli_epi32(t, 8)), 8);
+	}
+
+	template <bool Bgra>
+	int _Argb32_to_interchange(const unsigned char* src, unsigned char* dest, int width) noexcept {
+		const auto byteMask = _mm256_set1_epi32(0xff);
+		int x = 0;
+		for (; x + 8 <= width; x += 8) {
+			auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x * 4));
+			auto a = _mm256_srli_epi32(v, 24);
+			auto reciprocal = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_cvtepi32_ps(a));
+			auto halfAlpha = _mm256_cvtepi32_ps(_mm256_srli_epi32(a, 1));
+			auto r = _Unpremultiply_lanes(_mm256_and_si256(_mm256_srli_epi32(v, 16), byteMask), reciprocal, halfAlpha);
+			auto g = _Unpremultiply_lanes(_mm256_and_si256(_mm256_srli_epi32(v, 8), byteMask), reciprocal, halfAlpha);
+			auto b = _Unpremultiply_lanes(_mm256_and_si256(v, byteMask), reciprocal, halfAlpha);
+			auto first = Bgra ? b : r;
+			auto third = Bgra ? r : b;
+			auto out = _mm256_or_si256(_mm256_or_si256(first, _mm256_slli_epi32(g, 8)), _mm256_or_si256(_mm256_slli_epi32(third, 16), _mm256_slli_epi32(a, 24)));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + x * 4), out);
+		}
+		return x;
+	}
+
+	template <bool Bgra>
+	int _Interchange_to_argb32(const unsigned char* src, unsigned char* dest, int width) noexcept {
+		const auto byteMask = _mm256_set1_epi32(0xff);
+		int x = 0;
+		for (; x + 8 <= width; x += 8) {
+			auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x * 4));
+			auto first = _mm256_and_si256(v, byteMask);
+			auto g = _mm256_and_si256(_mm256_srli_epi32(v, 8), byteMask);
+			auto third = _mm256_and_si256(_mm256_srli_epi32(v, 16), byteMask);
+			auto a = _mm256_srli_epi32(v, 24);
+			auto r = _Premultiply_lanes(Bgra ? third : first, a);
+			auto b = _Premultiply_lanes(Bgra ? first : third, a);
+			g = _Premultiply_lanes(g, a);
+			auto out = _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi32(a, 24), _mm256_slli_epi32(r, 16)), _mm256_or_si256(_mm256_slli_epi32(g, 8), b));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + x * 4), out);
+		}
+		return x;
+	}
+}
+
+namespace std {
+	namespace experimental {
+		namespace io2d {
+#if _Inline_namespace_conditional_support_test
+			inline namespace v1 {
+#endif
+				// m is { m00, m01, m10, m11, m20, m21 }; pts and out are count packed x, y pairs and may be the same.
+				void _Transform_points_avx2(const double* m, const double* pts, ::std::size_t count, double* out) noexcept {
+					// Two points per register. The x and y terms are formed in the same order as matrix_2d::transform_point and without fused multiply-adds, so the results are identical.
+					const auto c0 = _mm256_setr_pd(m[0], m[1], m[0], m[1]);
+					const auto c1 = _mm256_setr_pd(m[2], m[3], m[2], m[3]);
+					const auto t = _mm256_setr_pd(m[4], m[5], m[4], m[5]);
+					::std::size_t i = 0;
+					for (; i + 4 <= count; i += 4) {
+						const auto p0 = _mm256_loadu_pd(pts + i * 2);
+						const auto p1 = _mm256_loadu_pd(pts + i * 2 + 4);
+						const auto r0 = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(_mm256_unpacklo_pd(p0, p0), c0), _mm256_mul_pd(_mm256_unpackhi_pd(p0, p0), c1)), t);
+						const auto r1 = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(_mm256_unpacklo_pd(p1, p1), c0), _mm256_mul_pd(_mm256_unpackhi_pd(p1, p1), c1)), t);
+						_mm256_storeu_pd(out + i * 2, r0);
+						_mm256_storeu_pd(out + i * 2 + 4, r1);
+					}
+					const auto c0h = _mm256_castpd256_pd128(c0);
+					const auto c1h = _mm256_castpd256_pd128(c1);
+					const auto th = _mm256_castpd256_pd128(t);
+					for (; i < count; i++) {
+						const auto p = _mm_loadu_pd(pts + i * 2);
+						_mm_storeu_pd(out + i * 2, _mm_add_pd(_mm_add_pd(_mm_mul_pd(_mm_unpacklo_pd(p, p), c0h), _mm_mul_pd(_mm_unpackhi_pd(p, p), c1h)), th));
+					}
+				}
+
+				int _Argb32_to_interchange_avx2(const unsigned char* src, unsigned char* dest, int width, bool bgra) noexcept {
+					return bgra ? _Argb32_to_interchange<true>(src, dest, width) : _Argb32_to_interchange<false>(src, dest, width);
+				}
+
+				int _Interchange_to_argb32_avx2(const unsigned char* src, unsigned char* dest, int width, bool bgra) noexcept {
+					return bgra ? _Interchange_to_argb32<true>(src, dest, width) : _Interchange_to_argb32<false>(src, dest, width);
+				}
+#if _Inline_namespace_conditional_support_test
+			}
+#endif
+		}
+	}
+}
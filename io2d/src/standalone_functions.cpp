@@ -1,6 +1,11 @@
 #include "io2d.h"
 #include "xio2dhelpers.h"
 #include "xcairoenumhelpers.h"
+#include <cstdlib>
+#include <cstring>
+#if defined(USE_AVX2) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 using namespace std;
 using namespace std::experimental::io2d;
@@ -16,6 +21,8 @@ namespace std {
 					return ec;
 				}
 
+#if defined(_WIN32_WINNT) || defined(USE_XCB) || defined(USE_XLIB)
+				// Only the display_surface backends define display_surface's constructors.
 				display_surface make_display_surface(int preferredWidth, int preferredHeight, format preferredFormat, scaling scl, refresh_rate rr, double desiredFramerate) {
 					return display_surface(preferredWidth, preferredHeight, preferredFormat, scl, rr, desiredFramerate);
 				}
@@ -23,6 +30,7 @@ namespace std {
 				display_surface make_display_surface(int preferredWidth, int preferredHeight, format preferredFormat, int preferredDisplayWidth, int preferredDisplayHeight, scaling scl, refresh_rate rr, double desiredFramerate) {
 					return display_surface(preferredWidth, preferredHeight, preferredFormat, preferredDisplayWidth, preferredDisplayHeight,scl, rr, desiredFramerate);
 				}
+#endif
 
 				image_surface make_image_surface(format fmt, int width, int height) {
 					return image_surface(fmt, width, height);
@@ -31,6 +39,37 @@ namespace std {
 				int format_stride_for_width(format format, int width) noexcept {
 					return cairo_format_stride_for_width(_Format_to_cairo_format_t(format), width);
 				}
+
+#if defined(USE_AVX2)
+				// This file is compiled without AVX2, so the check itself runs on any CPU.
+				bool _Has_avx2() noexcept {
+					static const bool result = []() {
+						// Like PIXMAN_DISABLE, for comparing against the code the other CPUs run.
+						auto disable = ::std::getenv("IO2D_DISABLE");
+						if (disable != nullptr && ::std::strstr(disable, "avx2") != nullptr) {
+							return false;
+						}
+#if defined(_MSC_VER)
+						int info[4];
+						__cpuid(info, 0);
+						if (info[0] < 7) {
+							return false;
+						}
+						__cpuid(info, 1);
+						// OSXSAVE and AVX, and the OS saves the YMM registers.
+						if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0 || (_xgetbv(0) & 0x6) != 0x6) {
+							return false;
+						}
+						__cpuidex(info, 7, 0);
+						return (info[1] & (1 << 5)) != 0;
+#else
+						__builtin_cpu_init();
+						return __builtin_cpu_supports("avx2") != 0;
+#endif
+					}();
+					return result;
+				}
+#endif
 #if _Inline_namespace_conditional_support_test
 			}
 #endif
@@ -53,9 +92,7 @@ namespace {
 	// Declarations
 
 	double _Curve_value_for_t(double a, double b, double c, double d, double t) noexcept;
-	inline vector_2d _Cubic_bezier_derivative_for_t(const vector_2d& pt0, const vector_2d& pt1, const vector_2d& pt2, const vector_2d& pt3, double t) noexcept;
-	inline bool _Same_sign(double lhs, double rhs) noexcept;
-	double _Find_t_for_d_of_t_equal_zero(const vector_2d& pt0, const vector_2d& pt1, const vector_2d& pt2, const vector_2d& pt3, double t0, double t2, const bool findX, const double epsilon = numeric_limits<double>::epsilon()) noexcept;
+	void _Curve_axis_extents(double a, double b, double c, double d, double& low, double& high) noexcept;
 	vector_2d _Rotate_point(const vector_2d& pt, double angle, bool clockwise = true) noexcept;
 
 	// Definitions
@@ -64,79 +101,36 @@ namespace {
 		return pow(1.0 - t, 3.0) * a + 3.0 * pow(1.0 - t, 2.0) * t * b + 3.0 * (1.0 - t) * pow(t, 2.0) * c + pow(t, 3.0) * d;
 	}
 
-	inline vector_2d _Cubic_bezier_derivative_for_t(const vector_2d& pt0, const vector_2d& pt1, const vector_2d& pt2, const vector_2d& pt3, double t) noexcept {
-		return vector_2d{ 3.0 * pow(1.0 - t, 2.0) * (pt1 - pt0).x(), 3.0 * pow(1.0 - t, 2.0) * (pt1 - pt0).y() } +
-			vector_2d{ 6.0 * (1.0 - t) * t * (pt2 - pt1).x(), 6.0 * (1.0 - t) * t * (pt2 - pt1).y() } +
-			vector_2d{ 3.0 * pow(t, 2.0) * (pt3 - pt2).x(), 3.0 * pow(t, 2.0) * (pt3 - pt2).y() };
-	}
-
-	inline bool _Same_sign(double lhs, double rhs) noexcept {
-		return ((lhs < 0.0) && (rhs < 0.0)) || ((lhs > 0.0) && (rhs > 0.0));
-	}
-
-	double _Find_t_for_d_of_t_equal_zero(const vector_2d& pt0, const vector_2d& pt1, const vector_2d& pt2, const vector_2d& pt3, double t0, double t2, const bool findX, const double epsilon) noexcept {
-		// Validate that t0 is the low value, t2 is the high value, t0 is not equal to t2, and that both are in the range [0.0, 1.0].
-		assert(t0 >= 0.0 && t0 < t2 && t2 <= 1.0);
-		// Find the midpoint.
-		double t1 = (t2 - t0) / 2.0 + t0;
-
-		double t1Previous = -1.0;
-		// Short-circuit and return current t0 if t0 and t1 are equal or t1 and t1Previous are equal to avoid infinite looping.
-		if (_Almost_equal_relative(t0, t1, epsilon) || _Almost_equal_relative(t1, t1Previous, epsilon)) {
-			return t0;
-		}
-		auto dt0 = _Cubic_bezier_derivative_for_t(pt0, pt1, pt2, pt3, t0);
-		auto dt2 = _Cubic_bezier_derivative_for_t(pt0, pt1, pt2, pt3, t2);
-
-		if (findX) {
-			assert(!_Same_sign(dt0.x(), dt2.x()));
+	void _Curve_axis_extents(double a, double b, double c, double d, double& low, double& high) noexcept {
+		// Along one axis the curve can only go beyond its ends where its derivative, 3 * (qa * t * t + qb * t + qc), is zero.
+		const auto qa = (b - a) - 2.0 * (c - b) + (d - c);
+		const auto qb = 2.0 * ((c - b) - (b - a));
+		const auto qc = b - a;
+		double roots[2];
+		int rootCount = 0;
+		if (qa == 0.0) {
+			if (qb != 0.0) {
+				roots[rootCount++] = -qc / qb;
+			}
 		}
 		else {
-			assert(!_Same_sign(dt0.y(), dt2.y()));
-		}
-
-		auto dt1 = _Cubic_bezier_derivative_for_t(pt0, pt1, pt2, pt3, t1);
-
-		// If t0 and t1 are equal or t1 and t1Previous are equal, we can no longer get a meaningful t1 value so the value of t0 will have to be accepted as close enough.
-		while (!_Almost_equal_relative(t0, t1, epsilon) && !_Almost_equal_relative(t1, t1Previous, epsilon)) {
-			if (findX) {
-				if (_Almost_equal_relative(dt1.x(), 0.0, epsilon)) {
-					return t1;
-				}
-				if (_Same_sign(dt0.x(), dt1.x())) {
-					// Since t0 and t2 are different signs and t0 and t1 are the same sign, we know our value lies between t1 and t2 so set t0 = t1 and calculate the new t1.
-					t0 = t1;
-					t1Previous = t1;
-					t1 = (t2 - t0) / 2.0 + t0;
-				}
-				else {
-					assert(_Same_sign(dt1.x(), dt2.x()));
-					// Since t0 and t2 are different signs and t1 and t2 are the same sign, we know our value lies between t0 and t1 so set t2 = t1 and calculate the new t1.
-					t2 = t1;
-					t1Previous = t1;
-					t1 = (t2 - t0) / 2.0 + t0;
+			const auto discriminant = qb * qb - 4.0 * qa * qc;
+			if (discriminant >= 0.0) {
+				// This form of the quadratic formula does not lose precision when qb and the square root nearly cancel.
+				const auto q = -0.5 * (qb + copysign(sqrt(discriminant), qb));
+				roots[rootCount++] = q / qa;
+				if (q != 0.0) {
+					roots[rootCount++] = qc / q;
 				}
 			}
-			else {
-				if (_Almost_equal_relative(dt1.y(), 0.0, epsilon)) {
-					return t1;
-				}
-				if (_Same_sign(dt0.y(), dt1.y())) {
-					// Since t0 and t2 are different signs and t0 and t1 are the same sign, we know our value lies between t1 and t2 so set t0 = t1 and calculate the new t1.
-					t0 = t1;
-					t1Previous = t1;
-					t1 = (t2 - t0) / 2.0 + t0;
-				}
-				else {
-					assert(_Same_sign(dt1.y(), dt2.y()));
-					// Since t0 and t2 are different signs and t1 and t2 are the same sign, we know our value lies between t0 and t1 so set t2 = t1 and calculate the new t1.
-					t2 = t1;
-					t1Previous = t1;
-					t1 = (t2 - t0) / 2.0 + t0;
-				}
+		}
+		for (int i = 0; i < rootCount; ++i) {
+			if (roots[i] > 0.0 && roots[i] < 1.0) {
+				const auto value = _Curve_value_for_t(a, b, c, d, roots[i]);
+				low = min(low, value);
+				high = max(high, value);
 			}
 		}
-		return t1;
 	}
 
 	vector_2d _Rotate_point(const vector_2d& pt, double angle, bool clockwise) noexcept {
@@ -562,10 +556,10 @@ namespace std {
 							exPt1.y(max(cte0.y(), cte1.y()));
 						}
 						else {
-							exPt0.x(min(min(pt0.x(), cte0.x()), cte1.x()));
-							exPt0.y(min(min(pt0.y(), cte0.y()), cte1.y()));
-							exPt1.x(max(max(pt1.x(), cte0.x()), cte1.x()));
-							exPt1.y(max(max(pt1.y(), cte0.y()), cte1.y()));
+							exPt0.x(min(min(exPt0.x(), cte0.x()), cte1.x()));
+							exPt0.y(min(min(exPt0.y(), cte0.y()), cte1.y()));
+							exPt1.x(max(max(exPt1.x(), cte0.x()), cte1.x()));
+							exPt1.y(max(max(exPt1.y(), cte0.y()), cte1.y()));
 						}
 						if (arcNegative) {
 							currentTheta -= theta;
@@ -579,235 +573,14 @@ namespace std {
 				}
 
 				void _Curve_to_extents(const vector_2d& pt0, const vector_2d& pt1, const vector_2d& pt2, const vector_2d& pt3, vector_2d& extents0, vector_2d& extents1) noexcept {
-					// We know at a minimum that the extents are the two knots, pt0 and pt3. The only question is whether the extents go beyond those two points.
-					extents0.x(min(pt0.x(), pt3.x()));
-					extents0.y(min(pt0.y(), pt3.y()));
-					extents1.x(max(pt0.x(), pt3.x()));
-					extents1.y(max(pt0.y(), pt3.y()));
-
-					// Find X's and Ys (between 0 and 2).
-					int numPoints = 0;
-					int numXs = 0;
-					int numYs = 0;
-
-					const auto dt0 = _Cubic_bezier_derivative_for_t(pt0, pt1, pt2, pt3, 0.0);
-					const auto dt1 = _Cubic_bezier_derivative_for_t(pt0, pt1, pt2, pt3, 0.5);
-					const auto dt2 = _Cubic_bezier_derivative_for_t(pt0, pt1, pt2, pt3, 1.0);
-					bool foundLowX = false;
-					bool foundHighX = false;
-					bool foundLowY = false;
-					bool foundHighY = false;
-
-					const double epsilon = numeric_limits<double>::epsilon();
-
-					// X values
-					if (_Almost_equal_relative(dt0.x(), 0.0, epsilon)) {
-						assert(numXs == 0);
-						// First knot is critical. We already assigned it so we're done with that.
-						foundLowX = true;
-						numPoints++;
-						numXs++;
-						if (_Same_sign(dt1.x(), dt2.x())) {
-							// No second critical point so the second knot is the other extent and we already assigned it so we're done with that.
-							foundHighX = true;
-							numPoints++;
-							numXs++;
-						}
-						else {
-							auto t = _Find_t_for_d_of_t_equal_zero(pt0, pt1, pt2, pt3, 0.5, 1.0, true);
-							auto xval = _Curve_value_for_t(pt0.x(), pt1.x(), pt2.x(), pt3.x(), t);
-							// We do this min/max assignment because critical points just signal a change in curve direction, not that the critical point is actually a min/max point.
-							extents0.x(min(extents0.x(), xval));
-							extents1.x(max(extents1.x(), xval));
-							foundHighX = true;
-							numPoints++;
-							numXs++;
-						}
-					}
-					if (_Almost_equal_relative(dt1.x(), 0.0, epsilon)) {
-						assert(numXs == 0);
-						// Center is only critical.
-						auto cxval = _Curve_value_for_t(pt0.x(), pt1.x(), pt2.x(), pt3.x(), 0.5);
-						// Arbitrarily use pt3.x() rather than pt0.x(); they are the same value regardless.
-						assert(_Almost_equal_relative(pt0.x(), pt3.x(), epsilon));
-						extents0.x(min(cxval, pt3.x()));
-						extents1.x(max(cxval, pt3.x()));
-						numPoints += 2;
-						numXs += 2;
-					}
-					if (_Almost_equal_relative(dt2.x(), 0.0, epsilon)) {
-						assert(numXs == 0);
-						numPoints++;
-						numXs++;
-						foundHighX = true;
-						if (_Same_sign(dt0.x(), dt1.x())) {
-							// No second critical point so the first knot is the other extent and we already assigned it so we're done with that.
-							foundLowX = true;
-							numPoints++;
-							numXs++;
-						}
-						else {
-							auto t = _Find_t_for_d_of_t_equal_zero(pt0, pt1, pt2, pt3, 0.0, 0.5, true);
-							auto xval = _Curve_value_for_t(pt0.y(), pt1.y(), pt2.y(), pt3.y(), t);
-							// We do this min/max assignment because critical points just signal a change in curve direction, not that the critical point is actually a min/max point.
-							extents0.x(min(extents0.x(), xval));
-							extents1.x(max(extents1.x(), xval));
-							foundLowX = true;
-							numPoints++;
-							numXs++;
-						}
-					}
-					if (numXs == 0) {
-						if (_Same_sign(dt0.x(), dt1.x()) && _Same_sign(dt1.x(), dt2.x())) {
-							// No critical points on X: use ends.
-							extents0.x(min(pt0.x(), pt3.x()));
-							extents1.x(max(pt0.x(), pt3.x()));
-							foundLowX = true;
-							foundHighX = true;
-							numPoints += 2;
-							numXs += 2;
-						}
-					}
-					if (!foundLowX) {
-						if (_Same_sign(dt0.x(), dt1.x())) {
-							// There is no critical point between dt0.x() and dt1.x() so the lowX point is pt0.x(), which we already assigned.
-							foundLowX = true;
-							numPoints++;
-							numXs++;
-						}
-						else {
-							auto t = _Find_t_for_d_of_t_equal_zero(pt0, pt1, pt2, pt3, 0.0, 0.5, true);
-							auto xval = _Curve_value_for_t(pt0.x(), pt1.x(), pt2.x(), pt3.x(), t);
-							// We do this min/max assignment because critical points just signal a change in curve direction, not that the critical point is actually a min/max point.
-							extents0.x(min(extents0.x(), xval));
-							extents1.x(max(extents1.x(), xval));
-							foundLowX = true;
-							numPoints++;
-							numXs++;
-						}
-					}
-					if (!foundHighX) {
-						if (_Same_sign(dt1.x(), dt2.x())) {
-							// There is no critical point between dt1.x and dt2.x so the highX point is pt3.x, which we already assigned.
-							foundHighX = true;
-							numPoints++;
-							numXs++;
-						}
-						else {
-							auto t = _Find_t_for_d_of_t_equal_zero(pt0, pt1, pt2, pt3, 0.5, 1.0, true);
-							auto xval = _Curve_value_for_t(pt0.x(), pt1.x(), pt2.x(), pt3.x(), t);
-							// We do this min/max assignment because critical points just signal a change in curve direction, not that the critical point is actually a min/max point.
-							extents0.x(min(extents0.x(), xval));
-							extents1.x(max(extents1.x(), xval));
-							foundHighX = true;
-							numPoints++;
-							numXs++;
-						}
-					}
-
-					// Y values
-					if (_Almost_equal_relative(dt0.y(), 0.0, epsilon)) {
-						assert(numYs == 0);
-						// First knot is critical. We already assigned it so we're done with that.
-						foundLowY = true;
-						numPoints++;
-						numYs++;
-						if (_Same_sign(dt1.y(), dt2.y())) {
-							// No second critical point so the second knot is the other extent and we already assigned it so we're done with that.
-							foundHighY = true;
-							numPoints++;
-							numYs++;
-						}
-						else {
-							auto t = _Find_t_for_d_of_t_equal_zero(pt0, pt1, pt2, pt3, 0.5, 1.0, false);
-							auto yval = _Curve_value_for_t(pt0.y(), pt1.y(), pt2.y(), pt3.y(), t);
-							// We do this min/max assignment because critical points just signal a change in curve direction, not that the critical point is actually a min/max point.
-							extents0.y(min(extents0.y(), yval));
-							extents1.y(max(extents1.y(), yval));
-							foundHighY = true;
-							numPoints++;
-							numYs++;
-						}
-					}
-					if (_Almost_equal_relative(dt1.y(), 0.0, epsilon)) {
-						assert(numYs == 0);
-						// Center is only critical.
-						auto cyval = _Curve_value_for_t(pt0.y(), pt1.y(), pt2.y(), pt3.y(), 0.5);
-						// Arbitrarily use pt3.y() rather than pt0.y(); they are the same value regardless.
-						assert(_Almost_equal_relative(pt0.y(), pt3.y(), epsilon));
-						extents0.y(min(cyval, pt3.y()));
-						extents1.y(max(cyval, pt3.y()));
-						numPoints += 2;
-						numYs += 2;
-					}
-					if (_Almost_equal_relative(dt2.y(), 0.0, epsilon)) {
-						assert(numYs == 0);
-						numPoints++;
-						numYs++;
-						foundHighY = true;
-						if (_Same_sign(dt0.y(), dt1.y())) {
-							// No second critical point so the first knot is the other extent and we already assigned it so we're done with that.
-							foundLowY = true;
-							numPoints++;
-							numYs++;
-						}
-						else {
-							auto t = _Find_t_for_d_of_t_equal_zero(pt0, pt1, pt2, pt3, 0.0, 0.5, false);
-							auto yval = _Curve_value_for_t(pt0.y(), pt1.y(), pt2.y(), pt3.y(), t);
-							// We do this min/max assignment because critical points just signal a change in curve direction, not that the critical point is actually a min/max point.
-							extents0.y(min(extents0.y(), yval));
-							extents1.y(max(extents1.y(), yval));
-							foundLowY = true;
-							numPoints++;
-							numYs++;
-						}
-					}
-					if (numYs == 0) {
-						if (_Same_sign(dt0.y(), dt1.y()) && _Same_sign(dt1.y(), dt2.y())) {
-							// No critical points on Y: use ends.
-							extents0.y(min(pt0.y(), pt3.y()));
-							extents1.y(max(pt0.y(), pt3.y()));
-							foundLowY = true;
-							foundHighY = true;
-							numPoints += 2;
-							numYs += 2;
-						}
-					}
-					if (!foundLowY) {
-						if (_Same_sign(dt0.y(), dt1.y())) {
-							// There is no critical point between dt0.y() and dt1.y() so the lowY point is pt0.y(), which we already assigned.
-							foundLowY = true;
-							numPoints++;
-							numYs++;
-						}
-						else {
-							auto t = _Find_t_for_d_of_t_equal_zero(pt0, pt1, pt2, pt3, 0.0, 0.5, false);
-							auto yval = _Curve_value_for_t(pt0.y(), pt1.y(), pt2.y(), pt3.y(), t);
-							extents0.y(min(extents0.y(), yval));
-							extents1.y(max(extents1.y(), yval));
-							foundLowY = true;
-							numPoints++;
-							numYs++;
-						}
-					}
-					if (!foundHighY) {
-						if (_Same_sign(dt1.y(), dt2.y())) {
-							// There is no critical point between dt1.y() and dt2.y() so the lowY point is pt3.y(), which we already assigned.
-							foundHighY = true;
-							numPoints++;
-							numYs++;
-						}
-						else {
-							auto t = _Find_t_for_d_of_t_equal_zero(pt0, pt1, pt2, pt3, 0.5, 1.0, false);
-							auto yval = _Curve_value_for_t(pt0.y(), pt1.y(), pt2.y(), pt3.y(), t);
-							extents0.y(min(extents0.y(), yval));
-							extents1.y(max(extents1.y(), yval));
-							foundHighY = true;
-							numPoints++;
-							numYs++;
-						}
-					}
-					assert(foundLowX && foundLowY && foundHighX && foundHighY && numPoints == 4 && numXs == 2 && numYs == 2);
+					auto lowX = min(pt0.x(), pt3.x());
+					auto highX = max(pt0.x(), pt3.x());
+					auto lowY = min(pt0.y(), pt3.y());
+					auto highY = max(pt0.y(), pt3.y());
+					_Curve_axis_extents(pt0.x(), pt1.x(), pt2.x(), pt3.x(), lowX, highX);
+					_Curve_axis_extents(pt0.y(), pt1.y(), pt2.y(), pt3.y(), lowY, highY);
+					extents0 = { lowX, lowY };
+					extents1 = { highX, highY };
 				}
 
 #if _Inline_namespace_conditional_support_test
@@ -8,29 +8,298 @@ using namespace std::experimental::io2d;
 
 namespace {
 	const vector_2d _Font_default_size{ 16.0, 16.0 };
+
+	// What _Brush holds while a new surface's brush is still a plain color, so that creating a surface does not create a pattern.
+	const ::std::experimental::io2d::brush& _Default_brush() {
+		static const ::std::experimental::io2d::brush b(solid_color_brush_factory(rgba_color::transparent_black()));
+		return b;
+	}
+
+	// Created by the first surface that draws or measures text rather than by every surface, and shared by all of them.
+	const ::std::experimental::io2d::font_resource& _Default_font_resource() {
+		static const ::std::experimental::io2d::font_resource f(font_resource_factory{});
+		return f;
+	}
+
+	// Mirrors the checks in cairo_set_dash so that invalid dashes are rejected before they are stored rather than when they are flushed.
+	bool _Dashes_are_valid(const ::std::experimental::io2d::dashes& d) noexcept {
+		double total = 0.0;
+		for (auto dash : get<0>(d)) {
+			if (dash < 0.0) {
+				return false;
+			}
+			total += dash;
+		}
+		return get<0>(d).empty() || total != 0.0;
+	}
+
+	bool _Box_contains(const _Damage_region::_Box& outer, const _Damage_region::_Box& inner) noexcept {
+		return outer.x0 <= inner.x0 && outer.y0 <= inner.y0 && outer.x1 >= inner.x1 && outer.y1 >= inner.y1;
+	}
+
+	long long _Box_area(const _Damage_region::_Box& b) noexcept {
+		return static_cast<long long>(b.x1 - b.x0) * (b.y1 - b.y0);
+	}
+
+	_Damage_region::_Box _Box_union(const _Damage_region::_Box& a, const _Damage_region::_Box& b) noexcept {
+		return{ min(a.x0, b.x0), min(a.y0, b.y0), max(a.x1, b.x1), max(a.y1, b.y1) };
+	}
+
+	// Adds the device-space bounds of a user-space box.
+	void _Add_user_box(cairo_t* context, _Damage_region& region, double x0, double y0, double x1, double y1) noexcept {
+		double xs[4] = { x0, x1, x0, x1 };
+		double ys[4] = { y0, y0, y1, y1 };
+		for (int i = 0; i < 4; i++) {
+			cairo_user_to_device(context, &xs[i], &ys[i]);
+		}
+		region._Add(_Device_box_covering(*min_element(xs, xs + 4), *min_element(ys, ys + 4), *max_element(xs, xs + 4), *max_element(ys, ys + 4)));
+	}
+
+	// How far a miter join in p can reach from the point where it joins, in half line widths: 1 / sin(psi / 2) for segments that meet at an angle psi, or 1 where cairo bevels the join because that would exceed miterLimit. ctm is the matrix p is stroked under. Walking the path is far cheaper than stroking it to find out.
+	double _Miter_reach(const cairo_path_t& p, const cairo_matrix_t& ctm, double miterLimit) noexcept {
+		// cairo rounds points to 24.8 fixed point in device space and decides whether to miter from the angle there, so ctm's singular values bound how far the angles it sees can be from the ones here.
+		const auto sumOfSquares = ctm.xx * ctm.xx + ctm.yx * ctm.yx + ctm.xy * ctm.xy + ctm.yy * ctm.yy;
+		const auto determinant = ctm.xx * ctm.yy - ctm.xy * ctm.yx;
+		const auto largest = sqrt((sumOfSquares + sqrt(max(sumOfSquares * sumOfSquares - 4.0 * determinant * determinant, 0.0))) / 2.0);
+		const auto smallest = abs(determinant) / largest;
+		if (!(smallest > 0.0)) {
+			return miterLimit;
+		}
+		const auto condition = largest / smallest;
+		// The furthest a join that cairo miters can reach here, however sharp it looks in user space.
+		const auto limit = miterLimit * condition;
+		// Rounding moves each end of a segment by at most 1/512 in x and in y, which turns a segment that is length long here by at most turn / length radians (asin(x) <= 1.6 * x).
+		const auto turn = condition * 1.6 * sqrt(2.0) / 256.0 / smallest;
+
+		double result = 1.0;
+		bool hasIn = false;
+		double inX = 0.0, inY = 0.0, inLength = 0.0;
+		double firstX = 0.0, firstY = 0.0, firstLength = 0.0;
+		double currentX = 0.0, currentY = 0.0, startX = 0.0, startY = 0.0;
+		auto join = [&](double ax, double ay, double aLength, double bx, double by, double bLength) noexcept {
+			// sin(psi / 2), where psi is the angle between the reversed incoming segment and the outgoing one, less what rounding could take off it.
+			auto sine = sqrt(max((1.0 + (ax * bx + ay * by) / (aLength * bLength)) / 2.0, 0.0)) - (turn / aLength + turn / bLength) / 2.0;
+			result = max(result, (sine * limit <= 1.0) ? limit : 1.0 / sine);
+		};
+		// Adds a segment that leaves the current point along (sx, sy) and arrives along (ex, ey). Like cairo, skips it if it has no length.
+		auto add = [&](double sx, double sy, double ex, double ey) noexcept {
+			const auto sLength = sqrt(sx * sx + sy * sy);
+			if (sLength == 0.0) {
+				return;
+			}
+			if (hasIn) {
+				join(inX, inY, inLength, sx, sy, sLength);
+			}
+			else {
+				firstX = sx;
+				firstY = sy;
+				firstLength = sLength;
+			}
+			inX = ex;
+			inY = ey;
+			inLength = sqrt(ex * ex + ey * ey);
+			hasIn = true;
+		};
+		for (int i = 0; i < p.num_data; i += p.data[i].header.length) {
+			const auto points = p.data + i + 1;
+			switch (p.data[i].header.type) {
+			case CAIRO_PATH_MOVE_TO:
+				currentX = startX = points[0].point.x;
+				currentY = startY = points[0].point.y;
+				hasIn = false;
+				break;
+			case CAIRO_PATH_LINE_TO:
+				add(points[0].point.x - currentX, points[0].point.y - currentY, points[0].point.x - currentX, points[0].point.y - currentY);
+				currentX = points[0].point.x;
+				currentY = points[0].point.y;
+				break;
+			case CAIRO_PATH_CURVE_TO:
+			{
+				// The end tangents, found as _cairo_spline_init finds them. Between its ends cairo joins the pieces of a curve with round fans.
+				double sx = points[0].point.x - currentX, sy = points[0].point.y - currentY;
+				if (sx == 0.0 && sy == 0.0) {
+					sx = points[1].point.x - currentX;
+					sy = points[1].point.y - currentY;
+				}
+				if (sx == 0.0 && sy == 0.0) {
+					sx = points[2].point.x - currentX;
+					sy = points[2].point.y - currentY;
+				}
+				double ex = points[2].point.x - points[1].point.x, ey = points[2].point.y - points[1].point.y;
+				if (ex == 0.0 && ey == 0.0) {
+					ex = points[2].point.x - points[0].point.x;
+					ey = points[2].point.y - points[0].point.y;
+				}
+				if (ex == 0.0 && ey == 0.0) {
+					ex = points[2].point.x - currentX;
+					ey = points[2].point.y - currentY;
+				}
+				add(sx, sy, ex, ey);
+				currentX = points[2].point.x;
+				currentY = points[2].point.y;
+			} break;
+			case CAIRO_PATH_CLOSE_PATH:
+				add(startX - currentX, startY - currentY, startX - currentX, startY - currentY);
+				if (hasIn) {
+					join(inX, inY, inLength, firstX, firstY, firstLength);
+				}
+				currentX = startX;
+				currentY = startY;
+				hasIn = false;
+				break;
+			}
+		}
+		return result;
+	}
+
+	// Bounded well inside int, so that a position plus a size cannot overflow once they are cast.
+	bool _Is_whole_pixel(double v) noexcept {
+		return v == trunc(v) && abs(v) < 1073741824.0;
+	}
+
+	// Operators that change the destination outside of what is drawn, up to the clip.
+	bool _Is_unbounded(::std::experimental::io2d::compositing_operator co) noexcept {
+		switch (co) {
+		case ::std::experimental::io2d::compositing_operator::in:
+		case ::std::experimental::io2d::compositing_operator::out:
+		case ::std::experimental::io2d::compositing_operator::dest_in:
+		case ::std::experimental::io2d::compositing_operator::dest_atop:
+			return true;
+		default:
+			return false;
+		}
+	}
+}
+
+void _Damage_region::_Add(const _Box& b) noexcept {
+	if (_Everything || b.x0 >= b.x1 || b.y0 >= b.y1) {
+		return;
+	}
+	for (int i = 0; i < _Count; i++) {
+		if (_Box_contains(_Boxes[i], b)) {
+			return;
+		}
+	}
+	int kept = 0;
+	for (int i = 0; i < _Count; i++) {
+		if (!_Box_contains(b, _Boxes[i])) {
+			_Boxes[kept++] = _Boxes[i];
+		}
+	}
+	_Count = kept;
+	_Boxes[_Count++] = b;
+	if (_Count > _Max_boxes) {
+		int bestI = 0;
+		int bestJ = 1;
+		auto bestWaste = numeric_limits<long long>::max();
+		for (int i = 0; i < _Count; i++) {
+			for (int j = i + 1; j < _Count; j++) {
+				auto waste = _Box_area(_Box_union(_Boxes[i], _Boxes[j])) - _Box_area(_Boxes[i]) - _Box_area(_Boxes[j]);
+				if (waste < bestWaste) {
+					bestWaste = waste;
+					bestI = i;
+					bestJ = j;
+				}
+			}
+		}
+		_Boxes[bestI] = _Box_union(_Boxes[bestI], _Boxes[bestJ]);
+		_Boxes[bestJ] = _Boxes[--_Count];
+	}
+}
+
+void _Damage_region::_Add_everything() noexcept {
+	_Everything = true;
+	_Count = 0;
+}
+
+void _Damage_region::_Clear() noexcept {
+	_Everything = false;
+	_Count = 0;
+}
+
+void surface::_Damage_clip() noexcept {
+	if (!_Track_damage) {
+		return;
+	}
+	double x0, y0, x1, y1;
+	cairo_clip_extents(_Context.get(), &x0, &y0, &x1, &y1);
+	_Add_user_box(_Context.get(), _Dirty_region, x0, y0, x1, y1);
+}
+
+void surface::_Damage_user_box(double x0, double y0, double x1, double y1) noexcept {
+	if (_Is_unbounded(_Compositing_operator)) {
+		_Damage_clip();
+		return;
+	}
+	_Damage_clipped_user_box(x0, y0, x1, y1);
+}
+
+void surface::_Damage_clipped_user_box(double x0, double y0, double x1, double y1) noexcept {
+	double cx0, cy0, cx1, cy1;
+	cairo_clip_extents(_Context.get(), &cx0, &cy0, &cx1, &cy1);
+	x0 = max(x0, cx0);
+	y0 = max(y0, cy0);
+	x1 = min(x1, cx1);
+	y1 = min(y1, cy1);
+	if (x0 < x1 && y0 < y1) {
+		_Add_user_box(_Context.get(), _Dirty_region, x0, y0, x1, y1);
+	}
+}
+
+void surface::_Damage_fill() noexcept {
+	if (!_Track_damage) {
+		return;
+	}
+	double x0, y0, x1, y1;
+	cairo_path_extents(_Context.get(), &x0, &y0, &x1, &y1);
+	_Damage_user_box(x0, y0, x1, y1);
+}
+
+void surface::_Damage_stroke(const cairo_path_t* p) noexcept {
+	if (!_Track_damage) {
+		return;
+	}
+	// How far a stroke can reach past the path's own bounds, in line widths: half a line, more at a square cap's corners or a miter's tip.
+	auto joinReach = 1.0;
+	if (p != nullptr && (_Line_join == ::std::experimental::io2d::line_join::miter || _Line_join == ::std::experimental::io2d::line_join::miter_or_bevel)) {
+		cairo_matrix_t ctm;
+		cairo_get_matrix(_Context.get(), &ctm);
+		joinReach = _Miter_reach(*p, ctm, cairo_get_miter_limit(_Context.get()));
+	}
+	auto pad = 0.5 * max(joinReach, (_Line_cap == ::std::experimental::io2d::line_cap::square) ? sqrt(2.0) : 1.0) * _Line_width;
+	double x0, y0, x1, y1;
+	cairo_path_extents(_Context.get(), &x0, &y0, &x1, &y1);
+	_Damage_user_box(x0 - pad, y0 - pad, x1 + pad, y1 + pad);
+}
+
+void surface::_Damage_text(const string& utf8) noexcept {
+	if (!_Track_damage) {
+		return;
+	}
+	cairo_text_extents_t extents;
+	cairo_text_extents(_Context.get(), utf8.c_str(), &extents);
+	double x, y;
+	cairo_get_current_point(_Context.get(), &x, &y);
+	_Damage_user_box(x + extents.x_bearing, y + extents.y_bearing, x + extents.x_bearing + extents.width, y + extents.y_bearing + extents.height);
+}
+
+void surface::_Damage_glyphs(const cairo_glyph_t* glyphs, int count) noexcept {
+	if (!_Track_damage) {
+		return;
+	}
+	cairo_text_extents_t extents;
+	cairo_glyph_extents(_Context.get(), glyphs, count, &extents);
+	_Damage_user_box(extents.x_bearing, extents.y_bearing, extents.x_bearing + extents.width, extents.y_bearing + extents.height);
 }
 
 void surface::_Ensure_state() {
 	if (_Surface == nullptr || _Context == nullptr) {
 		_Throw_if_failed_cairo_status_t(CAIRO_STATUS_NULL_POINTER);
 	}
-	brush(_Brush);
-	antialias(_Antialias);
-	dashes(_Dashes);
-	fill_rule(_Fill_rule);
-	line_cap(_Line_cap);
-	line_join(_Line_join);
-	line_width(_Line_width);
-	miter_limit(_Miter_limit);
-	compositing_operator(_Compositing_operator);
-	if (_Current_path.get() != nullptr) {
-		path(*_Current_path);
-	}
-	else {
-		cairo_new_path(_Context.get());
-	}
-	matrix(_Transform_matrix);
-	font_resource(_Font_resource);
+	cairo_matrix_t cm{ _Transform_matrix.m00(), _Transform_matrix.m01(), _Transform_matrix.m10(), _Transform_matrix.m11(), _Transform_matrix.m20(), _Transform_matrix.m21() };
+	cairo_set_matrix(_Context.get(), &cm);
+	_Dirty_state = _State_all;
+	_Bound_pattern = nullptr;
 }
 
 void surface::_Ensure_state(error_code& ec) noexcept {
@@ -38,33 +307,93 @@ void surface::_Ensure_state(error_code& ec) noexcept {
 		ec = _Cairo_status_t_to_std_error_code(CAIRO_STATUS_NULL_POINTER);
 		return;
 	}
-	brush(_Brush, ec);
-	if (static_cast<bool>(ec)) {
+	cairo_matrix_t cm{ _Transform_matrix.m00(), _Transform_matrix.m01(), _Transform_matrix.m10(), _Transform_matrix.m11(), _Transform_matrix.m20(), _Transform_matrix.m21() };
+	cairo_set_matrix(_Context.get(), &cm);
+	_Dirty_state = _State_all;
+	_Bound_pattern = nullptr;
+	ec.clear();
+}
+
+void surface::_Flush_state() const noexcept {
+	if ((_Dirty_state & ~_State_current_path) == 0) {
 		return;
 	}
-	antialias(_Antialias);
-	fill_rule(_Fill_rule);
-	line_cap(_Line_cap);
-	line_join(_Line_join);
-	line_width(_Line_width);
-	miter_limit(_Miter_limit);
-	compositing_operator(_Compositing_operator);
-	if (_Current_path.get() != nullptr) {
-		path(*_Current_path, ec);
-		if (static_cast<bool>(ec)) {
-			return;
+	auto context = _Context.get();
+	if ((_Dirty_state & _State_antialias) != 0) {
+		cairo_set_antialias(context, _Antialias_to_cairo_antialias_t(_Antialias));
+	}
+	if ((_Dirty_state & _State_dashes) != 0) {
+		if (_Dashes == nullptr) {
+			cairo_set_dash(context, nullptr, 0, 0.0);
+		}
+		else {
+			cairo_set_dash(context, get<0>(*_Dashes).data(), _Container_size_to_int(get<0>(*_Dashes)), get<1>(*_Dashes));
+		}
+	}
+	if ((_Dirty_state & _State_fill_rule) != 0) {
+		cairo_set_fill_rule(context, _Fill_rule_to_cairo_fill_rule_t(_Fill_rule));
+	}
+	if ((_Dirty_state & _State_line_cap) != 0) {
+		cairo_set_line_cap(context, _Line_cap_to_cairo_line_cap_t(_Line_cap));
+	}
+	if ((_Dirty_state & _State_line_join) != 0) {
+		cairo_set_line_join(context, _Line_join_to_cairo_line_join_t(_Line_join));
+		if (_Line_join == ::std::experimental::io2d::line_join::miter_or_bevel) {
+			cairo_set_miter_limit(context, min(_Miter_limit, _Line_join_miter_miter_limit));
 		}
+		else {
+			cairo_set_miter_limit(context, _Line_join_miter_miter_limit);
+		}
+	}
+	if ((_Dirty_state & _State_line_width) != 0) {
+		cairo_set_line_width(context, _Line_width);
+	}
+	if ((_Dirty_state & _State_compositing_operator) != 0) {
+		cairo_set_operator(context, _Compositing_operator_to_cairo_operator_t(_Compositing_operator));
+	}
+	if ((_Dirty_state & _State_font_resource) != 0 && _Font_resource._Scaled_font != nullptr) {
+		cairo_set_scaled_font(context, _Font_resource._Scaled_font.get());
+	}
+	_Dirty_state &= _State_current_path;
+}
+
+void surface::_Flush_current_path() const noexcept {
+	if ((_Dirty_state & _State_current_path) == 0) {
+		return;
+	}
+	if (_Current_path.get() != nullptr) {
+		_Current_path->_Set_on(_Context.get());
 	}
 	else {
 		cairo_new_path(_Context.get());
 	}
-	matrix(_Transform_matrix);
-	dashes(_Dashes, ec);
-	if (static_cast<bool>(ec)) {
+	_Dirty_state &= ~static_cast<unsigned int>(_State_current_path);
+}
+
+void surface::_Brush_color_to(const rgba_color& c) noexcept {
+	_Brush_is_color = true;
+	_Brush_color = c;
+}
+
+void surface::_Resolve_font_resource() const {
+	if (_Font_resource._Scaled_font == nullptr) {
+		_Font_resource = _Default_font_resource();
+		_Dirty_state |= _State_font_resource;
+	}
+}
+
+void surface::_Bind_brush() const noexcept {
+	if (_Brush_is_color) {
+		// cairo does nothing if the source already is this color and otherwise recycles solid patterns through its own free list, so this does not allocate once warmed up.
+		cairo_set_source_rgba(_Context.get(), _Brush_color.r(), _Brush_color.g(), _Brush_color.b(), _Brush_color.a());
+		_Bound_pattern = nullptr;
 		return;
 	}
-	font_resource(_Font_resource);
-	ec.clear();
+	_Brush._Configure_pattern();
+	if (_Bound_pattern != _Brush.native_handle()) {
+		cairo_set_source(_Context.get(), _Brush.native_handle());
+		_Bound_pattern = _Brush.native_handle();
+	}
 }
 
 surface::surface(format fmt, int width, int height)
@@ -72,11 +401,12 @@ surface::surface(format fmt, int width, int height)
 	, _Device()
 	, _Surface(unique_ptr<cairo_surface_t, decltype(&cairo_surface_destroy)>(cairo_image_surface_create(_Format_to_cairo_format_t(fmt), width, height), &cairo_surface_destroy))
 	, _Context(unique_ptr<cairo_t, decltype(&cairo_destroy)>(cairo_create(_Surface.get()), &cairo_destroy))
-	, _Native_font_options(unique_ptr<cairo_font_options_t, decltype(&cairo_font_options_destroy)>(cairo_font_options_create(), &cairo_font_options_destroy))
-	, _Dirty_rect()
+	, _Dirty_region()
 	, _Format(_Cairo_format_t_to_format(cairo_image_surface_get_format(_Surface.get())))
 	, _Content(_Cairo_content_t_to_content(cairo_surface_get_content(_Surface.get())))
-	, _Brush(cairo_pattern_create_rgba(0.0, 0.0, 0.0, 0.0))
+	, _Brush(_Default_brush())
+	, _Brush_is_color(true)
+	, _Brush_color(rgba_color::transparent_black())
 	, _Antialias(experimental::io2d::antialias::default_antialias)
 	, _Fill_rule(::std::experimental::io2d::fill_rule::winding)
 	, _Line_cap(::std::experimental::io2d::line_cap::butt)
@@ -86,17 +416,24 @@ surface::surface(format fmt, int width, int height)
 	, _Compositing_operator(::std::experimental::io2d::compositing_operator::over)
 	, _Current_path()
 	, _Immediate_path()
+	, _Immediate_cairo_path()
 	, _Transform_matrix(matrix_2d::init_identity())
-	, _Font_resource(font_resource_factory())
+	, _Font_resource(nullptr)
+	, _Memory_resource(get_default_resource())
 	, _Saved_state() {
 	_Throw_if_failed_cairo_status_t(cairo_surface_status(_Surface.get()));
 	_Throw_if_failed_cairo_status_t(cairo_status(_Context.get()));
-	_Throw_if_failed_cairo_status_t(cairo_font_options_status(_Native_font_options.get()));
 	_Throw_if_failed_cairo_status_t(cairo_pattern_status(_Brush.native_handle()));
 	_Ensure_state();
 }
 
 surface::native_handle_type surface::native_handle() const {
+	// Callers may use the context directly, so it has to hold everything that has been set on this surface.
+	_Resolve_font_resource();
+	_Flush_state();
+	_Flush_current_path();
+	// Nor can the source be trusted once the caller has had the context.
+	_Bound_pattern = nullptr;
 	return{ _Surface.get(), _Context.get() };
 }
 
@@ -105,10 +442,11 @@ surface::surface(surface&& other) noexcept
 	, _Device(move(other._Device))
 	, _Surface(move(other._Surface))
 	, _Context(move(other._Context))
-	, _Native_font_options(move(other._Native_font_options))
 	, _Format(_Cairo_format_t_to_format(cairo_image_surface_get_format(_Surface.get())))
 	, _Content(_Cairo_content_t_to_content(cairo_surface_get_content(_Surface.get())))
 	, _Brush(move(other._Brush))
+	, _Brush_is_color(other._Brush_is_color)
+	, _Brush_color(other._Brush_color)
 	, _Antialias(move(other._Antialias))
 	, _Fill_rule(move(other._Fill_rule))
 	, _Line_cap(move(other._Line_cap))
@@ -117,10 +455,17 @@ surface::surface(surface&& other) noexcept
 	, _Miter_limit(move(other._Miter_limit))
 	, _Compositing_operator(move(other._Compositing_operator))
 	, _Current_path(move(other._Current_path))
-	, _Immediate_path(move(other._Immediate_path))
+	, _Immediate_path(other._Immediate_path._Without_save_point())
+	, _Immediate_cairo_path(move(other._Immediate_cairo_path))
 	, _Transform_matrix(move(other._Transform_matrix))
 	, _Font_resource(move(other._Font_resource))
-	, _Saved_state(move(other._Saved_state)) {
+	, _Memory_resource(other._Memory_resource)
+	, _Saved_state(move(other._Saved_state))
+	, _Dirty_state(other._Dirty_state)
+	, _Bound_pattern(other._Bound_pattern) {
+	_Dirty_region = other._Dirty_region;
+	_Track_damage = other._Track_damage;
+	_Set_active_save_point();
 }
 
 surface& surface::operator=(surface&& other) noexcept {
@@ -128,10 +473,11 @@ surface& surface::operator=(surface&& other) noexcept {
 		_Device = move(other._Device);
 		_Surface = move(other._Surface);
 		_Context = move(other._Context);
-		_Native_font_options = move(other._Native_font_options);
 		_Format = _Cairo_format_t_to_format(cairo_image_surface_get_format(_Surface.get()));
 		_Content = _Cairo_content_t_to_content(cairo_surface_get_content(_Surface.get()));
 		_Brush = move(other._Brush);
+		_Brush_is_color = other._Brush_is_color;
+		_Brush_color = other._Brush_color;
 		_Antialias = move(other._Antialias);
 		_Fill_rule = move(other._Fill_rule);
 		_Line_cap = move(other._Line_cap);
@@ -140,10 +486,20 @@ surface& surface::operator=(surface&& other) noexcept {
 		_Miter_limit = move(other._Miter_limit);
 		_Compositing_operator = move(other._Compositing_operator);
 		_Current_path = move(other._Current_path);
-		_Immediate_path = move(other._Immediate_path);
+		// Assignment would keep this surface's memory resources and copy whatever was allocated from other ones, so the immediate path and the saved state are constructed again from other's instead, taking its allocators with them.
+		_Immediate_path.~path_factory();
+		new (&_Immediate_path) path_factory(other._Immediate_path._Without_save_point());
+		_Immediate_cairo_path = move(other._Immediate_cairo_path);
 		_Transform_matrix = move(other._Transform_matrix);
 		_Font_resource = move(other._Font_resource);
-		_Saved_state = move(other._Saved_state);
+		_Memory_resource = other._Memory_resource;
+		_Saved_state.~_Saved_state_type();
+		new (&_Saved_state) _Saved_state_type(move(other._Saved_state));
+		_Dirty_state = other._Dirty_state;
+		_Bound_pattern = other._Bound_pattern;
+		_Dirty_region = other._Dirty_region;
+		_Track_damage = other._Track_damage;
+		_Set_active_save_point();
 	}
 	return *this;
 }
@@ -154,10 +510,11 @@ surface::surface(surface::native_handle_type nh, ::std::experimental::io2d::form
 	, _Device()
 	, _Surface(unique_ptr<cairo_surface_t, decltype(&cairo_surface_destroy)>(nh.csfce, &cairo_surface_destroy))
 	, _Context(unique_ptr<cairo_t, decltype(&cairo_destroy)>(((nh.csfce == nullptr) ? nullptr : cairo_create(nh.csfce)), &cairo_destroy))
-	, _Native_font_options(unique_ptr<cairo_font_options_t, decltype(&cairo_font_options_destroy)>(cairo_font_options_create(), &cairo_font_options_destroy))
 	, _Format(fmt)
 	, _Content(ctnt)
-	, _Brush(_Context.get() == nullptr ? cairo_pattern_create_rgba(0.0, 0.0, 0.0, 0.0) : cairo_pattern_reference(cairo_get_source(_Context.get())))
+	, _Brush(_Default_brush())
+	, _Brush_is_color(true)
+	, _Brush_color(rgba_color::transparent_black())
 	, _Antialias(_Context.get() == nullptr ? experimental::io2d::antialias::default_antialias : _Cairo_antialias_t_to_antialias(cairo_get_antialias(_Context.get())))
 	, _Fill_rule(_Context.get() == nullptr ? ::std::experimental::io2d::fill_rule::winding : _Cairo_fill_rule_t_to_fill_rule(cairo_get_fill_rule(_Context.get())))
 	, _Line_cap(_Context.get() == nullptr ? ::std::experimental::io2d::line_cap::butt : _Cairo_line_cap_t_to_line_cap(cairo_get_line_cap(_Context.get())))
@@ -167,22 +524,38 @@ surface::surface(surface::native_handle_type nh, ::std::experimental::io2d::form
 	, _Compositing_operator(_Context.get() == nullptr ? ::std::experimental::io2d::compositing_operator::over : _Cairo_operator_t_to_compositing_operator(cairo_get_operator(_Context.get())))
 	, _Current_path()
 	, _Immediate_path()
+	, _Immediate_cairo_path()
 	, _Transform_matrix()
-	, _Font_resource(font_resource_factory())
+	, _Font_resource(nullptr)
+	, _Memory_resource(get_default_resource())
 	, _Saved_state() {
 	if (nh.csfce != nullptr) {
 		_Throw_if_failed_cairo_status_t(cairo_surface_status(_Surface.get()));
 		_Throw_if_failed_cairo_status_t(cairo_status(_Context.get()));
-		auto pf = path_factory{};
-		unique_ptr<cairo_path_t, decltype(&cairo_path_destroy)> upcpt{ cairo_copy_path(_Context.get()), &cairo_path_destroy };
-		if (upcpt.get() == nullptr) {
-			_Throw_if_failed_cairo_status_t(CAIRO_STATUS_NULL_POINTER);
+		// A path always leaves a current point, so without one there is nothing worth copying (a new context never has one).
+		if (cairo_has_current_point(_Context.get())) {
+			auto pf = path_factory{};
+			unique_ptr<cairo_path_t, decltype(&cairo_path_destroy)> upcpt{ cairo_copy_path(_Context.get()), &cairo_path_destroy };
+			if (upcpt.get() == nullptr) {
+				_Throw_if_failed_cairo_status_t(CAIRO_STATUS_NULL_POINTER);
+			}
+			pf.append(_Cairo_path_data_t_array_to_path_data_item_vector(*(upcpt.get())));
+			_Current_path = make_shared<experimental::io2d::path>(pf);
 		}
-		pf.append(_Cairo_path_data_t_array_to_path_data_item_vector(*(upcpt.get())));
-		_Current_path = make_shared<experimental::io2d::path>(pf);
 		_Ensure_state();
 	}
-	_Throw_if_failed_cairo_status_t(cairo_font_options_status(_Native_font_options.get()));
+	if (_Context.get() != nullptr) {
+		// A new context's source is almost always cairo's static opaque black, which needs no pattern of our own.
+		auto source = cairo_get_source(_Context.get());
+		double r, g, b, a;
+		if (cairo_pattern_get_rgba(source, &r, &g, &b, &a) == CAIRO_STATUS_SUCCESS) {
+			_Brush_color = rgba_color(r, g, b, a);
+		}
+		else {
+			_Brush = ::std::experimental::io2d::brush(cairo_pattern_reference(source));
+			_Brush_is_color = false;
+		}
+	}
 	_Throw_if_failed_cairo_status_t(cairo_pattern_status(_Brush.native_handle()));
 	if (_Context.get() != nullptr) {
 		cairo_set_miter_limit(_Context.get(), _Line_join_miter_miter_limit);
@@ -194,10 +567,11 @@ surface::surface(surface::native_handle_type nh, ::std::experimental::io2d::form
 	, _Device()
 	, _Surface(unique_ptr<cairo_surface_t, decltype(&cairo_surface_destroy)>(nh.csfce, &cairo_surface_destroy))
 	, _Context(unique_ptr<cairo_t, decltype(&cairo_destroy)>(((nh.csfce == nullptr) ? nullptr : cairo_create(nh.csfce)), &cairo_destroy))
-	, _Native_font_options(unique_ptr<cairo_font_options_t, decltype(&cairo_font_options_destroy)>(cairo_font_options_create(), &cairo_font_options_destroy))
 	, _Format(fmt)
 	, _Content(ctnt)
-	, _Brush(_Context.get() == nullptr ? cairo_pattern_create_rgba(0.0, 0.0, 0.0, 0.0) : cairo_pattern_reference(cairo_get_source(_Context.get())))
+	, _Brush(_Default_brush())
+	, _Brush_is_color(true)
+	, _Brush_color(rgba_color::transparent_black())
 	, _Fill_rule(::std::experimental::io2d::fill_rule::winding)
 	, _Line_cap(::std::experimental::io2d::line_cap::butt)
 	, _Line_join(::std::experimental::io2d::line_join::miter)
@@ -206,15 +580,12 @@ surface::surface(surface::native_handle_type nh, ::std::experimental::io2d::form
 	, _Compositing_operator(::std::experimental::io2d::compositing_operator::over)
 	, _Current_path()
 	, _Immediate_path()
+	, _Immediate_cairo_path()
 	, _Transform_matrix(matrix_2d::init_identity())
-	, _Font_resource(font_resource_factory())
+	, _Font_resource(nullptr)
+	, _Memory_resource(get_default_resource())
 	, _Saved_state() {
 	if (nh.csfce != nullptr) {
-		if (static_cast<bool>(ec)) {
-			_Surface = nullptr;
-			_Context = nullptr;
-			return;
-		}
 		ec = _Cairo_status_t_to_std_error_code(cairo_surface_status(_Surface.get()));
 		if (static_cast<bool>(ec)) {
 			_Surface = nullptr;
@@ -228,14 +599,22 @@ surface::surface(surface::native_handle_type nh, ::std::experimental::io2d::form
 			return;
 		}
 	}
-	ec = _Cairo_status_t_to_std_error_code(cairo_font_options_status(_Native_font_options.get()));
-	if (static_cast<bool>(ec)) {
-		_Surface = nullptr;
-		_Context = nullptr;
-		return;
+	try {
+		if (_Context.get() != nullptr) {
+			// A new context's source is almost always cairo's static opaque black, which needs no pattern of our own.
+			auto source = cairo_get_source(_Context.get());
+			double r, g, b, a;
+			if (cairo_pattern_get_rgba(source, &r, &g, &b, &a) == CAIRO_STATUS_SUCCESS) {
+				_Brush_color = rgba_color(r, g, b, a);
+			}
+			else {
+				_Brush = ::std::experimental::io2d::brush(cairo_pattern_reference(source));
+				_Brush_is_color = false;
+			}
+		}
 	}
-	ec = _Cairo_status_t_to_std_error_code(cairo_pattern_status(_Brush.native_handle()));
-	if (static_cast<bool>(ec)) {
+	catch (const bad_alloc&) {
+		ec = make_error_code(errc::not_enough_memory);
 		_Surface = nullptr;
 		_Context = nullptr;
 		return;
@@ -257,7 +636,6 @@ surface::surface(const surface& other, ::std::experimental::io2d::content ctnt,
 	, _Device()
 	, _Surface(unique_ptr<cairo_surface_t, decltype(&cairo_surface_destroy)>(cairo_surface_create_similar(other._Surface.get(), _Content_to_cairo_content_t(ctnt), width, height), &cairo_surface_destroy))
 	, _Context(unique_ptr<cairo_t, decltype(&cairo_destroy)>(cairo_create(_Surface.get()), &cairo_destroy))
-	, _Native_font_options(unique_ptr<cairo_font_options_t, decltype(&cairo_font_options_destroy)>(cairo_font_options_create(), &cairo_font_options_destroy))
 	, _Format(other._Format)
 	, _Content(ctnt)
 	, _Brush(other._Context.get() == nullptr ? cairo_pattern_create_rgba(0.0, 0.0, 0.0, 0.0) : cairo_pattern_reference(cairo_get_source(other._Context.get())))
@@ -269,12 +647,13 @@ surface::surface(const surface& other, ::std::experimental::io2d::content ctnt,
 	, _Compositing_operator(::std::experimental::io2d::compositing_operator::over)
 	, _Current_path()
 	, _Immediate_path()
+	, _Immediate_cairo_path()
 	, _Transform_matrix(matrix_2d::init_identity())
-	, _Font_resource(font_resource_factory())
+	, _Font_resource(nullptr)
+	, _Memory_resource(get_default_resource())
 	, _Saved_state() {
 	_Throw_if_failed_cairo_status_t(cairo_surface_status(_Surface.get()));
 	_Throw_if_failed_cairo_status_t(cairo_status(_Context.get()));
-	_Throw_if_failed_cairo_status_t(cairo_font_options_status(_Native_font_options.get()));
 	_Throw_if_failed_cairo_status_t(cairo_pattern_status(_Brush.native_handle()));
 	_Ensure_state();
 }
@@ -333,27 +712,32 @@ shared_ptr<experimental::io2d::device> experimental::io2d::v1::surface::device(e
 }
 
 void surface::mark_dirty() {
+	_Dirty_region._Add_everything();
 	cairo_surface_mark_dirty(_Surface.get());
 }
 
 void std::experimental::io2d::v1::surface::mark_dirty(::std::error_code & ec) noexcept {
+	_Dirty_region._Add_everything();
 	cairo_surface_mark_dirty(_Surface.get());
 	ec.clear();
 }
 
 void surface::mark_dirty(const rectangle& rect) {
-	_Dirty_rect = rect;
+	_Dirty_region._Add(_Device_box_covering(rect.x(), rect.y(), rect.x() + rect.width(), rect.y() + rect.height()));
 	cairo_surface_mark_dirty_rectangle(_Surface.get(), _Double_to_int(rect.x()), _Double_to_int(rect.y()), _Double_to_int(rect.width()), _Double_to_int(rect.height()));
 }
 
 void std::experimental::io2d::v1::surface::mark_dirty(const rectangle & rect, ::std::error_code & ec) noexcept {
-	_Dirty_rect = rect;
+	_Dirty_region._Add(_Device_box_covering(rect.x(), rect.y(), rect.x() + rect.width(), rect.y() + rect.height()));
 	cairo_surface_mark_dirty_rectangle(_Surface.get(), _Double_to_int(rect.x()), _Double_to_int(rect.y()), _Double_to_int(rect.width()), _Double_to_int(rect.height()));
 	ec.clear();
 }
 
 void surface::map(const ::std::function<void(mapped_surface&)>& action) {
 	if (action != nullptr) {
+		_Dirty_region._Add_everything();
+		// Mapping an image surface hands out its own pixels, so any snapshot of them (see surface_brush_factory) must take its copy first.
+		cairo_surface_flush(_Surface.get());
 		mapped_surface m({ cairo_surface_map_to_image(_Surface.get(), nullptr), nullptr }, { _Surface.get(), nullptr });
 		action(m);
 	}
@@ -361,6 +745,8 @@ void surface::map(const ::std::function<void(mapped_surface&)>& action) {
 
 void surface::map(const ::std::function<void(mapped_surface&, error_code&)>& action, error_code& ec) {
 	if (action != nullptr) {
+		_Dirty_region._Add_everything();
+		cairo_surface_flush(_Surface.get());
 		mapped_surface m({ cairo_surface_map_to_image(_Surface.get(), nullptr), nullptr }, { _Surface.get(), nullptr }, ec);
 		if (static_cast<bool>(ec)) {
 			return;
@@ -376,6 +762,8 @@ void surface::map(const ::std::function<void(mapped_surface&, error_code&)>& act
 void surface::map(const ::std::function<void(mapped_surface&)>& action, const rectangle& extents) {
 	if (action != nullptr) {
 		cairo_rectangle_int_t cextents{ _Double_to_int(extents.x()), _Double_to_int(extents.y()), _Double_to_int(extents.width()), _Double_to_int(extents.height()) };
+		_Dirty_region._Add({ cextents.x, cextents.y, cextents.x + cextents.width, cextents.y + cextents.height });
+		cairo_surface_flush(_Surface.get());
 		mapped_surface m({ cairo_surface_map_to_image(_Surface.get(), &cextents), nullptr }, { _Surface.get(), nullptr });
 		action(m);
 	}
@@ -384,6 +772,8 @@ void surface::map(const ::std::function<void(mapped_surface&)>& action, const re
 void surface::map(const ::std::function<void(mapped_surface&, error_code&)>& action, const rectangle& extents, error_code& ec) {
 	if (action != nullptr) {
 		cairo_rectangle_int_t cextents{ _Double_to_int(extents.x()), _Double_to_int(extents.y()), _Double_to_int(extents.width()), _Double_to_int(extents.height()) };
+		_Dirty_region._Add({ cextents.x, cextents.y, cextents.x + cextents.width, cextents.y + cextents.height });
+		cairo_surface_flush(_Surface.get());
 		mapped_surface m({ cairo_surface_map_to_image(_Surface.get(), &cextents), nullptr }, { _Surface.get(), nullptr }, ec);
 		if (static_cast<bool>(ec)) {
 			return;
@@ -397,21 +787,31 @@ void surface::map(const ::std::function<void(mapped_surface&, error_code&)>& act
 }
 
 void surface::save() {
+	// cairo_save copies the native state, so it has to be current for restore to leave nothing but the path to flush.
+	_Flush_state();
 	cairo_save(_Context.get());
-	_Saved_state.push(make_tuple(_Brush, _Antialias, _Dashes, _Fill_rule, _Line_cap, _Line_join, _Line_width, _Miter_limit, _Compositing_operator, _Current_path, _Immediate_path, _Transform_matrix, _Font_resource));
+	_Saved_state.push(_Saved_state_item{ _Brush, _Brush_is_color, _Brush_color, _Antialias, _Dashes, _Fill_rule, _Line_cap, _Line_join, _Line_width, _Miter_limit, _Compositing_operator, _Current_path, _Immediate_path._Make_save_point(), _Transform_matrix, _Font_resource, _Bound_pattern });
+	_Set_active_save_point();
 }
 
 void surface::save(error_code& ec) noexcept {
+	_Flush_state();
 	cairo_save(_Context.get());
 	try {
-		_Saved_state.push(make_tuple(_Brush, _Antialias, _Dashes, _Fill_rule, _Line_cap, _Line_join, _Line_width, _Miter_limit, _Compositing_operator, _Current_path, _Immediate_path, _Transform_matrix, _Font_resource));
+		_Saved_state.push(_Saved_state_item{ _Brush, _Brush_is_color, _Brush_color, _Antialias, _Dashes, _Fill_rule, _Line_cap, _Line_join, _Line_width, _Miter_limit, _Compositing_operator, _Current_path, _Immediate_path._Make_save_point(), _Transform_matrix, _Font_resource, _Bound_pattern });
 	}
 	catch (const bad_alloc&) {
+		cairo_restore(_Context.get());
 		ec = make_error_code(errc::not_enough_memory);
+		return;
 	}
 	catch (const length_error&) {
+		cairo_restore(_Context.get());
 		ec = make_error_code(errc::not_enough_memory);
+		return;
 	}
+	_Set_active_save_point();
+	ec.clear();
 }
 
 void surface::restore() {
@@ -421,23 +821,31 @@ void surface::restore() {
 	cairo_restore(_Context.get());
 	{
 		auto& t = _Saved_state.top();
-		_Brush = get<0>(t);
-		_Antialias = get<1>(t);
-		_Dashes = move(get<2>(t));
-		_Fill_rule = get<3>(t);
-		_Line_cap = get<4>(t);
-		_Line_join = get<5>(t);
-		_Line_width = get<6>(t);
-		_Miter_limit = get<7>(t);
-		_Compositing_operator = get<8>(t);
-		_Current_path = move(get<9>(t));
-		_Immediate_path = move(get<10>(t));
-		_Transform_matrix = get<11>(t);
-		_Font_resource = move(get<12>(t));
+		_Brush = t._Brush;
+		_Brush_is_color = t._Brush_is_color;
+		_Brush_color = t._Brush_color;
+		_Antialias = t._Antialias;
+		_Dashes = move(t._Dashes);
+		_Fill_rule = t._Fill_rule;
+		_Line_cap = t._Line_cap;
+		_Line_join = t._Line_join;
+		_Line_width = t._Line_width;
+		_Miter_limit = t._Miter_limit;
+		_Compositing_operator = t._Compositing_operator;
+		_Current_path = move(t._Current_path);
+		_Immediate_path._Restore_save_point(t._Immediate_path);
+		_Transform_matrix = t._Transform_matrix;
+		_Font_resource = move(t._Font_resource);
+		_Bound_pattern = t._Bound_pattern;
 	}
 	_Saved_state.pop();
-
-	_Ensure_state();
+	// Keeping the container's memory is what makes the next save() allocation free, but memory from any other resource may be released behind the surface's back (e.g. an arena reset at the end of a frame).
+	if (_Saved_state.empty() && *_Memory_resource != *new_delete_resource()) {
+		_Reset_saved_state();
+	}
+	_Set_active_save_point();
+	// cairo_restore has put back the native state that save flushed; only the path is not part of it.
+	_Dirty_state = _State_current_path;
 }
 
 void surface::restore(error_code& ec) noexcept {
@@ -448,114 +856,177 @@ void surface::restore(error_code& ec) noexcept {
 	cairo_restore(_Context.get());
 	{
 		auto& t = _Saved_state.top();
-		_Brush = get<0>(t);
-		_Antialias = get<1>(t);
-		_Dashes = move(get<2>(t));
-		_Fill_rule = get<3>(t);
-		_Line_cap = get<4>(t);
-		_Line_join = get<5>(t);
-		_Line_width = get<6>(t);
-		_Miter_limit = get<7>(t);
-		_Compositing_operator = get<8>(t);
-		_Current_path = move(get<9>(t));
-		_Immediate_path = move(get<10>(t));
-		_Transform_matrix = get<11>(t);
-		_Font_resource = move(get<12>(t));
+		_Brush = t._Brush;
+		_Brush_is_color = t._Brush_is_color;
+		_Brush_color = t._Brush_color;
+		_Antialias = t._Antialias;
+		_Dashes = move(t._Dashes);
+		_Fill_rule = t._Fill_rule;
+		_Line_cap = t._Line_cap;
+		_Line_join = t._Line_join;
+		_Line_width = t._Line_width;
+		_Miter_limit = t._Miter_limit;
+		_Compositing_operator = t._Compositing_operator;
+		_Current_path = move(t._Current_path);
+		_Immediate_path._Restore_save_point(t._Immediate_path);
+		_Transform_matrix = t._Transform_matrix;
+		_Font_resource = move(t._Font_resource);
+		_Bound_pattern = t._Bound_pattern;
 	}
 	_Saved_state.pop();
+	// Keeping the container's memory is what makes the next save() allocation free, but memory from any other resource may be released behind the surface's back (e.g. an arena reset at the end of a frame).
+	if (_Saved_state.empty() && *_Memory_resource != *new_delete_resource()) {
+		_Reset_saved_state();
+	}
+	_Set_active_save_point();
+	_Dirty_state = _State_current_path;
+	ec.clear();
+}
 
-	_Ensure_state(ec);
-	if (static_cast<bool>(ec)) {
+void surface::_Reset_saved_state() noexcept {
+	assert(_Saved_state.empty());
+	// Assignment keeps a container's allocator, so the only way to switch to another memory resource is to construct the stack again.
+	_Saved_state.~_Saved_state_type();
+	new (&_Saved_state) _Saved_state_type(_Saved_state_container(polymorphic_allocator<_Saved_state_item>(_Memory_resource)));
+}
+
+void surface::_Set_active_save_point() noexcept {
+	_Immediate_path._Active_save_point = (_Saved_state.empty() || _Saved_state.top()._Immediate_path._Items_moved) ? nullptr : &_Saved_state.top()._Immediate_path;
+}
+
+void surface::memory_resource(experimental::io2d::memory_resource* mr) {
+	if (!_Saved_state.empty()) {
+		throw system_error(make_error_code(errc::operation_not_permitted));
+	}
+	_Memory_resource = mr;
+	_Reset_saved_state();
+}
+
+void surface::memory_resource(experimental::io2d::memory_resource* mr, error_code& ec) noexcept {
+	if (!_Saved_state.empty()) {
+		ec = make_error_code(errc::operation_not_permitted);
 		return;
 	}
+	_Memory_resource = mr;
+	_Reset_saved_state();
 	ec.clear();
 }
 
 void surface::brush(nullopt_t) noexcept {
 	cairo_set_source_rgba(_Context.get(), 0.0, 0.0, 0.0, 0.0);
 	_Brush = ::std::experimental::io2d::brush(cairo_pattern_reference(cairo_get_source(_Context.get())));
+	_Brush_is_color = false;
+	_Bound_pattern = _Brush.native_handle();
 }
 
 void surface::brush(const ::std::experimental::io2d::brush& source) {
 	_Brush = source;
+	_Brush_is_color = false;
 }
 
 void surface::brush(const::std::experimental::io2d::brush & source, ::std::error_code & ec) noexcept {
 	// This overload exists for backends where brushes are device-specific and will require resource allocation, etc., when using them on a different device for the first time.
 	_Brush = source;
+	_Brush_is_color = false;
 	ec.clear();
 }
 
 void surface::antialias(::std::experimental::io2d::antialias a) noexcept {
-	_Antialias = a;
-	cairo_set_antialias(_Context.get(), _Antialias_to_cairo_antialias_t(a));
+	if (_Antialias != a) {
+		_Antialias = a;
+		_Dirty_state |= _State_antialias;
+	}
 }
 
 void surface::dashes(nullopt_t) noexcept {
-	_Dashes = ::std::experimental::io2d::dashes(vector<double>(), 0.0);
-	cairo_set_dash(_Context.get(), nullptr, 0, 0.0);
+	if (_Dashes != nullptr) {
+		_Dashes.reset();
+		_Dirty_state |= _State_dashes;
+	}
 }
 
 void surface::dashes(const ::std::experimental::io2d::dashes& d) {
-	_Dashes = d;
-	cairo_set_dash(_Context.get(), get<0>(d).data(), _Container_size_to_int(get<0>(d)), get<1>(d));
-	if (cairo_status(_Context.get()) == CAIRO_STATUS_INVALID_DASH) {
+	if (!_Dashes_are_valid(d)) {
 		_Throw_if_failed_cairo_status_t(CAIRO_STATUS_INVALID_DASH);
 	}
+	if (get<0>(d).empty()) {
+		dashes(nullopt);
+		return;
+	}
+	if (_Dashes == nullptr || *_Dashes != d) {
+		_Dashes = make_shared<const ::std::experimental::io2d::dashes>(d);
+		_Dirty_state |= _State_dashes;
+	}
 }
 
 void surface::dashes(const ::std::experimental::io2d::dashes& d, error_code& ec) noexcept {
-	try {
-		_Dashes = d;
-	}
-	catch (const bad_alloc&) {
-		ec = make_error_code(errc::not_enough_memory);
+	if (!_Dashes_are_valid(d)) {
+		ec = make_error_code(io2d_error::invalid_dash);
 		return;
 	}
-	cairo_set_dash(_Context.get(), get<0>(d).data(), _Container_size_to_int(get<0>(d)), get<1>(d));
-	if (cairo_status(_Context.get()) == CAIRO_STATUS_INVALID_DASH) {
-		ec = make_error_code(io2d_error::invalid_dash);
+	if (get<0>(d).empty()) {
+		dashes(nullopt);
+		ec.clear();
 		return;
 	}
+	if (_Dashes == nullptr || *_Dashes != d) {
+		try {
+			_Dashes = make_shared<const ::std::experimental::io2d::dashes>(d);
+		}
+		catch (const bad_alloc&) {
+			ec = make_error_code(errc::not_enough_memory);
+			return;
+		}
+		_Dirty_state |= _State_dashes;
+	}
 	ec.clear();
 }
 
 void surface::fill_rule(::std::experimental::io2d::fill_rule fr) noexcept {
-	_Fill_rule = fr;
-	cairo_set_fill_rule(_Context.get(), _Fill_rule_to_cairo_fill_rule_t(fr));
+	if (_Fill_rule != fr) {
+		_Fill_rule = fr;
+		_Dirty_state |= _State_fill_rule;
+	}
 }
 
 void surface::line_cap(::std::experimental::io2d::line_cap lc) noexcept {
-	_Line_cap = lc;
-	cairo_set_line_cap(_Context.get(), _Line_cap_to_cairo_line_cap_t(lc));
+	if (_Line_cap != lc) {
+		_Line_cap = lc;
+		_Dirty_state |= _State_line_cap;
+	}
 }
 
 void surface::line_join(::std::experimental::io2d::line_join lj) noexcept {
-	_Line_join = lj;
-	cairo_set_line_join(_Context.get(), _Line_join_to_cairo_line_join_t(lj));
-	if (lj == ::std::experimental::io2d::line_join::miter_or_bevel) {
-		cairo_set_miter_limit(_Context.get(), _Miter_limit);
-	}
-	if (lj == ::std::experimental::io2d::line_join::miter) {
-		cairo_set_miter_limit(_Context.get(), _Line_join_miter_miter_limit);
+	if (_Line_join != lj) {
+		_Line_join = lj;
+		_Dirty_state |= _State_line_join;
 	}
 }
 
 void surface::line_width(double width) noexcept {
-	_Line_width = max(0.0, width);
-	cairo_set_line_width(_Context.get(), _Line_width);
+	auto w = max(0.0, width);
+	if (_Line_width != w) {
+		_Line_width = w;
+		_Dirty_state |= _State_line_width;
+	}
 }
 
 void surface::miter_limit(double limit) noexcept {
-	_Miter_limit = std::max(limit, 1.0);
-	if (_Line_join == ::std::experimental::io2d::line_join::miter_or_bevel) {
-		cairo_set_miter_limit(_Context.get(), std::min(std::max(limit, 1.0), _Line_join_miter_miter_limit));
+	auto l = max(limit, 1.0);
+	if (_Miter_limit != l) {
+		_Miter_limit = l;
+		// The native miter limit only follows _Miter_limit while the join is miter_or_bevel.
+		if (_Line_join == ::std::experimental::io2d::line_join::miter_or_bevel) {
+			_Dirty_state |= _State_line_join;
+		}
 	}
 }
 
 void surface::compositing_operator(::std::experimental::io2d::compositing_operator co) noexcept {
-	_Compositing_operator = co;
-	cairo_set_operator(_Context.get(), _Compositing_operator_to_cairo_operator_t(co));
+	if (_Compositing_operator != co) {
+		_Compositing_operator = co;
+		_Dirty_state |= _State_compositing_operator;
+	}
 }
 
 //void surface::clip(experimental::nullopt_t) noexcept {
@@ -563,22 +1034,22 @@ void surface::compositing_operator(::std::experimental::io2d::compositing_operat
 //}
 
 void surface::clip(const experimental::io2d::path& p) {
-	auto currPath = _Current_path;
-	path(p);
+	_Flush_state();
+	p._Set_on(_Context.get());
 	cairo_clip(_Context.get());
-	path(currPath);
+	_Restore_current_path();
 }
 
 void surface::clip_immediate() {
-	auto currPath = _Current_path;
-	path(experimental::io2d::path(_Immediate_path));
+	_Flush_state();
+	_Set_immediate_path();
 	cairo_clip(_Context.get());
-	path(currPath);
+	_Restore_current_path();
 }
 
 void surface::path(nullopt_t) noexcept {
 	_Current_path.reset();
-	cairo_new_path(_Context.get());
+	_Dirty_state |= _State_current_path;
 }
 
 void surface::path(const shared_ptr<experimental::io2d::path>& p) {
@@ -586,7 +1057,7 @@ void surface::path(const shared_ptr<experimental::io2d::path>& p) {
 		path(*p);
 	}
 	else {
-		cairo_new_path(_Context.get());
+		path(nullopt);
 	}
 }
 
@@ -598,15 +1069,14 @@ void surface::path(const shared_ptr<experimental::io2d::path>& p, error_code& ec
 		}
 	}
 	else {
-		cairo_new_path(_Context.get());
+		path(nullopt);
 	}
 	ec.clear();
 }
 
 void surface::path(const ::std::experimental::io2d::path& p) {
 	_Current_path = make_shared<experimental::io2d::path>(p);
-	cairo_new_path(_Context.get());
-	cairo_append_path(_Context.get(), _Current_path->native_handle());
+	_Dirty_state |= _State_current_path;
 }
 
 void surface::path(const experimental::io2d::path& p, error_code& ec) noexcept {
@@ -617,8 +1087,7 @@ void surface::path(const experimental::io2d::path& p, error_code& ec) noexcept {
 		ec = make_error_code(errc::not_enough_memory);
 		return;
 	}
-	cairo_new_path(_Context.get());
-	cairo_append_path(_Context.get(), _Current_path->native_handle());
+	_Dirty_state |= _State_current_path;
 	ec.clear();
 }
 
@@ -626,27 +1095,46 @@ path_factory& surface::immediate() noexcept {
 	return _Immediate_path;
 }
 
+void surface::_Set_immediate_path() const {
+	_Immediate_cairo_path.convert(_Immediate_path);
+	auto cairoPath = _Immediate_cairo_path.native_path();
+	cairo_new_path(_Context.get());
+	cairo_append_path(_Context.get(), &cairoPath);
+}
+
+void surface::_Set_immediate_path(error_code& ec) const noexcept {
+	_Immediate_cairo_path.convert(_Immediate_path, ec);
+	if (static_cast<bool>(ec)) {
+		return;
+	}
+	auto cairoPath = _Immediate_cairo_path.native_path();
+	cairo_new_path(_Context.get());
+	cairo_append_path(_Context.get(), &cairoPath);
+	ec.clear();
+}
+
+void surface::_Restore_current_path() const noexcept {
+	_Dirty_state |= _State_current_path;
+}
+
 void surface::clear() {
 	cairo_save(_Context.get());
 	cairo_set_operator(_Context.get(), CAIRO_OPERATOR_CLEAR);
 	cairo_set_source_rgba(_Context.get(), 1.0, 1.0, 1.0, 1.0);
+	_Damage_clip();
 	cairo_paint(_Context.get());
 	cairo_restore(_Context.get());
 }
 
 void surface::paint() {
-	cairo_pattern_set_extend(_Brush.native_handle(), _Extend_to_cairo_extend_t(_Brush.extend()));
-	cairo_pattern_set_filter(_Brush.native_handle(), _Filter_to_cairo_filter_t(_Brush.filter()));
-	cairo_matrix_t cPttnMatrix;
-	cairo_matrix_init(&cPttnMatrix, _Brush.matrix().m00(), _Brush.matrix().m01(), _Brush.matrix().m10(), _Brush.matrix().m11(), _Brush.matrix().m20(), _Brush.matrix().m21());
-	cairo_pattern_set_matrix(_Brush.native_handle(), &cPttnMatrix);
-	cairo_set_source(_Context.get(), _Brush.native_handle());
+	_Flush_state();
+	_Bind_brush();
+	_Damage_clip();
 	cairo_paint(_Context.get());
 }
 
 void surface::paint(const rgba_color& c) {
-	solid_color_brush_factory factory(c);
-	brush(experimental::io2d::brush(factory));
+	_Brush_color_to(c);
 	paint();
 }
 
@@ -656,29 +1144,203 @@ void surface::paint(const ::std::experimental::io2d::brush& b) {
 }
 
 void surface::paint(const surface& s, const matrix_2d& m, extend e, filter f) {
-	cairo_set_source_surface(_Context.get(), s.native_handle().csfce, 0.0, 0.0);
+	_Flush_state();
+	cairo_set_source_surface(_Context.get(), s._Surface.get(), 0.0, 0.0);
+	_Bound_pattern = nullptr;
 	auto pat = cairo_get_source(_Context.get());
 	cairo_pattern_set_extend(pat, _Extend_to_cairo_extend_t(e));
 	cairo_pattern_set_filter(pat, _Filter_to_cairo_filter_t(f));
 	cairo_matrix_t cmat{ m.m00(), m.m01(), m.m10(), m.m11(), m.m20(), m.m21() };
 	cairo_pattern_set_matrix(pat, &cmat);
+	_Damage_clip();
 	cairo_paint(_Context.get());
-	cairo_set_source_rgba(_Context.get(), 0.0, 0.0, 0.0, 0.0);
+}
+
+void surface::blit(const surface& s, const rectangle& srcRect, const vector_2d& dstPoint, ::std::experimental::io2d::compositing_operator co) {
+	error_code ec;
+	blit(s, srcRect, dstPoint, ec, co);
+	if (static_cast<bool>(ec)) {
+		throw system_error(ec);
+	}
+}
+
+void surface::blit(const surface& s, const rectangle& srcRect, const vector_2d& dstPoint, error_code& ec, ::std::experimental::io2d::compositing_operator co) noexcept {
+	_Flush_state();
+	auto context = _Context.get();
+	// Not s.native_handle(), which would flush s's state and path for nothing: only its pixels are read, and pixman reads them directly.
+	auto sfce = s._Surface.get();
+	cairo_surface_flush(sfce);
+	auto sx = srcRect.x();
+	auto sy = srcRect.y();
+	auto w = srcRect.width();
+	auto h = srcRect.height();
+	auto dx = dstPoint.x();
+	auto dy = dstPoint.y();
+	if (w <= 0.0 || h <= 0.0) {
+		ec.clear();
+		return;
+	}
+	if (_Track_damage) {
+		_Damage_clipped_user_box(dx, dy, dx + w, dy + h);
+	}
+	auto cairoOp = _Compositing_operator_to_cairo_operator_t(co);
+	// Whole pixels at a whole pixel offset are copied by pixman directly; anything cairo_blit_surface turns down is painted with the surface, clipped to the rectangle, as usual. Either way nothing outside the rectangle changes, whatever the operator.
+	if (!(_Is_whole_pixel(sx) && _Is_whole_pixel(sy) && _Is_whole_pixel(w) && _Is_whole_pixel(h) && _Is_whole_pixel(dx) && _Is_whole_pixel(dy) &&
+		cairo_blit_surface(context, sfce, cairoOp, static_cast<int>(sx), static_cast<int>(sy), static_cast<int>(w), static_cast<int>(h), static_cast<int>(dx), static_cast<int>(dy)))) {
+		cairo_save(context);
+		cairo_new_path(context);
+		cairo_rectangle(context, dx, dy, w, h);
+		cairo_clip(context);
+		cairo_set_operator(context, cairoOp);
+		cairo_set_source_surface(context, sfce, dx - sx, dy - sy);
+		cairo_paint(context);
+		cairo_restore(context);
+		_Restore_current_path();
+	}
+	auto status = cairo_status(context);
+	if (status != CAIRO_STATUS_SUCCESS) {
+		ec = _Cairo_status_t_to_std_error_code(status);
+		return;
+	}
+	ec.clear();
+}
+
+void surface::draw_sprites(const surface& atlas, const vector<rectangle>& srcRects, const vector<vector_2d>& dstPoints, const vector<double>& alphas) {
+	error_code ec;
+	draw_sprites(atlas, srcRects, dstPoints, ec, alphas);
+	if (static_cast<bool>(ec)) {
+		throw system_error(ec);
+	}
+}
+
+void surface::draw_sprites(const surface& atlas, const vector<rectangle>& srcRects, const vector<vector_2d>& dstPoints, error_code& ec, const vector<double>& alphas) noexcept {
+	if (dstPoints.size() != srcRects.size()) {
+		ec = make_error_code(errc::invalid_argument);
+		return;
+	}
+	_Draw_sprites(atlas, srcRects, dstPoints.data(), nullptr, alphas, ec);
+}
+
+void surface::draw_sprites(const surface& atlas, const vector<rectangle>& srcRects, const vector<matrix_2d>& matrices, const vector<double>& alphas) {
+	error_code ec;
+	draw_sprites(atlas, srcRects, matrices, ec, alphas);
+	if (static_cast<bool>(ec)) {
+		throw system_error(ec);
+	}
+}
+
+void surface::draw_sprites(const surface& atlas, const vector<rectangle>& srcRects, const vector<matrix_2d>& matrices, error_code& ec, const vector<double>& alphas) noexcept {
+	if (matrices.size() != srcRects.size()) {
+		ec = make_error_code(errc::invalid_argument);
+		return;
+	}
+	_Draw_sprites(atlas, srcRects, nullptr, matrices.data(), alphas, ec);
+}
+
+void surface::_Draw_sprites(const surface& atlas, const vector<rectangle>& srcRects, const vector_2d* dstPoints, const matrix_2d* matrices, const vector<double>& alphas, error_code& ec) noexcept {
+	if (!alphas.empty() && alphas.size() != srcRects.size()) {
+		ec = make_error_code(errc::invalid_argument);
+		return;
+	}
+	_Flush_state();
+	auto context = _Context.get();
+	// As in blit, only the atlas's pixels are read.
+	auto sfce = atlas._Surface.get();
+	cairo_surface_flush(sfce);
+	auto cairoOp = _Compositing_operator_to_cairo_operator_t(_Compositing_operator);
+	// Consecutive sprites at whole pixel offsets go to cairo_blit_surface_array together, a run at a time so that nothing is allocated; the rest, and any run it turns down, are painted one by one from a single pattern for the atlas, each clipped to its own area. Either way they are drawn in order, since later sprites may cover earlier ones.
+	const int runCapacity = 256;
+	cairo_blit_t run[runCapacity];
+	int runCount = 0;
+	unique_ptr<cairo_pattern_t, decltype(&cairo_pattern_destroy)> pat(nullptr, &cairo_pattern_destroy);
+	auto paintSprite = [&](double sx, double sy, double w, double h, const cairo_matrix_t& m, double alpha) {
+		cairo_matrix_t inverse = m;
+		if (cairo_matrix_invert(&inverse) != CAIRO_STATUS_SUCCESS) {
+			// A degenerate matrix leaves the sprite without any area.
+			return;
+		}
+		if (pat == nullptr) {
+			pat.reset(cairo_pattern_create_for_surface(sfce));
+		}
+		cairo_matrix_t pm;
+		cairo_matrix_init_translate(&pm, sx, sy);
+		cairo_pattern_set_matrix(pat.get(), &pm);
+		cairo_save(context);
+		cairo_transform(context, &m);
+		cairo_new_path(context);
+		cairo_rectangle(context, 0.0, 0.0, w, h);
+		cairo_clip(context);
+		cairo_set_source(context, pat.get());
+		cairo_paint_with_alpha(context, alpha);
+		cairo_restore(context);
+		_Restore_current_path();
+	};
+	auto flushRun = [&]() {
+		if (runCount != 0 && !cairo_blit_surface_array(context, sfce, cairoOp, run, runCount)) {
+			for (int i = 0; i < runCount; i++) {
+				cairo_matrix_t m;
+				cairo_matrix_init_translate(&m, run[i].dst_x, run[i].dst_y);
+				paintSprite(run[i].src_x, run[i].src_y, run[i].width, run[i].height, m, run[i].alpha);
+			}
+		}
+		runCount = 0;
+	};
+	for (size_t i = 0; i < srcRects.size(); i++) {
+		const auto& r = srcRects[i];
+		auto sx = r.x();
+		auto sy = r.y();
+		auto w = r.width();
+		auto h = r.height();
+		auto alpha = alphas.empty() ? 1.0 : alphas[i];
+		if (w <= 0.0 || h <= 0.0) {
+			continue;
+		}
+		cairo_matrix_t m;
+		if (dstPoints != nullptr) {
+			cairo_matrix_init_translate(&m, dstPoints[i].x(), dstPoints[i].y());
+		}
+		else {
+			const auto& mm = matrices[i];
+			m = { mm.m00(), mm.m01(), mm.m10(), mm.m11(), mm.m20(), mm.m21() };
+		}
+		if (_Track_damage) {
+			double xs[4] = { 0.0, w, w, 0.0 };
+			double ys[4] = { 0.0, 0.0, h, h };
+			for (int j = 0; j < 4; j++) {
+				cairo_matrix_transform_point(&m, &xs[j], &ys[j]);
+			}
+			_Damage_clipped_user_box(*min_element(xs, xs + 4), *min_element(ys, ys + 4), *max_element(xs, xs + 4), *max_element(ys, ys + 4));
+		}
+		if (m.xx == 1.0 && m.yx == 0.0 && m.xy == 0.0 && m.yy == 1.0 && _Is_whole_pixel(m.x0) && _Is_whole_pixel(m.y0) &&
+			_Is_whole_pixel(sx) && _Is_whole_pixel(sy) && _Is_whole_pixel(w) && _Is_whole_pixel(h)) {
+			run[runCount++] = { static_cast<int>(sx), static_cast<int>(sy), static_cast<int>(w), static_cast<int>(h), static_cast<int>(m.x0), static_cast<int>(m.y0), alpha };
+			if (runCount == runCapacity) {
+				flushRun();
+			}
+		}
+		else {
+			flushRun();
+			paintSprite(sx, sy, w, h, m, alpha);
+		}
+	}
+	flushRun();
+	auto status = cairo_status(context);
+	if (status != CAIRO_STATUS_SUCCESS) {
+		ec = _Cairo_status_t_to_std_error_code(status);
+		return;
+	}
+	ec.clear();
 }
 
 void surface::paint(double alpha) {
-	cairo_pattern_set_extend(_Brush.native_handle(), _Extend_to_cairo_extend_t(_Brush.extend()));
-	cairo_pattern_set_filter(_Brush.native_handle(), _Filter_to_cairo_filter_t(_Brush.filter()));
-	cairo_matrix_t cPttnMatrix;
-	cairo_matrix_init(&cPttnMatrix, _Brush.matrix().m00(), _Brush.matrix().m01(), _Brush.matrix().m10(), _Brush.matrix().m11(), _Brush.matrix().m20(), _Brush.matrix().m21());
-	cairo_pattern_set_matrix(_Brush.native_handle(), &cPttnMatrix);
-	cairo_set_source(_Context.get(), _Brush.native_handle());
+	_Flush_state();
+	_Bind_brush();
+	_Damage_clip();
 	cairo_paint_with_alpha(_Context.get(), alpha);
 }
 
 void surface::paint(const rgba_color& c, double alpha) {
-	solid_color_brush_factory factory(c);
-	brush(experimental::io2d::brush(factory));
+	_Brush_color_to(c);
 	paint(alpha);
 }
 
@@ -688,29 +1350,28 @@ void surface::paint(const ::std::experimental::io2d::brush& b, double alpha) {
 }
 
 void surface::paint(const surface& s, double alpha, const matrix_2d& m, extend e, filter f) {
-	cairo_set_source_surface(_Context.get(), s.native_handle().csfce, 0.0, 0.0);
+	_Flush_state();
+	cairo_set_source_surface(_Context.get(), s._Surface.get(), 0.0, 0.0);
+	_Bound_pattern = nullptr;
 	auto pat = cairo_get_source(_Context.get());
 	cairo_pattern_set_extend(pat, _Extend_to_cairo_extend_t(e));
 	cairo_pattern_set_filter(pat, _Filter_to_cairo_filter_t(f));
 	cairo_matrix_t cmat{ m.m00(), m.m01(), m.m10(), m.m11(), m.m20(), m.m21() };
 	cairo_pattern_set_matrix(pat, &cmat);
+	_Damage_clip();
 	cairo_paint_with_alpha(_Context.get(), alpha);
-	cairo_set_source_rgba(_Context.get(), 0.0, 0.0, 0.0, 0.0);
 }
 
 void surface::fill() {
-	cairo_pattern_set_extend(_Brush.native_handle(), _Extend_to_cairo_extend_t(_Brush.extend()));
-	cairo_pattern_set_filter(_Brush.native_handle(), _Filter_to_cairo_filter_t(_Brush.filter()));
-	cairo_matrix_t cPttnMatrix;
-	cairo_matrix_init(&cPttnMatrix, _Brush.matrix().m00(), _Brush.matrix().m01(), _Brush.matrix().m10(), _Brush.matrix().m11(), _Brush.matrix().m20(), _Brush.matrix().m21());
-	cairo_pattern_set_matrix(_Brush.native_handle(), &cPttnMatrix);
-	cairo_set_source(_Context.get(), _Brush.native_handle());
+	_Flush_state();
+	_Flush_current_path();
+	_Bind_brush();
+	_Damage_fill();
 	cairo_fill_preserve(_Context.get());
 }
 
 void surface::fill(const rgba_color& c) {
-	solid_color_brush_factory factory(c);
-	brush(experimental::io2d::brush(factory));
+	_Brush_color_to(c);
 	fill();
 }
 
@@ -720,32 +1381,118 @@ void surface::fill(const ::std::experimental::io2d::brush& b) {
 }
 
 void surface::fill(const surface& s, const matrix_2d& m, extend e, filter f) {
-	cairo_set_source_surface(_Context.get(), s.native_handle().csfce, 0.0, 0.0);
+	_Flush_state();
+	_Flush_current_path();
+	cairo_set_source_surface(_Context.get(), s._Surface.get(), 0.0, 0.0);
+	_Bound_pattern = nullptr;
 	auto pat = cairo_get_source(_Context.get());
 	cairo_pattern_set_extend(pat, _Extend_to_cairo_extend_t(e));
 	cairo_pattern_set_filter(pat, _Filter_to_cairo_filter_t(f));
 	cairo_matrix_t cmat{ m.m00(), m.m01(), m.m10(), m.m11(), m.m20(), m.m21() };
 	cairo_pattern_set_matrix(pat, &cmat);
+	_Damage_fill();
 	cairo_fill_preserve(_Context.get());
-	cairo_set_source_rgba(_Context.get(), 0.0, 0.0, 0.0, 0.0);
+}
+
+void surface::fill_rectangles(const vector<rectangle>& rects, const rgba_color& c) {
+	error_code ec;
+	fill_rectangles(rects, c, ec);
+	if (static_cast<bool>(ec)) {
+		throw system_error(ec);
+	}
+}
+
+void surface::fill_rectangles(const vector<rectangle>& rects, const rgba_color& c, error_code& ec) noexcept {
+	_Fill_rectangles(rects, &c, 0, ec);
+}
+
+void surface::fill_rectangles(const vector<rectangle>& rects, const vector<rgba_color>& colors) {
+	error_code ec;
+	fill_rectangles(rects, colors, ec);
+	if (static_cast<bool>(ec)) {
+		throw system_error(ec);
+	}
+}
+
+void surface::fill_rectangles(const vector<rectangle>& rects, const vector<rgba_color>& colors, error_code& ec) noexcept {
+	if (colors.size() != rects.size()) {
+		ec = make_error_code(errc::invalid_argument);
+		return;
+	}
+	_Fill_rectangles(rects, colors.data(), 1, ec);
+}
+
+void surface::_Fill_rectangles(const vector<rectangle>& rects, const rgba_color* colors, size_t colorStep, error_code& ec) noexcept {
+	_Flush_state();
+	auto context = _Context.get();
+	auto unbounded = _Is_unbounded(_Compositing_operator);
+	if (_Track_damage && unbounded) {
+		_Damage_clip();
+	}
+	// Runs of whole pixel rectangles go to cairo_fill_rectangle_array, a run at a time from the stack, which stores opaque colors straight into the surface and makes one source per run for translucent ones; the rest, and any run it turns down, are filled one by one with cairo's own rectangle path rather than through an io2d path. cairo sees that a lone rectangle is rectilinear and fills it as a box through its rectangular scan converter, not the general polygon one. They are not gathered into one path per color, since one fill covers where they overlap once, where filling them one by one covers it again.
+	const int runCapacity = 256;
+	cairo_color_rectangle_t run[runCapacity];
+	int runCount = 0;
+	auto fillRectangle = [&](double x, double y, double w, double h, double r, double g, double b, double a) {
+		cairo_set_source_rgba(context, r, g, b, a);
+		_Bound_pattern = nullptr;
+		cairo_new_path(context);
+		cairo_rectangle(context, x, y, w, h);
+		cairo_fill(context);
+		_Restore_current_path();
+	};
+	auto flushRun = [&]() {
+		if (runCount != 0 && !cairo_fill_rectangle_array(context, run, runCount)) {
+			for (int i = 0; i < runCount; i++) {
+				fillRectangle(run[i].x, run[i].y, run[i].width, run[i].height, run[i].red, run[i].green, run[i].blue, run[i].alpha);
+			}
+		}
+		runCount = 0;
+	};
+	for (size_t i = 0; i < rects.size(); i++) {
+		const auto& rect = rects[i];
+		const auto& c = colors[i * colorStep];
+		auto x = rect.x();
+		auto y = rect.y();
+		auto w = rect.width();
+		auto h = rect.height();
+		if (w <= 0.0 || h <= 0.0) {
+			continue;
+		}
+		if (_Track_damage && !unbounded) {
+			_Damage_clipped_user_box(x, y, x + w, y + h);
+		}
+		if (_Is_whole_pixel(x) && _Is_whole_pixel(y) && _Is_whole_pixel(w) && _Is_whole_pixel(h)) {
+			run[runCount++] = { static_cast<int>(x), static_cast<int>(y), static_cast<int>(w), static_cast<int>(h), c.r(), c.g(), c.b(), c.a() };
+			if (runCount == runCapacity) {
+				flushRun();
+			}
+		}
+		else {
+			flushRun();
+			fillRectangle(x, y, w, h, c.r(), c.g(), c.b(), c.a());
+		}
+	}
+	flushRun();
+	auto status = cairo_status(context);
+	if (status != CAIRO_STATUS_SUCCESS) {
+		ec = _Cairo_status_t_to_std_error_code(status);
+		return;
+	}
+	ec.clear();
 }
 
 void surface::fill_immediate() {
-	auto currPath = _Current_path;
-	path(experimental::io2d::path(_Immediate_path));
-	cairo_pattern_set_extend(_Brush.native_handle(), _Extend_to_cairo_extend_t(_Brush.extend()));
-	cairo_pattern_set_filter(_Brush.native_handle(), _Filter_to_cairo_filter_t(_Brush.filter()));
-	cairo_matrix_t cPttnMatrix;
-	cairo_matrix_init(&cPttnMatrix, _Brush.matrix().m00(), _Brush.matrix().m01(), _Brush.matrix().m10(), _Brush.matrix().m11(), _Brush.matrix().m20(), _Brush.matrix().m21());
-	cairo_pattern_set_matrix(_Brush.native_handle(), &cPttnMatrix);
-	cairo_set_source(_Context.get(), _Brush.native_handle());
+	_Flush_state();
+	_Set_immediate_path();
+	_Bind_brush();
+	_Damage_fill();
 	cairo_fill(_Context.get());
-	path(currPath);
+	_Restore_current_path();
 }
 
 void surface::fill_immediate(const rgba_color& c) {
-	solid_color_brush_factory factory(c);
-	brush(experimental::io2d::brush(factory));
+	_Brush_color_to(c);
 	fill_immediate();
 }
 
@@ -755,32 +1502,30 @@ void surface::fill_immediate(const ::std::experimental::io2d::brush& b) {
 }
 
 void surface::fill_immediate(const surface& s, const matrix_2d& m, extend e, filter f) {
-	auto currPath = _Current_path;
-	path(experimental::io2d::path(_Immediate_path));
-	cairo_set_source_surface(_Context.get(), s.native_handle().csfce, 0.0, 0.0);
+	_Flush_state();
+	_Set_immediate_path();
+	cairo_set_source_surface(_Context.get(), s._Surface.get(), 0.0, 0.0);
+	_Bound_pattern = nullptr;
 	auto pat = cairo_get_source(_Context.get());
 	cairo_pattern_set_extend(pat, _Extend_to_cairo_extend_t(e));
 	cairo_pattern_set_filter(pat, _Filter_to_cairo_filter_t(f));
 	cairo_matrix_t cmat{ m.m00(), m.m01(), m.m10(), m.m11(), m.m20(), m.m21() };
 	cairo_pattern_set_matrix(pat, &cmat);
+	_Damage_fill();
 	cairo_fill(_Context.get());
-	cairo_set_source_rgba(_Context.get(), 0.0, 0.0, 0.0, 0.0);
-	path(currPath);
+	_Restore_current_path();
 }
 
 void surface::stroke() {
-	cairo_pattern_set_extend(_Brush.native_handle(), _Extend_to_cairo_extend_t(_Brush.extend()));
-	cairo_pattern_set_filter(_Brush.native_handle(), _Filter_to_cairo_filter_t(_Brush.filter()));
-	cairo_matrix_t cPttnMatrix;
-	cairo_matrix_init(&cPttnMatrix, _Brush.matrix().m00(), _Brush.matrix().m01(), _Brush.matrix().m10(), _Brush.matrix().m11(), _Brush.matrix().m20(), _Brush.matrix().m21());
-	cairo_pattern_set_matrix(_Brush.native_handle(), &cPttnMatrix);
-	cairo_set_source(_Context.get(), _Brush.native_handle());
+	_Flush_state();
+	_Flush_current_path();
+	_Bind_brush();
+	_Damage_stroke(_Current_path.get() == nullptr ? nullptr : _Current_path->native_handle());
 	cairo_stroke_preserve(_Context.get());
 }
 
 void surface::stroke(const rgba_color& c) {
-	solid_color_brush_factory factory(c);
-	brush(experimental::io2d::brush(factory));
+	_Brush_color_to(c);
 	stroke();
 }
 
@@ -790,32 +1535,31 @@ void surface::stroke(const ::std::experimental::io2d::brush& b) {
 }
 
 void surface::stroke(const surface& s, const matrix_2d& m, extend e, filter f) {
-	cairo_set_source_surface(_Context.get(), s.native_handle().csfce, 0.0, 0.0);
+	_Flush_state();
+	_Flush_current_path();
+	cairo_set_source_surface(_Context.get(), s._Surface.get(), 0.0, 0.0);
+	_Bound_pattern = nullptr;
 	auto pat = cairo_get_source(_Context.get());
 	cairo_pattern_set_extend(pat, _Extend_to_cairo_extend_t(e));
 	cairo_pattern_set_filter(pat, _Filter_to_cairo_filter_t(f));
 	cairo_matrix_t cmat{ m.m00(), m.m01(), m.m10(), m.m11(), m.m20(), m.m21() };
 	cairo_pattern_set_matrix(pat, &cmat);
+	_Damage_stroke(_Current_path.get() == nullptr ? nullptr : _Current_path->native_handle());
 	cairo_stroke_preserve(_Context.get());
-	cairo_set_source_rgba(_Context.get(), 0.0, 0.0, 0.0, 0.0);
 }
 
 void surface::stroke_immediate() {
-	auto currPath = _Current_path;
-	path(experimental::io2d::path(_Immediate_path));
-	cairo_pattern_set_extend(_Brush.native_handle(), _Extend_to_cairo_extend_t(_Brush.extend()));
-	cairo_pattern_set_filter(_Brush.native_handle(), _Filter_to_cairo_filter_t(_Brush.filter()));
-	cairo_matrix_t cPttnMatrix;
-	cairo_matrix_init(&cPttnMatrix, _Brush.matrix().m00(), _Brush.matrix().m01(), _Brush.matrix().m10(), _Brush.matrix().m11(), _Brush.matrix().m20(), _Brush.matrix().m21());
-	cairo_pattern_set_matrix(_Brush.native_handle(), &cPttnMatrix);
-	cairo_set_source(_Context.get(), _Brush.native_handle());
+	_Flush_state();
+	_Set_immediate_path();
+	_Bind_brush();
+	auto cairoPath = _Immediate_cairo_path.native_path();
+	_Damage_stroke(&cairoPath);
 	cairo_stroke(_Context.get());
-	path(currPath);
+	_Restore_current_path();
 }
 
 void surface::stroke_immediate(const rgba_color& c) {
-	solid_color_brush_factory factory(c);
-	brush(experimental::io2d::brush(factory));
+	_Brush_color_to(c);
 	stroke_immediate();
 }
 
@@ -825,32 +1569,30 @@ void surface::stroke_immediate(const ::std::experimental::io2d::brush& b) {
 }
 
 void surface::stroke_immediate(const surface& s, const matrix_2d& m, extend e, filter f) {
-	auto currPath = _Current_path;
-	path(experimental::io2d::path(_Immediate_path));
-	cairo_set_source_surface(_Context.get(), s.native_handle().csfce, 0.0, 0.0);
+	_Flush_state();
+	_Set_immediate_path();
+	cairo_set_source_surface(_Context.get(), s._Surface.get(), 0.0, 0.0);
+	_Bound_pattern = nullptr;
 	auto pat = cairo_get_source(_Context.get());
 	cairo_pattern_set_extend(pat, _Extend_to_cairo_extend_t(e));
 	cairo_pattern_set_filter(pat, _Filter_to_cairo_filter_t(f));
 	cairo_matrix_t cmat{ m.m00(), m.m01(), m.m10(), m.m11(), m.m20(), m.m21() };
 	cairo_pattern_set_matrix(pat, &cmat);
+	auto cairoPath = _Immediate_cairo_path.native_path();
+	_Damage_stroke(&cairoPath);
 	cairo_stroke(_Context.get());
-	cairo_set_source_rgba(_Context.get(), 0.0, 0.0, 0.0, 0.0);
-	path(currPath);
+	_Restore_current_path();
 }
 
 void surface::mask(const ::std::experimental::io2d::brush& maskBrush) {
-	cairo_pattern_set_extend(_Brush.native_handle(), _Extend_to_cairo_extend_t(_Brush.extend()));
-	cairo_pattern_set_filter(_Brush.native_handle(), _Filter_to_cairo_filter_t(_Brush.filter()));
-	cairo_matrix_t cPttnMatrix;
-	cairo_matrix_init(&cPttnMatrix, _Brush.matrix().m00(), _Brush.matrix().m01(), _Brush.matrix().m10(), _Brush.matrix().m11(), _Brush.matrix().m20(), _Brush.matrix().m21());
-	cairo_pattern_set_matrix(_Brush.native_handle(), &cPttnMatrix);
-	cairo_set_source(_Context.get(), _Brush.native_handle());
+	_Flush_state();
+	_Bind_brush();
+	_Damage_clip();
 	cairo_mask(_Context.get(), maskBrush.native_handle());
 }
 
 void surface::mask(const ::std::experimental::io2d::brush& maskBrush, const rgba_color& c) {
-	solid_color_brush_factory factory(c);
-	brush(experimental::io2d::brush(factory));
+	_Brush_color_to(c);
 	mask(maskBrush);
 }
 
@@ -860,55 +1602,47 @@ void surface::mask(const ::std::experimental::io2d::brush& maskBrush, const ::st
 }
 
 void surface::mask(const ::std::experimental::io2d::brush& maskBrush, const surface& s, const matrix_2d& m, extend e, filter f) {
-	cairo_set_source_surface(_Context.get(), s.native_handle().csfce, 0.0, 0.0);
+	_Flush_state();
+	cairo_set_source_surface(_Context.get(), s._Surface.get(), 0.0, 0.0);
+	_Bound_pattern = nullptr;
 	auto pat = cairo_get_source(_Context.get());
 	cairo_pattern_set_extend(pat, _Extend_to_cairo_extend_t(e));
 	cairo_pattern_set_filter(pat, _Filter_to_cairo_filter_t(f));
 	cairo_matrix_t cmat{ m.m00(), m.m01(), m.m10(), m.m11(), m.m20(), m.m21() };
 	cairo_pattern_set_matrix(pat, &cmat);
+	_Damage_clip();
 	cairo_mask(_Context.get(), maskBrush.native_handle());
-	cairo_set_source_rgba(_Context.get(), 0.0, 0.0, 0.0, 0.0);
 }
 
-void surface::mask(surface& maskSurface, const matrix_2d& maskMatrix, extend maskExtend, filter maskFilter) {
-	cairo_pattern_set_extend(_Brush.native_handle(), _Extend_to_cairo_extend_t(_Brush.extend()));
-	cairo_pattern_set_filter(_Brush.native_handle(), _Filter_to_cairo_filter_t(_Brush.filter()));
-	cairo_matrix_t cPttnMatrix;
-	cairo_matrix_init(&cPttnMatrix, _Brush.matrix().m00(), _Brush.matrix().m01(), _Brush.matrix().m10(), _Brush.matrix().m11(), _Brush.matrix().m20(), _Brush.matrix().m21());
-	cairo_pattern_set_matrix(_Brush.native_handle(), &cPttnMatrix);
-	cairo_set_source(_Context.get(), _Brush.native_handle());
-
-	surface_brush_factory sbf(maskSurface);
-	experimental::io2d::brush maskBrush(sbf);
-	maskBrush.matrix(maskMatrix);
-	maskBrush.extend(maskExtend);
-	maskBrush.filter(maskFilter);
+void surface::_Mask_with_surface(const surface& maskSurface, const matrix_2d& maskMatrix, extend maskExtend, filter maskFilter) noexcept {
+	auto pat = cairo_pattern_create_for_surface(maskSurface._Surface.get());
+	cairo_pattern_set_extend(pat, _Extend_to_cairo_extend_t(maskExtend));
+	cairo_pattern_set_filter(pat, _Filter_to_cairo_filter_t(maskFilter));
+	cairo_matrix_t cmat{ maskMatrix.m00(), maskMatrix.m01(), maskMatrix.m10(), maskMatrix.m11(), maskMatrix.m20(), maskMatrix.m21() };
+	cairo_pattern_set_matrix(pat, &cmat);
+	_Damage_clip();
+	cairo_mask(_Context.get(), pat);
+	cairo_pattern_destroy(pat);
+}
 
-	mask(maskBrush);
+void surface::mask(surface& maskSurface, const matrix_2d& maskMatrix, extend maskExtend, filter maskFilter) {
+	_Flush_state();
+	_Bind_brush();
+	_Mask_with_surface(maskSurface, maskMatrix, maskExtend, maskFilter);
 }
 
 void surface::mask(surface& maskSurface, const rgba_color& c, const matrix_2d& maskMatrix, extend maskExtend, filter maskFilter) {
-	surface_brush_factory sbf(maskSurface);
-	experimental::io2d::brush maskBrush(sbf);
-	maskBrush.matrix(maskMatrix);
-	maskBrush.extend(maskExtend);
-	maskBrush.filter(maskFilter);
-
-	mask(maskBrush);
-	mask(maskBrush, c);
+	_Brush_color_to(c);
+	mask(maskSurface, maskMatrix, maskExtend, maskFilter);
 }
 
 void surface::mask(surface& maskSurface, const ::std::experimental::io2d::brush& b, const matrix_2d& maskMatrix, extend maskExtend, filter maskFilter) {
-	surface_brush_factory sbf(maskSurface);
-	experimental::io2d::brush maskBrush(sbf);
-	maskBrush.matrix(maskMatrix);
-	maskBrush.extend(maskExtend);
-	maskBrush.filter(maskFilter);
-
-	mask(maskBrush, b);
+	brush(b);
+	mask(maskSurface, maskMatrix, maskExtend, maskFilter);
 }
 
 void surface::mask(surface& maskSurface, const surface& s, const matrix_2d& maskMatrix, const matrix_2d& m, extend maskExtend, extend e, filter maskFilter, filter f) {
+	_Flush_state();
 	//cairo_set_source_surface(_Context.get(), s.native_handle().csfce, 0.0, 0.0);
 	//auto pat = cairo_get_source(_Context.get());
 	//cairo_pattern_set_extend(pat, _Extend_to_cairo_extend_t(e));
@@ -927,27 +1661,17 @@ void surface::mask(surface& maskSurface, const surface& s, const matrix_2d& mask
 }
 
 void surface::mask_immediate(const ::std::experimental::io2d::brush& maskBrush) {
-	auto currPath = _Current_path;
-	path(experimental::io2d::path(_Immediate_path));
-	cairo_pattern_set_extend(_Brush.native_handle(), _Extend_to_cairo_extend_t(_Brush.extend()));
-	cairo_pattern_set_filter(_Brush.native_handle(), _Filter_to_cairo_filter_t(_Brush.filter()));
-	cairo_matrix_t cPttnMatrix;
-	cairo_matrix_init(&cPttnMatrix, _Brush.matrix().m00(), _Brush.matrix().m01(), _Brush.matrix().m10(), _Brush.matrix().m11(), _Brush.matrix().m20(), _Brush.matrix().m21());
-	cairo_pattern_set_matrix(_Brush.native_handle(), &cPttnMatrix);
-
-	cairo_pattern_set_extend(maskBrush.native_handle(), _Extend_to_cairo_extend_t(maskBrush.extend()));
-	cairo_pattern_set_filter(maskBrush.native_handle(), _Filter_to_cairo_filter_t(maskBrush.filter()));
-	cairo_matrix_init(&cPttnMatrix, maskBrush.matrix().m00(), maskBrush.matrix().m01(), maskBrush.matrix().m10(), maskBrush.matrix().m11(), maskBrush.matrix().m20(), maskBrush.matrix().m21());
-	cairo_pattern_set_matrix(maskBrush.native_handle(), &cPttnMatrix);
-
-	cairo_set_source(_Context.get(), _Brush.native_handle());
+	_Flush_state();
+	_Set_immediate_path();
+	_Bind_brush();
+	maskBrush._Configure_pattern();
+	_Damage_clip();
 	cairo_mask(_Context.get(), maskBrush.native_handle());
-	path(currPath);
+	_Restore_current_path();
 }
 
 void surface::mask_immediate(const ::std::experimental::io2d::brush& maskBrush, const rgba_color& c) {
-	solid_color_brush_factory factory(c);
-	brush(experimental::io2d::brush(factory));
+	_Brush_color_to(c);
 	mask_immediate(maskBrush);
 }
 
@@ -957,26 +1681,25 @@ void surface::mask_immediate(const ::std::experimental::io2d::brush& maskBrush,
 }
 
 void surface::mask_immediate(const ::std::experimental::io2d::brush& maskBrush, const surface& s, const matrix_2d& m, extend e, filter f) {
-	auto currPath = _Current_path;
-	path(experimental::io2d::path(_Immediate_path));
-	cairo_set_source_surface(_Context.get(), s.native_handle().csfce, 0.0, 0.0);
+	_Flush_state();
+	_Set_immediate_path();
+	cairo_set_source_surface(_Context.get(), s._Surface.get(), 0.0, 0.0);
+	_Bound_pattern = nullptr;
 	auto pat = cairo_get_source(_Context.get());
 	cairo_pattern_set_extend(pat, _Extend_to_cairo_extend_t(e));
 	cairo_pattern_set_filter(pat, _Filter_to_cairo_filter_t(f));
 	cairo_matrix_t cmat{ m.m00(), m.m01(), m.m10(), m.m11(), m.m20(), m.m21() };
 	cairo_pattern_set_matrix(pat, &cmat);
 
-	cairo_pattern_set_extend(maskBrush.native_handle(), _Extend_to_cairo_extend_t(maskBrush.extend()));
-	cairo_pattern_set_filter(maskBrush.native_handle(), _Filter_to_cairo_filter_t(maskBrush.filter()));
-	cairo_matrix_init(&cmat, maskBrush.matrix().m00(), maskBrush.matrix().m01(), maskBrush.matrix().m10(), maskBrush.matrix().m11(), maskBrush.matrix().m20(), maskBrush.matrix().m21());
-	cairo_pattern_set_matrix(maskBrush.native_handle(), &cmat);
+	maskBrush._Configure_pattern();
 
+	_Damage_clip();
 	cairo_mask(_Context.get(), maskBrush.native_handle());
-	cairo_set_source_rgba(_Context.get(), 0.0, 0.0, 0.0, 0.0);
-	path(currPath);
+	_Restore_current_path();
 }
 
 void surface::mask_immediate(surface& maskSurface, const matrix_2d& maskMatrix, extend maskExtend, filter maskFilter) {
+	_Flush_state();
 	//auto currPath = _Current_path;
 	//path(experimental::io2d::path(_Immediate_path));
 	//cairo_pattern_set_extend(_Brush.native_handle(), _Extend_to_cairo_extend_t(_Brush.extend()));
@@ -987,36 +1710,24 @@ void surface::mask_immediate(surface& maskSurface, const matrix_2d& maskMatrix,
 	//cairo_set_source(_Context.get(), _Brush.native_handle());
 	//cairo_mask_surface(_Context.get(), maskSurface.native_handle().csfce, 0.0, 0.0);
 	//path(currPath);
-	surface_brush_factory sbf(maskSurface);
-	experimental::io2d::brush maskBrush(sbf);
-	maskBrush.matrix(maskMatrix);
-	maskBrush.extend(maskExtend);
-	maskBrush.filter(maskFilter);
-
-	mask_immediate(maskBrush);
+	_Set_immediate_path();
+	_Bind_brush();
+	_Mask_with_surface(maskSurface, maskMatrix, maskExtend, maskFilter);
+	_Restore_current_path();
 }
 
 void surface::mask_immediate(surface& maskSurface, const rgba_color& c, const matrix_2d& maskMatrix, extend maskExtend, filter maskFilter) {
-	surface_brush_factory sbf(maskSurface);
-	experimental::io2d::brush maskBrush(sbf);
-	maskBrush.matrix(maskMatrix);
-	maskBrush.extend(maskExtend);
-	maskBrush.filter(maskFilter);
-
-	mask_immediate(maskBrush, c);
+	_Brush_color_to(c);
+	mask_immediate(maskSurface, maskMatrix, maskExtend, maskFilter);
 }
 
 void surface::mask_immediate(surface& maskSurface, const ::std::experimental::io2d::brush& b, const matrix_2d& maskMatrix, extend maskExtend, filter maskFilter) {
-	surface_brush_factory sbf(maskSurface);
-	experimental::io2d::brush maskBrush(sbf);
-	maskBrush.matrix(maskMatrix);
-	maskBrush.extend(maskExtend);
-	maskBrush.filter(maskFilter);
-
-	mask_immediate(maskBrush, b);
+	brush(b);
+	mask_immediate(maskSurface, maskMatrix, maskExtend, maskFilter);
 }
 
 void surface::mask_immediate(surface& maskSurface, const surface& s, const matrix_2d& maskMatrix, const matrix_2d& m, extend maskExtend, extend e, filter maskFilter, filter f) {
+	_Flush_state();
 	//auto currPath = _Current_path;
 	//path(experimental::io2d::path(_Immediate_path));
 	//cairo_set_source_surface(_Context.get(), s.native_handle().csfce, 0.0, 0.0);
@@ -1037,24 +1748,21 @@ void surface::mask_immediate(surface& maskSurface, const surface& s, const matri
 }
 
 vector_2d surface::render_text(const string& utf8, const vector_2d& position) {
+	_Resolve_font_resource();
+	_Flush_state();
 	cairo_new_path(_Context.get());
 	cairo_move_to(_Context.get(), position.x(), position.y());
-	cairo_pattern_set_extend(_Brush.native_handle(), _Extend_to_cairo_extend_t(_Brush.extend()));
-	cairo_pattern_set_filter(_Brush.native_handle(), _Filter_to_cairo_filter_t(_Brush.filter()));
-	cairo_matrix_t cPttnMatrix;
-	cairo_matrix_init(&cPttnMatrix, _Brush.matrix().m00(), _Brush.matrix().m01(), _Brush.matrix().m10(), _Brush.matrix().m11(), _Brush.matrix().m20(), _Brush.matrix().m21());
-	cairo_pattern_set_matrix(_Brush.native_handle(), &cPttnMatrix);
-	cairo_set_source(_Context.get(), _Brush.native_handle());
+	_Bind_brush();
+	_Damage_text(utf8);
 	cairo_show_text(_Context.get(), utf8.c_str());
 	double x, y;
 	cairo_get_current_point(_Context.get(), &x, &y);
-	path(_Current_path);
+	_Restore_current_path();
 	return vector_2d{ x, y };
 }
 
 vector_2d surface::render_text(const string& utf8, const vector_2d& position, const rgba_color& c) {
-	solid_color_brush_factory factory(c);
-	brush(experimental::io2d::brush(factory));
+	_Brush_color_to(c);
 	return render_text(utf8, position);
 }
 
@@ -1064,30 +1772,27 @@ vector_2d surface::render_text(const string& utf8, const vector_2d& position, co
 }
 
 vector_2d surface::render_text(const string& utf8, const vector_2d& position, const surface& s, const matrix_2d& m, extend e, filter f) {
-	cairo_set_source_surface(_Context.get(), s.native_handle().csfce, 0.0, 0.0);
+	cairo_set_source_surface(_Context.get(), s._Surface.get(), 0.0, 0.0);
+	_Bound_pattern = nullptr;
 	auto pat = cairo_get_source(_Context.get());
 	cairo_pattern_set_extend(pat, _Extend_to_cairo_extend_t(e));
 	cairo_pattern_set_filter(pat, _Filter_to_cairo_filter_t(f));
 	cairo_matrix_t cmat{ m.m00(), m.m01(), m.m10(), m.m11(), m.m20(), m.m21() };
 	cairo_pattern_set_matrix(pat, &cmat);
 	auto result = render_text(utf8, position);
-	cairo_set_source_rgba(_Context.get(), 0.0, 0.0, 0.0, 0.0);
 	return result;
 }
 
 void surface::render_glyph_run(const glyph_run& gr) {
-	cairo_pattern_set_extend(_Brush.native_handle(), _Extend_to_cairo_extend_t(_Brush.extend()));
-	cairo_pattern_set_filter(_Brush.native_handle(), _Filter_to_cairo_filter_t(_Brush.filter()));
-	cairo_matrix_t cPttnMatrix;
-	cairo_matrix_init(&cPttnMatrix, _Brush.matrix().m00(), _Brush.matrix().m01(), _Brush.matrix().m10(), _Brush.matrix().m11(), _Brush.matrix().m20(), _Brush.matrix().m21());
-	cairo_pattern_set_matrix(_Brush.native_handle(), &cPttnMatrix);
-	cairo_set_source(_Context.get(), _Brush.native_handle());
+	_Resolve_font_resource();
+	_Flush_state();
+	_Bind_brush();
+	_Damage_glyphs(gr._Cairo_glyphs.get(), static_cast<int>(gr.glyphs().size()));
 	cairo_show_text_glyphs(_Context.get(), gr.original_text().c_str(), static_cast<int>(gr.original_text().length()), gr._Cairo_glyphs.get(), static_cast<int>(gr.glyphs().size()), gr._Cairo_text_clusters.get(), static_cast<int>(gr.clusters().size()), gr._Text_cluster_flags);
 }
 
 void surface::render_glyph_run(const glyph_run& gr, const rgba_color& c) {
-	solid_color_brush_factory factory(c);
-	brush(experimental::io2d::brush(factory));
+	_Brush_color_to(c);
 	render_glyph_run(gr);
 }
 
@@ -1097,14 +1802,14 @@ void surface::render_glyph_run(const glyph_run& gr, const ::std::experimental::i
 }
 
 void surface::render_glyph_run(const glyph_run& gr, const surface& s, const matrix_2d& m, extend e, filter f) {
-	cairo_set_source_surface(_Context.get(), s.native_handle().csfce, 0.0, 0.0);
+	cairo_set_source_surface(_Context.get(), s._Surface.get(), 0.0, 0.0);
+	_Bound_pattern = nullptr;
 	auto pat = cairo_get_source(_Context.get());
 	cairo_pattern_set_extend(pat, _Extend_to_cairo_extend_t(e));
 	cairo_pattern_set_filter(pat, _Filter_to_cairo_filter_t(f));
 	cairo_matrix_t cmat{ m.m00(), m.m01(), m.m10(), m.m11(), m.m20(), m.m21() };
 	cairo_pattern_set_matrix(pat, &cmat);
 	render_glyph_run(gr);
-	cairo_set_source_rgba(_Context.get(), 0.0, 0.0, 0.0, 0.0);
 }
 
 void surface::matrix(const matrix_2d& m) {
@@ -1112,9 +1817,13 @@ void surface::matrix(const matrix_2d& m) {
 	if (det == 0.0) {
 		_Throw_if_failed_cairo_status_t(CAIRO_STATUS_INVALID_MATRIX);
 	}
-	_Transform_matrix = m;
-	cairo_matrix_t cm{ m.m00(), m.m01(), m.m10(), m.m11(), m.m20(), m.m21() };
-	cairo_set_matrix(_Context.get(), &cm);
+	if (_Transform_matrix != m) {
+		// The path on the context is in device space, so it must be put there using the matrix it was set under.
+		_Flush_current_path();
+		_Transform_matrix = m;
+		cairo_matrix_t cm{ m.m00(), m.m01(), m.m10(), m.m11(), m.m20(), m.m21() };
+		cairo_set_matrix(_Context.get(), &cm);
+	}
 }
 
 void surface::matrix(const matrix_2d& m, error_code& ec) noexcept {
@@ -1126,23 +1835,31 @@ void surface::matrix(const matrix_2d& m, error_code& ec) noexcept {
 		ec = _Cairo_status_t_to_std_error_code(CAIRO_STATUS_INVALID_MATRIX);
 		return;
 	}
-	_Transform_matrix = m;
-	cairo_matrix_t cm{ m.m00(), m.m01(), m.m10(), m.m11(), m.m20(), m.m21() };
-	cairo_set_matrix(_Context.get(), &cm);
+	if (_Transform_matrix != m) {
+		_Flush_current_path();
+		_Transform_matrix = m;
+		cairo_matrix_t cm{ m.m00(), m.m01(), m.m10(), m.m11(), m.m20(), m.m21() };
+		cairo_set_matrix(_Context.get(), &cm);
+	}
 	ec.clear();
 }
 
 void surface::font_resource(const experimental::io2d::font_resource& f) noexcept {
-	_Font_resource = f;
-	cairo_set_scaled_font(_Context.get(), f._Scaled_font.get());
+	if (_Font_resource._Scaled_font != f._Scaled_font) {
+		_Font_resource = f;
+		_Dirty_state |= _State_font_resource;
+	}
 }
 
 void surface::font_resource(const ::std::string& family, double size, font_slant sl, font_weight w) {
-	_Font_resource = experimental::io2d::font_resource(font_resource_factory(family, sl, w, matrix_2d::init_scale({ size, size })));
-	cairo_set_scaled_font(_Context.get(), _Font_resource._Scaled_font.get());
+	// Asking again for the current font comes back from the font cache as the same scaled font, which need not be set again.
+	font_resource(experimental::io2d::font_resource(font_resource_factory(family, sl, w, matrix_2d::init_scale({ size, size }))));
 }
 
 brush surface::brush() const noexcept {
+	if (_Brush_is_color) {
+		return ::std::experimental::io2d::brush(solid_color_brush_factory(_Brush_color));
+	}
 	return _Brush;
 }
 
@@ -1164,40 +1881,27 @@ antialias surface::antialias() const noexcept {
 }
 
 ::std::experimental::io2d::dashes surface::dashes() const {
-	::std::experimental::io2d::dashes result{};
-	auto& d = get<0>(result);
-	auto& o = get<1>(result);
-	d.resize(static_cast<vector<double>::size_type>(cairo_get_dash_count(_Context.get())));
-	cairo_get_dash(_Context.get(), d.data(), &o);
-	return result;
+	return _Dashes == nullptr ? ::std::experimental::io2d::dashes() : *_Dashes;
 }
 
 experimental::io2d::dashes surface::dashes(error_code& ec) const noexcept {
-	::std::experimental::io2d::dashes result{};
-	auto& d = get<0>(result);
-	auto& o = get<1>(result);
 	try {
-		d.resize(static_cast<vector<double>::size_type>(cairo_get_dash_count(_Context.get())));
-	}
-	catch (const ::std::length_error&) {
-		ec = ::std::make_error_code(::std::errc::not_enough_memory);
+		auto result = (_Dashes == nullptr ? ::std::experimental::io2d::dashes() : *_Dashes);
+		ec.clear();
 		return result;
 	}
 	catch (const ::std::bad_alloc&) {
 		ec = ::std::make_error_code(::std::errc::not_enough_memory);
-		return result;
+		return{ };
 	}
-	cairo_get_dash(_Context.get(), d.data(), &o);
-	ec.clear();
-	return result;
 }
 
 fill_rule surface::fill_rule() const noexcept {
-	return _Cairo_fill_rule_t_to_fill_rule(cairo_get_fill_rule(_Context.get()));
+	return _Fill_rule;
 }
 
 line_cap surface::line_cap() const noexcept {
-	return _Cairo_line_cap_t_to_line_cap(cairo_get_line_cap(_Context.get()));
+	return _Line_cap;
 }
 
 line_join surface::line_join() const noexcept {
@@ -1205,7 +1909,7 @@ line_join surface::line_join() const noexcept {
 }
 
 double surface::line_width() const noexcept {
-	return cairo_get_line_width(_Context.get());
+	return _Line_width;
 }
 
 double surface::miter_limit() const noexcept {
@@ -1213,7 +1917,11 @@ double surface::miter_limit() const noexcept {
 }
 
 compositing_operator surface::compositing_operator() const noexcept {
-	return _Cairo_operator_t_to_compositing_operator(cairo_get_operator(_Context.get()));
+	return _Compositing_operator;
+}
+
+experimental::io2d::memory_resource* surface::memory_resource() const noexcept {
+	return _Memory_resource;
 }
 
 rectangle surface::clip_extents() const noexcept {
@@ -1238,53 +1946,87 @@ vector<rectangle> surface::clip_rectangles() const {
 }
 
 rectangle surface::fill_extents() const noexcept {
+	_Flush_state();
+	_Flush_current_path();
 	double pt0x, pt0y, pt1x, pt1y;
 	cairo_fill_extents(_Context.get(), &pt0x, &pt0y, &pt1x, &pt1y);
 	return{ min(pt0x, pt1x), min(pt0y, pt1y), max(pt0x, pt1x) - min(pt0x, pt1x), max(pt0y, pt1y) - min(pt0y, pt1y) };
 }
 
 rectangle surface::fill_extents_immediate() const noexcept {
+	_Flush_state();
 	// fill_extents doesn't care whether something is ACTUALLY inked; just whether or not the current fill_rule combined with the path means the area could be filled (even if the brush won't actually change it).
-	throw runtime_error("Not implemented.");
-	//double pt0x, pt0y, pt1x, pt1y;
-	//cairo_fill_extents(_Context.get(), &pt0x, &pt0y, &pt1x, &pt1y);
-	//return{ min(pt0x, pt1x), min(pt0y, pt1y), max(pt0x, pt1x) - min(pt0x, pt1x), max(pt0y, pt1y) - min(pt0y, pt1y) };
+	error_code ec;
+	_Set_immediate_path(ec);
+	if (static_cast<bool>(ec)) {
+		return{ };
+	}
+	double pt0x, pt0y, pt1x, pt1y;
+	cairo_fill_extents(_Context.get(), &pt0x, &pt0y, &pt1x, &pt1y);
+	_Restore_current_path();
+	return{ min(pt0x, pt1x), min(pt0y, pt1y), max(pt0x, pt1x) - min(pt0x, pt1x), max(pt0y, pt1y) - min(pt0y, pt1y) };
 }
 
 bool surface::in_fill(const vector_2d& pt) const noexcept {
+	_Flush_state();
+	_Flush_current_path();
 	return cairo_in_fill(_Context.get(), pt.x(), pt.y()) != 0;
 }
 
 bool surface::in_fill_immediate(const vector_2d& pt) const noexcept {
-	throw runtime_error("Not implemented.");
-	//return cairo_in_fill(_Context.get(), pt.x(), pt.y()) != 0;
+	_Flush_state();
+	error_code ec;
+	_Set_immediate_path(ec);
+	if (static_cast<bool>(ec)) {
+		return false;
+	}
+	auto result = cairo_in_fill(_Context.get(), pt.x(), pt.y()) != 0;
+	_Restore_current_path();
+	return result;
 }
 
 rectangle surface::stroke_extents() const noexcept {
+	_Flush_state();
+	_Flush_current_path();
 	double pt0x, pt0y, pt1x, pt1y;
 	cairo_stroke_extents(_Context.get(), &pt0x, &pt0y, &pt1x, &pt1y);
 	return{ min(pt0x, pt1x), min(pt0y, pt1y), max(pt0x, pt1x) - min(pt0x, pt1x), max(pt0y, pt1y) - min(pt0y, pt1y) };
 }
 
 rectangle surface::stroke_extents_immediate() const noexcept {
-	throw runtime_error("Not implemented.");
-	//auto currPath = _Current_path;
-	//path(path(_Immediate_path));
-	//double pt0x, pt0y, pt1x, pt1y;
-	//cairo_stroke_extents(_Context.get(), &pt0x, &pt0y, &pt1x, &pt1y);
-	//path(currPath);
-	//return{ min(pt0x, pt1x), min(pt0y, pt1y), max(pt0x, pt1x) - min(pt0x, pt1x), max(pt0y, pt1y) - min(pt0y, pt1y) };
+	_Flush_state();
+	error_code ec;
+	_Set_immediate_path(ec);
+	if (static_cast<bool>(ec)) {
+		return{ };
+	}
+	double pt0x, pt0y, pt1x, pt1y;
+	cairo_stroke_extents(_Context.get(), &pt0x, &pt0y, &pt1x, &pt1y);
+	_Restore_current_path();
+	return{ min(pt0x, pt1x), min(pt0y, pt1y), max(pt0x, pt1x) - min(pt0x, pt1x), max(pt0y, pt1y) - min(pt0y, pt1y) };
 }
 
 bool surface::in_stroke(const vector_2d& pt) const noexcept {
+	_Flush_state();
+	_Flush_current_path();
 	return cairo_in_stroke(_Context.get(), pt.x(), pt.y()) != 0;
 }
 
 bool surface::in_stroke_immediate(const vector_2d& pt) const noexcept {
-	throw runtime_error("Not implemented.");
+	_Flush_state();
+	error_code ec;
+	_Set_immediate_path(ec);
+	if (static_cast<bool>(ec)) {
+		return false;
+	}
+	auto result = cairo_in_stroke(_Context.get(), pt.x(), pt.y()) != 0;
+	_Restore_current_path();
+	return result;
 }
 
 ::std::experimental::io2d::font_extents surface::font_extents() const noexcept {
+	_Resolve_font_resource();
+	_Flush_state();
 	::std::experimental::io2d::font_extents result;
 	cairo_font_extents_t cfe{};
 	cairo_font_extents(_Context.get(), &cfe);
@@ -1295,6 +2037,8 @@ bool surface::in_stroke_immediate(const vector_2d& pt) const noexcept {
 }
 
 ::std::experimental::io2d::text_extents surface::text_extents(const string& utf8) const {
+	_Resolve_font_resource();
+	_Flush_state();
 	::std::experimental::io2d::text_extents result;
 	if (utf8.size() == 0) {
 		return result;
@@ -1463,5 +2207,6 @@ vector_2d surface::surface_to_user_distance(const vector_2d& dpt) const {
 }
 
 experimental::io2d::font_resource surface::font_resource() const noexcept {
+	_Resolve_font_resource();
 	return _Font_resource;
 }
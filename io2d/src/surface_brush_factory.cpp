@@ -22,11 +22,19 @@ surface_brush_factory::surface_brush_factory() noexcept
 //}
 
 surface_brush_factory::surface_brush_factory(surface_brush_factory&& other) noexcept
-	: _Surface(move(other._Surface)) {
+	: _Snapshot(move(other._Snapshot))
+	, _Format(other._Format)
+	, _Width(other._Width)
+	, _Height(other._Height)
+	, _Surface(move(other._Surface)) {
 }
 
 surface_brush_factory& surface_brush_factory::operator=(surface_brush_factory&& other) noexcept {
 	if (this != &other) {
+		_Snapshot = move(other._Snapshot);
+		_Format = other._Format;
+		_Width = other._Width;
+		_Height = other._Height;
 		_Surface = move(other._Surface);
 	}
 	return *this;
@@ -34,45 +42,90 @@ surface_brush_factory& surface_brush_factory::operator=(surface_brush_factory&&
 
 surface_brush_factory::surface_brush_factory(::std::experimental::io2d::surface& s)
 	: _Surface() {
-	_Surface = make_unique<image_surface>(_Surface_create_image_surface_copy(s));
+	surface(s);
 }
 
 void surface_brush_factory::surface(::std::experimental::io2d::surface& s) {
-	// Create an image_surface copy of the new surface.
-	auto sfc = _Surface_create_image_surface_copy(s);
-	// Move the copy of the new surface to be the current surface
-	_Surface = make_unique<image_surface>(move(sfc));
+	if (!s._Has_surface_resource()) {
+		throw invalid_argument("Surface to be copied has no surface resource.");
+	}
+	if (s.is_finished()) {
+		_Throw_if_failed_cairo_status_t(CAIRO_STATUS_SURFACE_FINISHED);
+	}
+	unique_ptr<image_surface> copy;
+	auto sfce = s._Surface.get();
+	if (cairo_surface_get_type(sfce) != CAIRO_SURFACE_TYPE_IMAGE || _Pixel_writer_count(sfce) != 0) {
+		// Only an image surface's pixels can be shared, so anything else is still copied into one. So is an image surface that a pixel_view or mapped_surface can still write to, as cairo would not see those writes in time to give the snapshot its own copy.
+		copy = make_unique<image_surface>(_Surface_create_image_surface_copy(s));
+		sfce = copy->_Surface.get();
+	}
+	unique_ptr<cairo_surface_t, decltype(&cairo_surface_destroy)> snapshot(cairo_surface_create_snapshot(sfce), &cairo_surface_destroy);
+	_Throw_if_failed_cairo_status_t(cairo_surface_status(snapshot.get()));
+	_Format = _Cairo_format_t_to_format(cairo_image_surface_get_format(sfce));
+	_Width = cairo_image_surface_get_width(sfce);
+	_Height = cairo_image_surface_get_height(sfce);
+	_Snapshot = move(snapshot);
+	_Surface = move(copy);
 }
 
 void surface_brush_factory::surface(::std::experimental::io2d::surface& s, ::std::error_code & ec) noexcept {
-	image_surface sfc{format::argb32, 1, 1, ec};
-	if (static_cast<bool>(ec)) {
+	if (!s._Has_surface_resource()) {
+		ec = make_error_code(errc::invalid_argument);
 		return;
 	}
-
-	// Create an image_surface copy of the new surface.
-	_Surface_create_image_surface_copy(s, sfc, ec);
-
-	if (static_cast<bool>(ec)) {
+	if (s.is_finished()) {
+		ec = make_error_code(io2d_error::surface_finished);
 		return;
 	}
-
-	// Move the copy of the new surface to be the current surface
-	try {
-		auto heapSfc = make_unique<image_surface>(move(sfc));
-		swap(heapSfc, _Surface);
+	unique_ptr<image_surface> copy;
+	auto sfce = s._Surface.get();
+	if (cairo_surface_get_type(sfce) != CAIRO_SURFACE_TYPE_IMAGE || _Pixel_writer_count(sfce) != 0) {
+		image_surface sfc{ format::argb32, 1, 1, ec };
+		if (static_cast<bool>(ec)) {
+			return;
+		}
+		_Surface_create_image_surface_copy(s, sfc, ec);
+		if (static_cast<bool>(ec)) {
+			return;
+		}
+		try {
+			copy = make_unique<image_surface>(move(sfc));
+		}
+		catch (const bad_alloc&) {
+			ec = make_error_code(errc::not_enough_memory);
+			return;
+		}
+		sfce = copy->_Surface.get();
 	}
-	catch (bad_alloc) {
-		ec = make_error_code(errc::not_enough_memory);
+	unique_ptr<cairo_surface_t, decltype(&cairo_surface_destroy)> snapshot(cairo_surface_create_snapshot(sfce), &cairo_surface_destroy);
+	auto status = cairo_surface_status(snapshot.get());
+	if (status != CAIRO_STATUS_SUCCESS) {
+		ec = _Cairo_status_t_to_std_error_code(status);
 		return;
 	}
+	_Format = _Cairo_format_t_to_format(cairo_image_surface_get_format(sfce));
+	_Width = cairo_image_surface_get_width(sfce);
+	_Height = cairo_image_surface_get_height(sfce);
+	_Snapshot = move(snapshot);
+	_Surface = move(copy);
 	ec.clear();
 }
 
 bool surface_brush_factory::has_surface() const noexcept {
-	return _Surface.get() != nullptr;
+	return _Snapshot != nullptr;
 }
 
 const image_surface& surface_brush_factory::surface() const {
+	// This is the one place the snapshot's pixels have to be copied, and const callers on several threads may get here at once.
+	lock_guard<mutex> lock(_Surface_mutex);
+	if (_Surface == nullptr && _Snapshot != nullptr) {
+		auto copy = make_unique<image_surface>(_Format, _Width, _Height);
+		unique_ptr<cairo_t, decltype(&cairo_destroy)> context(cairo_create(copy->_Surface.get()), &cairo_destroy);
+		cairo_set_operator(context.get(), CAIRO_OPERATOR_SOURCE);
+		cairo_set_source_surface(context.get(), _Snapshot.get(), 0.0, 0.0);
+		cairo_paint(context.get());
+		_Throw_if_failed_cairo_status_t(cairo_status(context.get()));
+		_Surface = move(copy);
+	}
 	return *_Surface.get();
 }
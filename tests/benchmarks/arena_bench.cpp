@@ -0,0 +1,138 @@
+// Frame time and allocations with path_factory and saved state on the heap, and on a per frame arena that is reset
+// after each frame. The scenes are the tests/sample-draw ones that build paths and save state every frame:
+// draw_test_compositing_operators, test_fill_rules and draw_sort_visualization, drawn on an image_surface.
+#include "io2d.h"
+#include "benchmark.h"
+#include <cmath>
+
+using namespace std;
+using namespace std::experimental::io2d;
+
+namespace {
+	// Passes everything on to new_delete_resource() and counts the calls.
+	class counting_resource : public memory_resource {
+		virtual void* do_allocate(size_t bytes, size_t alignment) override {
+			++allocations;
+			return new_delete_resource()->allocate(bytes, alignment);
+		}
+		virtual void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+			new_delete_resource()->deallocate(p, bytes, alignment);
+		}
+		virtual bool do_is_equal(const memory_resource& other) const noexcept override {
+			return this == &other;
+		}
+	public:
+		long long allocations = 0;
+	};
+
+	void compositing_operators(image_surface& s, memory_resource* mr) {
+		s.save();
+		path_factory pb(mr);
+		pb.rectangle({ 10.0, 10.0, 120.0, 90.0 });
+		auto firstRectPath = path(pb);
+		pb.clear();
+		pb.rectangle({ 50.0, 40.0, 120.0, 90.0 });
+		auto secondRectPath = path(pb);
+		pb.clear();
+		pb.move_to({ 85.0, 25.0 });
+		pb.line_to({ 150.0, 115.0 });
+		pb.line_to({ 30.0, 115.0 });
+		pb.close_path();
+		auto triangleClipPath = path(pb);
+
+		s.compositing_operator(compositing_operator::clear);
+		s.paint(rgba_color::transparent_black());
+		s.compositing_operator(compositing_operator::over);
+		s.path(firstRectPath);
+		s.fill(rgba_color(0.8, 0.0, 0.0, 0.8));
+		s.save();
+		s.clip(triangleClipPath);
+		s.path(secondRectPath);
+		s.compositing_operator(compositing_operator::xor_op);
+		s.fill(rgba_color(0.0, 0.2, 0.2, 0.4));
+		s.restore();
+		s.compositing_operator(compositing_operator::source);
+		s.line_width(2.0);
+		s.path(firstRectPath);
+		s.stroke(rgba_color::teal());
+		s.path(triangleClipPath);
+		s.stroke(rgba_color::yellow());
+		s.restore();
+	}
+
+	void fill_rules(image_surface& s) {
+		s.save();
+		auto rect = rectangle{ 10.0, 10.0, 120.0, 90.0 };
+		for (int i = 0; i < 4; ++i) {
+			s.fill_rule(i < 2 ? fill_rule::winding : fill_rule::even_odd);
+			s.immediate().clear();
+			rect.top_left({ 10.0 + 180.0 * (i / 2), 10.0 + 140.0 * (i % 2) });
+			s.immediate().rectangle(rect, true);
+			rect.top_left({ 50.0 + 180.0 * (i / 2), 40.0 + 140.0 * (i % 2) });
+			s.immediate().rectangle(rect, i % 2 == 0);
+			s.fill_immediate(rgba_color(0.5, 0.0, 0.0, 0.5));
+		}
+		s.immediate().clear();
+		s.restore();
+	}
+
+	void sort_visualization(image_surface& s, memory_resource* mr, int frame) {
+		const int elementCount = 12;
+		const double pi = 3.14159265358979323846;
+		s.paint(rgba_color::cornflower_blue());
+		const double radius = trunc(s.width() * 0.8 / elementCount / 2.0);
+		const double beginX = trunc(s.width() * 0.1);
+		const double y = trunc(s.height() * 0.5);
+		path_factory pf(mr);
+		for (int i = 0; i < elementCount; ++i) {
+			s.save();
+			pf.clear();
+			const vector_2d center{ radius * i * 2.0 + radius + beginX, y + ((i + frame) % 3) * 4.0 };
+			pf.change_matrix(matrix_2d::init_scale({ 1.0, 1.5 }) * matrix_2d::init_rotate(pi / 4.0));
+			pf.change_origin(center);
+			pf.arc_negative(center, radius - 3.0, pi / 2.0, -pi / 2.0);
+			s.path(path(pf));
+			const double grey = 1.0 - (((i * 7 + frame) % elementCount) / (elementCount - 1.0));
+			s.fill(rgba_color(grey, grey, grey, 1.0));
+			s.line_width(3.0);
+			s.stroke(rgba_color::red());
+			s.restore();
+		}
+	}
+
+	void frame(image_surface& s, memory_resource* mr, int n) {
+		compositing_operators(s, mr);
+		fill_rules(s);
+		sort_visualization(s, mr, n);
+		s.flush();
+	}
+}
+
+int main() {
+	const int iterations = 500;
+	image_surface s(format::argb32, 640, 480);
+	int n = 0;
+
+	counting_resource heap;
+	auto previous = set_default_resource(&heap);
+	auto heapUs = benchmark::time_us(iterations, [&]() {
+		frame(s, get_default_resource(), n++);
+	});
+	const auto heapAllocations = heap.allocations;
+	set_default_resource(previous);
+
+	counting_resource upstream;
+	monotonic_buffer_resource arena(&upstream);
+	s.memory_resource(&arena);
+	auto arenaUs = benchmark::time_us(iterations, [&]() {
+		frame(s, &arena, n++);
+		arena.reset();
+	});
+	s.memory_resource(new_delete_resource());
+
+	benchmark::report("frame, heap", heapUs);
+	benchmark::report("frame, per frame arena", arenaUs);
+	benchmark::report("heap allocations per frame", static_cast<double>(heapAllocations) / (iterations + 1), "");
+	benchmark::report("arena upstream allocations per frame", static_cast<double>(upstream.allocations) / (iterations + 1), "");
+	return 0;
+}
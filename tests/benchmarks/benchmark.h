@@ -0,0 +1,22 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+
+namespace benchmark {
+	// Runs f() iterations times after one untimed warm-up call and returns the mean time of a call in microseconds.
+	template <class F>
+	double time_us(int iterations, F&& f) {
+		f();
+		auto start = ::std::chrono::steady_clock::now();
+		for (int i = 0; i < iterations; ++i) {
+			f();
+		}
+		auto end = ::std::chrono::steady_clock::now();
+		return ::std::chrono::duration<double, ::std::micro>(end - start).count() / iterations;
+	}
+
+	inline void report(const char* name, double us, const char* unit = "us") {
+		::std::printf("%-44s %12.3f %s\n", name, us, unit);
+	}
+}
@@ -0,0 +1,80 @@
+// Pixel throughput of the compositing that io2d's drawing turns into, for comparing pixman's SIMD implementations.
+// pixman picks the best one the CPU has; PIXMAN_DISABLE turns levels off, so run this once for each of
+//   PIXMAN_DISABLE=""  "avx2"  "avx2 ssse3"  "avx2 ssse3 sse2 mmx"
+// Each operation is looked up first in the fast path tables of every level, so a level only shows up in the
+// cases that no faster level above it, and no dedicated fast path below it, already handles.
+#include "io2d.h"
+#include "benchmark.h"
+#include <cstdint>
+
+using namespace std;
+using namespace std::experimental::io2d;
+
+namespace {
+	const int size = 1024;
+
+	void fill_with_noise(image_surface& s) {
+		auto pixels = s.pixels();
+		uint32_t state = 12345;
+		for (int y = 0; y < pixels.height(); ++y) {
+			auto row = reinterpret_cast<uint32_t*>(pixels.row(y));
+			for (int x = 0; x < pixels.width(); ++x) {
+				state = state * 1664525u + 1013904223u;
+				// Premultiplied: no channel above alpha.
+				uint32_t a = state >> 24;
+				uint32_t c = (state >> 8) & 0xff;
+				c = c * a / 255;
+				row[x] = (a << 24) | (c << 16) | (c << 8) | c;
+			}
+		}
+	}
+
+	void run(const char* name, image_surface& dst, void(*draw)(image_surface&, image_surface&), image_surface& src) {
+		const int iterations = 40;
+		auto us = benchmark::time_us(iterations, [&]() {
+			draw(dst, src);
+			dst.flush();
+		});
+		benchmark::report(name, static_cast<double>(size) * size / us, "Mpix/s");
+	}
+}
+
+int main() {
+	image_surface dst(format::argb32, size, size);
+	image_surface src(format::argb32, size, size);
+	fill_with_noise(dst);
+	fill_with_noise(src);
+
+	run("fill opaque color", dst, [](image_surface& d, image_surface&) {
+		d.paint(rgba_color(0.2, 0.4, 0.6, 1.0));
+	}, src);
+	run("paint translucent color (over)", dst, [](image_surface& d, image_surface&) {
+		d.paint(rgba_color(0.2, 0.4, 0.6, 0.5));
+	}, src);
+	run("paint image (over)", dst, [](image_surface& d, image_surface& s) {
+		d.paint(s);
+	}, src);
+	run("paint image with alpha (over)", dst, [](image_surface& d, image_surface& s) {
+		d.paint(s, 0.5);
+	}, src);
+	run("paint image (add)", dst, [](image_surface& d, image_surface& s) {
+		d.compositing_operator(compositing_operator::add);
+		d.paint(s);
+		d.compositing_operator(compositing_operator::over);
+	}, src);
+	run("paint image (multiply)", dst, [](image_surface& d, image_surface& s) {
+		d.compositing_operator(compositing_operator::multiply);
+		d.paint(s);
+		d.compositing_operator(compositing_operator::over);
+	}, src);
+	// Magnifies by 2.5; the offset keeps every bilinear sample, even those of the first row and column, inside the source, which is the case the SIMD fetchers cover.
+	run("paint scaled image, bilinear (over)", dst, [](image_surface& d, image_surface& s) {
+		d.paint(s, matrix_2d(0.4, 0.0, 0.0, 0.4, 2.0, 2.0), extend::none, filter::bilinear);
+	}, src);
+	run("paint scaled image, bilinear (add)", dst, [](image_surface& d, image_surface& s) {
+		d.compositing_operator(compositing_operator::add);
+		d.paint(s, matrix_2d(0.4, 0.0, 0.0, 0.4, 2.0, 2.0), extend::none, filter::bilinear);
+		d.compositing_operator(compositing_operator::over);
+	}, src);
+	return 0;
+}
@@ -0,0 +1,100 @@
+// Path building and conversion throughput: the loops that path_factory, path and path_extents run once per path item,
+// which is where vector_2d, matrix_2d and rectangle are used most heavily.
+// Run with IO2D_DISABLE=avx2 to see what CPUs without AVX2 get from the batch point transforms.
+#include "io2d.h"
+#include "benchmark.h"
+#include <cmath>
+#include <vector>
+
+using namespace std;
+using namespace std::experimental::io2d;
+
+namespace {
+	const int points = 1000;
+	volatile double sink;
+
+	vector<vector_2d> make_polyline() {
+		vector<vector_2d> result;
+		for (int i = 0; i < points; ++i) {
+			result.push_back({ i * 0.75, 100.0 + 50.0 * sin(i * 0.05) });
+		}
+		return result;
+	}
+
+	void build_polyline(path_factory& pf, const vector<vector_2d>& pts) {
+		pf.move_to(pts[0]);
+		for (int i = 1; i < points; ++i) {
+			pf.line_to(pts[i]);
+		}
+	}
+
+	void build_curves(path_factory& pf, const vector<vector_2d>& pts) {
+		pf.move_to(pts[0]);
+		for (int i = 3; i < points; i += 3) {
+			pf.curve_to(pts[i - 2], pts[i - 1], pts[i]);
+		}
+		for (int i = 0; i < 50; ++i) {
+			pf.arc({ i * 10.0, 300.0 }, 5.0, 0.0, 3.0);
+		}
+		pf.close_path();
+	}
+}
+
+int main() {
+	auto pts = make_polyline();
+	const int iterations = 2000;
+	auto per_point = [](double us) { return us * 1000.0 / points; };
+
+	benchmark::report("build polyline", per_point(benchmark::time_us(iterations, [&]() {
+		path_factory pf;
+		build_polyline(pf, pts);
+	})), "ns/point");
+
+	path_factory polyline;
+	build_polyline(polyline, pts);
+	benchmark::report("path_extents of polyline", per_point(benchmark::time_us(iterations, [&]() {
+		sink = polyline.path_extents().width();
+	})), "ns/point");
+	benchmark::report("convert polyline to path", per_point(benchmark::time_us(iterations, [&]() {
+		path p(polyline);
+	})), "ns/point");
+
+	path_factory transformed;
+	transformed.change_matrix(matrix_2d::init_rotate(0.3) * matrix_2d::init_scale({ 1.5, 0.75 }));
+	transformed.change_origin({ 200.0, 100.0 });
+	build_polyline(transformed, pts);
+	benchmark::report("path_extents of transformed polyline", per_point(benchmark::time_us(iterations, [&]() {
+		sink = transformed.path_extents().width();
+	})), "ns/point");
+	benchmark::report("convert transformed polyline to path", per_point(benchmark::time_us(iterations, [&]() {
+		path p(transformed);
+	})), "ns/point");
+
+	path_factory curves;
+	build_curves(curves, pts);
+	benchmark::report("build curves and arcs", per_point(benchmark::time_us(iterations, [&]() {
+		path_factory pf;
+		build_curves(pf, pts);
+	})), "ns/point");
+	benchmark::report("path_extents of curves and arcs", per_point(benchmark::time_us(iterations, [&]() {
+		sink = curves.path_extents().width();
+	})), "ns/point");
+	benchmark::report("convert curves and arcs to path", per_point(benchmark::time_us(iterations, [&]() {
+		path p(curves);
+	})), "ns/point");
+
+	auto m = matrix_2d::init_rotate(0.3) * matrix_2d::init_translate({ 5.0, 7.0 });
+	benchmark::report("matrix_2d::transform_point", per_point(benchmark::time_us(iterations * 10, [&]() {
+		vector_2d sum;
+		for (const auto& pt : pts) {
+			sum += m.transform_point(pt);
+		}
+		sink = sum.x();
+	})), "ns/point");
+	vector<vector_2d> out(pts.size());
+	benchmark::report("matrix_2d::transform_points", per_point(benchmark::time_us(iterations * 10, [&]() {
+		m.transform_points(pts.data(), pts.size(), out.data());
+		sink = out.back().x();
+	})), "ns/point");
+	return 0;
+}
@@ -0,0 +1,146 @@
+// Memory and copy cost of path_factory's packed verb and coordinate streams next to the vector<path_data_item> that
+// path_factory used to keep, for the same 250k mixed items.
+#include "io2d.h"
+#include "benchmark.h"
+#include <vector>
+
+using namespace std;
+using namespace std::experimental::io2d;
+
+namespace {
+	const int items = 250000;
+
+	// Passes everything on to new_delete_resource() and keeps count of the bytes that are live.
+	class counting_resource : public memory_resource {
+		virtual void* do_allocate(size_t bytes, size_t alignment) override {
+			live += bytes;
+			return new_delete_resource()->allocate(bytes, alignment);
+		}
+		virtual void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+			live -= bytes;
+			new_delete_resource()->deallocate(p, bytes, alignment);
+		}
+		virtual bool do_is_equal(const memory_resource& other) const noexcept override {
+			return this == &other;
+		}
+	public:
+		size_t live = 0;
+	};
+
+	// The mix of items a path with straight and curved segments has: mostly line_to, some curves, a sub-path every 50 items.
+	// Add is called with the item that goes at each index, so the same items can go into either container.
+	template <class Add>
+	void build(Add&& add) {
+		for (int i = 0; i < items; ++i) {
+			const double x = (i % 1000) * 0.5;
+			const double y = (i / 1000) * 2.0;
+			if (i % 50 == 0) {
+				add(path_data_item::move_to({ x, y }));
+			}
+			else if (i % 50 == 49) {
+				add(path_data_item::close_path());
+			}
+			else if (i % 10 == 5) {
+				add(path_data_item::curve_to({ x + 1.0, y }, { x + 1.0, y + 1.0 }, { x, y + 1.0 }));
+			}
+			else if (i % 10 == 7) {
+				add(path_data_item::rel_line_to({ 0.5, 0.25 }));
+			}
+			else {
+				add(path_data_item::line_to({ x, y + 0.5 }));
+			}
+		}
+	}
+
+	void build(path_factory& pf) {
+		build([&pf](const path_data_item::path_data& item) {
+			switch (item.type()) {
+			case path_data_type::move_to:
+				pf.move_to(static_cast<const path_data_item::move_to&>(item).to());
+				break;
+			case path_data_type::line_to:
+				pf.line_to(static_cast<const path_data_item::line_to&>(item).to());
+				break;
+			case path_data_type::rel_line_to:
+				pf.rel_line_to(static_cast<const path_data_item::rel_line_to&>(item).to());
+				break;
+			case path_data_type::curve_to:
+			{
+				const auto& c = static_cast<const path_data_item::curve_to&>(item);
+				pf.curve_to(c.control_point_1(), c.control_point_2(), c.end_point());
+			}
+				break;
+			default:
+				pf.close_path();
+				break;
+			}
+		});
+	}
+
+	void build(vector<path_data_item>& v) {
+		build([&v](const path_data_item::path_data& item) {
+			switch (item.type()) {
+			case path_data_type::move_to:
+				v.emplace_back(static_cast<const path_data_item::move_to&>(item));
+				break;
+			case path_data_type::line_to:
+				v.emplace_back(static_cast<const path_data_item::line_to&>(item));
+				break;
+			case path_data_type::rel_line_to:
+				v.emplace_back(static_cast<const path_data_item::rel_line_to&>(item));
+				break;
+			case path_data_type::curve_to:
+				v.emplace_back(static_cast<const path_data_item::curve_to&>(item));
+				break;
+			default:
+				v.emplace_back(static_cast<const path_data_item::close_path&>(item));
+				break;
+			}
+		});
+	}
+}
+
+int main() {
+	counting_resource counter;
+	path_factory pf(&counter);
+	build(pf);
+	const auto grown = counter.live;
+	counting_resource copyCounter;
+	path_factory trimmed(pf, &copyCounter);
+	const auto packed = copyCounter.live;
+	vector<path_data_item> unpacked;
+	build(unpacked);
+	const auto itemBytes = unpacked.capacity() * sizeof(path_data_item);
+	const auto trimmedItemBytes = unpacked.size() * sizeof(path_data_item);
+
+	// "as built" includes what the vectors reserved while growing; a copy holds only what is used.
+	benchmark::report("path_factory storage, as built", grown / 1048576.0, "MB");
+	benchmark::report("vector<path_data_item> storage, as built", itemBytes / 1048576.0, "MB");
+	benchmark::report("path_factory storage, copied", packed / 1048576.0, "MB");
+	benchmark::report("vector<path_data_item> storage, copied", trimmedItemBytes / 1048576.0, "MB");
+	benchmark::report("path_factory bytes per item", static_cast<double>(packed) / items, "bytes");
+	benchmark::report("vector<path_data_item> bytes per item", static_cast<double>(sizeof(path_data_item)), "bytes");
+
+	const int iterations = 20;
+	benchmark::report("build path_factory", benchmark::time_us(iterations, [&]() {
+		path_factory f;
+		build(f);
+	}) / 1000.0, "ms");
+	benchmark::report("build vector<path_data_item>", benchmark::time_us(iterations, [&]() {
+		vector<path_data_item> v;
+		build(v);
+	}) / 1000.0, "ms");
+	benchmark::report("copy path_factory", benchmark::time_us(iterations, [&]() {
+		path_factory copy(pf);
+	}) / 1000.0, "ms");
+	benchmark::report("copy vector<path_data_item>", benchmark::time_us(iterations, [&]() {
+		auto copy = unpacked;
+	}) / 1000.0, "ms");
+	benchmark::report("convert path_factory to path", benchmark::time_us(iterations, [&]() {
+		path p(pf);
+	}) / 1000.0, "ms");
+	benchmark::report("convert vector<path_data_item> to path", benchmark::time_us(iterations, [&]() {
+		path p(unpacked);
+	}) / 1000.0, "ms");
+	return 0;
+}
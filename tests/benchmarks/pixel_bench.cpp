@@ -0,0 +1,95 @@
+// Per-pixel work on a 4K argb32 frame: a color grade written by hand against one through transform_pixels, and conversion
+// to and from straight-alpha rgba8 through convert_pixels against a scalar pixel_traits loop.
+// Run with IO2D_THREADS=n to see what n threads get from parallelism::parallel, and with IO2D_DISABLE=avx2 to see what
+// CPUs without AVX2 get.
+#include "io2d.h"
+#include "benchmark.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+using namespace std;
+using namespace std::experimental::io2d;
+
+namespace {
+	const int width = 3840;
+	const int height = 2160;
+
+	// A lambda rather than a function, so that transform_pixels can inline it.
+	const auto grade = [](rgba_pixel p) {
+		auto lift = [](int c) { return static_cast<uint8_t>(min(255, c * 9 / 8 + 6)); };
+		return rgba_pixel{ lift(p.r), lift(p.g), static_cast<uint8_t>(p.b * 7 / 8), p.a };
+	};
+
+	// What a caller without typed views writes: unpremultiply in double precision, grade, premultiply.
+	void grade_by_hand(unsigned char* data, int stride) {
+		for (int y = 0; y < height; ++y) {
+			auto row = reinterpret_cast<uint32_t*>(data + static_cast<ptrdiff_t>(y) * stride);
+			for (int x = 0; x < width; ++x) {
+				auto v = row[x];
+				auto a = static_cast<int>(v >> 24);
+				if (a == 0) {
+					continue;
+				}
+				auto unpremultiply = [a](uint32_t c) { return static_cast<int>((c & 0xffu) * 255.0 / a + 0.5); };
+				auto p = grade({ static_cast<uint8_t>(unpremultiply(v >> 16)), static_cast<uint8_t>(unpremultiply(v >> 8)), static_cast<uint8_t>(unpremultiply(v)), static_cast<uint8_t>(a) });
+				auto premultiply = [a](uint8_t c) { return static_cast<uint32_t>(c * a / 255.0 + 0.5); };
+				row[x] = (static_cast<uint32_t>(a) << 24) | (premultiply(p.r) << 16) | (premultiply(p.g) << 8) | premultiply(p.b);
+			}
+		}
+	}
+}
+
+int main() {
+	const int iterations = 10;
+	image_surface frame(format::argb32, width, height);
+	frame.paint(rgba_color(0.2, 0.5, 0.7, 0.6));
+	auto pixels = frame.pixels();
+	typed_pixel_view<format::argb32> view(pixels);
+
+	benchmark::report("4K grade by hand, double precision", benchmark::time_us(iterations, [&]() {
+		grade_by_hand(pixels.data(), pixels.stride());
+	}) / 1000.0, "ms");
+	benchmark::report("4K grade, transform_pixels, sequential", benchmark::time_us(iterations, [&]() {
+		transform_pixels(view, grade);
+	}) / 1000.0, "ms");
+	benchmark::report("4K grade, transform_pixels, parallel", benchmark::time_us(iterations, [&]() {
+		transform_pixels(view, grade, parallelism::parallel);
+	}) / 1000.0, "ms");
+
+	const int stride = width * 4;
+	vector<unsigned char> straight(static_cast<size_t>(stride) * height);
+	benchmark::report("4K argb32 to rgba8, pixel_traits loop", benchmark::time_us(iterations, [&]() {
+		for (int y = 0; y < height; ++y) {
+			auto src = view.row(y);
+			auto dest = straight.data() + static_cast<ptrdiff_t>(y) * stride;
+			for (int x = 0; x < width; ++x) {
+				auto p = pixel_traits<format::argb32>::to_rgba(src[x]);
+				memcpy(dest + x * 4, &p, 4);
+			}
+		}
+	}) / 1000.0, "ms");
+	for (auto p : { parallelism::sequential, parallelism::parallel }) {
+		benchmark::report(p == parallelism::sequential ? "4K argb32 to rgba8, convert_pixels" : "4K argb32 to rgba8, convert_pixels, parallel", benchmark::time_us(iterations, [&]() {
+			convert_pixels(pixels.data(), pixels.stride(), format::argb32, straight.data(), stride, interchange_format::rgba8, width, height, p);
+		}) / 1000.0, "ms");
+	}
+	benchmark::report("4K rgba8 to argb32, pixel_traits loop", benchmark::time_us(iterations, [&]() {
+		for (int y = 0; y < height; ++y) {
+			auto src = straight.data() + static_cast<ptrdiff_t>(y) * stride;
+			auto dest = view.row(y);
+			for (int x = 0; x < width; ++x) {
+				rgba_pixel p;
+				memcpy(&p, src + x * 4, 4);
+				dest[x] = pixel_traits<format::argb32>::from_rgba(p);
+			}
+		}
+	}) / 1000.0, "ms");
+	for (auto p : { parallelism::sequential, parallelism::parallel }) {
+		benchmark::report(p == parallelism::sequential ? "4K rgba8 to argb32, convert_pixels" : "4K rgba8 to argb32, convert_pixels, parallel", benchmark::time_us(iterations, [&]() {
+			convert_pixels(straight.data(), stride, interchange_format::rgba8, pixels.data(), pixels.stride(), format::argb32, width, height, p);
+		}) / 1000.0, "ms");
+	}
+	return 0;
+}
@@ -0,0 +1,40 @@
+// Cost of surface::save and restore by nesting depth and by the length of the immediate path, which save() used to copy.
+// Each level sets one property and appends one segment, as drawing code that saves around a change usually does.
+#include "io2d.h"
+#include "benchmark.h"
+
+using namespace std;
+using namespace std::experimental::io2d;
+
+namespace {
+	void run(int segments, int depth) {
+		image_surface s(format::argb32, 64, 64);
+		s.immediate().move_to({ 0.0, 0.0 });
+		for (int i = 0; i < segments; ++i) {
+			s.immediate().line_to({ i * 0.05, (i % 7) * 1.0 });
+		}
+		const int iterations = 200000 / depth;
+		auto us = benchmark::time_us(iterations, [&]() {
+			for (int i = 0; i < depth; ++i) {
+				s.save();
+				s.line_width(1.0 + i);
+				s.immediate().line_to({ i * 1.0, 2.0 });
+			}
+			for (int i = 0; i < depth; ++i) {
+				s.restore();
+			}
+		});
+		char name[64];
+		snprintf(name, sizeof(name), "%d segments, depth %d", segments, depth);
+		benchmark::report(name, us * 1000.0 / depth, "ns per save/restore pair");
+	}
+}
+
+int main() {
+	run(0, 1);
+	run(0, 64);
+	run(100, 8);
+	run(1000, 1);
+	run(1000, 64);
+	return 0;
+}
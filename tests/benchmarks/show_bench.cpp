@@ -0,0 +1,167 @@
+// What display_surface::show() costs on a real X server ($DISPLAY): the CPU a window uses at each refresh_rate when it has
+// little or nothing to draw, and how long a frame takes to present when everything is redrawn against when only a small
+// square is. Each case closes its window after a few seconds the way a window manager would, with WM_DELETE_WINDOW.
+// Run with IO2D_DISABLE=shm to see what presenting over the X connection costs instead of through MIT-SHM.
+#include "io2d.h"
+#include "benchmark.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <sys/resource.h>
+
+using namespace std;
+using namespace std::chrono;
+using namespace std::experimental::io2d;
+
+namespace {
+	const int width = 1280;
+	const int height = 720;
+	const auto runTime = seconds(3);
+
+	double cpu_seconds() {
+		rusage usage;
+		getrusage(RUSAGE_SELF, &usage);
+		return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1'000'000.0;
+	}
+
+#if defined(USE_XCB)
+	xcb_atom_t intern(xcb_connection_t* c, const char* name) {
+		unique_ptr<xcb_intern_atom_reply_t, decltype(&::free)> reply(xcb_intern_atom_reply(c, xcb_intern_atom(c, 0, static_cast<uint16_t>(strlen(name)), name), nullptr), &::free);
+		return reply == nullptr ? XCB_ATOM_NONE : reply->atom;
+	}
+
+	void close_window(const display_surface& ds) {
+		auto handle = ds.native_handle();
+		xcb_client_message_event_t message{};
+		message.response_type = XCB_CLIENT_MESSAGE;
+		message.format = 32;
+		message.window = handle.wndw;
+		message.type = intern(handle.connection, "WM_PROTOCOLS");
+		message.data.data32[0] = intern(handle.connection, "WM_DELETE_WINDOW");
+		xcb_send_event(handle.connection, 0, handle.wndw, XCB_EVENT_MASK_NO_EVENT, reinterpret_cast<const char*>(&message));
+		xcb_flush(handle.connection);
+	}
+#elif defined(USE_XLIB)
+	void close_window(const display_surface& ds) {
+		auto handle = ds.native_handle();
+		XEvent message{};
+		message.xclient.type = ClientMessage;
+		message.xclient.window = handle.wndw;
+		message.xclient.format = 32;
+		message.xclient.message_type = XInternAtom(handle.display, "WM_PROTOCOLS", False);
+		message.xclient.data.l[0] = static_cast<long>(XInternAtom(handle.display, "WM_DELETE_WINDOW", False));
+		XSendEvent(handle.display, handle.wndw, False, NoEventMask, &message);
+		XFlush(handle.display);
+	}
+#endif
+
+	struct run_result {
+		double cpuPercent;
+		int frames;
+		double seconds;
+	};
+
+	// Shows ds for runTime, calling poke every pokeInterval from another thread if it is given.
+	run_result run(display_surface& ds, const function<void(display_surface&)>& draw, void(*poke)(display_surface&) = nullptr, milliseconds pokeInterval = milliseconds(0)) {
+		int frames = 0;
+		ds.draw_callback([&](display_surface& s) {
+			++frames;
+			draw(s);
+		});
+		thread closer([&]() {
+			auto end = steady_clock::now() + runTime;
+			while (steady_clock::now() < end) {
+				this_thread::sleep_for(poke != nullptr ? pokeInterval : runTime);
+				if (poke != nullptr) {
+					poke(ds);
+				}
+			}
+			close_window(ds);
+		});
+		auto cpuStart = cpu_seconds();
+		auto start = steady_clock::now();
+		ds.show();
+		auto elapsed = duration<double>(steady_clock::now() - start).count();
+		auto cpu = cpu_seconds() - cpuStart;
+		closer.join();
+		return{ 100.0 * cpu / elapsed, frames, elapsed };
+	}
+
+	void fill_all(display_surface& s) {
+		s.paint(rgba_color(0.1, 0.2, 0.3, 1.0));
+	}
+
+	// A 32x32 square that moves a pixel a frame over the background, so each frame damages two small areas: where the
+	// square was and where it is.
+	struct square_mover {
+		int x = -1;
+
+		void operator()(display_surface& s) {
+			const rgba_color background(0.1, 0.2, 0.3, 1.0);
+			if (x < 0) {
+				s.paint(background);
+			}
+			else {
+				s.immediate().clear();
+				s.immediate().rectangle({ 40.0 + x, 40.0, 32.0, 32.0 });
+				s.fill_immediate(background);
+			}
+			x = (x + 1) % 500;
+			s.immediate().clear();
+			s.immediate().rectangle({ 40.0 + x, 40.0, 32.0, 32.0 });
+			s.fill_immediate(rgba_color(1.0, 0.5, 0.0, 1.0));
+		}
+	};
+
+	void report_idle(const char* name, const run_result& r) {
+		benchmark::report(name, r.cpuPercent, "% CPU");
+		char framesName[96];
+		snprintf(framesName, sizeof(framesName), "  frames drawn in %.1f s", r.seconds);
+		benchmark::report(framesName, r.frames, "frames");
+	}
+
+	void report_frame_time(const char* name, const run_result& r) {
+		benchmark::report(name, r.frames == 0 ? 0.0 : r.seconds * 1'000'000.0 / r.frames, "us/frame");
+	}
+}
+
+int main() {
+	if (getenv("DISPLAY") == nullptr) {
+		printf("show_bench needs an X server; DISPLAY is not set.\n");
+		return 0;
+	}
+#if defined(USE_XLIB)
+	// The windows are closed from another thread.
+	XInitThreads();
+#endif
+	{
+		display_surface ds(width, height, format::argb32, scaling::letterbox, refresh_rate::as_needed);
+		report_idle("as_needed, nothing to redraw", run(ds, fill_all));
+	}
+	{
+		display_surface ds(width, height, format::argb32, scaling::letterbox, refresh_rate::as_needed);
+		report_idle("as_needed, redraw_required() 10 times/s", run(ds, fill_all, [](display_surface& s) { s.redraw_required(); }, milliseconds(100)));
+	}
+	{
+		display_surface ds(width, height, format::argb32, scaling::letterbox, refresh_rate::fixed, 30.0);
+		report_idle("fixed, 30 fps", run(ds, fill_all));
+	}
+	{
+		display_surface ds(width, height, format::argb32, scaling::letterbox, refresh_rate::as_fast_as_possible);
+		report_frame_time("as_fast_as_possible, whole frame redrawn", run(ds, fill_all));
+	}
+	{
+		display_surface ds(width, height, format::argb32, scaling::letterbox, refresh_rate::as_fast_as_possible);
+		report_frame_time("as_fast_as_possible, 32x32 square moved", run(ds, square_mover()));
+	}
+	{
+		// Scaled to twice the size, so that damage has to be mapped through the filter.
+		display_surface ds(width / 2, height / 2, format::argb32, width, height, scaling::uniform, refresh_rate::as_fast_as_possible);
+		report_frame_time("as_fast_as_possible, 32x32 square moved, 2x scaled", run(ds, square_mover()));
+	}
+	return 0;
+}
@@ -0,0 +1,91 @@
+// What drawing many 16x16 tiles from an atlas costs per tile: one clip and paint per tile, one blit per tile, and one
+// draw_sprites call for all of them, with and without an alpha per tile.
+#include "io2d.h"
+#include "benchmark.h"
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+using namespace std::experimental::io2d;
+
+namespace {
+	const int width = 1920;
+	const int height = 1080;
+	const int atlasSize = 256;
+	const int tileSize = 16;
+
+	void fill_with_noise(image_surface& s) {
+		auto pixels = s.pixels();
+		uint32_t state = 12345;
+		for (int y = 0; y < pixels.height(); ++y) {
+			auto row = reinterpret_cast<uint32_t*>(pixels.row(y));
+			for (int x = 0; x < pixels.width(); ++x) {
+				state = state * 1664525u + 1013904223u;
+				// Premultiplied: no channel above alpha.
+				uint32_t a = state >> 24;
+				uint32_t c = (state >> 8) & 0xff;
+				c = c * a / 255;
+				row[x] = (a << 24) | (c << 16) | (c << 8) | c;
+			}
+		}
+	}
+}
+
+int main() {
+	image_surface dst(format::argb32, width, height);
+	image_surface atlas(format::argb32, atlasSize, atlasSize);
+	fill_with_noise(atlas);
+
+	for (int count : { 10000, 100000, 1000000 }) {
+		// Tiles from all over the atlas, at whole pixel positions all over the surface.
+		vector<rectangle> srcRects;
+		vector<vector_2d> dstPoints;
+		vector<double> alphas;
+		uint32_t state = 777;
+		for (int i = 0; i < count; ++i) {
+			state = state * 1664525u + 1013904223u;
+			const auto tiles = atlasSize / tileSize;
+			srcRects.push_back({ static_cast<double>((state >> 8) % tiles * tileSize), static_cast<double>((state >> 16) % tiles * tileSize), static_cast<double>(tileSize), static_cast<double>(tileSize) });
+			state = state * 1664525u + 1013904223u;
+			dstPoints.push_back({ static_cast<double>((state >> 8) % (width - tileSize)), static_cast<double>((state >> 20) % (height - tileSize)) });
+			alphas.push_back(0.25 + (i % 4) * 0.25);
+		}
+
+		char name[64];
+		snprintf(name, sizeof(name), "%d tiles, clip and paint each", count);
+		benchmark::report(name, benchmark::time_us(1, [&]() {
+			for (size_t i = 0; i < srcRects.size(); ++i) {
+				const auto& r = srcRects[i];
+				const auto& p = dstPoints[i];
+				dst.save();
+				dst.immediate().clear();
+				dst.immediate().rectangle({ p.x(), p.y(), r.width(), r.height() });
+				dst.clip_immediate();
+				dst.paint(atlas, matrix_2d::init_translate({ r.x() - p.x(), r.y() - p.y() }));
+				dst.restore();
+			}
+			dst.flush();
+		}) * 1000.0 / count, "ns/tile");
+
+		snprintf(name, sizeof(name), "%d tiles, blit each", count);
+		benchmark::report(name, benchmark::time_us(1, [&]() {
+			for (size_t i = 0; i < srcRects.size(); ++i) {
+				dst.blit(atlas, srcRects[i], dstPoints[i]);
+			}
+			dst.flush();
+		}) * 1000.0 / count, "ns/tile");
+
+		snprintf(name, sizeof(name), "%d tiles, draw_sprites", count);
+		benchmark::report(name, benchmark::time_us(1, [&]() {
+			dst.draw_sprites(atlas, srcRects, dstPoints);
+			dst.flush();
+		}) * 1000.0 / count, "ns/tile");
+
+		snprintf(name, sizeof(name), "%d tiles, draw_sprites with alphas", count);
+		benchmark::report(name, benchmark::time_us(1, [&]() {
+			dst.draw_sprites(atlas, srcRects, dstPoints, alphas);
+			dst.flush();
+		}) * 1000.0 / count, "ns/tile");
+	}
+	return 0;
+}
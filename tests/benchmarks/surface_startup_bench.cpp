@@ -0,0 +1,97 @@
+// What creating a small image_surface costs, in time and in heap allocations, for programs that make many of them (one per
+// sprite, tile or glyph cache entry). With glibc every malloc is counted, which includes cairo's and pixman's.
+#include "io2d.h"
+#include "benchmark.h"
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+
+using namespace std;
+using namespace std::experimental::io2d;
+
+namespace {
+	bool counting = false;
+	long long mallocs = 0;
+	long long mallocBytes = 0;
+}
+
+#if defined(__GLIBC__)
+// glibc lets a program replace malloc and friends; these count the calls and forward to glibc's own.
+extern "C" {
+	void* __libc_malloc(size_t n);
+	void* __libc_calloc(size_t count, size_t n);
+	void* __libc_realloc(void* p, size_t n);
+	void* __libc_memalign(size_t alignment, size_t n);
+	void __libc_free(void* p);
+
+	void* malloc(size_t n) {
+		if (counting) {
+			++mallocs;
+			mallocBytes += static_cast<long long>(n);
+		}
+		return __libc_malloc(n);
+	}
+	void* calloc(size_t count, size_t n) {
+		if (counting) {
+			++mallocs;
+			mallocBytes += static_cast<long long>(count * n);
+		}
+		return __libc_calloc(count, n);
+	}
+	void* realloc(void* p, size_t n) {
+		if (counting) {
+			++mallocs;
+			mallocBytes += static_cast<long long>(n);
+		}
+		return __libc_realloc(p, n);
+	}
+	int posix_memalign(void** p, size_t alignment, size_t n) {
+		if (counting) {
+			++mallocs;
+			mallocBytes += static_cast<long long>(n);
+		}
+		*p = __libc_memalign(alignment, n);
+		return *p == nullptr ? 12 : 0;
+	}
+	void free(void* p) {
+		__libc_free(p);
+	}
+}
+const bool counts_malloc = true;
+#else
+const bool counts_malloc = false;
+#endif
+
+int main() {
+	const int count = 10000;
+	const int size = 16;
+	vector<image_surface> surfaces;
+	surfaces.reserve(count);
+
+	// The first surface creates what every later one shares.
+	surfaces.emplace_back(format::argb32, size, size);
+	surfaces.clear();
+
+	mallocs = 0;
+	mallocBytes = 0;
+	counting = true;
+	auto start = chrono::steady_clock::now();
+	for (int i = 0; i < count; ++i) {
+		surfaces.emplace_back(format::argb32, size, size);
+	}
+	auto end = chrono::steady_clock::now();
+	counting = false;
+
+	benchmark::report("create a 16x16 image_surface", chrono::duration<double, nano>(end - start).count() / count, "ns/surface");
+	if (counts_malloc) {
+		benchmark::report("allocations", static_cast<double>(mallocs) / count, "per surface");
+		benchmark::report("heap bytes", static_cast<double>(mallocBytes) / count, "per surface");
+	}
+
+	// Destroying them is part of the cost of a short-lived surface too.
+	start = chrono::steady_clock::now();
+	surfaces.clear();
+	end = chrono::steady_clock::now();
+	benchmark::report("destroy a 16x16 image_surface", chrono::duration<double, nano>(end - start).count() / count, "ns/surface");
+	return 0;
+}
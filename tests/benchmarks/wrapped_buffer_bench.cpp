@@ -0,0 +1,46 @@
+// What drawing an overlay on a video frame costs when the frame has to be copied into an image_surface and back out,
+// against drawing straight into the frame's own buffer.
+#include "io2d.h"
+#include "benchmark.h"
+#include <vector>
+
+using namespace std;
+using namespace std::experimental::io2d;
+
+namespace {
+	const int width = 1280;
+	const int height = 720;
+
+	void draw_overlay(image_surface& s) {
+		s.immediate().clear();
+		s.immediate().rectangle({ 40.0, 600.0, 400.0, 80.0 });
+		s.fill_immediate(rgba_color(0.0, 0.0, 0.0, 0.5));
+	}
+}
+
+int main() {
+	const int iterations = 200;
+	const int stride = format_stride_for_width(format::argb32, width);
+	vector<unsigned char> frame(static_cast<size_t>(stride) * height, 0x80);
+
+	benchmark::report("copy in, draw, copy out", benchmark::time_us(iterations, [&]() {
+		image_surface s(frame, format::argb32, width, height);
+		draw_overlay(s);
+		frame = s.data();
+	}), "us/frame");
+
+	benchmark::report("wrap, draw", benchmark::time_us(iterations, [&]() {
+		image_surface s(frame.data(), format::argb32, width, height, stride);
+		draw_overlay(s);
+		s.flush();
+	}), "us/frame");
+
+	// A capture loop that reuses its buffers can keep one surface per buffer.
+	image_surface wrapped(frame.data(), format::argb32, width, height, stride);
+	benchmark::report("draw into a kept wrapper", benchmark::time_us(iterations, [&]() {
+		wrapped.mark_dirty();
+		draw_overlay(wrapped);
+		wrapped.flush();
+	}), "us/frame");
+	return 0;
+}
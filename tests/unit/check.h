@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdio>
+
+// Each test is a program that reports every failed check and exits with a non-zero status if there was one.
+namespace check {
+	inline int& failures() {
+		static int count = 0;
+		return count;
+	}
+
+	inline void fail(const char* file, int line, const char* expression) {
+		::std::printf("%s:%d: check failed: %s\n", file, line, expression);
+		++failures();
+	}
+
+	inline int result() {
+		if (failures() != 0) {
+			::std::printf("%d check(s) failed\n", failures());
+			return 1;
+		}
+		return 0;
+	}
+}
+
+#define CHECK(expression) do { if (!(expression)) { ::check::fail(__FILE__, __LINE__, #expression); } } while (false)
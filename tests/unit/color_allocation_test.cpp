@@ -0,0 +1,238 @@
+// The rgba_color overloads of the drawing functions must not allocate: no brush, no pattern, nothing of io2d's own.
+// Every operator new is counted, and with glibc every malloc as well, which includes cairo's and pixman's. cairo itself
+// still allocates for some operations (a scan converter for fills that are not boxes, a pixman image for colors it cannot
+// fill spans with directly), so those are checked to allocate no more than the same drawing done with cairo directly.
+#include "io2d.h"
+#include "check.h"
+#include <cairo.h>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+using namespace std;
+using namespace std::experimental::io2d;
+
+namespace {
+	bool counting = false;
+	long long news = 0;
+	long long mallocs = 0;
+}
+
+void* operator new(size_t n) {
+	if (counting) {
+		++news;
+	}
+	if (auto p = malloc(n == 0 ? 1 : n)) {
+		return p;
+	}
+	throw bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+	free(p);
+}
+
+#if defined(__GLIBC__)
+// glibc lets a program replace malloc and friends; these count the calls and forward to glibc's own.
+extern "C" {
+	void* __libc_malloc(size_t n);
+	void* __libc_calloc(size_t count, size_t n);
+	void* __libc_realloc(void* p, size_t n);
+	void* __libc_memalign(size_t alignment, size_t n);
+	void __libc_free(void* p);
+
+	void* malloc(size_t n) {
+		if (counting) {
+			++mallocs;
+		}
+		return __libc_malloc(n);
+	}
+	void* calloc(size_t count, size_t n) {
+		if (counting) {
+			++mallocs;
+		}
+		return __libc_calloc(count, n);
+	}
+	void* realloc(void* p, size_t n) {
+		if (counting) {
+			++mallocs;
+		}
+		return __libc_realloc(p, n);
+	}
+	int posix_memalign(void** p, size_t alignment, size_t n) {
+		if (counting) {
+			++mallocs;
+		}
+		*p = __libc_memalign(alignment, n);
+		return *p == nullptr ? 12 : 0;
+	}
+	void free(void* p) {
+		__libc_free(p);
+	}
+}
+const bool counts_malloc = true;
+#else
+const bool counts_malloc = false;
+#endif
+
+namespace {
+	struct counts {
+		long long news;
+		long long mallocs;
+	};
+
+	// Counts over many calls, after a few that may fill caches, with a different color each time.
+	template <class Draw>
+	counts count(Draw&& draw) {
+		for (int i = 0; i < 5; ++i) {
+			draw(i);
+		}
+		news = 0;
+		mallocs = 0;
+		counting = true;
+		for (int i = 0; i < 100; ++i) {
+			draw(i);
+		}
+		counting = false;
+		return{ news, mallocs };
+	}
+
+	rgba_color color(int i, double alpha = 1.0) {
+		return rgba_color((i % 10) / 10.0, 0.5, 0.25, alpha);
+	}
+
+	void set_color(cairo_t* cr, int i, double alpha = 1.0) {
+		cairo_set_source_rgba(cr, (i % 10) / 10.0, 0.5, 0.25, alpha);
+	}
+
+	// Checks that io2d allocates nothing of its own and that cairo, counted with it, allocates no more than perDraw times per
+	// draw.
+	template <class Io2d>
+	void check_at_most(const char* name, long long perDraw, Io2d&& io2d) {
+		auto a = count(io2d);
+		printf("%-40s io2d: %lld new, %lld malloc\n", name, a.news, a.mallocs);
+		CHECK(a.news == 0);
+		CHECK(a.mallocs <= perDraw * 100);
+	}
+
+	// Checks that io2d allocates nothing of its own and that cairo, counted with it, needs no more than it does alone.
+	template <class Io2d, class Cairo>
+	void check_no_more_than_cairo(const char* name, Io2d&& io2d, Cairo&& cairo) {
+		auto a = count(io2d);
+		auto b = count(cairo);
+		printf("%-40s io2d: %lld new, %lld malloc; cairo alone: %lld malloc\n", name, a.news, a.mallocs, b.mallocs);
+		CHECK(a.news == 0);
+		CHECK(a.mallocs <= b.mallocs);
+	}
+
+	template <class Io2d>
+	void check_none(const char* name, Io2d&& io2d) {
+		check_at_most(name, 0, io2d);
+	}
+}
+
+int main() {
+	image_surface s(format::argb32, 200, 200);
+	image_surface maskSurface(format::a8, 200, 200);
+	maskSurface.paint(rgba_color(0.0, 0.0, 0.0, 0.5));
+	auto cs = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 200, 200);
+	auto cr = cairo_create(cs);
+	auto cmask = cairo_image_surface_create(CAIRO_FORMAT_A8, 200, 200);
+	auto cmaskContext = cairo_create(cmask);
+	cairo_set_source_rgba(cmaskContext, 0.0, 0.0, 0.0, 0.5);
+	cairo_paint(cmaskContext);
+	cairo_destroy(cmaskContext);
+
+	path_factory pf;
+	pf.rectangle({ 20.0, 20.0, 100.0, 80.0 });
+	path box(pf);
+	pf.clear();
+	pf.move_to({ 10.0, 10.0 });
+	pf.line_to({ 150.0, 30.0 });
+	pf.line_to({ 40.0, 170.0 });
+	pf.close_path();
+	path triangle(pf);
+	s.immediate() = pf;
+
+	// Setting the path allocates, so each check sets it once and then draws with it repeatedly.
+	// Opaque colors on whole-pixel boxes are what cairo fills without any allocation of its own.
+	s.path(box);
+	check_none("fill(color), box", [&](int i) { s.fill(color(i)); });
+	check_none("stroke(color), box", [&](int i) { s.stroke(color(i)); });
+	check_none("paint(color)", [&](int i) { s.paint(color(i)); });
+
+	// A heat map: a grid of cells with a color each, all different. Opaque colors are stored straight into the surface;
+	// translucent ones share a single source per call, which fits all 256 cells.
+	vector<rectangle> cells;
+	vector<rgba_color> opaqueCells[2];
+	vector<rgba_color> translucentCells[2];
+	for (int y = 0; y < 16; ++y) {
+		for (int x = 0; x < 16; ++x) {
+			cells.push_back({ x * 10.0, y * 10.0, 10.0, 10.0 });
+			for (int i = 0; i < 2; ++i) {
+				opaqueCells[i].push_back(rgba_color(x / 16.0, y / 16.0, i * 0.5, 1.0));
+				translucentCells[i].push_back(rgba_color(x / 16.0, y / 16.0, i * 0.5, 0.25 + (x + y) / 64.0));
+			}
+		}
+	}
+	check_none("fill_rectangles(colors), opaque", [&](int i) { s.fill_rectangles(cells, opaqueCells[i % 2]); });
+	check_at_most("fill_rectangles(colors), translucent", 1, [&](int i) { s.fill_rectangles(cells, translucentCells[i % 2]); });
+
+	check_no_more_than_cairo("fill(color), translucent box", [&](int i) { s.fill(color(i, 0.5)); }, [&](int i) {
+		cairo_append_path(cr, box.native_handle());
+		set_color(cr, i, 0.5);
+		cairo_fill(cr);
+	});
+	s.path(triangle);
+	check_no_more_than_cairo("fill(color), triangle", [&](int i) { s.fill(color(i)); }, [&](int i) {
+		cairo_append_path(cr, triangle.native_handle());
+		set_color(cr, i);
+		cairo_fill(cr);
+	});
+	check_no_more_than_cairo("stroke(color), triangle", [&](int i) { s.stroke(color(i)); }, [&](int i) {
+		cairo_append_path(cr, triangle.native_handle());
+		set_color(cr, i);
+		cairo_stroke(cr);
+	});
+	check_no_more_than_cairo("fill_immediate(color)", [&](int i) { s.fill_immediate(color(i)); }, [&](int i) {
+		cairo_append_path(cr, triangle.native_handle());
+		set_color(cr, i);
+		cairo_fill(cr);
+	});
+	check_no_more_than_cairo("stroke_immediate(color)", [&](int i) { s.stroke_immediate(color(i)); }, [&](int i) {
+		cairo_append_path(cr, triangle.native_handle());
+		set_color(cr, i);
+		cairo_stroke(cr);
+	});
+	check_no_more_than_cairo("paint(color, alpha)", [&](int i) { s.paint(color(i), 0.5); }, [&](int i) {
+		set_color(cr, i);
+		cairo_paint_with_alpha(cr, 0.5);
+	});
+	check_no_more_than_cairo("mask(surface, color)", [&](int i) { s.mask(maskSurface, color(i)); }, [&](int i) {
+		set_color(cr, i);
+		cairo_mask_surface(cr, cmask, 0.0, 0.0);
+	});
+	check_no_more_than_cairo("mask_immediate(surface, color)", [&](int i) { s.mask_immediate(maskSurface, color(i)); }, [&](int i) {
+		set_color(cr, i);
+		cairo_mask_surface(cr, cmask, 0.0, 0.0);
+	});
+
+	// The same font on both, so that cairo's glyph cache is the only one involved.
+	s.render_text("Hello", { 20.0, 100.0 }, color(0));
+	cairo_set_scaled_font(cr, cairo_get_scaled_font(s.native_handle().cctxt));
+	check_no_more_than_cairo("render_text(color)", [&](int i) { s.render_text("Hello", { 20.0, 100.0 }, color(i)); }, [&](int i) {
+		cairo_move_to(cr, 20.0, 100.0);
+		set_color(cr, i);
+		cairo_show_text(cr, "Hello");
+		cairo_new_path(cr);
+	});
+
+	if (!counts_malloc) {
+		printf("malloc is not counted with this C library; only operator new was checked\n");
+	}
+	cairo_surface_destroy(cmask);
+	cairo_destroy(cr);
+	cairo_surface_destroy(cs);
+	return check::result();
+}
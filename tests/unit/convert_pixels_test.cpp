@@ -0,0 +1,109 @@
+// convert_pixels must give exactly what pixel_traits gives, pixel for pixel, whichever of its loops runs: every alpha and
+// channel pair through the argb32 kernels, at every row length up to a few vectors so that each loop's remainder runs too.
+// Run again with IO2D_DISABLE=avx2 to check the SSE2 loop on CPUs that have AVX2.
+#include "io2d.h"
+#include "check.h"
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+using namespace std;
+using namespace std::experimental::io2d;
+
+namespace {
+	uint32_t load(const unsigned char* p) {
+		uint32_t v;
+		memcpy(&v, p, sizeof(v));
+		return v;
+	}
+
+	void store(unsigned char* p, uint32_t v) {
+		memcpy(p, &v, sizeof(v));
+	}
+
+	// Every alpha with every channel value, valid (channel <= alpha) or not, in the given order of the channels.
+	vector<unsigned char> every_argb32_pixel() {
+		vector<unsigned char> result(256 * 256 * 4);
+		for (uint32_t a = 0; a < 256; ++a) {
+			for (uint32_t c = 0; c < 256; ++c) {
+				auto i = a * 256 + c;
+				store(&result[i * 4], (a << 24) | (c << 16) | (((c * 7) & 0xffu) << 8) | (255 - c));
+			}
+		}
+		return result;
+	}
+
+	bool matches_traits_to(const vector<unsigned char>& src, const vector<unsigned char>& dest, int count, bool bgra) {
+		for (int i = 0; i < count; ++i) {
+			auto p = pixel_traits<format::argb32>::to_rgba(load(&src[i * 4]));
+			const unsigned char expected[4] = { bgra ? p.b : p.r, p.g, bgra ? p.r : p.b, p.a };
+			if (memcmp(&dest[i * 4], expected, 4) != 0) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool matches_traits_from(const vector<unsigned char>& src, const vector<unsigned char>& dest, int count, bool bgra) {
+		for (int i = 0; i < count; ++i) {
+			auto s = &src[i * 4];
+			rgba_pixel p{ bgra ? s[2] : s[0], s[1], bgra ? s[0] : s[2], s[3] };
+			if (load(&dest[i * 4]) != pixel_traits<format::argb32>::from_rgba(p)) {
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+int main() {
+	const auto pixels = every_argb32_pixel();
+	const int count = static_cast<int>(pixels.size() / 4);
+	for (auto fmt : { interchange_format::rgba8, interchange_format::bgra8 }) {
+		const bool bgra = fmt == interchange_format::bgra8;
+		// All of them in one row, then the same bytes read back as interchange pixels.
+		vector<unsigned char> out(pixels.size());
+		convert_pixels(pixels.data(), count * 4, format::argb32, out.data(), count * 4, fmt, count, 1);
+		CHECK(matches_traits_to(pixels, out, count, bgra));
+		convert_pixels(pixels.data(), count * 4, fmt, out.data(), count * 4, format::argb32, count, 1);
+		CHECK(matches_traits_from(pixels, out, count, bgra));
+
+		// Rows of every length up to three AVX2 vectors, starting at an odd pixel so that no load is aligned.
+		for (int width = 1; width <= 25; ++width) {
+			const int rows = 3;
+			vector<unsigned char> src(pixels.begin() + 4 * 1001, pixels.begin() + 4 * (1001 + width * rows));
+			vector<unsigned char> to(src.size());
+			vector<unsigned char> from(src.size());
+			convert_pixels(src.data(), width * 4, format::argb32, to.data(), width * 4, fmt, width, rows);
+			CHECK(matches_traits_to(src, to, width * rows, bgra));
+			convert_pixels(src.data(), width * 4, fmt, from.data(), width * 4, format::argb32, width, rows);
+			CHECK(matches_traits_from(src, from, width * rows, bgra));
+		}
+	}
+
+	// Converting a valid premultiplied pixel to straight alpha and back gives it back.
+	vector<unsigned char> valid;
+	for (uint32_t a = 0; a < 256; ++a) {
+		for (uint32_t c = 0; c <= a; ++c) {
+			valid.resize(valid.size() + 4);
+			store(&valid[valid.size() - 4], (a << 24) | (c << 16) | ((c / 2) << 8) | (a - c));
+		}
+	}
+	const int validCount = static_cast<int>(valid.size() / 4);
+	vector<unsigned char> straight(valid.size());
+	vector<unsigned char> back(valid.size());
+	convert_pixels(valid.data(), validCount * 4, format::argb32, straight.data(), validCount * 4, interchange_format::rgba8, validCount, 1);
+	convert_pixels(straight.data(), validCount * 4, interchange_format::rgba8, back.data(), validCount * 4, format::argb32, validCount, 1);
+	CHECK(valid == back);
+
+	// Bad arguments are reported, not converted.
+	error_code ec;
+	vector<unsigned char> dest(64);
+	convert_pixels(nullptr, 16, format::argb32, dest.data(), 16, interchange_format::rgba8, 4, 1, ec);
+	CHECK(ec);
+	convert_pixels(valid.data(), 8, format::argb32, dest.data(), 16, interchange_format::rgba8, 4, 1, ec);
+	CHECK(ec);
+	convert_pixels(valid.data(), 16, format::argb32, dest.data(), 16, interchange_format::rgba8, 4, 1, ec);
+	CHECK(!ec);
+	return check::result();
+}
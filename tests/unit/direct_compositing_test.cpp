@@ -0,0 +1,176 @@
+// blit, draw_sprites and fill_rectangles go straight to pixman when they can. Whatever the operator, alpha and clip, they
+// must give exactly the pixels that clipping to each rectangle and painting or filling it the usual way gives, both where
+// they take that path and where they fall back to the usual one.
+#include "io2d.h"
+#include "check.h"
+#include "surfaces.h"
+#include <cstdio>
+#include <vector>
+
+using namespace std;
+using namespace std::experimental::io2d;
+
+namespace {
+	const int width = 97;
+	const int height = 83;
+
+	const compositing_operator operators[] = {
+		compositing_operator::over, compositing_operator::clear, compositing_operator::source, compositing_operator::in,
+		compositing_operator::out, compositing_operator::atop, compositing_operator::dest, compositing_operator::dest_over,
+		compositing_operator::dest_in, compositing_operator::dest_out, compositing_operator::dest_atop, compositing_operator::xor_op,
+		compositing_operator::add, compositing_operator::saturate, compositing_operator::multiply, compositing_operator::screen,
+		compositing_operator::overlay, compositing_operator::darken, compositing_operator::lighten, compositing_operator::color_dodge,
+		compositing_operator::color_burn, compositing_operator::hard_light, compositing_operator::soft_light, compositing_operator::difference,
+		compositing_operator::exclusion, compositing_operator::hsl_hue, compositing_operator::hsl_saturation, compositing_operator::hsl_color,
+		compositing_operator::hsl_luminosity
+	};
+
+	// No clip, a clip of whole pixels and one that is not, which has to be drawn the usual way.
+	const int clipCount = 3;
+
+	image_surface destination(int clip, format fmt = format::argb32) {
+		image_surface s(fmt, width, height);
+		if (fmt == format::argb32 || fmt == format::xrgb32) {
+			surfaces::fill_with_noise(s, 777);
+		}
+		else {
+			s.paint(rgba_color(0.3, 0.6, 0.2, 0.7));
+		}
+		if (clip == 1) {
+			s.immediate().rectangle({ 6.0, 9.0, 70.0, 51.0 });
+			s.clip_immediate();
+		}
+		else if (clip == 2) {
+			s.immediate().rectangle({ 6.5, 9.25, 70.0, 51.0 });
+			s.clip_immediate();
+		}
+		s.immediate().clear();
+		return s;
+	}
+
+	// What painting src at alpha over r (in s's user space), with src's (sx, sy) at r's corner, does the usual way.
+	void paint_the_usual_way(image_surface& s, const image_surface& src, const rectangle& r, double sx, double sy, double alpha, compositing_operator co) {
+		s.save();
+		s.immediate().clear();
+		s.immediate().rectangle(r);
+		s.clip_immediate();
+		s.immediate().clear();
+		s.compositing_operator(co);
+		s.paint(src, alpha, matrix_2d::init_translate({ sx - r.x(), sy - r.y() }), extend::none, filter::good);
+		s.restore();
+	}
+
+	void fill_the_usual_way(image_surface& s, const rectangle& r, const rgba_color& c, compositing_operator co) {
+		s.save();
+		s.compositing_operator(co);
+		s.immediate().clear();
+		s.immediate().rectangle(r);
+		s.fill_immediate(c);
+		s.immediate().clear();
+		s.restore();
+	}
+
+	bool check_blit(const image_surface& atlas, compositing_operator co, int clip) {
+		// Whole pixels, then a rectangle reaching past the atlas and a fractional one, which are drawn the usual way.
+		const rectangle srcRects[] = { { 3.0, 4.0, 40.0, 30.0 }, { 80.0, 70.0, 40.0, 30.0 }, { 3.5, 4.0, 20.25, 30.0 } };
+		const vector_2d dstPoints[] = { { 10.0, 12.0 }, { 30.0, 20.0 }, { 50.0, 41.5 } };
+		auto fast = destination(clip);
+		auto expected = destination(clip);
+		for (int i = 0; i < 3; ++i) {
+			fast.blit(atlas, srcRects[i], dstPoints[i], co);
+			paint_the_usual_way(expected, atlas, { dstPoints[i].x(), dstPoints[i].y(), srcRects[i].width(), srcRects[i].height() }, srcRects[i].x(), srcRects[i].y(), 1.0, co);
+		}
+		return surfaces::same_pixels(fast, expected);
+	}
+
+	bool check_sprites(const image_surface& atlas, compositing_operator co, int clip) {
+		// Overlapping, so that the order counts; alphas that repeat, so that masks are shared; one sprite that is not at a
+		// whole pixel offset, splitting the run.
+		vector<rectangle> srcRects;
+		vector<vector_2d> dstPoints;
+		vector<double> alphas;
+		for (int i = 0; i < 12; ++i) {
+			srcRects.push_back({ 2.0 + (i * 7) % 60, 3.0 + (i * 5) % 50, 16.0 + i % 3, 12.0 + i % 4 });
+			dstPoints.push_back({ 4.0 + (i * 11) % 70, (i == 7) ? 20.5 : 5.0 + (i * 13) % 60 });
+			alphas.push_back((i % 4 == 3) ? 0.0 : (i < 6) ? 1.0 : 0.25 + (i / 3) * 0.25);
+		}
+		bool same = true;
+		for (int withAlphas = 0; withAlphas < 2; ++withAlphas) {
+			auto fast = destination(clip);
+			auto expected = destination(clip);
+			fast.compositing_operator(co);
+			if (withAlphas != 0) {
+				fast.draw_sprites(atlas, srcRects, dstPoints, alphas);
+			}
+			else {
+				fast.draw_sprites(atlas, srcRects, dstPoints);
+			}
+			for (size_t i = 0; i < srcRects.size(); ++i) {
+				const auto& r = srcRects[i];
+				paint_the_usual_way(expected, atlas, { dstPoints[i].x(), dstPoints[i].y(), r.width(), r.height() }, r.x(), r.y(), withAlphas != 0 ? alphas[i] : 1.0, co);
+			}
+			same = same && surfaces::same_pixels(fast, expected);
+		}
+
+		// The matrix overload, with translations only, takes the same path.
+		vector<matrix_2d> matrices;
+		for (const auto& p : dstPoints) {
+			matrices.push_back(matrix_2d::init_translate(p));
+		}
+		auto fast = destination(clip);
+		auto expected = destination(clip);
+		fast.compositing_operator(co);
+		fast.draw_sprites(atlas, srcRects, matrices, alphas);
+		for (size_t i = 0; i < srcRects.size(); ++i) {
+			const auto& r = srcRects[i];
+			paint_the_usual_way(expected, atlas, { dstPoints[i].x(), dstPoints[i].y(), r.width(), r.height() }, r.x(), r.y(), alphas[i], co);
+		}
+		return same && surfaces::same_pixels(fast, expected);
+	}
+
+	// Filling stores colors in the destination directly where it can, so each format that can be stored in is checked.
+	bool check_fill(compositing_operator co, int clip, format fmt) {
+		const vector<rectangle> rects = { { 2.0, 3.0, 30.0, 20.0 }, { 20.0, 10.0, 40.0, 35.0 }, { 60.0, 50.0, 50.0, 50.0 }, { 10.5, 40.25, 20.0, 9.5 }, { -5.0, 70.0, 20.0, 30.0 } };
+		const vector<rgba_color> colors = { rgba_color(1.0, 0.0, 0.0, 1.0), rgba_color(0.2, 0.6, 0.9, 0.5), rgba_color(0.0, 0.0, 0.0, 0.0), rgba_color(0.3, 0.3, 0.1, 0.75), rgba_color(0.9, 0.8, 0.7, 0.01) };
+		auto fast = destination(clip, fmt);
+		auto expected = destination(clip, fmt);
+		fast.compositing_operator(co);
+		fast.fill_rectangles(rects, colors);
+		for (size_t i = 0; i < rects.size(); ++i) {
+			fill_the_usual_way(expected, rects[i], colors[i], co);
+		}
+		bool same = surfaces::same_pixels(fast, expected);
+
+		// One color for all of them.
+		auto fastOne = destination(clip, fmt);
+		auto expectedOne = destination(clip, fmt);
+		fastOne.compositing_operator(co);
+		fastOne.fill_rectangles(rects, colors[1]);
+		for (const auto& r : rects) {
+			fill_the_usual_way(expectedOne, r, colors[1], co);
+		}
+		return same && surfaces::same_pixels(fastOne, expectedOne);
+	}
+}
+
+int main() {
+	image_surface atlas(format::argb32, width, height);
+	surfaces::fill_with_noise(atlas, 4242);
+	for (auto co : operators) {
+		for (int clip = 0; clip < clipCount; ++clip) {
+			bool blitSame = check_blit(atlas, co, clip);
+			bool spritesSame = check_sprites(atlas, co, clip);
+			bool fillSame = true;
+			for (auto fmt : { format::argb32, format::xrgb32, format::rgb16_565, format::a8 }) {
+				fillSame = check_fill(co, clip, fmt) && fillSame;
+			}
+			if (!blitSame || !spritesSame || !fillSame) {
+				printf("operator %d, clip %d\n", static_cast<int>(co), clip);
+			}
+			CHECK(blitSame);
+			CHECK(spritesSame);
+			CHECK(fillSame);
+		}
+	}
+	return check::result();
+}
@@ -0,0 +1,135 @@
+// The font_resource cache: hits, misses and evictions are counted, the least recently used font leaves first, lowering the
+// capacity trims the cache at once, a capacity of 0 turns it off, threads constructing the same font share one entry, and
+// matrices that differ only in the sign of a zero are the same font.
+#include "io2d.h"
+#include "check.h"
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace std::experimental::io2d;
+
+namespace {
+	font_resource_factory factory(double size) {
+		return font_resource_factory("Sans", font_slant::normal, font_weight::normal, matrix_2d::init_scale({ size, size }));
+	}
+
+	// Empties the cache and its counts and gives it capacity n.
+	void start_over(size_t n) {
+		set_font_resource_cache_capacity(n);
+		clear_font_resource_cache();
+		reset_font_resource_cache_stats();
+	}
+
+	bool stats_are(const char* name, size_t hits, size_t misses, size_t evictions, size_t size) {
+		auto s = get_font_resource_cache_stats();
+		if (s.hits != hits || s.misses != misses || s.evictions != evictions || s.size != size) {
+			printf("%s: expected %zu hits, %zu misses, %zu evictions, size %zu; got %zu, %zu, %zu, %zu\n", name, hits, misses, evictions, size,
+				s.hits, s.misses, s.evictions, s.size);
+			return false;
+		}
+		return true;
+	}
+}
+
+int main() {
+	const auto defaultCapacity = get_font_resource_cache_capacity();
+
+	// A miss puts the font in, a second request for it is a hit, and going past the capacity evicts.
+	{
+		start_over(2);
+		font_resource a(factory(10.0));
+		CHECK(stats_are("first request", 0, 1, 0, 1));
+		font_resource b(factory(10.0));
+		CHECK(stats_are("second request", 1, 1, 0, 1));
+		font_resource c(factory(11.0));
+		font_resource d(factory(12.0));
+		CHECK(stats_are("past the capacity", 1, 3, 1, 2));
+		CHECK(get_font_resource_cache_stats().capacity == 2);
+		// The error_code constructor goes through the same cache.
+		error_code ec;
+		font_resource e(factory(12.0), ec);
+		CHECK(!ec);
+		CHECK(stats_are("error_code constructor", 2, 3, 1, 2));
+	}
+
+	// Using a font makes it the most recently used, so the other one goes first.
+	{
+		start_over(2);
+		font_resource a(factory(10.0));
+		font_resource b(factory(11.0));
+		font_resource a2(factory(10.0));
+		font_resource c(factory(12.0));
+		reset_font_resource_cache_stats();
+		font_resource a3(factory(10.0));
+		font_resource c2(factory(12.0));
+		CHECK(stats_are("recently used kept", 2, 0, 0, 2));
+		font_resource b2(factory(11.0));
+		CHECK(stats_are("least recently used evicted", 2, 1, 1, 2));
+	}
+
+	// Lowering the capacity drops the least recently used entries straight away, and returns the old capacity.
+	{
+		start_over(4);
+		for (double size : { 10.0, 11.0, 12.0, 13.0 }) {
+			font_resource f(factory(size));
+		}
+		reset_font_resource_cache_stats();
+		CHECK(set_font_resource_cache_capacity(2) == 4);
+		CHECK(stats_are("trimmed", 0, 0, 2, 2));
+		font_resource newest(factory(13.0));
+		font_resource next(factory(12.0));
+		CHECK(stats_are("newest kept", 2, 0, 2, 2));
+		font_resource oldest(factory(10.0));
+		CHECK(stats_are("oldest dropped", 2, 1, 3, 2));
+	}
+
+	// With a capacity of 0 nothing is kept, and every font still works.
+	{
+		start_over(0);
+		font_resource a(factory(10.0));
+		font_resource b(factory(10.0));
+		CHECK(stats_are("turned off", 0, 2, 0, 0));
+		CHECK(a.font_family() == "Sans");
+		CHECK(b.font_extents().height() > 0.0);
+	}
+
+	// Threads constructing the same font at once end up with one entry between them.
+	{
+		start_over(4);
+		const int threadCount = 8;
+		const int perThread = 100;
+		vector<thread> threads;
+		vector<int> sane(threadCount, 0);
+		for (int t = 0; t < threadCount; ++t) {
+			threads.emplace_back([t, &sane]() {
+				for (int i = 0; i < perThread; ++i) {
+					font_resource f(factory(10.0));
+					sane[t] += f.font_extents().height() > 0.0 ? 1 : 0;
+				}
+			});
+		}
+		for (auto& t : threads) {
+			t.join();
+		}
+		auto s = get_font_resource_cache_stats();
+		CHECK(s.size == 1);
+		CHECK(s.hits + s.misses == threadCount * perThread);
+		CHECK(s.evictions == 0);
+		for (auto n : sane) {
+			CHECK(n == perThread);
+		}
+	}
+
+	// -0.0 == 0.0, so a matrix with either zero finds the font the other put in.
+	{
+		start_over(4);
+		font_resource a(font_resource_factory("Sans", font_slant::normal, font_weight::normal, matrix_2d(10.0, 0.0, 0.0, 10.0, 0.0, 0.0)));
+		font_resource b(font_resource_factory("Sans", font_slant::normal, font_weight::normal, matrix_2d(10.0, -0.0, -0.0, 10.0, -0.0, 0.0)));
+		CHECK(stats_are("negative zero", 1, 1, 0, 1));
+	}
+
+	set_font_resource_cache_capacity(defaultCapacity);
+	return check::result();
+}
@@ -0,0 +1,132 @@
+// path_factory::path_extents and the cairo path a path is converted to must agree with each other and with extents worked
+// out by hand, including after a matrix or origin change, a repeated close_path, relative items following close_path, and
+// arcs that follow other items.
+#include "io2d.h"
+#include "check.h"
+#include <cairo.h>
+#include <cmath>
+#include <cstdio>
+
+using namespace std;
+using namespace std::experimental::io2d;
+
+namespace {
+	// cairo keeps path coordinates in 24.8 fixed point.
+	const double cairoTolerance = 1.0 / 256.0;
+
+	bool close_to(const rectangle& r, double x0, double y0, double x1, double y1, double tolerance) {
+		return abs(r.x() - x0) <= tolerance && abs(r.y() - y0) <= tolerance && abs(r.x() + r.width() - x1) <= tolerance && abs(r.y() + r.height() - y1) <= tolerance;
+	}
+
+	// The extents cairo gives the path that pf is converted to.
+	rectangle cairo_extents(const path_factory& pf) {
+		path p(pf);
+		auto cs = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 1, 1);
+		auto cr = cairo_create(cs);
+		cairo_append_path(cr, p.native_handle());
+		double x0, y0, x1, y1;
+		cairo_path_extents(cr, &x0, &y0, &x1, &y1);
+		cairo_destroy(cr);
+		cairo_surface_destroy(cs);
+		return{ x0, y0, x1 - x0, y1 - y0 };
+	}
+
+	// Checks both path_extents and the converted path against (x0, y0) - (x1, y1).
+	void check_extents(const char* name, const path_factory& pf, double x0, double y0, double x1, double y1, double tolerance = 0.0) {
+		auto fromFactory = pf.path_extents();
+		auto fromCairo = cairo_extents(pf);
+		const bool factoryRight = close_to(fromFactory, x0, y0, x1, y1, tolerance);
+		const bool cairoRight = close_to(fromCairo, x0, y0, x1, y1, tolerance + cairoTolerance);
+		if (!factoryRight || !cairoRight) {
+			printf("%s: expected (%g, %g) - (%g, %g), path_extents gave (%g, %g) - (%g, %g), cairo gave (%g, %g) - (%g, %g)\n", name, x0, y0, x1, y1,
+				fromFactory.x(), fromFactory.y(), fromFactory.x() + fromFactory.width(), fromFactory.y() + fromFactory.height(),
+				fromCairo.x(), fromCairo.y(), fromCairo.x() + fromCairo.width(), fromCairo.y() + fromCairo.height());
+		}
+		CHECK(factoryRight);
+		CHECK(cairoRight);
+	}
+}
+
+int main() {
+	// A second close_path starts its sub-path at the transformed first point too, so the line after it begins there.
+	{
+		path_factory pf;
+		pf.change_matrix(matrix_2d::init_translate({ 100.0, 0.0 }));
+		pf.move_to({ 0.0, 0.0 });
+		pf.line_to({ 10.0, 0.0 });
+		pf.line_to({ 10.0, 10.0 });
+		pf.close_path();
+		pf.close_path();
+		pf.line_to({ 20.0, 20.0 });
+		check_extents("second close_path", pf, 100.0, 0.0, 120.0, 20.0);
+	}
+
+	// The same with an origin, which is folded into the matrix: a half turn about (50, 50).
+	{
+		path_factory pf;
+		pf.change_origin({ 50.0, 50.0 });
+		pf.change_matrix(matrix_2d::init_scale({ -1.0, -1.0 }));
+		pf.move_to({ 40.0, 40.0 });
+		pf.line_to({ 30.0, 40.0 });
+		pf.close_path();
+		pf.close_path();
+		pf.line_to({ 45.0, 35.0 });
+		check_extents("second close_path with an origin", pf, 55.0, 60.0, 70.0, 65.0);
+	}
+
+	// After close_path, a relative item continues from the sub-path's first point, even when the matrix changed since it
+	// was added: the first point is (0, 0) in device space, so the rel_line_to ends at (5, 5).
+	{
+		path_factory pf;
+		pf.move_to({ 0.0, 0.0 });
+		pf.change_matrix(matrix_2d::init_translate({ 100.0, 0.0 }));
+		pf.line_to({ 10.0, 0.0 });
+		pf.close_path();
+		pf.rel_line_to({ 5.0, 5.0 });
+		check_extents("rel_line_to after close_path", pf, 0.0, 0.0, 110.0, 5.0);
+	}
+
+	// The same within one matrix: the line after close_path starts at the transformed first point.
+	{
+		path_factory pf;
+		pf.change_matrix(matrix_2d::init_translate({ 100.0, 50.0 }));
+		pf.move_to({ 0.0, 0.0 });
+		pf.line_to({ 10.0, 0.0 });
+		pf.close_path();
+		pf.rel_line_to({ -20.0, -20.0 });
+		check_extents("rel_line_to after close_path, one matrix", pf, 80.0, 30.0, 110.0, 50.0);
+	}
+
+	// rel_curve_to is measured from the transformed current point. The curve's highest point is at t = 0.5, 3/4 of the way
+	// to its control points.
+	{
+		path_factory pf;
+		pf.change_matrix(matrix_2d::init_translate({ 100.0, 0.0 }));
+		pf.move_to({ 0.0, 0.0 });
+		pf.rel_curve_to({ 0.0, 10.0 }, { 10.0, 10.0 }, { 10.0, 0.0 });
+		check_extents("rel_curve_to", pf, 100.0, 0.0, 110.0, 7.5);
+	}
+
+	// An arc adds to the extents of what came before it rather than replacing them. cairo's extents are those of the
+	// curves that approximate the arc, which stray from the circle by far less than the tolerance.
+	{
+		path_factory pf;
+		pf.move_to({ 0.0, 0.0 });
+		pf.line_to({ 200.0, 0.0 });
+		pf.new_sub_path();
+		pf.arc({ 50.0, 50.0 }, 10.0, 0.0, 6.0);
+		pf.close_path();
+		check_extents("arc after a line", pf, 0.0, 0.0, 200.0, 60.0, 0.01);
+	}
+
+	// Likewise for a line after an arc, and for an arc that is joined to the current point.
+	{
+		path_factory pf;
+		pf.arc({ 50.0, 50.0 }, 10.0, 0.0, 3.0);
+		pf.line_to({ -30.0, 100.0 });
+		pf.arc_negative({ 0.0, 0.0 }, 5.0, 1.0, -2.0);
+		check_extents("line and arc after an arc", pf, -30.0, -5.0, 60.0, 100.0, 0.01);
+	}
+
+	return check::result();
+}
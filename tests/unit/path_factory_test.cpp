@@ -0,0 +1,122 @@
+// path_factory keeps its items packed as a verb stream and a coordinate stream. What goes in must come back out of
+// data() and data_item() unchanged, and a path made from the factory must draw exactly what a path made from the
+// equivalent vector<path_data_item> draws.
+#include "io2d.h"
+#include "check.h"
+#include "paths.h"
+#include "surfaces.h"
+#include <vector>
+
+using namespace std;
+using namespace std::experimental::io2d;
+using paths::same;
+
+namespace {
+	// Builds the same path item by item through path_factory and as a vector<path_data_item>, using every kind of item.
+	void build(path_factory& pf, vector<path_data_item>& items) {
+		pf.move_to({ 10.0, 10.0 });
+		items.emplace_back(path_data_item::move_to({ 10.0, 10.0 }));
+		pf.line_to({ 50.5, 12.25 });
+		items.emplace_back(path_data_item::line_to({ 50.5, 12.25 }));
+		pf.rel_line_to({ 3.0, 20.0 });
+		items.emplace_back(path_data_item::rel_line_to({ 3.0, 20.0 }));
+		pf.curve_to({ 60.0, 40.0 }, { 20.0, 70.0 }, { 15.0, 45.0 });
+		items.emplace_back(path_data_item::curve_to({ 60.0, 40.0 }, { 20.0, 70.0 }, { 15.0, 45.0 }));
+		pf.rel_curve_to({ -5.0, 1.0 }, { -2.0, -8.0 }, { 1.0, -10.0 });
+		items.emplace_back(path_data_item::rel_curve_to({ -5.0, 1.0 }, { -2.0, -8.0 }, { 1.0, -10.0 }));
+		pf.close_path();
+		items.emplace_back(path_data_item::close_path());
+		pf.rel_move_to({ 40.0, 40.0 });
+		items.emplace_back(path_data_item::rel_move_to({ 40.0, 40.0 }));
+		pf.rel_line_to({ 12.0, -3.0 });
+		items.emplace_back(path_data_item::rel_line_to({ 12.0, -3.0 }));
+		pf.new_sub_path();
+		items.emplace_back(path_data_item::new_sub_path());
+		pf.arc({ 80.0, 80.0 }, 12.0, 0.0, 4.0);
+		items.emplace_back(path_data_item::arc({ 80.0, 80.0 }, 12.0, 0.0, 4.0));
+		pf.arc_negative({ 30.0, 90.0 }, 7.5, 1.0, -2.0);
+		items.emplace_back(path_data_item::arc_negative({ 30.0, 90.0 }, 7.5, 1.0, -2.0));
+		pf.close_path();
+		items.emplace_back(path_data_item::close_path());
+		const auto m = matrix_2d::init_rotate(0.2) * matrix_2d::init_scale({ 1.25, 0.8 });
+		pf.change_matrix(m);
+		items.emplace_back(path_data_item::change_matrix(m));
+		pf.change_origin({ 60.0, 20.0 });
+		items.emplace_back(path_data_item::change_origin({ 60.0, 20.0 }));
+		pf.move_to({ 70.0, 5.0 });
+		items.emplace_back(path_data_item::move_to({ 70.0, 5.0 }));
+		pf.line_to({ 95.0, 30.0 });
+		items.emplace_back(path_data_item::line_to({ 95.0, 30.0 }));
+		pf.line_to({ 65.0, 35.0 });
+		items.emplace_back(path_data_item::line_to({ 65.0, 35.0 }));
+		pf.close_path();
+		items.emplace_back(path_data_item::close_path());
+	}
+
+	void draw(image_surface& s, const path& p) {
+		s.paint(rgba_color::white());
+		s.path(p);
+		s.fill(rgba_color(0.1, 0.3, 0.8, 0.75));
+		s.path(p);
+		s.line_width(2.5);
+		s.stroke(rgba_color(0.9, 0.2, 0.1, 1.0));
+	}
+}
+
+int main() {
+	path_factory pf;
+	vector<path_data_item> items;
+	build(pf, items);
+
+	CHECK(same(pf.data(), items));
+	for (unsigned int i = 0; i < items.size(); ++i) {
+		CHECK(same(pf.data_item(i), items[i]));
+	}
+
+	// A copy, and factories filled by appending, hold the same items.
+	path_factory copy(pf);
+	CHECK(same(copy.data(), items));
+	path_factory appendedItems;
+	appendedItems.append(items);
+	CHECK(same(appendedItems.data(), items));
+	path_factory appendedFactory;
+	appendedFactory.append(pf);
+	CHECK(same(appendedFactory.data(), items));
+
+	// Building in pieces and appending keeps the order.
+	path_factory first;
+	vector<path_data_item> ignored;
+	build(first, ignored);
+	first.append(pf);
+	auto twice = items;
+	twice.insert(twice.end(), items.begin(), items.end());
+	CHECK(same(first.data(), twice));
+
+	// The coordinate stream is read back from the right offset after every kind of item.
+	CHECK(pf.has_current_point());
+	CHECK(same(pf.current_matrix(), matrix_2d::init_rotate(0.2) * matrix_2d::init_scale({ 1.25, 0.8 })));
+	CHECK(same(pf.current_origin(), vector_2d(60.0, 20.0)));
+
+	// Both kinds of path draw the same pixels and have the same extents.
+	path fromFactory(pf);
+	path fromItems(items);
+	image_surface a(format::argb32, 120, 120);
+	image_surface b(format::argb32, 120, 120);
+	draw(a, fromFactory);
+	draw(b, fromItems);
+	CHECK(surfaces::same_pixels(a, b));
+	auto ea = pf.path_extents();
+	auto eb = appendedItems.path_extents();
+	CHECK(ea.x() == eb.x() && ea.y() == eb.y() && ea.width() == eb.width() && ea.height() == eb.height());
+	CHECK(ea.width() > 0.0 && ea.height() > 0.0);
+
+	// clear() leaves a factory that can be reused.
+	copy.clear();
+	CHECK(copy.data().empty());
+	CHECK(!copy.has_current_point());
+	vector<path_data_item> again;
+	build(copy, again);
+	CHECK(same(copy.data(), items));
+
+	return check::result();
+}
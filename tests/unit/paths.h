@@ -0,0 +1,80 @@
+#pragma once
+
+#include "io2d.h"
+#include <vector>
+
+// Exact comparisons of path items, for the tests that check that what path_factory stores comes back unchanged.
+namespace paths {
+	using namespace ::std::experimental::io2d;
+
+	inline bool same(const vector_2d& a, const vector_2d& b) {
+		return a.x() == b.x() && a.y() == b.y();
+	}
+
+	inline bool same(const matrix_2d& a, const matrix_2d& b) {
+		return a.m00() == b.m00() && a.m01() == b.m01() && a.m10() == b.m10() && a.m11() == b.m11() && a.m20() == b.m20() && a.m21() == b.m21();
+	}
+
+	template <class T>
+	bool same_point(const path_data_item& a, const path_data_item& b) {
+		return same(a.get<T>().to(), b.get<T>().to());
+	}
+
+	template <class T>
+	bool same_curve(const path_data_item& a, const path_data_item& b) {
+		auto ca = a.get<T>();
+		auto cb = b.get<T>();
+		return same(ca.control_point_1(), cb.control_point_1()) && same(ca.control_point_2(), cb.control_point_2()) && same(ca.end_point(), cb.end_point());
+	}
+
+	template <class T>
+	bool same_arc(const path_data_item& a, const path_data_item& b) {
+		auto aa = a.get<T>();
+		auto ab = b.get<T>();
+		return same(aa.center(), ab.center()) && aa.radius() == ab.radius() && aa.angle_1() == ab.angle_1() && aa.angle_2() == ab.angle_2();
+	}
+
+	inline bool same(const path_data_item& a, const path_data_item& b) {
+		if (a.type() != b.type()) {
+			return false;
+		}
+		switch (a.type()) {
+		case path_data_type::move_to:
+			return same_point<path_data_item::move_to>(a, b);
+		case path_data_type::line_to:
+			return same_point<path_data_item::line_to>(a, b);
+		case path_data_type::rel_move_to:
+			return same_point<path_data_item::rel_move_to>(a, b);
+		case path_data_type::rel_line_to:
+			return same_point<path_data_item::rel_line_to>(a, b);
+		case path_data_type::change_origin:
+			return same(a.get<path_data_item::change_origin>().origin(), b.get<path_data_item::change_origin>().origin());
+		case path_data_type::curve_to:
+			return same_curve<path_data_item::curve_to>(a, b);
+		case path_data_type::rel_curve_to:
+			return same_curve<path_data_item::rel_curve_to>(a, b);
+		case path_data_type::arc:
+			return same_arc<path_data_item::arc>(a, b);
+		case path_data_type::arc_negative:
+			return same_arc<path_data_item::arc_negative>(a, b);
+		case path_data_type::change_matrix:
+			return same(a.get<path_data_item::change_matrix>().matrix(), b.get<path_data_item::change_matrix>().matrix());
+		case path_data_type::new_sub_path:
+		case path_data_type::close_path:
+			return true;
+		}
+		return false;
+	}
+
+	inline bool same(const ::std::vector<path_data_item>& a, const ::std::vector<path_data_item>& b) {
+		if (a.size() != b.size()) {
+			return false;
+		}
+		for (::std::size_t i = 0; i < a.size(); ++i) {
+			if (!same(a[i], b[i])) {
+				return false;
+			}
+		}
+		return true;
+	}
+}
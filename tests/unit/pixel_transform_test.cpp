@@ -0,0 +1,165 @@
+// transform_pixels must give, for every format, what applying the kernel through pixel_traits one pixel at a time gives,
+// whether or not the argb32 rows go through the SIMD conversion kernels and whether or not the rows are split across
+// threads. Parallel for_each_row must visit every row exactly once, rethrow what an action throws and cope with an action
+// that itself asks for parallel work. Run again with IO2D_THREADS set so that the worker threads are used on any machine.
+#include "io2d.h"
+#include "check.h"
+#include "surfaces.h"
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace std::experimental::io2d;
+
+namespace {
+	const int width = 517;
+	const int height = 301;
+
+	rgba_pixel grade(rgba_pixel p) {
+		return{ static_cast<uint8_t>(255 - p.r), static_cast<uint8_t>(p.g / 2), static_cast<uint8_t>(min(255, p.b + 40)), p.a };
+	}
+
+	// Every byte of every row, so that the 8- and 16-bit formats get varied pixels as well.
+	void fill_bytes(image_surface& s) {
+		auto pixels = s.pixels();
+		uint32_t state = 777;
+		for (int y = 0; y < pixels.height(); ++y) {
+			auto row = pixels.row(y);
+			for (int x = 0; x < pixels.stride(); ++x) {
+				state = state * 1664525u + 1013904223u;
+				row[x] = static_cast<unsigned char>(state >> 24);
+			}
+		}
+	}
+
+	void fill(image_surface& s) {
+		if (s.format() == format::argb32 || s.format() == format::xrgb32) {
+			surfaces::fill_with_noise(s);
+		}
+		else {
+			fill_bytes(s);
+		}
+	}
+
+	template <format Fmt>
+	void transform_one_at_a_time(image_surface& s) {
+		auto pixels = s.pixels();
+		typed_pixel_view<Fmt> view(pixels);
+		for (int y = 0; y < view.height(); ++y) {
+			auto row = view.row(y);
+			for (int x = 0; x < row.width(); ++x) {
+				row.set(x, grade(row.get(x)));
+			}
+		}
+	}
+
+	template <format Fmt>
+	void check_format() {
+		image_surface expected(Fmt, width, height);
+		fill(expected);
+		transform_one_at_a_time<Fmt>(expected);
+
+		for (auto p : { parallelism::sequential, parallelism::parallel }) {
+			image_surface typed(Fmt, width, height);
+			fill(typed);
+			{
+				auto pixels = typed.pixels();
+				transform_pixels(typed_pixel_view<Fmt>(pixels), grade, p);
+			}
+			CHECK(surfaces::same_pixels(typed, expected));
+
+			// The overload that picks the view from the format at run time.
+			image_surface untyped(Fmt, width, height);
+			fill(untyped);
+			{
+				auto pixels = untyped.pixels();
+				transform_pixels(pixels, grade, p);
+			}
+			CHECK(surfaces::same_pixels(untyped, expected));
+		}
+	}
+}
+
+int main() {
+	check_format<format::argb32>();
+	check_format<format::xrgb32>();
+	check_format<format::rgb16_565>();
+	check_format<format::a8>();
+
+	image_surface s(format::argb32, width, height);
+	fill(s);
+	auto pixels = s.pixels();
+	typed_pixel_view<format::argb32> view(pixels);
+
+	// Every row once, whichever thread it was given to.
+	vector<int> visits(height);
+	set<thread::id> threads;
+	mutex threadsLock;
+	for_each_row(view, [&](typed_pixel_row<format::argb32> row, int y) {
+		CHECK(row.data() == view.row(y).data());
+		++visits[static_cast<size_t>(y)];
+		lock_guard<mutex> lock(threadsLock);
+		threads.insert(this_thread::get_id());
+	}, parallelism::parallel);
+	bool eachOnce = true;
+	for (auto v : visits) {
+		eachOnce = eachOnce && v == 1;
+	}
+	CHECK(eachOnce);
+	printf("parallel for_each_row ran on %d thread(s)\n", static_cast<int>(threads.size()));
+
+	// The exception an action throws comes back out, after the other bands have finished.
+	bool caught = false;
+	try {
+		for_each_row(view, [](typed_pixel_row<format::argb32>, int y) {
+			if (y == height - 1) {
+				throw runtime_error("last row");
+			}
+		}, parallelism::parallel);
+	}
+	catch (const runtime_error&) {
+		caught = true;
+	}
+	CHECK(caught);
+
+	// An action that asks for parallel work again gets it done on its own thread, without going back to the busy pool.
+	vector<int> nestedVisits(height);
+	for_each_row(view, [&](typed_pixel_row<format::argb32>, int y) {
+		if (y % 50 == 0) {
+			vector<int> inner(height);
+			for_each_row(view, [&inner](typed_pixel_row<format::argb32>, int innerY) {
+				++inner[static_cast<size_t>(innerY)];
+			}, parallelism::parallel);
+			CHECK(inner == vector<int>(height, 1));
+		}
+		++nestedVisits[static_cast<size_t>(y)];
+	}, parallelism::parallel);
+	CHECK(nestedVisits == vector<int>(height, 1));
+
+	// convert_pixels splits its rows the same way.
+	const int stride = width * 4;
+	vector<unsigned char> sequential(static_cast<size_t>(stride) * height);
+	vector<unsigned char> parallel(sequential.size());
+	convert_pixels(pixels.data(), pixels.stride(), format::argb32, sequential.data(), stride, interchange_format::rgba8, width, height);
+	convert_pixels(pixels.data(), pixels.stride(), format::argb32, parallel.data(), stride, interchange_format::rgba8, width, height, parallelism::parallel);
+	CHECK(sequential == parallel);
+	image_surface back(format::argb32, width, height);
+	{
+		auto backPixels = back.pixels();
+		error_code ec;
+		convert_pixels(parallel.data(), stride, interchange_format::rgba8, backPixels.data(), backPixels.stride(), format::argb32, width, height, ec, parallelism::parallel);
+		CHECK(!ec);
+	}
+	image_surface backSequential(format::argb32, width, height);
+	{
+		auto backPixels = backSequential.pixels();
+		convert_pixels(sequential.data(), stride, interchange_format::rgba8, backPixels.data(), backPixels.stride(), format::argb32, width, height);
+	}
+	CHECK(surfaces::same_pixels(back, backSequential));
+	return check::result();
+}
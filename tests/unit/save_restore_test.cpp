@@ -0,0 +1,142 @@
+// surface::save records the immediate path copy-on-write: appending leaves the saved items in place, and clearing,
+// assigning or moving the immediate path first hands them to the saved state. Whatever happens in between, restore()
+// must give back exactly what an independent copy taken at save() holds, including after the surface itself moves.
+#include "io2d.h"
+#include "check.h"
+#include "paths.h"
+#include "surfaces.h"
+#include <stack>
+#include <system_error>
+#include <utility>
+
+using namespace std;
+using namespace std::experimental::io2d;
+using paths::same;
+
+namespace {
+	struct reference_state {
+		path_factory path;
+		double line_width;
+	};
+
+	// Fills what the immediate path holds; the reference is drawn the same way from its copy.
+	void draw(image_surface& s) {
+		s.paint(rgba_color::white());
+		s.fill_immediate(rgba_color(0.2, 0.4, 0.6, 0.8));
+	}
+
+	bool draws_the_same(image_surface& s, const path_factory& expected) {
+		image_surface r(format::argb32, s.width(), s.height());
+		r.immediate() = expected;
+		draw(r);
+		draw(s);
+		return surfaces::same_pixels(s, r);
+	}
+
+	// Changes the immediate path in the way that level picks, and the reference the same way.
+	void change(image_surface& s, path_factory& expected, int level) {
+		const double d = level * 7.0;
+		switch (level % 4) {
+		case 0:
+			s.immediate().line_to({ 80.0 - d, 10.0 + d });
+			expected.line_to({ 80.0 - d, 10.0 + d });
+			break;
+		case 1:
+			s.immediate().clear();
+			expected.clear();
+			s.immediate().move_to({ 5.0 + d, 5.0 });
+			s.immediate().line_to({ 90.0, 30.0 + d });
+			s.immediate().line_to({ 20.0, 90.0 });
+			expected.move_to({ 5.0 + d, 5.0 });
+			expected.line_to({ 90.0, 30.0 + d });
+			expected.line_to({ 20.0, 90.0 });
+			break;
+		case 2:
+		{
+			path_factory other;
+			other.move_to({ 50.0, 2.0 + d });
+			other.curve_to({ 98.0, 20.0 }, { 60.0, 98.0 }, { 10.0 + d, 60.0 });
+			s.immediate() = other;
+			expected = other;
+		}
+			break;
+		default:
+		{
+			// Moving out while a saved state still refers to the items leaves them in place; moving back must not lose any.
+			path_factory taken(move(s.immediate()));
+			CHECK(same(taken.data(), expected.data()));
+			s.immediate() = move(taken);
+			s.immediate().rel_line_to({ -d, 3.0 });
+			expected.rel_line_to({ -d, 3.0 });
+		}
+			break;
+		}
+	}
+
+	void save(image_surface& s, stack<reference_state>& saved, const path_factory& expected, int level) {
+		saved.push({ expected, s.line_width() });
+		if (level % 2 == 0) {
+			s.save();
+		}
+		else {
+			error_code ec;
+			s.save(ec);
+			CHECK(!ec);
+		}
+	}
+
+	void restore(image_surface& s, stack<reference_state>& saved, path_factory& expected) {
+		s.restore();
+		expected = saved.top().path;
+		CHECK(same(s.immediate().data(), expected.data()));
+		CHECK(s.line_width() == saved.top().line_width);
+		CHECK(draws_the_same(s, expected));
+		saved.pop();
+	}
+}
+
+int main() {
+	const int depth = 12;
+	image_surface s(format::argb32, 100, 100);
+	path_factory expected;
+	stack<reference_state> saved;
+	s.immediate().move_to({ 10.0, 10.0 });
+	s.immediate().line_to({ 60.0, 15.0 });
+	expected.move_to({ 10.0, 10.0 });
+	expected.line_to({ 60.0, 15.0 });
+
+	for (int level = 0; level < depth; ++level) {
+		save(s, saved, expected, level);
+		s.line_width(1.0 + level);
+		change(s, expected, level);
+		CHECK(same(s.immediate().data(), expected.data()));
+	}
+
+	// Move construction takes the saved states along.
+	image_surface moved(move(s));
+	for (int level = depth; level > depth / 2; --level) {
+		restore(moved, saved, expected);
+	}
+
+	// So does move assignment, replacing whatever the target had saved, with a different memory resource.
+	monotonic_buffer_resource arena;
+	image_surface target(format::argb32, 100, 100);
+	target.memory_resource(&arena);
+	target.immediate().move_to({ 1.0, 1.0 });
+	target.save();
+	target.immediate().line_to({ 2.0, 2.0 });
+	target = move(moved);
+	for (int level = depth / 2; level > 0; --level) {
+		// Nesting again on top of restored states.
+		save(target, saved, expected, level);
+		change(target, expected, level + 1);
+		restore(target, saved, expected);
+		restore(target, saved, expected);
+	}
+	CHECK(saved.empty());
+
+	error_code ec;
+	target.restore(ec);
+	CHECK(ec);
+	return check::result();
+}
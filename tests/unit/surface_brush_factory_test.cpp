@@ -0,0 +1,151 @@
+// surface_brush_factory shares its source's pixels until the source changes, so brushes made from it must keep showing the
+// source as it was when the factory was given it: after the source is drawn to, and after writes through a pixel_view or
+// mapped_surface that was already open when the factory was made. surface() const must be safe to call from several
+// threads at once, the first time included.
+#include "io2d.h"
+#include "check.h"
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace std::experimental::io2d;
+
+namespace {
+	const int width = 64;
+	const int height = 48;
+	const uint32_t red = 0xffff0000u;
+	const uint32_t blue = 0xff0000ffu;
+
+	uint32_t pixel_at(const image_surface& s, int x, int y) {
+		auto pixels = s.const_pixels();
+		uint32_t v;
+		memcpy(&v, pixels.row(y) + x * 4, sizeof(v));
+		return v;
+	}
+
+	bool all_pixels_are(const image_surface& s, uint32_t expected) {
+		for (int y = 0; y < s.height(); ++y) {
+			for (int x = 0; x < s.width(); ++x) {
+				if (pixel_at(s, x, y) != expected) {
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	void fill_rows(unsigned char* data, int stride, uint32_t value) {
+		for (int y = 0; y < height; ++y) {
+			for (int x = 0; x < width; ++x) {
+				memcpy(data + static_cast<ptrdiff_t>(y) * stride + x * 4, &value, sizeof(value));
+			}
+		}
+	}
+
+	// What a brush made from factory paints.
+	image_surface painted(surface_brush_factory& factory) {
+		image_surface dest(format::argb32, width, height);
+		dest.paint(brush(factory));
+		dest.flush();
+		return dest;
+	}
+
+	image_surface red_surface() {
+		image_surface s(format::argb32, width, height);
+		s.paint(rgba_color(1.0, 0.0, 0.0, 1.0));
+		return s;
+	}
+}
+
+int main() {
+	// Drawing to the source after the factory is made.
+	{
+		auto src = red_surface();
+		surface_brush_factory factory(src);
+		src.paint(rgba_color(0.0, 0.0, 1.0, 1.0));
+		CHECK(all_pixels_are(painted(factory), red));
+		CHECK(all_pixels_are(factory.surface(), red));
+	}
+
+	// A pixel_view opened before the factory is made, written to after.
+	{
+		auto src = red_surface();
+		surface_brush_factory factory;
+		{
+			auto pixels = src.pixels();
+			factory.surface(src);
+			fill_rows(pixels.data(), pixels.stride(), blue);
+		}
+		CHECK(all_pixels_are(src, blue));
+		CHECK(all_pixels_are(painted(factory), red));
+		CHECK(all_pixels_are(factory.surface(), red));
+	}
+
+	// The same through the error_code overload.
+	{
+		auto src = red_surface();
+		surface_brush_factory factory;
+		{
+			auto pixels = src.pixels();
+			error_code ec;
+			factory.surface(src, ec);
+			CHECK(!ec);
+			fill_rows(pixels.data(), pixels.stride(), blue);
+		}
+		CHECK(all_pixels_are(painted(factory), red));
+	}
+
+	// A factory made from inside map(), written to through the mapped_surface after.
+	{
+		auto src = red_surface();
+		surface_brush_factory factory;
+		src.map([&](mapped_surface& m) {
+			factory.surface(src);
+			fill_rows(m.data(), m.stride(), blue);
+			m.commit_changes();
+		});
+		CHECK(all_pixels_are(src, blue));
+		CHECK(all_pixels_are(painted(factory), red));
+	}
+
+	// Once the views are gone the source is snapshotted again rather than copied, and still keeps its pixels.
+	{
+		auto src = red_surface();
+		{
+			auto pixels = src.pixels();
+		}
+		surface_brush_factory factory(src);
+		{
+			auto pixels = src.pixels();
+			fill_rows(pixels.data(), pixels.stride(), blue);
+		}
+		CHECK(all_pixels_are(painted(factory), red));
+	}
+
+	// surface() from several threads at once, the first time: one copy, with the right pixels, for all of them.
+	for (int round = 0; round < 20; ++round) {
+		auto src = red_surface();
+		surface_brush_factory factory(src);
+		src.paint(rgba_color(0.0, 0.0, 1.0, 1.0));
+		const int threadCount = 4;
+		vector<const image_surface*> results(threadCount);
+		vector<thread> threads;
+		for (int i = 0; i < threadCount; ++i) {
+			threads.emplace_back([&factory, &results, i]() {
+				results[static_cast<size_t>(i)] = &factory.surface();
+			});
+		}
+		for (auto& t : threads) {
+			t.join();
+		}
+		bool same = true;
+		for (auto r : results) {
+			same = same && r == results[0];
+		}
+		CHECK(same);
+		CHECK(all_pixels_are(*results[0], red));
+	}
+	return check::result();
+}
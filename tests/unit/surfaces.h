@@ -0,0 +1,54 @@
+#pragma once
+
+#include "io2d.h"
+#include <cstdint>
+#include <cstring>
+
+// Helpers for the tests that check a fast path by drawing the same thing the slow way and comparing pixels.
+namespace surfaces {
+	// Fills s with a pattern that differs from pixel to pixel and has every alpha level, premultiplied for argb32.
+	inline void fill_with_noise(::std::experimental::io2d::image_surface& s, ::std::uint32_t seed = 12345) {
+		auto pixels = s.pixels();
+		auto state = seed;
+		const bool premultiply = pixels.format() == ::std::experimental::io2d::format::argb32;
+		for (int y = 0; y < pixels.height(); ++y) {
+			auto row = reinterpret_cast<::std::uint32_t*>(pixels.row(y));
+			for (int x = 0; x < pixels.width(); ++x) {
+				state = state * 1664525u + 1013904223u;
+				::std::uint32_t a = premultiply ? state >> 24 : 0xffu;
+				::std::uint32_t r = ((state >> 16) & 0xffu) * a / 255;
+				::std::uint32_t g = ((state >> 8) & 0xffu) * a / 255;
+				::std::uint32_t b = (state & 0xffu) * a / 255;
+				row[x] = (a << 24) | (r << 16) | (g << 8) | b;
+			}
+		}
+	}
+
+	// True when both surfaces have the same size and format and every pixel is identical.
+	inline bool same_pixels(const ::std::experimental::io2d::image_surface& a, const ::std::experimental::io2d::image_surface& b) {
+		if (a.width() != b.width() || a.height() != b.height() || a.format() != b.format()) {
+			return false;
+		}
+		auto pa = a.const_pixels();
+		auto pb = b.const_pixels();
+		// Only the pixels themselves: the padding at the end of a row, and the unused bits of xrgb32, may hold anything.
+		const bool xrgb = a.format() == ::std::experimental::io2d::format::xrgb32;
+		const auto bits = a.format() == ::std::experimental::io2d::format::a1 ? 1 : a.format() == ::std::experimental::io2d::format::a8 ? 8 : a.format() == ::std::experimental::io2d::format::rgb16_565 ? 16 : 32;
+		const auto used = (static_cast<::std::size_t>(a.width()) * bits + 7) / 8;
+		for (int y = 0; y < a.height(); ++y) {
+			if (xrgb) {
+				auto ra = reinterpret_cast<const ::std::uint32_t*>(pa.row(y));
+				auto rb = reinterpret_cast<const ::std::uint32_t*>(pb.row(y));
+				for (int x = 0; x < a.width(); ++x) {
+					if (((ra[x] ^ rb[x]) & 0x00ffffffu) != 0) {
+						return false;
+					}
+				}
+			}
+			else if (::std::memcmp(pa.row(y), pb.row(y), used) != 0) {
+				return false;
+			}
+		}
+		return true;
+	}
+}
@@ -0,0 +1,50 @@
+// matrix_2d::transform_points must give exactly what transform_point gives, point for point, whichever of its loops runs.
+#include "io2d.h"
+#include "check.h"
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace std::experimental::io2d;
+
+namespace {
+	bool same(const vector_2d& a, const vector_2d& b) {
+		return a.x() == b.x() && a.y() == b.y();
+	}
+
+	void check_matrix(const matrix_2d& m, const vector<vector_2d>& pts) {
+		// Every count up to the length, so that each loop's remainder handling runs.
+		for (size_t count = 0; count <= pts.size(); ++count) {
+			vector<vector_2d> out(count);
+			m.transform_points(pts.data(), count, out.data());
+			vector<vector_2d> inPlace(pts.begin(), pts.begin() + count);
+			m.transform_points(inPlace.data(), count);
+			for (size_t i = 0; i < count; ++i) {
+				auto expected = m.transform_point(pts[i]);
+				CHECK(same(out[i], expected));
+				CHECK(same(inPlace[i], expected));
+			}
+		}
+	}
+}
+
+int main() {
+	mt19937 rng(1);
+	uniform_real_distribution<double> coordinate(-1.0e4, 1.0e4);
+	vector<vector_2d> pts;
+	for (int i = 0; i < 37; ++i) {
+		pts.push_back({ coordinate(rng), coordinate(rng) });
+	}
+	pts.push_back({ 0.1, 0.2 });
+	pts.push_back({ -0.0, 1.0e-300 });
+
+	check_matrix(matrix_2d::init_identity(), pts);
+	check_matrix(matrix_2d::init_translate({ 3.25, -7.5 }), pts);
+	check_matrix(matrix_2d::init_scale({ 1.5, -0.3 }), pts);
+	check_matrix(matrix_2d(1.5, 0.0, 0.0, -0.3, 11.0, 0.1), pts);
+	check_matrix(matrix_2d::init_rotate(0.7), pts);
+	check_matrix(matrix_2d::init_rotate(0.7) * matrix_2d::init_translate({ 100.0, 0.1 }), pts);
+	check_matrix(matrix_2d(0.1, 0.2, 0.3, 0.4, 0.5, 0.6), pts);
+	check_matrix(matrix_2d::init_shear_x(0.25), pts);
+	return check::result();
+}
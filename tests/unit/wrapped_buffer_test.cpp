@@ -0,0 +1,128 @@
+// An image_surface made over a caller's buffer must draw into that buffer and nowhere else: the same pixels an ordinary
+// image_surface gets, in the caller's rows, with the padding between rows left alone. The release callback must run exactly
+// once, after the last use of the buffer, including when construction fails.
+#include "io2d.h"
+#include "check.h"
+#include "surfaces.h"
+#include <cstdint>
+#include <cstring>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace std::experimental::io2d;
+
+namespace {
+	const int width = 37;
+	const int height = 23;
+	const unsigned char padding = 0xa5;
+
+	void draw(image_surface& s) {
+		s.paint(rgba_color(1.0, 1.0, 1.0, 1.0));
+		s.immediate().clear();
+		s.immediate().move_to({ 2.0, 3.0 });
+		s.immediate().line_to({ 35.5, 8.25 });
+		s.immediate().line_to({ 10.0, 21.0 });
+		s.immediate().close_path();
+		s.fill_immediate(rgba_color(0.1, 0.3, 0.8, 0.75));
+		s.stroke_immediate(rgba_color(0.9, 0.2, 0.1, 1.0));
+	}
+
+	struct release_counter {
+		int calls = 0;
+		unsigned char* data = nullptr;
+
+		function<void(unsigned char*)> callback() {
+			return [this](unsigned char* d) {
+				++calls;
+				data = d;
+			};
+		}
+	};
+}
+
+int main() {
+	const int rowSize = format_stride_for_width(format::argb32, width);
+	const int stride = rowSize + 64;
+	vector<unsigned char> buffer(static_cast<size_t>(stride) * height, padding);
+	image_surface reference(format::argb32, width, height);
+	draw(reference);
+
+	release_counter released;
+	{
+		image_surface wrapped(buffer.data(), format::argb32, width, height, stride, released.callback());
+		CHECK(wrapped.stride() == stride);
+		draw(wrapped);
+		CHECK(surfaces::same_pixels(wrapped, reference));
+
+		// The pixels are the caller's: no copy is made, and the padding after each row is never written.
+		wrapped.flush();
+		CHECK(wrapped.pixels().row(0) == buffer.data());
+		auto expected = reference.const_pixels();
+		bool rowsMatch = true;
+		bool paddingUntouched = true;
+		for (int y = 0; y < height; ++y) {
+			auto row = buffer.data() + static_cast<ptrdiff_t>(y) * stride;
+			rowsMatch = rowsMatch && memcmp(row, expected.row(y), static_cast<size_t>(rowSize)) == 0;
+			for (int x = rowSize; x < stride; ++x) {
+				paddingUntouched = paddingUntouched && row[x] == padding;
+			}
+		}
+		CHECK(rowsMatch);
+		CHECK(paddingUntouched);
+
+		// What the caller writes is what gets drawn, once cairo has been told.
+		auto pixel = reinterpret_cast<uint32_t*>(buffer.data() + static_cast<ptrdiff_t>(5) * stride) + 7;
+		*pixel = 0xff00ff00u;
+		wrapped.mark_dirty();
+		image_surface copy(format::argb32, width, height);
+		copy.paint(wrapped);
+		CHECK(*(reinterpret_cast<const uint32_t*>(copy.const_pixels().row(5)) + 7) == 0xff00ff00u);
+
+		// Moving the surface does not release the buffer.
+		image_surface moved(move(wrapped));
+		moved.paint(rgba_color(0.0, 0.0, 0.0, 1.0));
+		CHECK(released.calls == 0);
+	}
+	CHECK(released.calls == 1);
+	CHECK(released.data == buffer.data());
+
+	// Without a callback the buffer simply outlives the surface.
+	{
+		image_surface wrapped(buffer.data(), format::argb32, width, height, stride);
+		draw(wrapped);
+		CHECK(surfaces::same_pixels(wrapped, reference));
+	}
+
+	// A failed constructor still releases the buffer, exactly once.
+	release_counter nullData;
+	bool threw = false;
+	try {
+		image_surface wrapped(nullptr, format::argb32, width, height, stride, nullData.callback());
+	}
+	catch (const system_error&) {
+		threw = true;
+	}
+	CHECK(threw);
+	CHECK(nullData.calls == 1);
+
+	release_counter badStride;
+	error_code ec;
+	{
+		image_surface wrapped(buffer.data(), format::argb32, width, height, rowSize - 4, ec, badStride.callback());
+		CHECK(static_cast<bool>(ec));
+		CHECK(badStride.calls == 1);
+	}
+	CHECK(badStride.calls == 1);
+
+	release_counter good;
+	{
+		image_surface wrapped(buffer.data(), format::argb32, width, height, stride, ec, good.callback());
+		CHECK(!ec);
+		draw(wrapped);
+		CHECK(surfaces::same_pixels(wrapped, reference));
+	}
+	CHECK(good.calls == 1);
+	return check::result();
+}